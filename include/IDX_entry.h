@@ -101,6 +101,12 @@ public:
     float       recent_low_level;
     time_t      recent_low_time;
 
+    // Subordinate station MIN/MAX search state, see TCPredictor
+    time_t      sec_low_time;
+    time_t      sec_high_time;
+    double      sec_low_level;
+    double      sec_high_level;
+
 };
 
 WX_DECLARE_OBJARRAY(IDX_entry, ArrayOfIDXEntry);
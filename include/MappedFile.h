@@ -0,0 +1,73 @@
+/******************************************************************************
+ *
+ * Project:  OpenCPN
+ * Purpose:  Read only memory mapped file
+ *
+ ***************************************************************************
+ *   Copyright (C) 2020 by David S. Register                               *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301,  USA.         *
+ ***************************************************************************
+ */
+
+#ifndef __MAPPEDFILE_H__
+#define __MAPPEDFILE_H__
+
+#include <wx/string.h>
+#include <stddef.h>
+
+//  A read only view of a whole file.
+//  The file is mapped into memory where the platform supports it,
+//  otherwise it is read into a private heap buffer, so callers may
+//  always treat GetData() as a plain pointer to the file contents.
+class MappedFile
+{
+public:
+    MappedFile();
+    ~MappedFile();
+
+    bool Open(const wxString &path);
+    void Close();
+
+    bool IsOpened() const { return m_data != NULL; }
+    bool IsMapped() const { return m_bmapped; }
+
+    const unsigned char *GetData() const { return m_data; }
+    size_t GetSize() const { return m_size; }
+
+    //  Returns a pointer to [offset, offset+len) or NULL if out of range
+    const unsigned char *GetRange(size_t offset, size_t len) const
+    {
+        if(!m_data || offset > m_size || len > m_size - offset)
+            return NULL;
+        return m_data + offset;
+    }
+
+private:
+    MappedFile(const MappedFile &);
+    MappedFile &operator=(const MappedFile &);
+
+    const unsigned char *m_data;
+    size_t      m_size;
+    bool        m_bmapped;
+
+#ifdef __WXMSW__
+    void        *m_hFile;
+    void        *m_hMapping;
+#endif
+};
+
+#endif
@@ -0,0 +1,102 @@
+/******************************************************************************
+ *
+ * Project:  OpenCPN
+ * Purpose:  Lightweight tracing of where the time goes
+ *
+ ***************************************************************************
+ *   Copyright (C) 2020 by David S. Register                               *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301,  USA.         *
+ ***************************************************************************
+ */
+
+#ifndef __PERFTRACE_H__
+#define __PERFTRACE_H__
+
+#include <wx/string.h>
+#include <wx/arrstr.h>
+
+#include <atomic>
+
+//  PERF_ZONE("name") times the rest of the enclosing scope.
+//  While neither recording nor frame statistics are on, a zone costs one
+//  relaxed atomic load, so zones may stay in hot paths of release builds.
+//  Names must be string literals, or come from PerfTrace::Intern().
+//
+//  Recording keeps the zones of all threads in memory and writes them at
+//  StopRecording() as a Chrome trace JSON file, to be opened with
+//  chrome://tracing or ui.perfetto.dev.
+//
+//  Frame statistics keep the time per frame of the main thread zones over
+//  the last frames, for the on-screen overlay.
+class PerfTrace
+{
+public:
+    static bool IsActive() { return s_flags.load(std::memory_order_relaxed) != 0; }
+
+    static void StartRecording(const wxString &file);
+    static bool StopRecording();
+    static bool IsRecording() { return (s_flags.load(std::memory_order_relaxed) & RECORD) != 0; }
+
+    static void EnableFrameStats(bool benable);
+    static bool IsFrameStatsEnabled() { return (s_flags.load(std::memory_order_relaxed) & FRAME_STATS) != 0; }
+
+    //  Microseconds since the start of the process
+    static double Now();
+
+    //  A finished zone, times from Now()
+    static void Record(const char *name, double start, double end);
+    //  A value worth following over time, e.g. a queue length
+    static void Counter(const char *name, double value);
+
+    //  A name that lives until the process exits
+    static const char *Intern(const wxString &name);
+
+    //  Mark the end of a rendered frame, main thread only
+    static void FrameEnd();
+    //  The overlay text: the frame time, then the zones by time per frame
+    static void GetFrameStats(wxArrayString &lines);
+
+private:
+    enum { RECORD = 1, FRAME_STATS = 2 };
+
+    static std::atomic<int> s_flags;
+};
+
+class PerfZone
+{
+public:
+    PerfZone(const char *name)
+        : m_name(name), m_start(PerfTrace::IsActive() ? PerfTrace::Now() : -1.) {}
+    ~PerfZone()
+    {
+        if(m_start >= 0.)
+            PerfTrace::Record(m_name, m_start, PerfTrace::Now());
+    }
+
+private:
+    PerfZone(const PerfZone &);
+    PerfZone &operator=(const PerfZone &);
+
+    const char  *m_name;
+    double      m_start;
+};
+
+#define PERF_ZONE_CAT2(a, b) a##b
+#define PERF_ZONE_CAT(a, b) PERF_ZONE_CAT2(a, b)
+#define PERF_ZONE(name) PerfZone PERF_ZONE_CAT(perf_zone_, __LINE__)(name)
+
+#endif
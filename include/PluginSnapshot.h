@@ -0,0 +1,164 @@
+/******************************************************************************
+ *
+ * Project:  OpenCPN
+ * Purpose:  Navigation data snapshot shared with the PlugIns
+ *
+ ***************************************************************************
+ *   Copyright (C) 2020 by David S. Register                               *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301,  USA.         *
+ ***************************************************************************
+ */
+
+#ifndef __PLUGINSNAPSHOT_H__
+#define __PLUGINSNAPSHOT_H__
+
+#include <atomic>
+#include <mutex>
+#include <stdint.h>
+#include <string.h>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "ocpn_plugin.h"
+
+//  A value of plain data written by one thread and read by any number of
+//  others without locking.  Readers copy the value and retry if a write
+//  happened meanwhile, so reads are never torn.  A reader which keeps
+//  losing to the writer gives up after a few tries, and reads again under
+//  a lock the writer also holds.
+//  The value is kept in relaxed atomic words so the copy is race free.
+template <class T>
+class SeqLocked
+{
+public:
+    SeqLocked() : m_seq(0)
+    {
+        for(int i = 0 ; i < NWORDS ; i++)
+            m_words[i].store(0, std::memory_order_relaxed);
+    }
+
+    //  One writer thread only
+    void Write(const T &value)
+    {
+        uint64_t words[NWORDS] = {};
+        memcpy(words, &value, sizeof(T));
+
+        unsigned int seq = m_seq.load(std::memory_order_relaxed);
+        m_seq.store(seq + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        for(int i = 0 ; i < NWORDS ; i++)
+            m_words[i].store(words[i], std::memory_order_relaxed);
+        m_seq.store(seq + 2, std::memory_order_release);
+    }
+
+    //  False if writes got in the way every time.  Otherwise seq is the
+    //  sequence of the value read, which changes with every write.
+    bool TryRead(T &value, unsigned int &seq) const
+    {
+        uint64_t words[NWORDS];
+        for(int attempt = 0 ; attempt < MAX_ATTEMPTS ; attempt++) {
+            seq = m_seq.load(std::memory_order_acquire);
+            if(seq & 1) {
+                std::this_thread::yield();      // a write is under way
+                continue;
+            }
+
+            for(int i = 0 ; i < NWORDS ; i++)
+                words[i] = m_words[i].load(std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_acquire);
+
+            if(m_seq.load(std::memory_order_relaxed) == seq) {
+                memcpy(&value, words, sizeof(T));
+                return true;
+            }
+        }
+        return false;
+    }
+
+    //  Only while the writer is held off, by a lock it takes for writing
+    unsigned int ReadLocked(T &value) const
+    {
+        uint64_t words[NWORDS];
+        for(int i = 0 ; i < NWORDS ; i++)
+            words[i] = m_words[i].load(std::memory_order_relaxed);
+        memcpy(&value, words, sizeof(T));
+        return m_seq.load(std::memory_order_relaxed);
+    }
+
+private:
+    enum { NWORDS = (sizeof(T) + sizeof(uint64_t) - 1) / sizeof(uint64_t) };
+    enum { MAX_ATTEMPTS = 64 };
+
+    std::atomic<unsigned int>   m_seq;
+    std::atomic<uint64_t>       m_words[NWORDS];
+};
+
+//  The latest ownship fix and AIS target table, for PlugIns to read at their
+//  own pace from any thread instead of parsing NMEA sentences or JSON messages.
+//
+//  The main thread writes, as fixes and AIS reports arrive.  Targets live in
+//  a flat array of slots, each read consistently by itself; the table as a
+//  whole is read again if targets were added or removed during the read.
+//  Readers which keep colliding with writes copy under m_write_mutex.
+class PluginSnapshot
+{
+public:
+    enum { MAX_AIS_TARGETS = 2048 };
+
+    static PluginSnapshot &Get();
+
+    //  Main thread only
+    void SetPositionFix(const PlugIn_Position_Fix_Ex &fix, bool bvalid);
+    void SetAISTarget(const PlugIn_AIS_Target &target);
+    void RemoveAISTarget(int mmsi);
+    void ClearAISTargets();
+
+    //  Any thread.  The generation changes whenever the data does.
+    bool GetPositionFix(PlugIn_Position_Fix_Ex *pfix, unsigned int *pgeneration) const;
+    unsigned int GetAISGeneration() const { return m_ais_generation.load(std::memory_order_acquire); }
+    //  Copies at most max_targets targets, and returns how many there are
+    int GetAISTargets(PlugIn_AIS_Target *ptargets, int max_targets, unsigned int *pgeneration) const;
+
+private:
+    struct Fix
+    {
+        PlugIn_Position_Fix_Ex  fix;
+        bool                    bvalid;
+    };
+
+    PluginSnapshot();
+    PluginSnapshot(const PluginSnapshot &);
+    PluginSnapshot &operator=(const PluginSnapshot &);
+
+    SeqLocked<Fix>                      m_fix;
+
+    std::vector<SeqLocked<PlugIn_AIS_Target> > m_slots;     // MMSI 0 when free
+    std::atomic<int>                    m_nslots;           // slots ever used
+    std::atomic<unsigned int>           m_layout;           // changes as targets come and go
+    std::atomic<unsigned int>           m_ais_generation;
+
+    //  Held by the writer while it writes, and by readers which fall back
+    //  to a locked copy
+    mutable std::mutex                  m_write_mutex;
+
+    //  Writer side only
+    std::unordered_map<int, int>        m_slot_of_mmsi;
+    std::vector<int>                    m_free_slots;
+};
+
+#endif
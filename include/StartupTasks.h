@@ -0,0 +1,107 @@
+/******************************************************************************
+ *
+ * Project:  OpenCPN
+ * Purpose:  Startup task scheduling and timing
+ *
+ ***************************************************************************
+ *   Copyright (C) 2020 by David S. Register                               *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301,  USA.         *
+ ***************************************************************************
+ */
+
+#ifndef __STARTUPTASKS_H__
+#define __STARTUPTASKS_H__
+
+#include <wx/string.h>
+#include <wx/arrstr.h>
+#include <wx/log.h>
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+//  Keeps track of the work done while the application starts.
+//
+//  Tasks that need no GUI and no shared state are started on worker threads
+//  as soon as their inputs are known, optionally after other tasks, and the
+//  main thread waits for them only where it needs the result.
+//  The main thread work is timed as a sequence of named phases.
+//  Report() logs when each task and phase ran, and how long it was waited for.
+//  What a worker logs is kept and logged by Wait(), wx logging is only safe
+//  on the main thread.
+//
+//  All the methods are to be called from the main thread only.
+class StartupTasks
+{
+public:
+    static StartupTasks &Get();
+
+    //  Run work on a worker thread once the tasks named in deps are done.
+    //  work must not touch wxString objects shared with other threads.
+    void Start(const wxString &name, const std::function<void()> &work,
+               const wxArrayString &deps = wxArrayString());
+
+    //  Block until the named task is done.  Unknown names return at once.
+    void Wait(const wxString &name);
+
+    //  End the current main thread phase and begin a new one
+    void Phase(const wxString &name);
+    void EndPhase();
+
+    //  A point in time of interest, like the UI becoming usable
+    void Mark(const wxString &name);
+
+    void Report();
+
+private:
+    struct Task
+    {
+        Task() : tracename(NULL), bworker(false), bdone(false), queued(0), start(0), end(0), waited(0) {}
+
+        wxString        name;
+        const char      *tracename;
+        std::thread     thread;
+        bool            bworker;
+        bool            bdone;
+        double          queued;
+        double          start;
+        double          end;
+        double          waited;
+        std::vector< std::pair<wxLogLevel, wxString> > log;
+    };
+
+    StartupTasks();
+    ~StartupTasks();
+    StartupTasks(const StartupTasks &);
+    StartupTasks &operator=(const StartupTasks &);
+
+    double Now() const;
+    Task *Find(const wxString &name);
+    void Done(Task &task);
+
+    std::deque<Task>            m_tasks;
+    Task                        *m_phase;
+
+    std::mutex                  m_mutex;
+    std::condition_variable     m_cond;
+};
+
+#endif
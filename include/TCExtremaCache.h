@@ -0,0 +1,112 @@
+/***************************************************************************
+ *
+ * Project:  OpenCPN
+ * Purpose:  Tide station high/low water cache
+ *
+ ***************************************************************************
+ *   Copyright (C) 2020 by David S. Register                               *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301,  USA.         *
+ **************************************************************************/
+
+#ifndef __TCEXTREMACACHE_H__
+#define __TCEXTREMACACHE_H__
+
+#include <wx/thread.h>
+
+#include <deque>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include <time.h>
+
+#include "tcmgr.h"
+
+//  One high or low water
+struct TCExtremum
+{
+    time_t      time;
+    float       level;
+    bool        bhigh;
+};
+
+class TCExtremaThread;
+
+//  High/low waters of stations over a window of days around the time
+//  they were asked for.  Windows are computed on a worker thread and then
+//  answered by binary search.  Only the stations used most recently are
+//  kept.  A lookup that misses returns
+//  false, the caller computes the answer directly and queues the station
+//  with Request(), so later lookups hit.
+class TCExtremaCache
+{
+public:
+    TCExtremaCache();
+    ~TCExtremaCache();
+
+    //  Stops the worker and drops everything, the index entries the
+    //  queued predictors refer to are about to go away
+    void Clear();
+
+    //  True if there is no window covering t comfortably, and none queued
+    bool NeedsRequest(int idx, time_t t);
+    void Request(int idx, const TCPredictor &predictor, time_t t);
+
+    //  First high or low water after t
+    bool GetNextExtremum(int idx, time_t t, TCExtremum &ext);
+
+    //  Nearest high (bhigh) or low water after (bforward) or before t
+    bool GetExtremum(int idx, time_t t, bool bforward, bool bhigh, TCExtremum &ext);
+
+private:
+    friend class TCExtremaThread;
+
+    //  A station without a working predictor gets a window with no
+    //  extrema, so it is not queued again until t leaves the window
+    struct StationWindow {
+        time_t                  t_start;
+        time_t                  t_end;
+        int                     step;
+        std::vector<TCExtremum> extrema;
+        unsigned                last_use;
+
+        time_t End() const { return t_end; }
+    };
+
+    struct WindowRequest {
+        int             idx;
+        time_t          t;
+        TCPredictor     predictor;
+    };
+
+    static void ComputeWindow(TCPredictor &predictor, time_t t, StationWindow &win);
+
+    bool NextRequest(WindowRequest &req, int &generation);
+    void Finish(int idx, int generation, StationWindow &win);
+    const StationWindow *Find(int idx);
+
+    wxMutex             m_mutex;
+    wxCondition         m_cond;
+    std::deque<WindowRequest> m_queue;
+    std::unordered_set<int> m_queued;
+    std::unordered_map<int, StationWindow> m_stations;
+    unsigned            m_clock;
+    int                 m_generation;
+    bool                m_bexit;
+    TCExtremaThread     *m_thread;
+};
+
+#endif
@@ -0,0 +1,69 @@
+/***************************************************************************
+ *
+ * Project:  OpenCPN
+ * Purpose:  Spatial index of tide and current stations
+ *
+ ***************************************************************************
+ *   Copyright (C) 2020 by David S. Register                               *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301,  USA.         *
+ **************************************************************************/
+
+#ifndef __TCSTATIONINDEX_H__
+#define __TCSTATIONINDEX_H__
+
+#include <functional>
+#include <utility>
+#include <vector>
+
+class LLBBox;
+
+//  Stations bucketed into one degree cells.  Stations are identified by
+//  their index in TCMgr, results come back in index order (bbox) or by
+//  increasing DistanceBearingMercator() distance (nearest).
+class TCStationIndex
+{
+public:
+    TCStationIndex();
+
+    void Clear();
+    void Add(int idx, double lat, double lon);
+    void Build();                                   // after the last Add()
+
+    //  Stations for which box.ContainsMarge(lat, lon, marge) holds
+    void GetInBBox(const LLBBox &box, double marge, std::vector<int> &stations) const;
+
+    //  Up to count stations nearest to lat, lon (count <= 0 for all) which
+    //  are accepted by the filter, as (distance in NMi, index) pairs
+    void GetNearest(double lat, double lon, int count,
+                    std::vector<std::pair<double, int> > &stations,
+                    const std::function<bool(int)> &accept = std::function<bool(int)>()) const;
+
+private:
+    struct Station {
+        int     idx;
+        double  lat, lon;
+        int     cell;
+    };
+
+    static int Row(double lat);
+    static int Col(double lon);
+
+    std::vector<Station>    m_stations;         // sorted by cell after Build()
+    std::vector<int>        m_cell_start;       // first station of each cell
+};
+
+#endif
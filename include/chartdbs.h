@@ -33,6 +33,7 @@
 #include "ocpn_types.h"
 #include "bbox.h"
 #include "LLRegion.h"
+#include "MappedFile.h"
 
 class wxGenericProgressDialog;
 class ChartBase;
@@ -47,13 +48,86 @@ public:
 
 WX_DECLARE_OBJARRAY(ChartDirInfo, ArrayOfCDI);
 
+//    The sorted files of a chart directory with their size and time,
+//    as found by the change detection scan.  Kept with the database, so
+//    files whose header could not be read are not read again until they
+//    change, or the database is rebuilt.
+struct ChartDirManifest
+{
+    wxArrayString               files;
+    std::vector<wxULongLong>    sizes;
+    std::vector<time_t>         times;
+    std::vector<bool>           failed;     // no chart could be made of it
+
+    int Index(const wxString &path) const;
+    bool Find(const wxString &path, time_t &time) const;
+};
+
 ///////////////////////////////////////////////////////////////////////
 
-static const int DB_VERSION_PREVIOUS = 17;
-static const int DB_VERSION_CURRENT = 18;
+static const int DB_VERSION_PREVIOUS = 18;
+static const int DB_VERSION_CURRENT = 19;
 
 class ChartDatabase;
 class ChartGroupArray;
+class ChartTablePoolWriter;
+
+//  Version 19 is used in place from a mapping of the file.
+//  Following the ChartTableHeader, every section 4 byte aligned:
+//      ChartTableSections_19
+//      int                         dir[nDirEntries]      string offsets
+//      ChartTableEntry_onDisk_19   entry[nTableEntries]
+//      int                         plyCount[nPlyTables]  aux and NoCovr tables
+//      int                         plyOffset[nPlyTables] in the point pool
+//      float                       point[2 * nPlyPoints] lat/lon pairs
+//      char                        string[nStringBytes]  NUL terminated UTF-8
+struct ChartTableSections_19
+{
+    int         nPlyTables;
+    int         nPlyPoints;
+    int         nStringBytes;
+    int         reserved;
+};
+
+struct ChartTableEntry_onDisk_19
+{
+    int         EntryOffset;
+    int         ChartType;
+    int         ChartFamily;
+    float       LatMax;
+    float       LatMin;
+    float       LonMax;
+    float       LonMin;
+
+    int         Scale;
+    int         edition_date;
+    int         file_date;
+
+    int         nPlyEntries;
+    int         nAuxPlyEntries;
+    int         nNoCovrPlyEntries;
+
+    float       skew;
+    int         ProjectionType;
+    int         bValid;
+
+    int         PathOffset;             // in the string pool
+    int         PlyOffset;              // in the point pool
+    int         AuxPlyIndex;            // in the ply table pools
+    int         NoCovrPlyIndex;
+};
+
+//  The pools of a mapped version 19 database
+struct ChartTablePools_19
+{
+    const char  *strings;
+    int         nStringBytes;
+    int         *plyCounts;
+    int         *plyOffsets;
+    int         nPlyTables;
+    float       *points;
+    int         nPlyPoints;
+};
 
 struct ChartTableEntry_onDisk_18
 {
@@ -176,7 +250,7 @@ struct ChartTableHeader
     bool CheckValid();
     int GetDirEntries() const { return nDirEntries; }
     int GetTableEntries() const { return nTableEntries; }
-    char *GetDBVersionString(){ return dbVersion; }
+    const char *GetDBVersionString() const { return dbVersion; }
 
 private:
     // NOTE: on-disk structure - cannot add, remove, or reorder!
@@ -194,7 +268,9 @@ struct ChartTableEntry
     bool IsEqualTo(const ChartTableEntry &cte) const;
     bool IsEarlierThan(const ChartTableEntry &cte) const;
     bool Read(const ChartDatabase *pDb, wxInputStream &is);
-    bool Write(const ChartDatabase *pDb, wxOutputStream &os);
+    bool Map(const ChartTableEntry_onDisk_19 &cte, const ChartTablePools_19 &pools);
+    bool Write(const ChartDatabase *pDb, ChartTableEntry_onDisk_19 &cte, ChartTablePoolWriter &pools) const;
+    void Detach();
     void Clear();
     void Disable();
     void ReEnable();
@@ -206,11 +282,13 @@ struct ChartTableEntry
     float *GetpPlyTable() const { return pPlyTable; }
 
     int GetnAuxPlyEntries() const { return nAuxPlyEntries; }
-    float *GetpAuxPlyTableEntry(int index) const { return pAuxPlyTable[index];}
+    float *GetpAuxPlyTableEntry(int index) const
+        { return m_bmapped ? m_pPointPool + 2 * m_pAuxPlyOffsets[index] : pAuxPlyTable[index];}
     int GetAuxCntTableEntry(int index) const { return pAuxCntTable[index];}
 
     int GetnNoCovrPlyEntries() const { return nNoCovrPlyEntries; }
-    float *GetpNoCovrPlyTableEntry(int index) const { return pNoCovrPlyTable[index];}
+    float *GetpNoCovrPlyTableEntry(int index) const
+        { return m_bmapped ? m_pPointPool + 2 * m_pNoCovrPlyOffsets[index] : pNoCovrPlyTable[index];}
     int GetNoCovrCntTableEntry(int index) const { return pNoCovrCntTable[index];}
     
     const LLBBox &GetBBox() const { return m_bbox; } 
@@ -228,9 +306,9 @@ struct ChartTableEntry
 
     bool GetbValid(){ return bValid;}
     void SetEntryOffset(int n) { EntryOffset = n;}
-    const wxString *GetpFileName(void) const { return m_pfilename; }
-    wxString *GetpsFullPath(void) const { return m_psFullPath; }
-    wxString GetFullSystemPath() const { return m_fullSystemPath; }
+    const wxString *GetpFileName(void) const;
+    wxString *GetpsFullPath(void) const;
+    wxString GetFullSystemPath() const;
     
     const std::vector<int> &GetGroupArray(void) const { return m_GroupArray; }
     void ClearGroupArray(void) { m_GroupArray.clear(); }
@@ -273,9 +351,14 @@ struct ChartTableEntry
     float       **pNoCovrPlyTable;
     
     std::vector<int> m_GroupArray;
-    wxString    *m_pfilename;             // a helper member, not on disk
-    wxString    *m_psFullPath;
-    wxString    m_fullSystemPath;
+    mutable wxString    *m_pfilename;     // helper members, not on disk, made on first use
+    mutable wxString    *m_psFullPath;
+    mutable wxString    m_fullSystemPath;
+
+    bool        m_bmapped;                // path and tables are in a mapped database
+    float       *m_pPointPool;
+    int         *m_pAuxPlyOffsets;
+    int         *m_pNoCovrPlyOffsets;
     
     LLBBox m_bbox;
     bool        m_bavail;
@@ -384,16 +467,26 @@ protected:
 private:
     bool IsChartDirUsed(const wxString &theDir);
 
-    int SearchDirAndAddCharts(wxString& dir_name_base, ChartClassDescriptor &chart_desc, wxGenericProgressDialog *pprog);
+    int SearchDirAndAddCharts(wxString& dir_name_base, ChartClassDescriptor &chart_desc, wxGenericProgressDialog *pprog,
+                              ChartDirManifest *manifest = NULL, const ChartDirManifest *previous = NULL);
 
     int TraverseDirAndAddCharts(ChartDirInfo& dir_info, wxGenericProgressDialog *pprog, wxString& dir_magic, bool bForce);
-    bool DetectDirChange(const wxString & dir_path, const wxString & prog_label, const wxString & magic, wxString &new_magic, wxGenericProgressDialog *pprog);
+    bool DetectDirChange(const wxString & dir_path, const wxString & prog_label, const wxString & magic, wxString &new_magic,
+                         wxGenericProgressDialog *pprog, ChartDirManifest *manifest = NULL);
 
     bool AddChart( wxString &chartfilename, ChartClassDescriptor &chart_desc, wxGenericProgressDialog *pprog,
                    int isearch, bool bthis_dir_in_dB );
 
     bool Check_CM93_Structure(wxString dir_name);
 
+    bool ReadMapped(ChartTableHeader &cth);
+    void DetachMapped();
+
+    //  The manifests are kept next to the database file
+    static wxString GetManifestFileName(const wxString &filePath);
+    void ReadManifests(const wxString &filePath);
+    bool WriteManifests(const wxString &filePath);
+
     bool          bValid;
     wxArrayString m_chartDirs;
     int           m_dbversion;
@@ -406,6 +499,10 @@ private:
     
     int         m_nentries;
 
+    MappedFile    m_dbFile;                 // version 19 database the entries point into
+
+    std::map<wxString, ChartDirManifest> m_dirManifests;    // by chart directory
+
     LLBBox m_dummy_bbox;
 };
 
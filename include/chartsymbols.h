@@ -29,6 +29,7 @@
 #include <tinyxml.h>
 #include "pugixml.hpp"
 
+class ChartSymbolsCacheWriter;
 
 class Lookup {
 public:
@@ -139,8 +140,12 @@ private:
       void ProcessPatterns( pugi::xml_node &node );
       void ProcessSymbols( pugi::xml_node &node );
       void ProcessVectorTag( pugi::xml_node &vectorNode, SymbolSizeInfo_t &vectorSize );
+
+      bool LoadCache( const wxString &cacheFile, const wxString &xmlFile );
+      void SaveCache( const wxString &cacheFile, const wxString &xmlFile, unsigned int firstColorTable );
       
       pugi::xml_document m_symbolsDoc;
+      ChartSymbolsCacheWriter *m_cache;     // collects what is built while the XML is parsed
 
       s52plib* plib;
 };
@@ -172,6 +172,20 @@ public:
       virtual void Refresh( bool eraseBackground = true, const wxRect *rect = (const wxRect *) NULL );
       virtual void Update();
 
+      //  The chart and the overlays that only change with the view or on edits are
+      //  cached as a static layer.  Any Refresh() invalidates it, except this one,
+      //  for updates of the moving objects only (ownship, AIS, alerts).
+      void RefreshDynamic( const wxRect *rect = NULL );
+      void InvalidateStaticLayer(){ m_bStaticLayerDirty = true; }
+      bool IsStaticLayerValid();
+      void SetStaticLayerValid();
+
+      //  Routes, tracks and marks that change while underway or being edited
+      //  are drawn on every frame, the others with the static layer
+      static bool IsDynamicTrack( Track *track );
+      static bool IsDynamicRoute( Route *route );
+      static bool IsDynamicWaypoint( RoutePoint *point );
+
       void LostMouseCapture(wxMouseCaptureLostEvent& event);
       
       void CancelMouseRoute();
@@ -625,11 +639,11 @@ private:
       void MovementStopTimerEvent( wxTimerEvent& );
       void OnCursorTrackTimerEvent(wxTimerEvent& event);
 
-      void DrawAllTracksInBBox( ocpnDC& dc, LLBBox& BltBBox );
+      void DrawStaticRoutesTracksAndWaypoints( ocpnDC& dc, LLBBox& BltBBox );
+      void DrawDynamicRoutesTracksAndWaypoints( ocpnDC& dc, LLBBox& BltBBox );
       void DrawActiveTrackInBBox( ocpnDC& dc, LLBBox& BltBBox );
-      void DrawAllRoutesInBBox(ocpnDC& dc, LLBBox& BltBBox );
       void DrawActiveRouteInBBox(ocpnDC& dc, LLBBox& BltBBox );
-      void DrawAllWaypointsInBBox(ocpnDC& dc, LLBBox& BltBBox );
+      void DrawWaypointInBBox( ocpnDC& dc, LLBBox& BltBBox, RoutePoint *pWP );
       void DrawAnchorWatchPoints( ocpnDC& dc );
       double GetAnchorWatchRadiusPixels(RoutePoint *pAnchorWatchPoint);
 
@@ -648,7 +662,11 @@ private:
       void GridDraw(ocpnDC& dc); // Display lat/lon Grid in chart display
       void ScaleBarDraw( ocpnDC& dc );
 
-      void DrawOverlayObjects ( ocpnDC &dc, const wxRegion& ru );
+      void DrawStaticOverlayObjects ( ocpnDC &dc );
+      void DrawDynamicOverlayObjects ( ocpnDC &dc, const wxRegion& ru );
+      void DrawStaticLayer( wxMemoryDC &dc, ViewPort &svp );
+      void DrawDynamicLayer( wxMemoryDC &dc, const wxRegion& ru );
+      unsigned int GetStaticLayerKey();
 
       emboss_data *EmbossDepthScale();
       emboss_data *CreateEmbossMapData(wxFont &font, int width, int height, const wxString &str, ColorScheme cs);
@@ -796,6 +814,11 @@ private:
       ViewPort    m_bm_cache_vp;
       wxBitmap    m_working_bm;           // Used to build quilt in OnPaint()
       wxBitmap    m_cached_chart_bm;      // A cached copy of the fully drawn quilt
+      wxBitmap    m_static_bm;            // The chart with the static overlays, for DC painting
+
+      bool        m_bStaticLayerDirty;
+      bool        m_bdynamic_refresh;
+      unsigned int m_static_layer_key;    // which objects were drawn on the static layer
 
       bool        m_bbrightdir;
       int         m_brightmod;
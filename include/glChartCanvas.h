@@ -66,12 +66,15 @@ typedef void (*PFNGLBINDFRAMEBUFFEREXTPROC) (GLenum target, GLuint framebuffer);
 
 
 class glTexFactory;
+class glTexPrefetchMotion;
 class ChartCanvas;
 
 #define GESTURE_EVENT_TIMER 78334
 #define ZOOM_TIMER 78335
 #define GESTURE_FINISH_TIMER 78336
 #define TEX_FADE_TIMER 78337
+#define FRAME_TIMER 78338
+#define QUALITY_TIMER 78339
 
 typedef class{
   public:
@@ -120,6 +123,9 @@ public:
 
     int m_iTextureDimension;
     int m_iTextureMemorySize;
+    int m_iTexturePrefetchPercent;      // share of texture memory for tiles uploaded ahead of use
+    int m_iMaxFrameRate;                // frames per second drawn at most, 0 for no limit
+    bool m_bAdaptiveQuality;            // draft quality for slow frames while the view moves
     
     bool m_GLPolygonSmoothing;
     bool m_GLLineSmoothing;
@@ -194,6 +200,11 @@ public:
 #endif
     
     void onZoomTimerEvent(wxTimerEvent &event);
+    void onFrameTimerEvent(wxTimerEvent &event);
+    void onQualityTimerEvent(wxTimerEvent &event);
+
+    //  Coalesces the redraw requests to the frame rate set in the options
+    void Refresh( bool eraseBackground = true, const wxRect *rect = NULL );
     
     wxString GetRendererString(){ return m_renderer; }
     wxString GetVersionString(){ return m_version; }
@@ -253,10 +264,12 @@ protected:
 
     void DrawFloatingOverlayObjects( ocpnDC &dc );
     void DrawGroundedOverlayObjects(ocpnDC &dc, ViewPort &vp);
+    void DrawStaticLayer( int sx, int sy );
 
     void DrawChartBar( ocpnDC &dc );
     void DrawQuiting();
     void DrawCloseMessage(wxString msg);
+    void DrawFrameStats();
 
     void DrawGLTidesInBBox(ocpnDC& dc, LLBBox& BBox);
     void DrawGLCurrentsInBBox(ocpnDC& dc, LLBBox& BBox);
@@ -265,6 +278,8 @@ protected:
     
     void RendertoTexture(GLint tex);
     
+    void UpdateRenderQuality();
+
     void fboFade(GLint tex0, GLint tex1);
     void onFadeTimerEvent(wxTimerEvent &event);
     bool m_inFade;
@@ -296,6 +311,7 @@ protected:
 
     GLuint       m_cache_tex[2];
     GLuint       m_cache_page;
+    GLuint       m_static_tex;          // the cached charts with the grounded overlays on top
     int          m_cache_tex_x;
     int          m_cache_tex_y;
 
@@ -345,9 +361,22 @@ protected:
     double      m_pinchlat, m_pinchlon;
     
     wxTimer     m_fadeTimer;
+
+    //  Frame governor
+    wxTimer     m_frameTimer;           // a frame deferred to keep to the frame rate
+    wxTimer     m_qualityTimer;         // full quality again once the view is still
+    double      m_frame_start;          // PerfTrace clock, us
+    double      m_frame_cost;           // smoothed time of the full quality moving frames, us
+    double      m_render_cost;          // time of the last frame before the buffer swap, us
+    bool        m_bLowQuality;
+    bool        m_bmoving;
+    ViewPort    m_last_frame_vp;
+
+    glTexPrefetchMotion *m_prefetch_motion;     // recent view motion, to upload tiles ahead
     
     OCPNRegion  m_canvasregion;
     TexFont     m_gridfont;
+    TexFont     m_statsfont;
 
     int		m_LRUtime;
 
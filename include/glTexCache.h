@@ -32,61 +32,49 @@
 
 #include "ocpn_types.h"
 #include "bbox.h"
+#include "MappedFile.h"
 
 class glTextureDescriptor;
 
-#define COMPRESSED_CACHE_MAGIC 0xf013  // change this when the format changes
+#define COMPRESSED_CACHE_MAGIC 0xf014  // change this when the format changes
 
 #define FACTORY_TIMER                   10000
 
-void HalfScaleChartBits( int width, int height, unsigned char *source, unsigned char *target );
-
 class ChartBaseBSB;
 class ChartPlugInWrapper;
 
+//  Compressed cache file layout
+//
+//  CompressedCacheHeader at offset 0
+//  Catalog at catalog_offset, a fixed size array of CatalogEntryValue
+//      indexed by [color scheme][mip level][tile], see CatalogIndex()
+//  LZ4 compressed texture data from data_offset to the end of the file
+//
+//  New textures are appended to the end of the file, then their single
+//  catalog slot is written in place, so the catalog is never rewritten.
+//  A zero compressed_size marks a slot with no data.
 struct CompressedCacheHeader
 {
     uint32_t magic;
     uint32_t format;
     uint32_t chartdate;
-    uint32_t m_nentries;
-    uint32_t catalog_offset;
     uint32_t chartfile_date;
     uint32_t chartfile_size;
-};
-
-struct CatalogEntryKey
-{
-    int         mip_level;
-    ColorScheme tcolorscheme;
-    int         x;
-    int         y;
+    uint32_t tex_dim;
+    uint32_t nx_tex;
+    uint32_t ny_tex;
+    uint32_t n_levels;
+    uint32_t n_color_schemes;
+    uint32_t catalog_offset;
+    uint32_t data_offset;
 };
 
 struct CatalogEntryValue
 {
-    int         texture_offset;
+    uint32_t    texture_offset;
     uint32_t    compressed_size;
 }; 
 
-#define CATALOG_ENTRY_SERIAL_SIZE 6 * sizeof(uint32_t)
-
-class CatalogEntry
-{
-public:
-    CatalogEntry();
-    ~CatalogEntry();
-    CatalogEntry(int level, int x0, int y0, ColorScheme colorscheme);
-    int GetSerialSize();
-    void Serialize(unsigned char *);
-    void DeSerialize(unsigned char *);
-    CatalogEntryKey k;
-    CatalogEntryValue v;
-    
-};
-
-WX_DEFINE_ARRAY(CatalogEntry*, ArrayOfCatalogEntries);
-
 class glTexTile
 {
 public:
@@ -112,6 +100,8 @@ public:
     glTextureDescriptor *GetOrCreateTD(const wxRect &rect);
     bool BuildTexture(glTextureDescriptor *ptd, int base_level, const wxRect &rect);
     bool PrepareTexture( int base_level, const wxRect &rect, ColorScheme color_scheme, int mem_used );
+    int PrefetchTexture( int base_level, const wxRect &rect, ColorScheme color_scheme );
+    bool IsTextureResident( const wxRect &rect, int base_level );
     int GetTextureLevel( glTextureDescriptor *ptd, const wxRect &rect, int level,  ColorScheme color_scheme );
     bool UpdateCacheAllLevels( const wxRect &rect, ColorScheme color_scheme, unsigned char **compcomp_array, int *compcomp_size);
     bool IsLevelInCache( int level, const wxRect &rect, ColorScheme color_scheme );
@@ -140,37 +130,37 @@ public:
 private:
     bool LoadCatalog(void);
     bool LoadHeader(void);
-    bool WriteCatalogAndHeader();
+    bool CreateCacheFile();
+    bool MapCacheFile();
 
     bool UpdateCachePrecomp(unsigned char *data, int data_size, const wxRect &rect, int level,
-                                          ColorScheme color_scheme, bool write_catalog = true);
+                                          ColorScheme color_scheme);
     bool UpdateCacheLevel( const wxRect &rect, int level, ColorScheme color_scheme, unsigned char *data, int size);
     
     void DeleteSingleTexture( glTextureDescriptor *ptd );
+    void StageTextureLevel( glTextureDescriptor *ptd, const wxRect &rect, int level );
 
     CatalogEntryValue *GetCacheEntryValue(int level, int x, int y, ColorScheme color_scheme);
-    bool AddCacheEntryValue(const CatalogEntry &p);
+    int  CatalogIndex(int level, int array_index, ColorScheme color_scheme) const
+        { return ((int)color_scheme * MAX_TEX_LEVEL + level) * m_ntex + array_index; }
     int  ArrayIndex(int x, int y) const { return ((y / m_tex_dim) * m_stride) + (x / m_tex_dim); } 
     void  ArrayXY(wxRect *r, int index) const;
 
-    int         n_catalog_entries;
-
-    CatalogEntryValue *m_cache[N_COLOR_SCHEMES][MAX_TEX_LEVEL];
-
-
+    CatalogEntryValue *m_catalog;
+    int         m_catalog_size;
+    CompressedCacheHeader m_hdr;
 
     wxString    m_ChartPath;
     wxString    m_HashKey;
     wxString    m_CompressedCacheFilePath;
     
-    int         m_catalog_offset;
     bool        m_hdrOK;
     bool        m_catalogOK;
     bool        m_newCatalog;
 
-    bool	m_catalogCorrupted;
-    
     wxFFile     *m_fs;
+    MappedFile  m_map;
+    wxFileOffset m_file_end;
     uint32_t    m_chart_date_binary;
     uint32_t    m_chartfile_date_binary;
     uint32_t    m_chartfile_size;
@@ -184,6 +174,7 @@ private:
     int         m_ny_tex;
     
     int		m_LRUtime;
+    bool        m_bprefetching;
     
     glTextureDescriptor  **m_td_array;
 
@@ -74,6 +74,8 @@ public:
     int                 compcomp_size[10];
 
     int compdata_ticks;
+
+    int prefetch_mem;           // texture memory uploaded ahead of use, 0 once shown
 };
 
 
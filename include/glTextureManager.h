@@ -27,6 +27,8 @@
 #ifndef __GLTEXTUREMANAGER_H__
 #define __GLTEXTUREMANAGER_H__
 
+#include "bbox.h"
+
 const wxEventType wxEVT_OCPN_COMPRESSIONTHREAD = wxNewEventType();
 
 class JobTicket;
@@ -111,6 +113,23 @@ public:
 };
 
 
+//      Recent viewport motion of one canvas, used to guess which raster
+//      tiles are about to scroll or zoom into view
+class glTexPrefetchMotion
+{
+public:
+    glTexPrefetchMotion();
+
+    void Update(const ViewPort &vp);
+    LLBBox PredictBox(const LLBBox &box) const;
+
+private:
+    bool        m_bvalid;
+    wxLongLong  m_time;
+    double      m_clat, m_clon, m_log_scale;
+    double      m_vlat, m_vlon, m_vzoom;        // per second
+};
+
 //      This is a hashmap with Chart full path as key, and glTexFactory as value
 WX_DECLARE_STRING_HASH_MAP( glTexFactory*, ChartPathHashTexfactType );
 
@@ -136,6 +155,13 @@ public:
     bool TextureCrunch(double factor);
     bool FactoryCrunch(double factor);
     void BuildCompressedCache();
+
+    //  Predictive tile upload
+    void PrefetchTiles(const glTexPrefetchMotion &motion, glTexFactory *ptf,
+                       const LLRegion &region, int base_level);
+    void NoteTileShown(int prefetch_mem, bool b_uploaded);
+    void NotePrefetchDiscarded(int prefetch_mem);
+    void LogPrefetchStats();
     
     //    This is a hash table
     //    key is Chart full path
@@ -162,6 +188,12 @@ private:
     bool        m_skip;
     bool        m_skipout;
     bool        m_bcompact;
+
+    long        m_prefetch_mem;
+    unsigned long m_prefetch_issued;
+    unsigned long m_prefetch_hits;
+    unsigned long m_prefetch_wasted;
+    unsigned long m_demand_loads;
 };
 
 class glTextureDescriptor;
@@ -46,6 +46,7 @@
 #include "ocpndc.h"
 #include "viewport.h"
 #include "cutil.h"
+#include "MappedFile.h"
 
 #ifdef __MSVC__
 #pragma warning(disable: 4251)   // relates to std::string fpath
@@ -98,10 +99,14 @@ typedef std::vector<contour> contour_list;
 class GshhsPolyCell {
 public:
 
-    GshhsPolyCell( FILE *fpoly, int x0, int y0, PolygonFileHeader *header );
+    GshhsPolyCell( const MappedFile &file, int x0, int y0, int quality, PolygonFileHeader *header );
     ~GshhsPolyCell();
 
     void ClearPolyV();
+#ifdef ocpnUSE_GL
+    //  Fill the opengl vertex cache before the cell is drawn, needs no GL context
+    void BuildPolyV( ViewPort &vp, bool idl );
+#endif
 
     void drawMapPlain( ocpnDC &pnt, double dx, ViewPort &vp, wxColor seaColor,
                        wxColor landColor, bool idl );
@@ -110,15 +115,23 @@ public:
     std::vector<wxLineF> * getCoasts() { return &coasts; }
     contour_list &getPoly1() { return poly1; }
 
+    int getQuality() { return quality; }
+    int getX() { return x0cell; }
+    int getY() { return y0cell; }
+    //  Approximate heap memory of the contours and the vertex cache
+    size_t getMemoryUsed() { return memoryUsed; }
+
     /* we remap the segments into a high resolution map to
        greatly reduce intersection testing time */
     std::vector<wxLineF> *high_res_map[GSSH_SUBM*GSSH_SUBM];
 
+    unsigned int lastUsed;      // the frame of the reader this cell was last needed in
+
 private:
     int nbpoints;
     int x0cell, y0cell;
-
-    FILE *fpoly;
+    int quality;
+    size_t memoryUsed;
 
     std::vector<wxLineF> coasts;
     PolygonFileHeader *header;
@@ -131,14 +144,21 @@ private:
     void DrawPolygonFilled( ocpnDC &pnt, contour_list * poly, double dx, ViewPort &vp,
             wxColor const &color );
 #ifdef ocpnUSE_GL        
+    void BuildPolygonFilledGL( contour_list * p, float_2Dpt **pv, int *pvc, ViewPort &vp, bool idl );
     void DrawPolygonFilledGL( contour_list * p, float_2Dpt **pv, int *pvc, ViewPort &vp,  wxColor const &color, bool idl );
 #endif
     void DrawPolygonContour( ocpnDC &pnt, contour_list * poly, double dx, ViewPort &vp );
 
-    void ReadPoly( contour_list &poly );
-    void ReadPolygonFile( );
+    bool ReadPoly( contour_list &poly, const unsigned char *&data, const unsigned char *end );
+    void ReadPolygonFile( const MappedFile &file );
 };
 
+class GshhsCellLoader;
+
+//  The polygon files of all the qualities are mapped at once.  Cells are
+//  built on a worker thread ahead of pans and zooms, and the cells of all
+//  the qualities stay loaded until they exceed a memory budget, so zooming
+//  back and forth across a quality change does not read them again.
 class GshhsPolyReader {
 public:
     GshhsPolyReader( int quality );
@@ -153,14 +173,30 @@ public:
     bool crossing1( wxLineF trajectWorld );
     int currentQuality;
     int ReadPolyVersion();
-    int GetPolyVersion() { return polyHeader.version; }
+    int GetPolyVersion() { return polyHeaders[currentQuality].version; }
 
 private:
-    FILE *fpoly;
-    GshhsPolyCell * allCells[360][180];
-
-    PolygonFileHeader polyHeader;
-    void readPolygonFileHeader( FILE *polyfile, PolygonFileHeader *header );
+    MappedFile polyFiles[5];
+    PolygonFileHeader polyHeaders[5];
+    GshhsPolyCell * allCells[5][360][180];
+
+    std::vector<GshhsPolyCell *> residentCells;
+    size_t residentBytes;
+    unsigned int frameCount;
+
+    GshhsCellLoader *cellLoader;
+    bool bcellLoaderStarted;
+    int prefetchArea[5];
+
+    bool readPolygonFileHeader( const MappedFile &file, PolygonFileHeader *header );
+
+    GshhsPolyCell *newCell( int quality, int x, int y );
+    void addCell( GshhsPolyCell *cel );
+    GshhsPolyCell *getDrawCell( int x, int y, bool bplaceholder, std::vector<int> &requests );
+    void adoptReadyCells();
+    void clearPolyV();
+    void prefetchCells( int clonmin, int clonmax, int clatmin, int clatmax );
+    void trimCells();
 
     wxMutex mutex1, mutex2;
 
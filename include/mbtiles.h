@@ -57,9 +57,11 @@ class PixelCache;
 class ocpnBitmap;
 class mbTileZoomDescriptor;
 class mbTileDescriptor;
+class mbTileDecoder;
 
  namespace SQLite {
    class Database;
+   class Statement;
  }
  
 //-----------------------------------------------------------------------------
@@ -119,6 +121,7 @@ protected:
       void PrepareTiles();
       void PrepareTilesForZoom(int zoomFactor, bool bset_geom);
       bool getTileTexture( mbTileDescriptor *tile);
+      void PrefetchZoom( int zoomFactor, const LLBBox &box );
       void FlushTiles( void );
       void FlushTextures( void );
       bool RenderTile( mbTileDescriptor *tile, int zoomLevel, const ViewPort& VPoint);
@@ -145,6 +148,8 @@ protected:
       MBTilesScheme m_Scheme;
       
       SQLite::Database  *m_pDB;
+      SQLite::Statement *m_pTileQuery;          // prepared tile fetch, when not using the decoder
+      mbTileDecoder     *m_pDecoder;            // background fetch and decode of tiles
       int       m_nTiles;
       
 private:
@@ -178,12 +178,16 @@ public:
       int LoadMyConfigRaw( bool bAsTemplate = false );
       
       void CreateRotatingNavObjBackup();
+
+      //    Parse navobj.xml on a worker thread, for LoadNavObjects() to take
+      void PreloadNavObjects();
       
       wxString                m_sNavObjSetFile;
       wxString                m_sNavObjSetChangesFile;
 
       NavObjectChanges        *m_pNavObjectChangesSet;
       NavObjectCollection1    *m_pNavObjectInputSet;
+      bool                    m_bNavObjectInputLoaded;
       bool                    m_bSkipChangeSetUpdate;
       
 };
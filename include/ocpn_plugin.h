@@ -66,7 +66,7 @@ class wxGLContext;
 //    PlugIns conforming to API Version less then the most modern will also
 //    be correctly supported.
 #define API_VERSION_MAJOR           1
-#define API_VERSION_MINOR           17
+#define API_VERSION_MINOR           18
 
 //    Fwd Definitions
 class       wxFileConfig;
@@ -589,6 +589,12 @@ public:
     /*Provide active leg data to plugins*/
     virtual void SetActiveLegInfo(Plugin_Active_Leg_Info &leg_info);
 };
+
+class DECL_EXP opencpn_plugin_118 : public opencpn_plugin_117
+{
+public:
+    opencpn_plugin_118(void *pmgr);
+};
 //------------------------------------------------------------------
 //      Route and Waypoint PlugIn support
 //
@@ -1383,4 +1389,15 @@ extern DECL_EXP int GetLatLonFormat(void);
 // API 1.17
 extern "C"  DECL_EXP void ZeroXTE();
 
+// API 1.18
+//
+//  A snapshot of the latest ownship fix and AIS targets, kept up to date by OpenCPN.
+//  It may be read at any time and from any thread, instead of parsing NMEA sentences
+//  or JSON messages.  The generation changes whenever the data does.
+//  GetPositionFixSnapshot returns false while there is no valid fix.
+//  GetAISTargetSnapshot copies at most max_targets targets, and returns how many there are.
+extern "C"  DECL_EXP bool GetPositionFixSnapshot(PlugIn_Position_Fix_Ex *pfix, unsigned int *pgeneration);
+extern "C"  DECL_EXP unsigned int GetAISTargetSnapshotGeneration(void);
+extern "C"  DECL_EXP int GetAISTargetSnapshot(PlugIn_AIS_Target *ptargets, int max_targets, unsigned int *pgeneration);
+
 #endif //_PLUGIN_H_
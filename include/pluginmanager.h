@@ -78,9 +78,11 @@
 //    Assorted static helper routines
 
 PlugIn_AIS_Target *Create_PI_AIS_Target(AIS_Target_Data *ptarget);
+void Fill_PI_AIS_Target(PlugIn_AIS_Target *pret, AIS_Target_Data *ptarget);
 
 class PluginListPanel;
 class PluginPanel;
+class PluginManifest;
 
 typedef struct {
     wxString name;      // name of the plugin
@@ -387,6 +389,8 @@ private:
       bool              m_benable_blackdialog;
       bool              m_benable_blackdialog_done;
       wxArrayString     m_deferred_blacklist_messages;
+
+      PluginManifest    *m_manifest;
       
       wxArrayString     m_plugin_order;
       void SetPluginOrder( wxString serialized_names );
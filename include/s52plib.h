@@ -200,6 +200,9 @@ public:
     bool GetGLPolygonSmoothing( ){ return m_GLPolygonSmoothing; }
     void SetGLLineSmoothing( bool bset ){ m_GLLineSmoothing = bset;}
     bool GetGLLineSmoothing( ){ return m_GLLineSmoothing; }
+    //  Cheaper, rougher rendering while the view moves, not part of the state hash
+    void SetDraftMode( bool bset ){ m_bDraftMode = bset; }
+    bool GetDraftMode( ){ return m_bDraftMode; }
 
     wxArrayOfLUPrec* SelectLUPARRAY( LUPname TNAM );
     LUPArrayContainer *SelectLUPArrayContainer( LUPname TNAM );
@@ -238,6 +241,7 @@ public:
     bool m_bExtendLightSectors;
     bool m_bShowS57ImportantTextOnly;
     bool m_bDeClutterText;
+    bool m_bDraftMode;
     bool m_bShowNationalTexts;
 
     int m_VersionMajor;
@@ -29,11 +29,14 @@
 
 #include <wx/arrstr.h>
 #include <map>
+#include <vector>
+#include <time.h>
 
 #include "Station_Data.h"
 #include "IDX_entry.h"
 #include "TC_Error_Code.h"
 #include "TCDataSource.h"
+#include "TCStationIndex.h"
 
 // ----------------------------------------------------------------------------
 // external C linkages
@@ -81,16 +84,81 @@ typedef struct {
 } mru_entry;
 
 
+//----------------------------------------------------------------------------
+//   TCPredictor
+//
+//   Tide/current prediction for one station.  The per year multipliers and
+//   the subordinate station MIN/MAX search state are private to the
+//   predictor, so separate predictors may run on separate threads.
+//----------------------------------------------------------------------------
+
+class TCPredictor
+{
+public:
+    TCPredictor(const IDX_entry *pIDX);
+
+    bool IsOk() const { return m_ncst > 0; }
+    //  False once the harmonic data of the entry was (re)loaded
+    bool IsFor(const IDX_entry *pIDX) const { return m_pIDX == pIDX && m_psd == pIDX->pref_sta_data; }
+
+    //  Denormalized level, with subordinate station offsets, at time t
+    double GetLevel(time_t t);
+
+    //  Levels at t0, t0 + step, ... t0 + (count - 1) * step
+    void GetLevels(time_t t0, int step, int count, float *values);
+
+    //  The MIN/MAX search is expensive, so callers predicting one value
+    //  at a time carry it across calls in the index entry
+    void LoadState(const IDX_entry *pIDX);
+    void SaveState(IDX_entry *pIDX) const;
+
+private:
+    struct YearCoefs {
+        int                 year;
+        time_t              epoch;
+        std::vector<double> mpy;        // normalized multipliers
+        std::vector<double> phase;      // constituent less station epoch
+    };
+
+    const YearCoefs &Coefs(int year);
+    double EvalTide(const YearCoefs &yc, time_t t, int deriv) const;
+    double BlendTide(time_t t, int deriv, int first_year, double blend);
+    double Tide(time_t t, int deriv = 0);
+    void   TideSeries(time_t t0, int step, int count, double *out);
+    double Mean(time_t t);
+    double Denormalize(double mpy) const;
+    int    NextBigEvent(time_t *tm);
+    double Secondary(time_t t);
+
+    const IDX_entry     *m_pIDX;
+    const Station_Data  *m_psd;
+    int                 m_ncst;
+    double              m_max_amplitude;
+
+    YearCoefs           m_coefs[3];
+    int                 m_next_slot;
+
+    time_t              m_lowtime, m_hightime;
+    double              m_lowlvl, m_highlvl;
+
+    std::vector<double> m_cos, m_sin, m_cosd, m_sind, m_series;
+};
+
+
 //----------------------------------------------------------------------------
 //   TCMgr
 //----------------------------------------------------------------------------
 
+class TCExtremaCache;
+class LLBBox;
+
 class TCMgr
 {
 public:
     TCMgr();
     ~TCMgr();
 
+    //  No GUI in here, so it may be run by a worker thread
     TC_Error_Code LoadDataSources(wxArrayString &sources);
     wxArrayString GetDataSet( void ) {
         return m_sourcefile_array;
@@ -102,6 +170,9 @@ public:
 
     bool GetTideOrCurrent(time_t t, int idx, float &value, float& dir);
     bool GetTideOrCurrent15(time_t t, int idx, float &tcvalue, float& dir, bool &bnew_val);
+    bool GetTideOrCurrentSeries(time_t t0, int step, int count, int idx, float *values, float *dirs = NULL);
+    void GetTideOrCurrentSeries(time_t t0, int step, int count, const std::vector<int> &stations,
+                                std::vector<float> &values);
     bool GetTideFlowSens(time_t t, int sch_step, int idx, float &tcvalue_now, float &tcvalue_prev, bool &w_t);
     void GetHightOrLowTide(time_t t, int sch_step_1, int sch_step_2, float tide_val ,bool w_t , int idx, float &tcvalue, time_t &tctime);
 
@@ -117,13 +188,17 @@ public:
         return m_Combined_IDX_array.GetCount()-1;
     }
 
-    std::map<double, const IDX_entry*> GetStationsForLL(double xlat, double xlon) const;
+    void GetStationsInBBox(const LLBBox &box, double marge, bool bcurrents, std::vector<int> &stations) const;
+    std::map<double, const IDX_entry*> GetStationsForLL(double xlat, double xlon, int max_stations = 0) const;
     
     int GetStationIDXbyName(const wxString & prefix, double xlat, double xlon) const;
     int GetStationIDXbyNameType(const wxString & prefix, double xlat, double xlon, char type) const;
 
 private:
     void PurgeData();
+    IDX_entry *GetPredictionEntry(int idx);
+    TCPredictor *GetPredictor(IDX_entry *pIDX);
+    void RequestExtrema(int idx, time_t t);
 
     void LoadMRU(void);
     void SaveMRU(void);
@@ -138,6 +213,14 @@ private:
 
     ArrayOfIDXEntry     m_Combined_IDX_array;
 
+    TCExtremaCache      *m_pExtrema;
+
+    enum { MAX_PREDICTORS = 256 };
+    std::map<const IDX_entry *, TCPredictor> m_predictors;
+
+    TCStationIndex      m_tide_index;
+    TCStationIndex      m_current_index;
+
 };
 
 /* $Id: tcd.h.in 3744 2010-08-17 22:34:46Z flaterco $ */
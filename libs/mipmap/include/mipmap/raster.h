@@ -0,0 +1,87 @@
+/******************************************************************************
+ *
+ * Project:  OpenCPN
+ * Purpose:  Per pixel raster kernels for chart textures
+ * Author:   David S. Register
+ *
+ ***************************************************************************
+ *   Copyright (C) 2020 by David S. Register                               *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301,  USA.         *
+ ***************************************************************************
+ */
+
+#ifndef __RASTER_H__
+#define __RASTER_H__
+
+/*  Pixel format conversions used when building chart textures.
+ *  Like the mipmap routines these are function pointers which
+ *  MipMap_ResolveRoutines() points at the fastest version the cpu
+ *  supports.  Packed colours are r | g << 8 | b << 16.
+ */
+
+#ifdef  __cplusplus
+extern "C" {
+#endif
+
+//  Scale every channel of npixels rgb pixels in place by level/256
+//  (256 leaves them unchanged).  For rgb this is the same as scaling
+//  the hsv value, so it implements the dusk and night dimming.
+extern void (*Raster_Dim_24)( int npixels, unsigned char *data, int level );
+
+//  Write npixels copies of the packed colour rgb as 3 byte pixels.
+//  Exactly 3*npixels bytes are written.
+extern void (*Raster_Fill_24)( int npixels, unsigned char *target, unsigned int rgb );
+
+//  Expand rgb to rgba.  Alpha comes from the alpha plane if given,
+//  otherwise 255, and pixels equal to the packed colour key (if key >= 0)
+//  get alpha 0.
+extern void (*Raster_RGB24_RGBA32)( int npixels, const unsigned char *source,
+                                    const unsigned char *alpha, int key,
+                                    unsigned char *target );
+
+//  Drop the alpha channel of rgba pixels.
+extern void (*Raster_RGBA32_RGB24)( int npixels, const unsigned char *source,
+                                    unsigned char *target );
+
+void Raster_Dim_24_generic( int npixels, unsigned char *data, int level );
+void Raster_Fill_24_generic( int npixels, unsigned char *target, unsigned int rgb );
+void Raster_RGB24_RGBA32_generic( int npixels, const unsigned char *source,
+                                  const unsigned char *alpha, int key,
+                                  unsigned char *target );
+void Raster_RGBA32_RGB24_generic( int npixels, const unsigned char *source,
+                                  unsigned char *target );
+
+void Raster_Dim_24_sse2( int npixels, unsigned char *data, int level );
+void Raster_Fill_24_sse2( int npixels, unsigned char *target, unsigned int rgb );
+void Raster_RGB24_RGBA32_ssse3( int npixels, const unsigned char *source,
+                                const unsigned char *alpha, int key,
+                                unsigned char *target );
+void Raster_RGBA32_RGB24_ssse3( int npixels, const unsigned char *source,
+                                unsigned char *target );
+void Raster_Dim_24_avx2( int npixels, unsigned char *data, int level );
+
+void Raster_Dim_24_neon( int npixels, unsigned char *data, int level );
+void Raster_RGB24_RGBA32_neon( int npixels, const unsigned char *source,
+                               const unsigned char *alpha, int key,
+                               unsigned char *target );
+void Raster_RGBA32_RGB24_neon( int npixels, const unsigned char *source,
+                               unsigned char *target );
+
+#ifdef  __cplusplus
+}
+#endif
+#endif
@@ -30,6 +30,7 @@
 #include <string.h>
 
 #include "mipmap.h"
+#include "raster.h"
 
 #ifdef __MSVC__
 
@@ -40,6 +41,10 @@ static void cpuid(int32_t out[4], int32_t x) {
     __cpuidex(out,x,0);
 }
 
+static uint64_t xgetbv0() {
+    return _xgetbv(0);
+}
+
 #else
 # if defined(__x86_64__) || defined(__i686__)
 
@@ -54,6 +59,12 @@ static void cpuid(int32_t out[4], int32_t x){
     );
 }
 
+static uint64_t xgetbv0() {
+    uint32_t eax, edx;
+    __asm__ __volatile__ ( ".byte 0x0f, 0x01, 0xd0" : "=a" (eax), "=d" (edx) : "c" (0) );
+    return ((uint64_t)edx << 32) | eax;
+}
+
 #if !defined( __WXOSX__ ) 
 #include <cpuid.h>
 #endif
@@ -144,6 +155,26 @@ void MipMap_ResolveRoutines()
 
         if(info[2] & bit_SSSE3)
             MipMap_24 = MipMap_24_ssse3;
+
+        if(info[3] & bit_SSE2) {
+            Raster_Dim_24 = Raster_Dim_24_sse2;
+            Raster_Fill_24 = Raster_Fill_24_sse2;
+        }
+
+        if(info[2] & bit_SSSE3) {
+            Raster_RGB24_RGBA32 = Raster_RGB24_RGBA32_ssse3;
+            Raster_RGBA32_RGB24 = Raster_RGBA32_RGB24_ssse3;
+        }
+
+        // the raster avx2 kernels are always built, but need the os
+        // to save the ymm registers (osxsave, avx and xcr0 bits 1,2)
+        int avx_os = (info[2] & (1 << 27)) && (info[2] & (1 << 28)) &&
+                     (xgetbv0() & 6) == 6;
+        if (avx_os && nIds >= 0x00000007) {
+            cpuid(info,0x00000007);
+            if(info[1] & bit_AVX2)
+                Raster_Dim_24 = Raster_Dim_24_avx2;
+        }
     }
     
 #if defined(__AVX2__) || (defined(__MSVC__) &&  (_MSC_VER >= 1700))
@@ -160,5 +191,9 @@ void MipMap_ResolveRoutines()
 #if defined(__ARM_NEON) || defined(__ARM_NEON_FP)
     MipMap_24 = MipMap_24_neon;
     MipMap_32 = MipMap_32_neon;
+
+    Raster_Dim_24 = Raster_Dim_24_neon;
+    Raster_RGB24_RGBA32 = Raster_RGB24_RGBA32_neon;
+    Raster_RGBA32_RGB24 = Raster_RGBA32_RGB24_neon;
 #endif
 }
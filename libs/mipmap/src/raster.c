@@ -0,0 +1,107 @@
+/******************************************************************************
+ *
+ * Project:  OpenCPN
+ * Purpose:  Per pixel raster kernels for chart textures
+ * Author:   David S. Register
+ *
+ ***************************************************************************
+ *   Copyright (C) 2020 by David S. Register                               *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301,  USA.         *
+ ***************************************************************************
+ */
+
+#include <stdint.h>
+#include <string.h>
+
+#include "raster.h"
+
+void Raster_Dim_24_generic( int npixels, unsigned char *data, int level )
+{
+    if(level >= 256)
+        return;
+
+    int n = 3 * npixels, i;
+    for( i = 0; i < n; i++ )
+        data[i] = (data[i] * level) >> 8;
+}
+
+void Raster_Fill_24_generic( int npixels, unsigned char *target, unsigned int rgb )
+{
+    unsigned char px[3] = { (unsigned char)rgb, (unsigned char)(rgb >> 8), (unsigned char)(rgb >> 16) };
+
+    if(npixels < 16) {
+        while(npixels--) {
+            memcpy(target, px, 3);
+            target += 3;
+        }
+        return;
+    }
+
+    // build 24 bytes (8 pixels) then copy that in blocks
+    unsigned char block[24];
+    int i;
+    for( i = 0; i < 8; i++ )
+        memcpy(block + 3*i, px, 3);
+
+    int nblocks = npixels >> 3;
+    for( i = 0; i < nblocks; i++ ) {
+        memcpy(target, block, 24);
+        target += 24;
+    }
+
+    memcpy(target, block, 3*(npixels & 7));
+}
+
+void Raster_RGB24_RGBA32_generic( int npixels, const unsigned char *source,
+                                  const unsigned char *alpha, int key,
+                                  unsigned char *target )
+{
+    int i;
+    for( i = 0; i < npixels; i++ ) {
+        unsigned char r = source[0], g = source[1], b = source[2];
+        target[0] = r;
+        target[1] = g;
+        target[2] = b;
+        if(key >= 0 && (int)(r | g << 8 | b << 16) == key)
+            target[3] = 0;
+        else
+            target[3] = alpha ? alpha[i] : 255;
+        source += 3;
+        target += 4;
+    }
+}
+
+void Raster_RGBA32_RGB24_generic( int npixels, const unsigned char *source,
+                                  unsigned char *target )
+{
+    int i;
+    for( i = 0; i < npixels; i++ ) {
+        target[0] = source[0];
+        target[1] = source[1];
+        target[2] = source[2];
+        source += 4;
+        target += 3;
+    }
+}
+
+void (*Raster_Dim_24)( int npixels, unsigned char *data, int level ) = Raster_Dim_24_generic;
+void (*Raster_Fill_24)( int npixels, unsigned char *target, unsigned int rgb ) = Raster_Fill_24_generic;
+void (*Raster_RGB24_RGBA32)( int npixels, const unsigned char *source,
+                             const unsigned char *alpha, int key,
+                             unsigned char *target ) = Raster_RGB24_RGBA32_generic;
+void (*Raster_RGBA32_RGB24)( int npixels, const unsigned char *source,
+                             unsigned char *target ) = Raster_RGBA32_RGB24_generic;
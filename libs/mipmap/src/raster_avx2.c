@@ -0,0 +1,64 @@
+/******************************************************************************
+ *
+ * Project:  OpenCPN
+ * Purpose:  Per pixel raster kernels for chart textures
+ * Author:   David S. Register
+ *
+ ***************************************************************************
+ *   Copyright (C) 2020 by David S. Register                               *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301,  USA.         *
+ ***************************************************************************
+ */
+
+#include <string.h>
+#include "raster.h"
+
+#if defined(__AVX2__) || (defined(__MSVC__) &&  (_MSC_VER >= 1700))
+
+#include <immintrin.h>
+
+void Raster_Dim_24_avx2( int npixels, unsigned char *data, int level )
+{
+    if(level >= 256)
+        return;
+
+    int n = 3 * npixels, i = 0;
+    __m256i z = _mm256_setzero_si256();
+    __m256i l = _mm256_set1_epi16(level);
+
+    // unpack and pack both work within 128 bit lanes so the order is kept
+    for( ; i + 32 <= n; i += 32 ) {
+        __m256i v = _mm256_loadu_si256((__m256i*)(data + i));
+        __m256i lo = _mm256_unpacklo_epi8(v, z);
+        __m256i hi = _mm256_unpackhi_epi8(v, z);
+        lo = _mm256_srli_epi16(_mm256_mullo_epi16(lo, l), 8);
+        hi = _mm256_srli_epi16(_mm256_mullo_epi16(hi, l), 8);
+        _mm256_storeu_si256((__m256i*)(data + i), _mm256_packus_epi16(lo, hi));
+    }
+
+    for( ; i < n; i++ )
+        data[i] = (data[i] * level) >> 8;
+}
+
+#else
+
+void Raster_Dim_24_avx2( int npixels, unsigned char *data, int level )
+{
+    Raster_Dim_24_sse2(npixels, data, level);
+}
+
+#endif
@@ -0,0 +1,118 @@
+/******************************************************************************
+ *
+ * Project:  OpenCPN
+ * Purpose:  Per pixel raster kernels for chart textures
+ * Author:   David S. Register
+ *
+ ***************************************************************************
+ *   Copyright (C) 2020 by David S. Register                               *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301,  USA.         *
+ ***************************************************************************
+ */
+
+#include <string.h>
+#include "raster.h"
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON_FP)
+#include <arm_neon.h>
+
+void Raster_Dim_24_neon( int npixels, unsigned char *data, int level )
+{
+    if(level >= 256)
+        return;
+
+    int n = 3 * npixels, i = 0;
+    uint8x8_t l = vdup_n_u8(level);
+
+    for( ; i + 16 <= n; i += 16 ) {
+        uint8x16_t v = vld1q_u8(data + i);
+        uint16x8_t lo = vmull_u8(vget_low_u8(v), l);
+        uint16x8_t hi = vmull_u8(vget_high_u8(v), l);
+        vst1q_u8(data + i, vcombine_u8(vshrn_n_u16(lo, 8), vshrn_n_u16(hi, 8)));
+    }
+
+    for( ; i < n; i++ )
+        data[i] = (data[i] * level) >> 8;
+}
+
+void Raster_RGB24_RGBA32_neon( int npixels, const unsigned char *source,
+                               const unsigned char *alpha, int key,
+                               unsigned char *target )
+{
+    uint8x16_t kr = vdupq_n_u8(key & 0xff);
+    uint8x16_t kg = vdupq_n_u8((key >> 8) & 0xff);
+    uint8x16_t kb = vdupq_n_u8((key >> 16) & 0xff);
+
+    int i = 0;
+    for( ; i + 16 <= npixels; i += 16 ) {
+        uint8x16x3_t v = vld3q_u8(source + 3*i);
+        uint8x16x4_t t;
+        t.val[0] = v.val[0];
+        t.val[1] = v.val[1];
+        t.val[2] = v.val[2];
+        t.val[3] = alpha ? vld1q_u8(alpha + i) : vdupq_n_u8(255);
+
+        if(key >= 0) {
+            uint8x16_t eq = vandq_u8(vandq_u8(vceqq_u8(v.val[0], kr), vceqq_u8(v.val[1], kg)),
+                                     vceqq_u8(v.val[2], kb));
+            t.val[3] = vbicq_u8(t.val[3], eq);
+        }
+
+        vst4q_u8(target + 4*i, t);
+    }
+
+    Raster_RGB24_RGBA32_generic(npixels - i, source + 3*i, alpha ? alpha + i : NULL,
+                                key, target + 4*i);
+}
+
+void Raster_RGBA32_RGB24_neon( int npixels, const unsigned char *source,
+                               unsigned char *target )
+{
+    int i = 0;
+    for( ; i + 16 <= npixels; i += 16 ) {
+        uint8x16x4_t v = vld4q_u8(source + 4*i);
+        uint8x16x3_t t;
+        t.val[0] = v.val[0];
+        t.val[1] = v.val[1];
+        t.val[2] = v.val[2];
+        vst3q_u8(target + 3*i, t);
+    }
+
+    Raster_RGBA32_RGB24_generic(npixels - i, source + 4*i, target + 3*i);
+}
+
+#else
+
+void Raster_Dim_24_neon( int npixels, unsigned char *data, int level )
+{
+    Raster_Dim_24_generic(npixels, data, level);
+}
+
+void Raster_RGB24_RGBA32_neon( int npixels, const unsigned char *source,
+                               const unsigned char *alpha, int key,
+                               unsigned char *target )
+{
+    Raster_RGB24_RGBA32_generic(npixels, source, alpha, key, target);
+}
+
+void Raster_RGBA32_RGB24_neon( int npixels, const unsigned char *source,
+                               unsigned char *target )
+{
+    Raster_RGBA32_RGB24_generic(npixels, source, target);
+}
+
+#endif
@@ -0,0 +1,94 @@
+/******************************************************************************
+ *
+ * Project:  OpenCPN
+ * Purpose:  Per pixel raster kernels for chart textures
+ * Author:   David S. Register
+ *
+ ***************************************************************************
+ *   Copyright (C) 2020 by David S. Register                               *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301,  USA.         *
+ ***************************************************************************
+ */
+
+#include <string.h>
+#include "raster.h"
+
+#if defined(__SSE2__) || (defined(__MSVC__) &&  (_MSC_VER >= 1700))
+
+#include <emmintrin.h>
+
+void Raster_Dim_24_sse2( int npixels, unsigned char *data, int level )
+{
+    if(level >= 256)
+        return;
+
+    int n = 3 * npixels, i = 0;
+    __m128i z = _mm_setzero_si128();
+    __m128i l = _mm_set1_epi16(level);
+
+    // the channels are all scaled the same so ignore pixel boundaries
+    for( ; i + 16 <= n; i += 16 ) {
+        __m128i v = _mm_loadu_si128((__m128i*)(data + i));
+        __m128i lo = _mm_unpacklo_epi8(v, z);
+        __m128i hi = _mm_unpackhi_epi8(v, z);
+        lo = _mm_srli_epi16(_mm_mullo_epi16(lo, l), 8);
+        hi = _mm_srli_epi16(_mm_mullo_epi16(hi, l), 8);
+        _mm_storeu_si128((__m128i*)(data + i), _mm_packus_epi16(lo, hi));
+    }
+
+    for( ; i < n; i++ )
+        data[i] = (data[i] * level) >> 8;
+}
+
+void Raster_Fill_24_sse2( int npixels, unsigned char *target, unsigned int rgb )
+{
+    if(npixels < 32) {
+        Raster_Fill_24_generic(npixels, target, rgb);
+        return;
+    }
+
+    // 16 pixels fill exactly three registers
+    unsigned char block[48];
+    Raster_Fill_24_generic(16, block, rgb);
+    __m128i a0 = _mm_loadu_si128((__m128i*)block);
+    __m128i a1 = _mm_loadu_si128((__m128i*)(block + 16));
+    __m128i a2 = _mm_loadu_si128((__m128i*)(block + 32));
+
+    int nblocks = npixels >> 4, i;
+    for( i = 0; i < nblocks; i++ ) {
+        _mm_storeu_si128((__m128i*)target, a0);
+        _mm_storeu_si128((__m128i*)(target + 16), a1);
+        _mm_storeu_si128((__m128i*)(target + 32), a2);
+        target += 48;
+    }
+
+    memcpy(target, block, 3*(npixels & 15));
+}
+
+#else
+
+void Raster_Dim_24_sse2( int npixels, unsigned char *data, int level )
+{
+    Raster_Dim_24_generic(npixels, data, level);
+}
+
+void Raster_Fill_24_sse2( int npixels, unsigned char *target, unsigned int rgb )
+{
+    Raster_Fill_24_generic(npixels, target, rgb);
+}
+
+#endif
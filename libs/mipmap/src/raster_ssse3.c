@@ -0,0 +1,100 @@
+/******************************************************************************
+ *
+ * Project:  OpenCPN
+ * Purpose:  Per pixel raster kernels for chart textures
+ * Author:   David S. Register
+ *
+ ***************************************************************************
+ *   Copyright (C) 2020 by David S. Register                               *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301,  USA.         *
+ ***************************************************************************
+ */
+
+#include <string.h>
+#include "raster.h"
+
+#if defined(__SSSE3__) || (defined(__MSVC__) &&  (_MSC_VER >= 1700))
+
+#include <tmmintrin.h>
+
+void Raster_RGB24_RGBA32_ssse3( int npixels, const unsigned char *source,
+                                const unsigned char *alpha, int key,
+                                unsigned char *target )
+{
+    const char Z = (char)0x80;
+    __m128i expand = _mm_set_epi8(Z, 11, 10, 9, Z, 8, 7, 6, Z, 5, 4, 3, Z, 2, 1, 0);
+    __m128i spread = _mm_set_epi8(3, Z, Z, Z, 2, Z, Z, Z, 1, Z, Z, Z, 0, Z, Z, Z);
+    __m128i rgbmask = _mm_set1_epi32(0x00ffffff);
+    __m128i opaque = _mm_set1_epi32((int)0xff000000);
+    __m128i vkey = _mm_set1_epi32(key);
+
+    // 4 pixels at a time, the 16 byte load reads 4 bytes past the pixels
+    // so stop while at least 6 pixels remain
+    int i = 0;
+    for( ; i + 6 <= npixels; i += 4 ) {
+        __m128i v = _mm_shuffle_epi8(_mm_loadu_si128((__m128i*)(source + 3*i)), expand);
+
+        __m128i a;
+        if(alpha) {
+            int a4;
+            memcpy(&a4, alpha + i, 4);
+            a = _mm_shuffle_epi8(_mm_cvtsi32_si128(a4), spread);
+        } else
+            a = opaque;
+
+        if(key >= 0)
+            a = _mm_andnot_si128(_mm_cmpeq_epi32(v, vkey), a);
+
+        _mm_storeu_si128((__m128i*)(target + 4*i), _mm_or_si128(_mm_and_si128(v, rgbmask), a));
+    }
+
+    Raster_RGB24_RGBA32_generic(npixels - i, source + 3*i, alpha ? alpha + i : NULL,
+                                key, target + 4*i);
+}
+
+void Raster_RGBA32_RGB24_ssse3( int npixels, const unsigned char *source,
+                                unsigned char *target )
+{
+    const char Z = (char)0x80;
+    __m128i pack = _mm_set_epi8(Z, Z, Z, Z, 14, 13, 12, 10, 9, 8, 6, 5, 4, 2, 1, 0);
+
+    // the 16 byte store writes 4 bytes past the 4 pixels
+    int i = 0;
+    for( ; i + 6 <= npixels; i += 4 ) {
+        __m128i v = _mm_loadu_si128((__m128i*)(source + 4*i));
+        _mm_storeu_si128((__m128i*)(target + 3*i), _mm_shuffle_epi8(v, pack));
+    }
+
+    Raster_RGBA32_RGB24_generic(npixels - i, source + 4*i, target + 3*i);
+}
+
+#else
+
+void Raster_RGB24_RGBA32_ssse3( int npixels, const unsigned char *source,
+                                const unsigned char *alpha, int key,
+                                unsigned char *target )
+{
+    Raster_RGB24_RGBA32_generic(npixels, source, alpha, key, target);
+}
+
+void Raster_RGBA32_RGB24_ssse3( int npixels, const unsigned char *source,
+                                unsigned char *target )
+{
+    Raster_RGBA32_RGB24_generic(npixels, source, target);
+}
+
+#endif
@@ -0,0 +1,132 @@
+/******************************************************************************
+ *
+ * Project:  OpenCPN
+ * Purpose:  Block gather for dxt1 compression, generic and cpu dispatch
+ *
+ ***************************************************************************
+ *   Copyright (C) 2020 by David S. Register                               *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301,  USA.         *
+ ***************************************************************************
+ */
+
+#include <string.h>
+#include <stdint.h>
+
+#include "blockfetch.h"
+
+#ifdef __MSVC__
+
+#include <intrin.h>
+
+static void cpuid(int32_t out[4], int32_t x) {
+    __cpuidex((int *)out, x, 0);
+}
+
+static uint64_t xgetbv0() {
+    return _xgetbv(0);
+}
+
+#define HAVE_CPUID 1
+
+#elif defined(__x86_64__) || defined(__i686__)
+
+static void cpuid(int32_t out[4], int32_t x) {
+    __asm__ __volatile__ (
+        "cpuid":
+        "=a" (out[0]),
+        "=b" (out[1]),
+        "=c" (out[2]),
+        "=d" (out[3])
+        : "a" (x), "c" (0)
+    );
+}
+
+static uint64_t xgetbv0() {
+    uint32_t eax, edx;
+    __asm__ __volatile__ ( ".byte 0x0f, 0x01, 0xd0" : "=a" (eax), "=d" (edx) : "c" (0) );
+    return ((uint64_t)edx << 32) | eax;
+}
+
+#define HAVE_CPUID 1
+
+#endif
+
+namespace squish {
+
+void FetchBlock_generic( u8 const* rgb, int width, int height, int x, int y,
+                         u8 const* flat, u8* rgba, u8* uniform )
+{
+    int bw = width < 4 ? width : 4;
+    int bh = height < 4 ? height : 4;
+
+    u8* t = rgba;
+    for( int py = 0; py < 4; ++py ) {
+        for( int px = 0; px < 4; ++px ) {
+            u8 const* s = rgb + 3*( width*( y + py % bh ) + x + px % bw );
+            *t++ = s[0] & flat[0];
+            *t++ = s[1] & flat[1];
+            *t++ = s[2] & flat[2];
+            *t++ = 255;
+        }
+    }
+
+    u8 same = 1;
+    for( int i = 4; i < 64; i += 4 )
+        if( memcmp( rgba, rgba + i, 3 ) ) {
+            same = 0;
+            break;
+        }
+    *uniform = same;
+}
+
+void FetchBlockRow_generic( u8 const* rgb, int width, int height, int y,
+                            u8 const* flat, u8* rgba, u8* uniform )
+{
+    for( int x = 0; x < width; x += 4 )
+        FetchBlock_generic( rgb, width, height, x, y, flat, rgba + 16*x, uniform++ );
+}
+
+FetchBlockRowFn FetchBlockRow = FetchBlockRow_generic;
+
+void FetchBlockRow_ResolveRoutines()
+{
+#ifdef HAVE_CPUID
+    int32_t info[4];
+    cpuid(info, 0);
+    int nIds = info[0];
+
+    if( nIds < 1 )
+        return;
+
+    cpuid(info, 1);
+    bool ssse3 = ( info[2] & ( 1 << 9 ) ) != 0;
+    bool osxsave = ( info[2] & ( 1 << 27 ) ) != 0;
+    bool avx = ( info[2] & ( 1 << 28 ) ) != 0;
+
+    if( ssse3 )
+        FetchBlockRow = FetchBlockRow_ssse3;
+
+    //  avx2 also needs the os to preserve the ymm registers
+    if( nIds >= 7 && osxsave && avx && ( xgetbv0() & 6 ) == 6 ) {
+        cpuid(info, 7);
+        if( info[1] & ( 1 << 5 ) )
+            FetchBlockRow = FetchBlockRow_avx2;
+    }
+#endif
+}
+
+} // namespace squish
@@ -0,0 +1,58 @@
+/******************************************************************************
+ *
+ * Project:  OpenCPN
+ * Purpose:  Gather rgb scanlines into 4x4 rgba blocks for dxt1 compression
+ *
+ ***************************************************************************
+ *   Copyright (C) 2020 by David S. Register                               *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301,  USA.         *
+ ***************************************************************************
+ */
+
+#ifndef SQUISH_BLOCKFETCH_H
+#define SQUISH_BLOCKFETCH_H
+
+#include "squish.h"
+
+namespace squish {
+
+/*  Gather the row of 4x4 blocks starting at scanline y of a packed rgb image
+ *  into consecutive 64 byte rgba blocks, masking each channel with flat[]
+ *  and setting alpha to 255.  uniform[i] is set when all 16 pixels of
+ *  block i came out the same, which lets the caller skip the colour fit.
+ *  Images narrower or shorter than a block are wrapped as squish does.
+ */
+typedef void (*FetchBlockRowFn)( u8 const* rgb, int width, int height, int y,
+                                 u8 const* flat, u8* rgba, u8* uniform );
+
+extern FetchBlockRowFn FetchBlockRow;
+
+void FetchBlockRow_ResolveRoutines();
+
+void FetchBlock_generic( u8 const* rgb, int width, int height, int x, int y,
+                         u8 const* flat, u8* rgba, u8* uniform );
+
+void FetchBlockRow_generic( u8 const* rgb, int width, int height, int y,
+                            u8 const* flat, u8* rgba, u8* uniform );
+void FetchBlockRow_ssse3( u8 const* rgb, int width, int height, int y,
+                          u8 const* flat, u8* rgba, u8* uniform );
+void FetchBlockRow_avx2( u8 const* rgb, int width, int height, int y,
+                         u8 const* flat, u8* rgba, u8* uniform );
+
+} // namespace squish
+
+#endif // ndef SQUISH_BLOCKFETCH_H
@@ -0,0 +1,102 @@
+/******************************************************************************
+ *
+ * Project:  OpenCPN
+ * Purpose:  AVX2 block gather for dxt1 compression
+ *
+ ***************************************************************************
+ *   Copyright (C) 2020 by David S. Register                               *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301,  USA.         *
+ ***************************************************************************
+ */
+
+#include <string.h>
+#include <stdint.h>
+
+#include "blockfetch.h"
+
+#if defined(__AVX2__) || (defined(__MSVC__) && (_MSC_VER >= 1700))
+#include <immintrin.h>
+#define HAVE_AVX2 1
+#endif
+
+namespace squish {
+
+#ifdef HAVE_AVX2
+
+// same as the ssse3 version but expands two neighbouring blocks per
+// instruction, one in each 128 bit lane
+void FetchBlockRow_avx2( u8 const* rgb, int width, int height, int y,
+                         u8 const* flat, u8* rgba, u8* uniform )
+{
+    if( width < 12 || height < 4 ) {
+        FetchBlockRow_generic( rgb, width, height, y, flat, rgba, uniform );
+        return;
+    }
+
+    const char Z = (char)0x80;
+    const __m256i shuf = _mm256_set_epi8( Z, 11, 10, 9, Z, 8, 7, 6, Z, 5, 4, 3, Z, 2, 1, 0,
+                                          Z, 11, 10, 9, Z, 8, 7, 6, Z, 5, 4, 3, Z, 2, 1, 0 );
+    const __m256i mask = _mm256_set1_epi32( flat[0] | ( flat[1] << 8 ) | ( flat[2] << 16 ) );
+    const __m256i alpha = _mm256_set1_epi32( (int)0xff000000 );
+
+    int stride = 3*width;
+    int nblocks = width / 4;
+    u8 const* row = rgb + stride*y;
+
+    //  pairs of blocks, never loading from the last block of the scanline
+    int bx = 0;
+    for( ; bx + 2 < nblocks; bx += 2 ) {
+        u8 const* s = row + 12*bx;
+        u8* t = rgba + 64*bx;
+        __m256i first = _mm256_setzero_si256(), eq = _mm256_set1_epi32( -1 );
+
+        for( int py = 0; py < 4; py++ ) {
+            u8 const* p = s + py*stride;
+            __m256i v = _mm256_inserti128_si256(
+                _mm256_castsi128_si256( _mm_loadu_si128( (__m128i const*)p ) ),
+                _mm_loadu_si128( (__m128i const*)( p + 12 ) ), 1 );
+            v = _mm256_shuffle_epi8( v, shuf );
+            v = _mm256_or_si256( _mm256_and_si256( v, mask ), alpha );
+
+            _mm_storeu_si128( (__m128i*)( t + 16*py ), _mm256_castsi256_si128( v ) );
+            _mm_storeu_si128( (__m128i*)( t + 64 + 16*py ), _mm256_extracti128_si256( v, 1 ) );
+
+            if( py == 0 )
+                first = _mm256_shuffle_epi32( v, 0 );
+            eq = _mm256_and_si256( eq, _mm256_cmpeq_epi32( v, first ) );
+        }
+
+        unsigned int m = (unsigned int)_mm256_movemask_epi8( eq );
+        uniform[bx] = ( m & 0xffff ) == 0xffff;
+        uniform[bx + 1] = ( m >> 16 ) == 0xffff;
+    }
+
+    for( ; bx < nblocks; bx++ )
+        FetchBlock_generic( rgb, width, height, 4*bx, y, flat, rgba + 64*bx, uniform + bx );
+}
+
+#else
+
+void FetchBlockRow_avx2( u8 const* rgb, int width, int height, int y,
+                         u8 const* flat, u8* rgba, u8* uniform )
+{
+    FetchBlockRow_generic( rgb, width, height, y, flat, rgba, uniform );
+}
+
+#endif
+
+} // namespace squish
@@ -0,0 +1,93 @@
+/******************************************************************************
+ *
+ * Project:  OpenCPN
+ * Purpose:  SSSE3 block gather for dxt1 compression
+ *
+ ***************************************************************************
+ *   Copyright (C) 2020 by David S. Register                               *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301,  USA.         *
+ ***************************************************************************
+ */
+
+#include <string.h>
+#include <stdint.h>
+
+#include "blockfetch.h"
+
+#if defined(__SSSE3__) || (defined(__MSVC__) && (_MSC_VER >= 1700))
+#include <tmmintrin.h>
+#define HAVE_SSSE3 1
+#endif
+
+namespace squish {
+
+#ifdef HAVE_SSSE3
+
+// expand one scanline of a block (4 rgb pixels) into rgba, four times faster
+// than the generic byte loop and detects single colour blocks for free
+void FetchBlockRow_ssse3( u8 const* rgb, int width, int height, int y,
+                          u8 const* flat, u8* rgba, u8* uniform )
+{
+    if( width < 8 || height < 4 ) {
+        FetchBlockRow_generic( rgb, width, height, y, flat, rgba, uniform );
+        return;
+    }
+
+    const char Z = (char)0x80;
+    const __m128i shuf = _mm_set_epi8( Z, 11, 10, 9, Z, 8, 7, 6, Z, 5, 4, 3, Z, 2, 1, 0 );
+    const __m128i mask = _mm_set1_epi32( flat[0] | ( flat[1] << 8 ) | ( flat[2] << 16 ) );
+    const __m128i alpha = _mm_set1_epi32( (int)0xff000000 );
+
+    int stride = 3*width;
+    int nblocks = width / 4;
+    u8 const* row = rgb + stride*y;
+
+    //  the last block of each scanline is left to the generic code
+    //  so the 16 byte loads never run past the end of the image
+    for( int bx = 0; bx < nblocks - 1; bx++ ) {
+        u8 const* s = row + 12*bx;
+        u8* t = rgba + 64*bx;
+        __m128i first = _mm_setzero_si128(), eq = _mm_set1_epi32( -1 );
+
+        for( int py = 0; py < 4; py++ ) {
+            __m128i v = _mm_loadu_si128( (__m128i const*)( s + py*stride ) );
+            v = _mm_shuffle_epi8( v, shuf );
+            v = _mm_or_si128( _mm_and_si128( v, mask ), alpha );
+            _mm_storeu_si128( (__m128i*)( t + 16*py ), v );
+
+            if( py == 0 )
+                first = _mm_shuffle_epi32( v, 0 );
+            eq = _mm_and_si128( eq, _mm_cmpeq_epi32( v, first ) );
+        }
+        uniform[bx] = _mm_movemask_epi8( eq ) == 0xffff;
+    }
+
+    FetchBlock_generic( rgb, width, height, 4*( nblocks - 1 ), y, flat,
+                        rgba + 64*( nblocks - 1 ), uniform + nblocks - 1 );
+}
+
+#else
+
+void FetchBlockRow_ssse3( u8 const* rgb, int width, int height, int y,
+                          u8 const* flat, u8* rgba, u8* uniform )
+{
+    FetchBlockRow_generic( rgb, width, height, y, flat, rgba, uniform );
+}
+
+#endif
+
+} // namespace squish
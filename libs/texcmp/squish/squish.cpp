@@ -25,6 +25,8 @@
 
 #include <stdio.h>
 #include <stdint.h>
+#include <string.h>
+#include <vector>
    
 #include "squish.h"
 #include "colourset.h"
@@ -36,6 +38,7 @@
 #include "singlecolourfit.h"
 #include "singlecolourfitfast.h"
 #include "twocolourfitfast.h"
+#include "blockfetch.h"
 #include <wx/thread.h>
 
 extern bool g_throttle_squish;
@@ -285,61 +288,56 @@ void CompressImageRGB( u8 const* rgb, int width, int height, void* blocks, int f
         }
 }
 
-void CompressImageRGBpow2_Flatten_Throttle_Abort( u8 const* rgb, int width, int height, void* blocks, int flags,
-                                                  bool b_flatten, void (*throttle)(void*), void *throttle_data, volatile bool &b_abort )
+// writes the same block as SingleColourFitFast::Compress3 without
+// building a colour set first
+static void CompressSingleColour_dxt1( u8 const* rgba, void* block )
+{
+    u8* bytes = ( u8* )block;
+    int a = (rgba[0] << 8) | (rgba[1] << 3) | (rgba[2] >> 3);
+
+    bytes[0] = ( u8 )( a & 0xff );
+    bytes[1] = ( u8 )( a >> 8 );
+    memset(bytes + 2, 0, 6);
+}
+
+static struct FetchBlockRowInit {
+    FetchBlockRowInit() { FetchBlockRow_ResolveRoutines(); }
+} s_fetch_block_row_init;
+
+void CompressImageRGBpow2_Flatten_Throttle_Abort_Rows( u8 const* rgb, int width, int height, void* blocks, int flags,
+                                                       bool b_flatten, int y0, int y1,
+                                                       void (*throttle)(void*), void *throttle_data, volatile bool &b_abort )
 {
     // fix any bad flags
     flags = FixFlags( flags );
     
     // initialise the block output
-    u8* targetBlock = reinterpret_cast< u8* >( blocks );
     int bytesPerBlock = ( ( flags & kDxt1 ) != 0 ) ? 8 : 16;
+    int nblocks = ( width + 3 ) / 4;
+    u8* targetBlock = reinterpret_cast< u8* >( blocks ) + ( y0 / 4 ) * nblocks * bytesPerBlock;
 
-    u8 r_flat_mask = 0xff;
-    u8 g_flat_mask = 0xff;
-    u8 b_flat_mask = 0xff;
- 
+    u8 flat[3] = { 0xff, 0xff, 0xff };
     if(b_flatten){
-        r_flat_mask = 0xf8;
-        g_flat_mask = 0xfc;
-        b_flat_mask = 0xf8;
+        flat[0] = 0xf8;
+        flat[1] = 0xfc;
+        flat[2] = 0xf8;
     }
-    
-    // loop over blocks
-    double tt = 0;
 
-    int bw = std::min(width, 4);
-    int bh = std::min(height, 4);
-                
-    for( int y = 0; y < height; y += 4 )
+    // one row of rgba blocks at a time
+    std::vector<u8> sourceRgba( 64 * nblocks );
+    std::vector<u8> uniform( nblocks );
+    
+    for( int y = y0; y < y1; y += 4 )
     {
-        for( int x = 0; x < width; x += 4 )
-        {
-            // build the 4x4 block of pixels
-            u8 sourceRgba[16*4];
-            u8* targetPixel = sourceRgba;
-
-            for( int py = 0; py < 4; ++py )
-            {
-                for( int px = 0; px < 4; ++px )
-                {
-                    // get the source pixel in the image
-                    int sx = x + (px % bw);
-                    int sy = y + (py % bh);
-                    
-                    // copy the rgba value
-                    u8 const* sourcePixel = rgb + 3*( width*sy + sx );
-
-                    *targetPixel++ = sourcePixel[0] & r_flat_mask;
-                    *targetPixel++ = sourcePixel[1] & g_flat_mask;
-                    *targetPixel++ = sourcePixel[2] & b_flat_mask;
-                    *targetPixel++ = 255;
-                }
-            }
+        FetchBlockRow( rgb, width, height, y, flat, &sourceRgba[0], &uniform[0] );
 
+        for( int i = 0; i < nblocks; i++ )
+        {
             // compress it into the output
-            Compress_dxt1( sourceRgba, targetBlock, flags );
-//            Compress( sourceRgba, targetBlock, flags );
+            if( uniform[i] )
+                CompressSingleColour_dxt1( &sourceRgba[64*i], targetBlock );
+            else
+                Compress_dxt1( &sourceRgba[64*i], targetBlock, flags );
             
             // advance
             targetBlock += bytesPerBlock;
@@ -352,6 +350,13 @@ void CompressImageRGBpow2_Flatten_Throttle_Abort( u8 const* rgb, int width, int
     }
 }
 
+void CompressImageRGBpow2_Flatten_Throttle_Abort( u8 const* rgb, int width, int height, void* blocks, int flags,
+                                                  bool b_flatten, void (*throttle)(void*), void *throttle_data, volatile bool &b_abort )
+{
+    CompressImageRGBpow2_Flatten_Throttle_Abort_Rows( rgb, width, height, blocks, flags, b_flatten,
+                                                      0, height, throttle, throttle_data, b_abort );
+}
+
 
 void DecompressImage( u8* rgba, int width, int height, void const* blocks, int flags )
 {
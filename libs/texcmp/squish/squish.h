@@ -224,6 +224,14 @@ void CompressImageRGB( u8 const* rgb, int width, int height, void* blocks, int f
 void CompressImageRGBpow2_Flatten_Throttle_Abort( u8 const* rgb, int width, int height, void* blocks, int flags,
                                                   bool b_flatten, void (*throttle)(void*), void *throttle_data, volatile bool &b_abort );
 
+/*  As above, but only compresses the block rows of scanlines [y0, y1) so that
+ *  separate threads may each fill their own band of the output.  y0 and y1
+ *  must be multiples of 4.
+ */
+void CompressImageRGBpow2_Flatten_Throttle_Abort_Rows( u8 const* rgb, int width, int height, void* blocks, int flags,
+                                                       bool b_flatten, int y0, int y1,
+                                                       void (*throttle)(void*), void *throttle_data, volatile bool &b_abort );
+
 // -----------------------------------------------------------------------------
 
 /*! @brief Decompresses an image in memory.
@@ -0,0 +1,81 @@
+/******************************************************************************
+ *
+ * Project:  OpenCPN
+ * Purpose:  Spread texture compression of one image over several cores
+ *
+ ***************************************************************************
+ *   Copyright (C) 2020 by David S. Register                               *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301,  USA.         *
+ ***************************************************************************
+ */
+
+#include <vector>
+
+#include <wx/thread.h>
+
+#include "texcmp_mt.h"
+
+//  A band on its own thread, at the low priority of the compression pool
+//  threads it helps, so the gui keeps its cpu headroom
+class TexCmpBandThread : public wxThread
+{
+public:
+    TexCmpBandThread( const std::function<void(int, int)> &fn, int row0, int row1 )
+        : wxThread( wxTHREAD_JOINABLE ), m_fn( fn ), m_row0( row0 ), m_row1( row1 ) {}
+
+    void *Entry()
+    {
+        SetPriority( WXTHREAD_MIN_PRIORITY );
+        m_fn( m_row0, m_row1 );
+        return 0;
+    }
+
+private:
+    const std::function<void(int, int)> &m_fn;
+    int m_row0, m_row1;
+};
+
+void TexCmp_ForEachBlockRowBand( int nrows, int nthreads,
+                                 const std::function<void(int, int)> &fn )
+{
+    if( nthreads > nrows )
+        nthreads = nrows;
+
+    std::vector<TexCmpBandThread *> workers;
+    int first_end = nrows;
+    for( int i = 1; i < nthreads; i++ ) {
+        int r0 = (int)( (long long)nrows * i / nthreads );
+        int r1 = (int)( (long long)nrows * ( i + 1 ) / nthreads );
+        if( i == 1 )
+            first_end = r0;
+        TexCmpBandThread *worker = new TexCmpBandThread( fn, r0, r1 );
+        if( worker->Create() == wxTHREAD_NO_ERROR && worker->Run() == wxTHREAD_NO_ERROR )
+            workers.push_back( worker );
+        else {
+            // out of threads, just do the band here
+            delete worker;
+            fn( r0, r1 );
+        }
+    }
+
+    fn( 0, first_end );
+
+    for( size_t i = 0; i < workers.size(); i++ ) {
+        workers[i]->Wait();
+        delete workers[i];
+    }
+}
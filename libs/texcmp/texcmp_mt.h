@@ -0,0 +1,39 @@
+/******************************************************************************
+ *
+ * Project:  OpenCPN
+ * Purpose:  Spread texture compression of one image over several cores
+ *
+ ***************************************************************************
+ *   Copyright (C) 2020 by David S. Register                               *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301,  USA.         *
+ ***************************************************************************
+ */
+
+#ifndef __TEXCMP_MT_H__
+#define __TEXCMP_MT_H__
+
+#include <functional>
+
+//  Split the block rows [0, nrows) of an image into nthreads contiguous
+//  bands and call fn(first_row, end_row) for each.  The first band runs on
+//  the calling thread, the others on short lived low priority threads which are
+//  all joined before returning.  Every block row is written by exactly one
+//  band, so the result is identical to a single threaded pass.
+void TexCmp_ForEachBlockRowBand( int nrows, int nthreads,
+                                 const std::function<void(int, int)> &fn );
+
+#endif
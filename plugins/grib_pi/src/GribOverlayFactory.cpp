@@ -261,6 +261,7 @@ GRIBOverlayFactory::GRIBOverlayFactory( GRIBUICtrlBar &dlg )
         m_pOverlay[i] = NULL;
 
     m_ParticleMap = NULL;
+    m_bBatchLines = false;
     m_tParticleTimer.Connect(wxEVT_TIMER, wxTimerEventHandler( GRIBOverlayFactory::OnParticleTimer ), NULL, this);
     m_bUpdateParticles = false;
 
@@ -411,6 +412,12 @@ void GRIBOverlayFactory::ClearCachedData( void )
         delete m_pOverlay[i];
         m_pOverlay[i] = NULL;
     }
+
+    //    and the velocities particles move with
+    if(m_ParticleMap) {
+        delete m_ParticleMap->m_Field;
+        m_ParticleMap->m_Field = NULL;
+    }
 }
 
 #ifdef __OCPN__ANDROID__
@@ -617,6 +624,9 @@ void GRIBOverlayFactory::GetCalibratedGraphicColor(int settings, double val_in,
 #endif
     
 }
+#endif
+
+#ifdef ocpnUSE_GL
 
 bool GRIBOverlayFactory::CreateGribGLTexture( GribOverlay *pGO, int settings, GribRecord *pGR)
 {
@@ -692,6 +702,9 @@ bool GRIBOverlayFactory::CreateGribGLTexture( GribOverlay *pGO, int settings, Gr
     th = height_pot;
 #endif    
     
+    GribColorLUT *lut = new GribColorLUT;
+    BuildColorLUT( settings, *lut, true );
+
     unsigned char *data = new unsigned char[tw*th*4];
     if (samples == 0) {
         for( int j = 0; j < pGR->getNj(); j++ ) {
@@ -700,7 +713,7 @@ bool GRIBOverlayFactory::CreateGribGLTexture( GribOverlay *pGO, int settings, Gr
                 int y = (j + 1)*delta;
                 int x = (i + !repeat)*delta;
                 int doff = 4*(y*tw + x);
-                GetCalibratedGraphicColor(settings, v, data + doff);
+                lut->Get(v, data + doff);
             }
         }
     }
@@ -711,7 +724,7 @@ bool GRIBOverlayFactory::CreateGribGLTexture( GribOverlay *pGO, int settings, Gr
                 int y = j + 1;
                 int x = i + !repeat;
                 int doff = 4*(y*tw + x);
-                GetCalibratedGraphicColor(settings, v, data + doff);
+                lut->Get(v, data + doff);
             }
         }
     } else {
@@ -767,7 +780,7 @@ bool GRIBOverlayFactory::CreateGribGLTexture( GribOverlay *pGO, int settings, Gr
                         }
 
                         int doff = 4*(y*tw + x);
-                        GetCalibratedGraphicColor(settings, v, data + doff);
+                        lut->Get(v, data + doff);
                         data[doff+3] *= a;
 
                         if(i == pGR->getNi()-1)
@@ -779,6 +792,7 @@ bool GRIBOverlayFactory::CreateGribGLTexture( GribOverlay *pGO, int settings, Gr
             }
         }
     }
+    delete lut;
 
     /* complete borders */
     memcpy(data              , data + 4*tw*1     , 4*tw);
@@ -856,6 +870,9 @@ wxImage GRIBOverlayFactory::CreateGribImage( int settings, GribRecord *pGR,
     wxImage gr_image( width, height );
     gr_image.InitAlpha();
 
+    GribColorLUT *lut = new GribColorLUT;
+    BuildColorLUT( settings, *lut, false );
+
     wxPoint p;
     for( int ipix = 0; ipix < ( width - grib_pixel_size + 1 ); ipix += grib_pixel_size ) {
         for( int jpix = 0; jpix < ( height - grib_pixel_size + 1 ); jpix += grib_pixel_size ) {
@@ -866,15 +883,12 @@ wxImage GRIBOverlayFactory::CreateGribImage( int settings, GribRecord *pGR,
 
             double v = pGR->getInterpolatedValue(lon, lat);
             if( v != GRIB_NOTDEF ) {
-                v = m_Settings.CalibrateValue(settings, v);
-                wxColour c = GetGraphicColor(settings, v);
-
-                //set full transparency if no rain or no clouds at all
-                unsigned char a = isClearSky(settings, v) ? 0 : m_Settings.m_iOverlayTransparency;
-
-                unsigned char r = c.Red();
-                unsigned char g = c.Green();
-                unsigned char b = c.Blue();
+                unsigned char c[4];
+                lut->Get(v, c);
+                unsigned char r = c[0];
+                unsigned char g = c[1];
+                unsigned char b = c[2];
+                unsigned char a = c[3];
 
                 for( int xp = 0; xp < grib_pixel_size; xp++ )
                     for( int yp = 0; yp < grib_pixel_size; yp++ ) {
@@ -888,6 +902,7 @@ wxImage GRIBOverlayFactory::CreateGribImage( int settings, GribRecord *pGR,
             }
         }
     }
+    delete lut;
 
     return gr_image.Blur( 4 );
 }
@@ -993,18 +1008,8 @@ void GRIBOverlayFactory::InitColorsTable( )
 	InitColor(CAPEMap, (sizeof CAPEMap) / (sizeof *CAPEMap));
 }
 
-void GRIBOverlayFactory::GetGraphicColor(int settings, double val_in, unsigned char &r, unsigned char &g, unsigned char &b)
+static bool GetColorMap(int colormap_index, ColorMap *&map, int &maplen)
 {
-    int colormap_index = m_Settings.Settings[settings].m_iOverlayMapColors;
-    ColorMap *map;
-    int maplen;
-
-    /* normalize input value */
-    double min = m_Settings.GetMin(settings), max = m_Settings.GetMax(settings);
-
-    val_in -= min;
-    val_in /= max-min;
-
     switch(colormap_index) {
     case CURRENT_GRAPHIC_INDEX:
         map = CurrentMap;
@@ -1039,8 +1044,24 @@ void GRIBOverlayFactory::GetGraphicColor(int settings, double val_in, unsigned c
 		maplen = (sizeof CAPEMap) / (sizeof *CAPEMap);
 		break;
     default:
-        return;
+        return false;
     }
+    return true;
+}
+
+void GRIBOverlayFactory::GetGraphicColor(int settings, double val_in, unsigned char &r, unsigned char &g, unsigned char &b)
+{
+    ColorMap *map;
+    int maplen;
+
+    /* normalize input value */
+    double min = m_Settings.GetMin(settings), max = m_Settings.GetMax(settings);
+
+    val_in -= min;
+    val_in /= max-min;
+
+    if(!GetColorMap(m_Settings.Settings[settings].m_iOverlayMapColors, map, maplen))
+        return;
 
     /* normalize map from 0 to 1 */
     double cmax = map[maplen-1].val;
@@ -1071,6 +1092,82 @@ wxColour GRIBOverlayFactory::GetGraphicColor(int settings, double val_in)
     GetGraphicColor(settings, val_in, r, g, b);
     return wxColour(r, g, b);
 }
+
+void GRIBOverlayFactory::BuildColorLUT( int settings, GribColorLUT &lut, bool gl )
+{
+    lut.m_psettings = &m_Settings;
+    lut.m_settings = settings;
+    lut.m_min = m_Settings.GetMin(settings);
+    lut.m_range = m_Settings.GetMax(settings) - lut.m_min;
+    lut.m_alpha = m_Settings.m_iOverlayTransparency;
+    lut.m_bgradual = m_bGradualColors;
+#if defined(ocpnUSE_GL) && !defined(__OCPN__ANDROID__)
+    lut.m_binvert = gl;         // see GetCalibratedGraphicColor()
+#endif
+
+    ColorMap *map;
+    int maplen;
+    if(GetColorMap(m_Settings.Settings[settings].m_iOverlayMapColors, map, maplen)) {
+        double cmax = map[maplen-1].val;
+        for(int i=0; i<maplen; i++) {
+            lut.m_breaks.push_back(map[i].val/cmax);
+            lut.m_rgb.push_back(map[i].r);
+            lut.m_rgb.push_back(map[i].g);
+            lut.m_rgb.push_back(map[i].b);
+        }
+    }
+
+    memset(lut.m_notdef, 0, sizeof lut.m_notdef);
+#ifdef ocpnUSE_GL
+    if( gl )
+        GetCalibratedGraphicColor(settings, GRIB_NOTDEF, lut.m_notdef);
+#endif
+}
+
+//  Same arithmetic as GetGraphicColor() and GetCalibratedGraphicColor(),
+//  the segment found by binary search instead of a linear one
+void GribColorLUT::Get(double v, unsigned char *c) const
+{
+    if( v == GRIB_NOTDEF ) {
+        memcpy(c, m_notdef, 4);
+        return;
+    }
+
+    v = m_psettings->CalibrateValue(m_settings, v);
+    unsigned char r = 0, g = 0, b = 0;
+    unsigned char a = isClearSky(m_settings, v) ? 0 : m_alpha;
+
+    int maplen = m_breaks.size();
+    if(maplen >= 2) {
+        double val_in = v;
+        val_in -= m_min;
+        val_in /= m_range;
+
+        // first break above the value, else the last one
+        int i = std::upper_bound(m_breaks.begin() + 1, m_breaks.end() - 1, val_in) - m_breaks.begin();
+        const unsigned char *c0 = &m_rgb[3*(i-1)], *c1 = &m_rgb[3*i];
+        if(m_bgradual) {
+            double d = (val_in-m_breaks[i-1])/(m_breaks[i]-m_breaks[i-1]);
+            r = (1-d)* c0[0] + d* c1[0];
+            g = (1-d)* c0[1] + d* c1[1];
+            b = (1-d)* c0[2] + d* c1[2];
+        } else {
+            r = c1[0];
+            g = c1[1];
+            b = c1[2];
+        }
+    }
+
+    if(m_binvert) {
+        r = 255-r;
+        g = 255-g;
+        b = 255-b;
+    }
+    c[0] = r;
+    c[1] = g;
+    c[2] = b;
+    c[3] = a;
+}
     
 wxString GRIBOverlayFactory::getLabelString(double value, int settings)
 {
@@ -1194,6 +1291,9 @@ void GRIBOverlayFactory::RenderGribBarbedArrows( int settings, GribRecord **pGR,
 #endif            
        
         glEnableClientState(GL_VERTEX_ARRAY);
+
+        // collect all the barbs and draw them at once
+        m_bBatchLines = m_oDC != NULL;
     }
 #endif
 
@@ -1283,8 +1383,10 @@ void GRIBOverlayFactory::RenderGribBarbedArrows( int settings, GribRecord **pGR,
 
 
 #ifdef ocpnUSE_GL
-    if( !m_pdc )
+    if( !m_pdc ) {
+        FlushLineBatch( .4 / m_pixelMM );
         glDisableClientState(GL_VERTEX_ARRAY);
+    }
 #endif
 }
 
@@ -1309,7 +1411,12 @@ void GRIBOverlayFactory::RenderGribIsobar( int settings, GribRecord **pGR,
     wxColour back_color;
     GetGlobalColor( _T ( "DILG1" ), &back_color );
 
-    //    Initialize the array of Isobars if necessary
+    //    Initialize the array of Isobars if necessary, they may have been
+    //    built for another set of the same time
+    GribTimelineRecordSet *set = m_pGribTimelineRecordSet;
+    if( !pIsobarArray[idx] )
+        set->SetCachedIsobars( idx, m_dlg.m_IsoLineCache.Find( set->m_ID, set->m_Reference_Time, idx ) );
+
     if( !pIsobarArray[idx] ) {
         // build magnitude from multiple record types like wind and current
         if(idy >= 0 && !polar && pGR[idy]) {
@@ -1322,12 +1429,6 @@ void GRIBOverlayFactory::RenderGribIsobar( int settings, GribRecord **pGR,
             pGRA = pGRM;
         }
 
-        pIsobarArray[idx] = new wxArrayPtrVoid;
-        IsoLine *piso;
-
-        wxGenericProgressDialog *progressdialog = nullptr;
-        wxDateTime start = wxDateTime::Now();
-
         double min = m_Settings.GetMin(settings);
         double max = m_Settings.GetMax(settings);
 
@@ -1335,25 +1436,21 @@ void GRIBOverlayFactory::RenderGribIsobar( int settings, GribRecord **pGR,
         double factor = ( settings == GribOverlaySettings::PRESSURE &&
                             m_Settings.Settings[settings].m_Units == 2 ) ? 0.03 : 1.;//divide spacing by 1/33 for PRESURRE & inHG
 
+        //    all the values are extracted at once
+        std::vector<double> values, raw;
         for( double press = min; press <= max; press += (m_Settings.Settings[settings].m_iIsoBarSpacing * factor) ) {
-            if(progressdialog)
-                progressdialog->Update(press-min);
-            else {
-                wxDateTime now = wxDateTime::Now();
-                if((now-start).GetSeconds() > 3 && press-min < (max-min)/2) {
-                    progressdialog = new wxGenericProgressDialog(
-                        _("Building Isobar map"), _("Wind"), max-min+1, NULL,
-                        wxPD_SMOOTH | wxPD_ELAPSED_TIME | wxPD_REMAINING_TIME);
-                }
-            }
+            values.push_back( press );
+            raw.push_back( press / m_Settings.CalibrationFactor(settings, press, true)
+                           - m_Settings.CalibrationOffset(settings) );
+        }
 
-            piso = new IsoLine( press,
-                                m_Settings.CalibrationFactor(settings, press, true),
-                                m_Settings.CalibrationOffset(settings), pGRA );
+        std::vector<IsoLine *> isolines;
+        IsoLine::BuildIsoLines( values, raw, pGRA, isolines );
 
-            pIsobarArray[idx]->Add( piso );
-        }
-        delete progressdialog;
+        wxArrayPtrVoid *array = new wxArrayPtrVoid;
+        for( unsigned int i = 0; i < isolines.size(); i++ )
+            array->Add( isolines[i] );
+        set->SetCachedIsobars( idx, m_dlg.m_IsoLineCache.Insert( set->m_ID, set->m_Reference_Time, idx, array ) );
 
         delete pGRM;
     }
@@ -1936,16 +2033,25 @@ void GRIBOverlayFactory::RenderGribParticles( int settings, GribRecord **pGR,
     if(!pGRX || !pGRY)
         return;
 
-    wxStopWatch sw;
-    sw.Start();
-
     if(m_ParticleMap && m_ParticleMap->m_Setting != settings)
         ClearParticles();
 
     if(!m_ParticleMap)
         m_ParticleMap = new ParticleMap(settings);
 
-    std::vector<Particle> &particles = m_ParticleMap->m_Particles;
+    ParticleMap &pm = *m_ParticleMap;
+
+    // velocities are looked up in a copy of the records made once, it can
+    // be read from all the threads; without it fall back to the records
+    if(!pm.m_Field)
+        pm.m_Field = new GribPolarField(pGRX, pGRY);
+    const GribPolarField *field = pm.m_Field->isOk() ? pm.m_Field : NULL;
+    auto velocity = [&](double &vkn, double &ang, double lon, double lat) {
+        if(field)
+            return field->getInterpolatedValues(vkn, ang, lon, lat);
+        return GribRecord::getInterpolatedValues(vkn, ang, pGRX, pGRY, lon, lat);
+    };
+    size_t grain = field ? 1024 : pm.size() + 1;
 
     const int max_duration = 50;
     const int run_count = 6;
@@ -1956,40 +2062,38 @@ void GRIBOverlayFactory::RenderGribParticles( int settings, GribRecord **pGR,
     int history_size = 27 / sqrt(density);
     history_size = wxMin(history_size, MAX_PARTICLE_HISTORY);
 
-    std::vector<Particle>::iterator it;
     // if the history size changed
-    if(m_ParticleMap->history_size != history_size) {
-        for(unsigned int i = 0; i < particles.size(); i++) {
-            Particle &it = particles[i];
-            if(m_ParticleMap->history_size > history_size &&
-               it.m_HistoryPos >= history_size) {
-                it = particles[particles.size() - 1];
-                particles.pop_back();
+    if(pm.history_size != history_size) {
+        for(unsigned int i = 0; i < pm.size(); i++) {
+            if(pm.history_size > history_size &&
+               pm.m_HistoryPos[i] >= history_size) {
+                pm.remove(i);
                 i--;
                 continue;
             }
 
-            it.m_HistorySize = it.m_HistoryPos+1;
+            pm.m_HistorySize[i] = pm.m_HistoryPos[i]+1;
         }
-        m_ParticleMap->history_size = history_size;
+        pm.history_size = history_size;
     }
 
     // Did the viewport change?  update cached screen coordinates
     // we could use normalized coordinates in opengl and avoid this
-    PlugIn_ViewPort &lvp = m_ParticleMap->last_viewport;
+    // GetCanvasPixLL() is host API, so it is only called from this thread
+    PlugIn_ViewPort &lvp = pm.last_viewport;
     if(lvp.bValid == false || vp->view_scale_ppm != lvp.view_scale_ppm
         || vp->skew != lvp.skew || vp->rotation != lvp.rotation) {
-        for(it = particles.begin(); it != particles.end(); it++)
-            for(int i=0; i<it->m_HistorySize; i++) {
-                Particle::ParticleNode &n = it->m_History[i];
-                float (&p)[2] = n.m_Pos;
+        for(size_t it = 0; it < pm.size(); it++)
+            for(int i=0; i<pm.m_HistorySize[it]; i++) {
+                float *p = pm.Pos(it, i);
                 if(p[0] == -10000)
                     continue;
 
                 wxPoint ps;
                 GetCanvasPixLL( vp, &ps, p[1], p[0] );
-                n.m_Screen[0] = ps.x;
-                n.m_Screen[1] = ps.y;
+                float *s = pm.Screen(it, i);
+                s[0] = ps.x;
+                s[1] = ps.y;
             }
 
         lvp = *vp;
@@ -2001,56 +2105,53 @@ void GRIBOverlayFactory::RenderGribParticles( int settings, GribRecord **pGR,
 
             p1 -= p2;
 
-            for(it = particles.begin(); it != particles.end(); it++)
-                for(int i=0; i<it->m_HistorySize; i++) {
-                    Particle::ParticleNode &n = it->m_History[i];
-                    float (&p)[2] = n.m_Pos;
+            for(size_t it = 0; it < pm.size(); it++)
+                for(int i=0; i<pm.m_HistorySize[it]; i++) {
+                    float *p = pm.Pos(it, i);
                     if(p[0] == -10000)
                         continue;
 
-                    n.m_Screen[0] += p1.x;
-                    n.m_Screen[1] += p1.y;
+                    float *s = pm.Screen(it, i);
+                    s[0] += p1.x;
+                    s[1] += p1.y;
                 }
             lvp = *vp;
         }
 
-    double ptime = 0;
-
-    // update particle map
+    // update particle map, particles move independently so they are
+    // advanced on all the cores, and projected to the screen here after
     if(m_bUpdateParticles) {
-        for(unsigned int i = 0; i < particles.size(); i++) {
-            Particle &it = particles[i];
-
+        std::vector<char> expired(pm.size(), 0);
+        std::vector<char> moved(pm.size(), 0);
+        ParallelFor(pm.size(), grain, [&](size_t begin, size_t end) {
+          for(size_t it = begin; it < end; it++) {
             // Update the interpolation factor
-            if(++it.m_Run < run_count)
+            if(++pm.m_Run[it] < run_count)
                 continue;
-            it.m_Run = 0;
+            pm.m_Run[it] = 0;
 
             // don't allow particle to live too long
-            if(it.m_Duration > max_duration) {
-                it = particles[particles.size() - 1];
-                particles.pop_back();
-                i--;
+            if(pm.m_Duration[it] > max_duration) {
+                expired[it] = 1;
                 continue;
             }
 
-            it.m_Duration++;
+            pm.m_Duration[it]++;
 
-            float (&pp)[2] = it.m_History[it.m_HistoryPos].m_Pos;
+            float *pp = pm.Pos(it, pm.m_HistoryPos[it]);
 
             // maximum history size
-            if(++it.m_HistorySize > history_size)
-                it.m_HistorySize = history_size;
+            if(++pm.m_HistorySize[it] > history_size)
+                pm.m_HistorySize[it] = history_size;
 
-            if(++it.m_HistoryPos >= history_size)
-                it.m_HistoryPos = 0;
+            if(++pm.m_HistoryPos[it] >= history_size)
+                pm.m_HistoryPos[it] = 0;
 
-            Particle::ParticleNode &n = it.m_History[it.m_HistoryPos];
-            float (&p)[2] = n.m_Pos;
+            float *p = pm.Pos(it, pm.m_HistoryPos[it]);
             double vkn=0, ang;
 
-            if(it.m_Duration < max_duration - history_size &&
-               GribRecord::getInterpolatedValues(vkn, ang, pGRX, pGRY, pp[0], pp[1]) &&
+            if(pm.m_Duration[it] < max_duration - history_size &&
+               velocity(vkn, ang, pp[0], pp[1]) &&
                vkn > 0 && vkn < 100 ) {
 
                 vkn = m_Settings.CalibrateValue(settings, vkn);
@@ -2084,21 +2185,32 @@ void GRIBOverlayFactory::RenderGribParticles( int settings, GribRecord **pGR,
                 p[0] = pp[0] + asinf(sa*sD/cy) * 180/M_PI;
                 p[1] = asinf(sy*cD + cy*sD*ca) * 180/M_PI;
 #endif
-                wxPoint ps;
-                GetCanvasPixLL( vp, &ps, p[1], p[0] );
+                moved[it] = 1;
 
-                n.m_Screen[0] = ps.x;
-                n.m_Screen[1] = ps.y;
-
-                wxColor c = GetGraphicColor(settings, vkn);
-
-                n.m_Color[0] = c.Red();
-                n.m_Color[1] = c.Green();
-                n.m_Color[2] = c.Blue();
+                wxUint8 *c = pm.Color(it, pm.m_HistoryPos[it]);
+                GetGraphicColor(settings, vkn, c[0], c[1], c[2]);
             } else
                 p[0] = -10000;
-            ptime += sw.Time();
+          }
+        });
+
+        for(size_t it = 0; it < pm.size(); it++) {
+            if(!moved[it])
+                continue;
+
+            float *p = pm.Pos(it, pm.m_HistoryPos[it]);
+            wxPoint ps;
+            GetCanvasPixLL( vp, &ps, p[1], p[0] );
+
+            float *s = pm.Screen(it, pm.m_HistoryPos[it]);
+            s[0] = ps.x;
+            s[1] = ps.y;
         }
+
+        // from the end, the particle moved in place of an expired one is kept
+        for(size_t it = pm.size(); it-- > 0; )
+            if(expired[it])
+                pm.remove(it);
     }
     m_bUpdateParticles = false;
 
@@ -2109,13 +2221,13 @@ void GRIBOverlayFactory::RenderGribParticles( int settings, GribRecord **pGR,
         total_particles = 60000;
 
     // remove particles if needed;
-    int remove_particles = ((int)particles.size() - total_particles) / 16;
-    for(int i = 0; i<remove_particles; i++)
-        particles.pop_back();
+    int remove_particles = ((int)pm.size() - total_particles) / 16;
+    if(remove_particles > 0)
+        pm.resize(pm.size() - remove_particles);
 
     // add new particles as needed
     int run = 0;
-    int new_particles = (total_particles - (int)particles.size()) / 64;
+    int new_particles = (total_particles - (int)pm.size()) / 64;
 
     for(int npi=0; npi<new_particles; npi++) {
         float p[2];
@@ -2125,7 +2237,7 @@ void GRIBOverlayFactory::RenderGribParticles( int settings, GribRecord **pGR,
             p[0] = (float)rand() / RAND_MAX * (pGRX->getLonMax() - pGRX->getLonMin()) + pGRX->getLonMin();
             p[1] = (float)rand() / RAND_MAX * (pGRX->getLatMax() - pGRX->getLatMin()) + pGRX->getLatMin();
 
-            if(GribRecord::getInterpolatedValues(vkn, ang, pGRX, pGRY, p[0], p[1]) &&
+            if(velocity(vkn, ang, p[0], p[1]) &&
                vkn > 0 && vkn < 100)
                 vkn = m_Settings.CalibrateValue(settings, vkn);
             else
@@ -2136,27 +2248,24 @@ void GRIBOverlayFactory::RenderGribParticles( int settings, GribRecord **pGR,
                 break;
         }
 
-        Particle np;
-        np.m_Duration = rand()%(max_duration/2);
-        np.m_HistoryPos = 0;
-        np.m_HistorySize = 1;
-        np.m_Run = run++;
+        size_t np = pm.size();
+        pm.resize(np + 1);
+        pm.m_Duration[np] = rand()%(max_duration/2);
+        pm.m_HistoryPos[np] = 0;
+        pm.m_HistorySize[np] = 1;
+        pm.m_Run[np] = run++;
         if(run == run_count)
             run = 0;
 
-        memcpy(np.m_History[np.m_HistoryPos].m_Pos, p, sizeof p);
+        memcpy(pm.Pos(np, 0), p, sizeof p);
 
         wxPoint ps;
         GetCanvasPixLL( vp, &ps, p[1], p[0]);
-        np.m_History[np.m_HistoryPos].m_Screen[0] = ps.x;
-        np.m_History[np.m_HistoryPos].m_Screen[1] = ps.y;
-
-        wxColour c = GetGraphicColor(settings, vkn);
-        np.m_History[np.m_HistoryPos].m_Color[0] = c.Red();
-        np.m_History[np.m_HistoryPos].m_Color[1] = c.Green();
-        np.m_History[np.m_HistoryPos].m_Color[2] = c.Blue();
+        pm.Screen(np, 0)[0] = ps.x;
+        pm.Screen(np, 0)[1] = ps.y;
 
-        particles.push_back(np);
+        wxUint8 *c = pm.Color(np, 0);
+        GetGraphicColor(settings, vkn, c[0], c[1], c[2]);
     }
 
     // settings for opengl lines
@@ -2170,28 +2279,27 @@ void GRIBOverlayFactory::RenderGribParticles( int settings, GribRecord **pGR,
     }
 
     int cnt=0;
-    unsigned char *&ca = m_ParticleMap->color_array;
-    float *&va = m_ParticleMap->vertex_array;
-    float *&caf = m_ParticleMap->color_float_array;
+    unsigned char *&ca = pm.color_array;
+    float *&va = pm.vertex_array;
+    float *&caf = pm.color_float_array;
 
-    if(m_ParticleMap->array_size < particles.size() && !m_pdc) {
-        m_ParticleMap->array_size = 2*particles.size();
+    if(pm.array_size < pm.size() && !m_pdc) {
+        pm.array_size = 2*pm.size();
         delete [] ca;
         delete [] va;
         delete [] caf;
 
-        ca = new unsigned char[m_ParticleMap->array_size * MAX_PARTICLE_HISTORY * 8];
-        caf = new float[m_ParticleMap->array_size * MAX_PARTICLE_HISTORY * 8];
-        va = new float[m_ParticleMap->array_size * MAX_PARTICLE_HISTORY * 4];
+        ca = new unsigned char[pm.array_size * MAX_PARTICLE_HISTORY * 8];
+        caf = new float[pm.array_size * MAX_PARTICLE_HISTORY * 8];
+        va = new float[pm.array_size * MAX_PARTICLE_HISTORY * 4];
     }
 
     // draw particles
-    for(std::vector<Particle>::iterator it = particles.begin();
-        it != particles.end(); it++) {
+    for(size_t it = 0; it < pm.size(); it++) {
 
         wxUint8 alpha = 250;
 
-        int i = it->m_HistoryPos;
+        int i = pm.m_HistoryPos[it];
 
         bool lip_valid = false;
         float *lp = NULL, lip[2];
@@ -2199,10 +2307,10 @@ void GRIBOverlayFactory::RenderGribParticles( int settings, GribRecord **pGR,
         float lcf[4];
 
         for(;;) {
-            float (&dp)[2] = it->m_History[i].m_Pos;
+            float *dp = pm.Pos(it, i);
             if(dp[0] != -10000) {
-                float (&sp)[2] = it->m_History[i].m_Screen;
-                wxUint8 (&ci)[3] = it->m_History[i].m_Color;
+                float *sp = pm.Screen(it, i);
+                wxUint8 *ci = pm.Color(it, i);
 
                 wxUint8 c[4] = {ci[0], ci[1], (unsigned char)(ci[2] + 240-alpha/2), alpha};
                 float cf[4];
@@ -2216,7 +2324,7 @@ void GRIBOverlayFactory::RenderGribParticles( int settings, GribRecord **pGR,
 
                     // interpolate between points..  a cubic interpolation
                     // might allow a much higher run_count
-                    float d = (float)it->m_Run/run_count;
+                    float d = (float)pm.m_Run[it]/run_count;
                     for(int j=0; j<2; j++)
                         sip[j] = d*lp[j] + (1-d)*sp[j];
 
@@ -2227,11 +2335,11 @@ void GRIBOverlayFactory::RenderGribParticles( int settings, GribRecord **pGR,
                         } else {
                             memcpy(ca + 4*cnt, c, sizeof lc);
                             memcpy(caf + 4*cnt, cf, sizeof lcf);
-                            memcpy(va + 2*cnt, lip, sizeof sp);
+                            memcpy(va + 2*cnt, lip, sizeof lip);
                             cnt++;
                             memcpy(ca + 4*cnt, lc, sizeof c);
                             memcpy(caf + 4*cnt, lcf, sizeof cf);
-                            memcpy(va + 2*cnt, sip, sizeof sp);
+                            memcpy(va + 2*cnt, sip, sizeof sip);
                             cnt++;
                         }
                     }
@@ -2248,11 +2356,11 @@ void GRIBOverlayFactory::RenderGribParticles( int settings, GribRecord **pGR,
 
             if(--i < 0) {
                 i = history_size - 1;
-                if(i >= it->m_HistorySize)
+                if(i >= pm.m_HistorySize[it])
                     break;
             }
 
-            if(i == it->m_HistoryPos)
+            if(i == pm.m_HistoryPos[it])
                 break;
 
             alpha -= 240 / history_size;
@@ -2428,7 +2536,9 @@ void GRIBOverlayFactory::drawWindArrowWithBarbs( int settings, int x, int y, dou
     }
 #ifdef ocpnUSE_GL
     else{
-        if(m_oDC){
+        if( m_bBatchLines )
+            m_BatchColour = arrowColor;
+        else if(m_oDC){
             wxPen pen( arrowColor, penWidth );
             m_oDC->SetPen( pen );
         }
@@ -2487,7 +2597,13 @@ void GRIBOverlayFactory::drawLineBuffer(LineBuffer &buffer, int x, int y, double
         }
     } else {                       // OpenGL mode
 #ifdef ocpnUSE_GL
-    if(m_oDC){
+    if( m_bBatchLines ) {
+        unsigned char c[4] = { m_BatchColour.Red(), m_BatchColour.Green(),
+                               m_BatchColour.Blue(), 255 };
+        m_BatchVertexes.insert(m_BatchVertexes.end(), vertexes, vertexes + 4*count);
+        for(int i=0; i < 2*count; i++)
+            m_BatchColors.insert(m_BatchColors.end(), c, c + 4);
+    } else if(m_oDC){
         for(int i=0; i < buffer.count; i++) {
             float *l = vertexes + 4*i;
             if( m_hiDefGraphics )
@@ -2503,6 +2619,30 @@ void GRIBOverlayFactory::drawLineBuffer(LineBuffer &buffer, int x, int y, double
     }
 }
 
+void GRIBOverlayFactory::FlushLineBatch( float width )
+{
+    m_bBatchLines = false;
+
+#ifdef ocpnUSE_GL
+    if( m_oDC && !m_BatchVertexes.empty() ) {
+        // vertex colours come from the arrays, the pen only sets the line width.
+        // Smoothed lines only with high definition graphics, as with StrokeLine
+        wxPen pen( m_BatchColour, width );
+        m_oDC->SetPen( pen );
+
+        m_BatchColorsFloat.resize(m_BatchColors.size());
+        for(size_t i=0; i < m_BatchColors.size(); i++)
+            m_BatchColorsFloat[i] = m_BatchColors[i] / 255.;
+
+        m_oDC->DrawGLLineArray(m_BatchVertexes.size() / 2, &m_BatchVertexes[0],
+                               &m_BatchColorsFloat[0], &m_BatchColors[0], m_hiDefGraphics);
+    }
+#endif
+
+    m_BatchVertexes.clear();
+    m_BatchColors.clear();
+}
+
 #ifdef ocpnUSE_GL
 //      Render a texture
 //      x/y : origin in screen pixels of UPPER RIGHT corner of render rectangle
@@ -42,6 +42,7 @@
 #include "pi_ocpndc.h"
 
 #include "TexFont.h"
+#include "GribRecord.h"
 
 //----------------------------------------------------------------------------------------------------------
 //    Grib Overlay Specification
@@ -81,24 +82,53 @@ public:
 #define MAX_PARTICLE_HISTORY 8
 #include <vector>
 #include <list>
-struct Particle {
-    int m_Duration;
+#include <algorithm>
+#include <thread>
+#include <atomic>
+#include <system_error>
+
+// Call f(begin, end) over ranges of at most grain items of [0, count) on all the cores.
+// The host API is not thread safe, f must not call into it.
+template <typename F>
+void ParallelFor( size_t count, size_t grain, F f )
+{
+    size_t nthreads = std::min<size_t>(std::thread::hardware_concurrency(), (count + grain - 1) / grain);
+    if( nthreads <= 1 ) {
+        if( count )
+            f(0, count);
+        return;
+    }
 
-    // history is a ringbuffer.. because so many particles are
-    // used, it is a slight optimization over std::list
-    int m_HistoryPos, m_HistorySize, m_Run;
-    struct ParticleNode {
-        float m_Pos[2];
-        float m_Screen[2];
-        wxUint8 m_Color[3];
-    } m_History[MAX_PARTICLE_HISTORY];
-};
+    std::atomic<size_t> next(0);
+    auto worker = [&]() {
+        size_t begin;
+        while( (begin = next.fetch_add(grain)) < count )
+            f(begin, std::min(begin + grain, count));
+    };
+
+    std::vector<std::thread> threads;
+    for( size_t n = 1; n < nthreads; n++ ) {
+        try {
+            threads.push_back(std::thread(worker));
+        } catch( std::system_error & ) {
+            break;              // the ranges left are done by this thread
+        }
+    }
+    worker();
+    for( size_t n = 0; n < threads.size(); n++ )
+        threads[n].join();
+}
 
+
+// Particles are kept as a structure of arrays: one array per field, and
+// the history nodes of particle i at i*MAX_PARTICLE_HISTORY in the node
+// arrays, so updating and drawing them walks memory in order.
 struct ParticleMap {
 public:
     ParticleMap(int settings)
     : m_Setting(settings), history_size(0), array_size(0),
-      color_array(NULL), vertex_array(NULL) , color_float_array(NULL)
+      color_array(NULL), vertex_array(NULL) , color_float_array(NULL),
+      m_Field(NULL)
     {
        // XXX should be done in default PlugIn_ViewPort CTOR
         last_viewport.bValid = false;
@@ -108,9 +138,51 @@ public:
         delete [] color_array;
         delete [] vertex_array;
         delete [] color_float_array;
+        delete m_Field;
+    }
+
+    size_t size() const { return m_Duration.size(); }
+
+    void resize(size_t n) {
+        m_Duration.resize(n);
+        m_HistoryPos.resize(n);
+        m_HistorySize.resize(n);
+        m_Run.resize(n);
+        m_Pos.resize(2*MAX_PARTICLE_HISTORY*n);
+        m_Screen.resize(2*MAX_PARTICLE_HISTORY*n);
+        m_Color.resize(3*MAX_PARTICLE_HISTORY*n);
     }
 
-    std::vector<Particle> m_Particles;
+    // overwrite particle to with particle from
+    void move(size_t from, size_t to) {
+        m_Duration[to] = m_Duration[from];
+        m_HistoryPos[to] = m_HistoryPos[from];
+        m_HistorySize[to] = m_HistorySize[from];
+        m_Run[to] = m_Run[from];
+        memcpy(&m_Pos[2*MAX_PARTICLE_HISTORY*to], &m_Pos[2*MAX_PARTICLE_HISTORY*from],
+               2*MAX_PARTICLE_HISTORY*sizeof(float));
+        memcpy(&m_Screen[2*MAX_PARTICLE_HISTORY*to], &m_Screen[2*MAX_PARTICLE_HISTORY*from],
+               2*MAX_PARTICLE_HISTORY*sizeof(float));
+        memcpy(&m_Color[3*MAX_PARTICLE_HISTORY*to], &m_Color[3*MAX_PARTICLE_HISTORY*from],
+               3*MAX_PARTICLE_HISTORY);
+    }
+
+    // remove particle i, the last one takes its place
+    void remove(size_t i) {
+        move(size() - 1, i);
+        resize(size() - 1);
+    }
+
+    float *Pos(size_t i, int h) { return &m_Pos[2*(i*MAX_PARTICLE_HISTORY + h)]; }
+    float *Screen(size_t i, int h) { return &m_Screen[2*(i*MAX_PARTICLE_HISTORY + h)]; }
+    wxUint8 *Color(size_t i, int h) { return &m_Color[3*(i*MAX_PARTICLE_HISTORY + h)]; }
+
+    std::vector<int> m_Duration;
+    // history is a ringbuffer.. because so many particles are
+    // used, it is a slight optimization over std::list
+    std::vector<int> m_HistoryPos, m_HistorySize, m_Run;
+    std::vector<float> m_Pos, m_Screen;
+    std::vector<wxUint8> m_Color;
 
     // particles are rebuilt whenever any of these fields change
     time_t m_Reference_Time;
@@ -122,6 +194,10 @@ public:
     float *vertex_array;
     float *color_float_array;
 
+    // velocities of the records the particles move in, built on first use
+    // and dropped when the records change
+    GribPolarField *m_Field;
+
     PlugIn_ViewPort last_viewport;
 };
 
@@ -143,6 +219,30 @@ private:
     std::list <float> buffer;
 };
 
+//  The colour map of one overlay setting, looked up once per overlay: its
+//  breakpoints normalized as GetGraphicColor() does, their colours and the
+//  transparency.  Get() calibrates the value and binary searches the
+//  breakpoints with the same arithmetic, so the colours and the clear sky
+//  transparency are exactly those of the per pixel GetGraphicColor().
+class GribColorLUT {
+public:
+    GribColorLUT() : m_psettings(NULL), m_settings(0), m_min(0), m_range(1), m_alpha(0),
+                     m_bgradual(false), m_binvert(false) { memset(m_notdef, 0, sizeof m_notdef); }
+
+    //  rgba of the raw value v
+    void Get(double v, unsigned char *c) const;
+
+    GribOverlaySettings *m_psettings;
+    int m_settings;
+    double m_min, m_range;
+    std::vector<double> m_breaks;           // map values over the map maximum
+    std::vector<unsigned char> m_rgb;       // colour of each break
+    unsigned char m_alpha;
+    bool m_bgradual;
+    bool m_binvert;                         // opengl textures want inverted colours
+    unsigned char m_notdef[4];
+};
+
 //----------------------------------------------------------------------------------------------------------
 //    Grib Overlay Factory Specification
 //----------------------------------------------------------------------------------------------------------
@@ -210,6 +310,8 @@ private:
                                  bool south, wxColour arrowColor, double rotate_angle );
     void drawLineBuffer(LineBuffer &buffer, int x, int y, double ang, double scale, bool south=false, bool head=true);
 
+    void BuildColorLUT( int settings, GribColorLUT &lut, bool gl );
+
     void DrawNumbers( wxPoint p, double value, int settings, wxColour back_color );
     void FillGrid(GribRecord *pGR);
     
@@ -259,6 +361,15 @@ private:
 
     LineBuffer m_WindArrowCache[14];
     LineBuffer m_SingleArrow[2], m_DoubleArrow[2];
+
+    // OpenGL line segments collected while m_bBatchLines is set,
+    // drawn with a single call by FlushLineBatch
+    void FlushLineBatch( float width );
+    bool m_bBatchLines;
+    wxColour m_BatchColour;
+    std::vector<float> m_BatchVertexes;
+    std::vector<unsigned char> m_BatchColors;
+    std::vector<float> m_BatchColorsFloat;
     
     double m_pixelMM;
     int windArrowSize;
@@ -28,6 +28,179 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "GribV1Record.h"
 #include "GribV2Record.h"
 #include <cassert>
+#include <algorithm>
+#include <thread>
+#include <atomic>
+#include <system_error>
+
+//-------------------------------------------------------------------------------
+// Unpack the data of the records on all the cores, they are independent
+static void DecodePackedRecords(const std::vector<GribRecord *> &recs)
+{
+    std::atomic<size_t> next(0);
+    auto worker = [&]() {
+        size_t i;
+        while ((i = next++) < recs.size()) {
+            if (!recs[i]->decodePackedData())
+                erreur("Record %d: can't unpack data", recs[i]->getId());
+        }
+    };
+
+    size_t nthreads = std::min<size_t>(std::thread::hardware_concurrency(), recs.size());
+    std::vector<std::thread> threads;
+    for (size_t n=1; n<nthreads; n++) {
+        try {
+            threads.push_back(std::thread(worker));
+        } catch (std::system_error &) {
+            break;              // the records left are decoded right here
+        }
+    }
+    worker();
+    for (size_t n=0; n<threads.size(); n++)
+        threads[n].join();
+}
+
+//-------------------------------------------------------------------------------
+GribDataCache::GribDataCache()
+{
+    m_bytes = 0;
+}
+//-------------------------------------------------------------------------------
+GribDataCache::~GribDataCache()
+{
+    // records still known are owned by the reader, which deleted them
+    m_loaded.clear();
+}
+//-------------------------------------------------------------------------------
+int GribDataCache::addFile(const wxString &fname, long size)
+{
+    wxMutexLocker lock(m_mutex);
+    DataFile f;
+    f.name = fname;
+    f.size = size;
+    m_files.push_back(f);
+    return m_files.size() - 1;
+}
+//-------------------------------------------------------------------------------
+void GribDataCache::addRecord(GribRecord *rec)
+{
+    // records are normally added before their data is first decoded
+    if (rec->data == NULL)
+        return;
+
+    wxMutexLocker lock(m_mutex);
+    m_loaded.push_front(rec);
+    m_bytes += (size_t)rec->Ni*rec->Nj*sizeof(double);
+    evict();
+}
+//-------------------------------------------------------------------------------
+void GribDataCache::removeRecord(GribRecord *rec)
+{
+    wxMutexLocker lock(m_mutex);
+    std::list<GribRecord *>::iterator it = std::find(m_loaded.begin(), m_loaded.end(), rec);
+    if (it != m_loaded.end()) {
+        m_loaded.erase(it);
+        m_bytes -= (size_t)rec->Ni*rec->Nj*sizeof(double);
+    }
+}
+//-------------------------------------------------------------------------------
+bool GribDataCache::loadData(GribRecord *rec)
+{
+    wxMutexLocker lock(m_mutex);
+
+    if (rec->data) {
+        std::list<GribRecord *>::iterator it = std::find(m_loaded.begin(), m_loaded.end(), rec);
+        if (it != m_loaded.end())
+            m_loaded.splice(m_loaded.begin(), m_loaded, it);
+        return true;
+    }
+
+    if (!rec->m_bdeferred || rec->m_dataFile < 0 || rec->m_dataFile >= (int)m_files.size())
+        return false;
+
+    ZUFILE *file = NULL;
+    int fileIndex = -1;
+    readPackedData(rec, file, fileIndex);
+    // GRIB_NOTDEF everywhere if it can't be read
+    rec->decodePackedData();
+    if (file)
+        zu_close(file);
+
+    insert(rec);
+    evict();
+    return true;
+}
+//-------------------------------------------------------------------------------
+void GribDataCache::loadData(const std::vector<GribRecord *> &recs)
+{
+    wxMutexLocker lock(m_mutex);
+
+    // reading is serial, one file is opened once
+    std::vector<GribRecord *> load;
+    ZUFILE *file = NULL;
+    int fileIndex = -1;
+    for (zuint i=0; i<recs.size(); i++) {
+        GribRecord *rec = recs[i];
+        if (rec == NULL || rec->m_dataCache != this || rec->packedData)
+            continue;
+        if (rec->data) {
+            std::list<GribRecord *>::iterator it = std::find(m_loaded.begin(), m_loaded.end(), rec);
+            if (it != m_loaded.end())
+                m_loaded.splice(m_loaded.begin(), m_loaded, it);
+            continue;
+        }
+        if (!rec->m_bdeferred || rec->m_dataFile < 0 || rec->m_dataFile >= (int)m_files.size())
+            continue;
+        readPackedData(rec, file, fileIndex);
+        load.push_back(rec);
+    }
+    if (file)
+        zu_close(file);
+
+    DecodePackedRecords(load);
+
+    for (zuint i=0; i<load.size(); i++)
+        insert(load[i]);
+    evict();
+}
+//-------------------------------------------------------------------------------
+bool GribDataCache::readPackedData(GribRecord *rec, ZUFILE *&file, int &fileIndex)
+{
+    // the file may have been replaced since it was read
+    const DataFile &f = m_files[rec->m_dataFile];
+    if (fileIndex != rec->m_dataFile) {
+        if (file)
+            zu_close(file);
+        file = zu_open((const char *)f.name.mb_str(), "rb", ZU_COMPRESS_NONE);
+        fileIndex = rec->m_dataFile;
+        if (file != NULL && zu_filesize(file) != f.size) {
+            zu_close(file);
+            file = NULL;
+        }
+    }
+    if (file != NULL && rec->readPackedData(file))
+        return true;
+
+    erreur("Record %d: can't read data from %s", rec->id, (const char *)f.name.mb_str());
+    return false;
+}
+//-------------------------------------------------------------------------------
+void GribDataCache::insert(GribRecord *rec)
+{
+    m_loaded.push_front(rec);
+    m_bytes += (size_t)rec->Ni*rec->Nj*sizeof(double);
+}
+//-------------------------------------------------------------------------------
+void GribDataCache::evict()
+{
+    while (m_bytes > GRIB_CACHE_SIZE && m_loaded.size() > GRIB_CACHE_MIN_RECORDS) {
+        GribRecord *rec = m_loaded.back();
+        m_loaded.pop_back();
+        m_bytes -= (size_t)rec->Ni*rec->Nj*sizeof(double);
+        delete [] rec->data;
+        rec->data = NULL;
+    }
+}
 
 //-------------------------------------------------------------------------------
 GribReader::GribReader()
@@ -125,19 +298,20 @@ void GribReader::readAllGribRecords()
     time_t firstdate = -1;
     bool b_EOF;
     bool is_v2 = false;
+    // only index uncompressed files, seeking back in the others is slow
+    bool defer = file->type == ZU_COMPRESS_NONE;
 
     do {
         id ++;
         // use the previously seen record type first
-        // a miss with compressed file is really slow as
-        // seek may mean re reading and decompressing the
-        // file from the start
+        // a miss with compressed file seeks back in the
+        // decompressed blocks zuFile keeps
 
         if (is_v2 == false) {
-            rec = new GribV1Record(file, id);
+            rec = new GribV1Record(file, id, defer);
             if (rec->isOk() == false) {
                 delete rec;
-                rec = new GribV2Record(file, id);
+                rec = new GribV2Record(file, id, defer);
                 is_v2 = rec->isOk();
             }
         }
@@ -148,13 +322,13 @@ void GribReader::readAllGribRecords()
                 delete prevDataSet;
             }
             else {
-                rec = new GribV2Record(file, id);
+                rec = new GribV2Record(file, id, defer);
             }
 
             is_v2 = rec->isOk();
             if (rec->isOk() == false) {
                 delete rec;
-                rec = new GribV1Record(file, id);
+                rec = new GribV1Record(file, id, defer);
             }
         }
         prevDataSet = 0;
@@ -438,6 +612,27 @@ void GribReader::readGribFileContent()
     fileSize = zu_filesize(file);
     readAllGribRecords();
 
+    // the records read with their data deferred now get it from the cache,
+    // the others are unpacked now, records not kept never are
+    int dataFile = -1;
+    std::vector<GribRecord *> packed;
+    std::map < std::string, std::vector<GribRecord *>* >::iterator it;
+    for (it=mapGribRecords.begin(); it!=mapGribRecords.end(); it++)
+    {
+        std::vector<GribRecord *> *ls = (*it).second;
+        for (zuint i=0; i<ls->size(); i++) {
+            GribRecord *rec = ls->at(i);
+            if (rec->hasPackedData())
+                packed.push_back(rec);
+            if (!rec->isDataDeferred() || rec->isDataCached())
+                continue;
+            if (dataFile == -1)
+                dataFile = dataCache.addFile(fileName, fileSize);
+            rec->setDataCache(&dataCache, dataFile);
+        }
+    }
+    DecodePackedRecords(packed);
+
     createListDates();
 //    hoursBetweenRecords = computeHoursBeetweenGribRecords();
 
@@ -31,9 +31,12 @@ Reader for a GRIB file
 #endif //precompiled headers
 
 
+#include <wx/thread.h>
+
 #include <iostream>
 #include <cmath>
 #include <vector>
+#include <list>
 #include <set>
 #include <map>
 
@@ -41,6 +44,47 @@ Reader for a GRIB file
 #include "GribRecord.h"
 #include "zuFile.h"
 
+//  Decoded grids kept by the cache, it holds at least GRIB_CACHE_MIN_RECORDS
+//  of them whatever their size, so all the records of one interpolation fit.
+#define GRIB_CACHE_SIZE         (256*1024*1024)
+#define GRIB_CACHE_MIN_RECORDS  16
+
+//===============================================================
+//  Data of the records of uncompressed files is not decoded when the file
+//  is read, the records only know where their data section is.  It is
+//  decoded when first needed and dropped again, least recently used first,
+//  when the decoded grids take more than GRIB_CACHE_SIZE.
+class GribDataCache
+{
+    public:
+        GribDataCache();
+        ~GribDataCache();
+
+        int   addFile(const wxString &fname, long size);
+        void  addRecord(GribRecord *rec);
+        void  removeRecord(GribRecord *rec);
+
+        // Decode the data of rec unless it is there, and mark it used
+        bool  loadData(GribRecord *rec);
+        // Same for several records, decoded on several threads
+        void  loadData(const std::vector<GribRecord *> &recs);
+
+    private:
+        struct DataFile {
+            wxString  name;
+            long      size;
+        };
+
+        bool  readPackedData(GribRecord *rec, ZUFILE *&file, int &fileIndex);
+        void  insert(GribRecord *rec);
+        void  evict();
+
+        wxMutex                  m_mutex;
+        std::vector<DataFile>    m_files;
+        std::list<GribRecord *>  m_loaded;    // most recently used first
+        size_t                   m_bytes;
+};
+
 //===============================================================
 class GribReader
 {
@@ -102,6 +146,7 @@ class GribReader
         int       dewpointDataStatus;
 
         std::map < std::string, std::vector<GribRecord *>* >  mapGribRecords;
+        GribDataCache  dataCache;
 
         void storeRecordInMap(GribRecord *rec);
 
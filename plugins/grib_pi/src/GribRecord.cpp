@@ -25,10 +25,14 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 //#include "dychart.h"        // for some compile time fixups
 //#include "cutil.h"
 #include <stdlib.h>
+#include <algorithm>
 
 //#include <QDateTime>
 
 #include "GribRecord.h"
+#include "GribReader.h"
+#include "GribV1Record.h"
+#include "GribV2Record.h"
 
 // interpolate two angles in range +- 180 or +-PI, with resulting angle in the same range
 static double interp_angle(double a0, double a1, double d, double p)
@@ -54,14 +58,22 @@ void GribRecord::print()
 //-------------------------------------------------------------------------------
 GribRecord::GribRecord(const GribRecord &rec)
 {
+    if (rec.m_dataCache || rec.packedData)
+        rec.ensureData();
     *this = rec;
     IsDuplicated = true;
+    // the copy is not known to the cache, it keeps its own data
+    m_dataCache = NULL;
+    packedData = NULL;
+    packedSize = 0;
     // recopie les champs de bits
     if (rec.data != NULL) {
         int size = rec.Ni*rec.Nj;
         this->data = new double[size];
         for (int i=0; i<size; i++)
             this->data[i] = rec.data[i];
+        m_bdeferred = false;
+        m_dataScale = 1.0;
     }
     if (rec.BMSbits != NULL) {
         int size = rec.BMSsize;
@@ -156,49 +168,113 @@ bool GribRecord::GetInterpolatedParameters
     rec1offi = rec1offdi, rec2offi = rec2offdi;
     rec1offj = rec1offdj, rec2offj = rec2offdj;
 
-    if (!rec1.data || !rec2.data)
-        return false;
-
     return true;
 }
 
+//-------------------------------------------------------------------------------
+// Rows of the interpolated grids.  With both grids at the same resolution
+// the rows are contiguous and have no branch, the compiler vectorizes them.
+static void BlendRow(double *out, const double *row1, int step1, const double *row2, int step2,
+                     int n, double d)
+{
+    if (step1 == 1 && step2 == 1) {
+        for (int i=0; i<n; i++) {
+            double data1 = row1[i], data2 = row2[i];
+            double v = (1-d)*data1 + d*data2;
+            out[i] = (data1 == GRIB_NOTDEF || data2 == GRIB_NOTDEF) ? GRIB_NOTDEF : v;
+        }
+        return;
+    }
+    for (int i=0; i<n; i++) {
+        double data1 = row1[i*step1], data2 = row2[i*step2];
+        double v = (1-d)*data1 + d*data2;
+        out[i] = (data1 == GRIB_NOTDEF || data2 == GRIB_NOTDEF) ? GRIB_NOTDEF : v;
+    }
+}
+
+static void BlendAngleRow(double *out, const double *row1, int step1, const double *row2, int step2,
+                          int n, double d)
+{
+    for (int i=0; i<n; i++) {
+        double data1 = row1[i*step1], data2 = row2[i*step2];
+        if(data1 == GRIB_NOTDEF || data2 == GRIB_NOTDEF)
+            out[i] = GRIB_NOTDEF;
+        else
+            out[i] = interp_angle(data1, data2, d, 180.);
+    }
+}
+
+// m and a are the magnitudes and angles of PolarData()
+static void BlendPolarRow(double *outx, double *outy,
+                          const double *m1, const double *a1, int step1,
+                          const double *m2, const double *a2, int step2, int n, double d)
+{
+    for (int i=0; i<n; i++) {
+        double data1m = m1[i*step1], data2m = m2[i*step2];
+        if(data1m == GRIB_NOTDEF || data2m == GRIB_NOTDEF) {
+            outx[i] = GRIB_NOTDEF;
+            outy[i] = GRIB_NOTDEF;
+            continue;
+        }
+        double datam = (1-d)*data1m + d*data2m;
+
+        double data1a = a1[i*step1], data2a = a2[i*step2];
+             if(data1a - data2a > M_PI) data1a -= 2*M_PI;
+        else if(data2a - data1a > M_PI) data2a -= 2*M_PI;
+        double dataa = (1-d)*data1a + d*data2a;
+
+        outx[i] = datam*cos(dataa);
+        outy[i] = datam*sin(dataa);
+    }
+}
+
 //-------------------------------------------------------------------------------
 // Constructeur de interpolate
 //-------------------------------------------------------------------------------
-GribRecord * GribRecord::InterpolatedRecord(const GribRecord &rec1, const GribRecord &rec2, double d, bool dir)
+GribRecord * GribRecord::InterpolatedRecord(const GribRecord &rec1, const GribRecord &rec2, double d, bool dir,
+                                            GribRecord *reuse)
 {
     double La1, Lo1, La2, Lo2, Di, Dj;
     int im1, jm1, im2, jm2;
     int Ni, Nj, rec1offi, rec1offj, rec2offi, rec2offj;
     if(!GetInterpolatedParameters(rec1, rec2, La1, Lo1, La2, Lo2, Di, Dj,
                                   im1, jm1, im2, jm2,
-                                  Ni, Nj, rec1offi, rec1offj, rec2offi, rec2offj))
+                                  Ni, Nj, rec1offi, rec1offj, rec2offi, rec2offj)
+       || !rec1.ensureData() || !rec2.ensureData()) {
+        delete reuse;
         return NULL;
+    }
 
     // recopie les champs de bits
     int size = Ni*Nj;
-    double *data = new double[size];
-
+    double *data = NULL;
     zuchar *BMSbits = NULL;
-    if (rec1.BMSbits != NULL && rec2.BMSbits != NULL)
+    if (reuse && (int)(reuse->Ni*reuse->Nj) == size) {
+        std::swap(data, reuse->data);
+        std::swap(BMSbits, reuse->BMSbits);
+    }
+    delete reuse;
+    if (data == NULL)
+        data = new double[size];
+
+    if (rec1.BMSbits == NULL || rec2.BMSbits == NULL) {
+        delete [] BMSbits;
+        BMSbits = NULL;
+    }
+    else if (BMSbits == NULL)
         BMSbits = new zuchar[(Ni*Nj-1)/8+1]();
 
-    for (int i=0; i<Ni; i++)
-        for (int j=0; j<Nj; j++) {
-            int in=j*Ni+i;
-            int i1 = (j*jm1+rec1offj)*rec1.Ni + i*im1+rec1offi;
-            int i2 = (j*jm2+rec2offj)*rec2.Ni + i*im2+rec2offi;
-            double data1 = rec1.data[i1], data2 = rec2.data[i2];
-            if(data1 == GRIB_NOTDEF || data2 == GRIB_NOTDEF)
-                data[in] = GRIB_NOTDEF;
-            else {
-				if( !dir )
-					data[in] = (1-d)*data1 + d*data2;
-				else
-					data[in] = interp_angle(data1, data2, d, 180.);
-			}
-
-            if(BMSbits) {
+    for (int j=0; j<Nj; j++) {
+        int i1 = (j*jm1+rec1offj)*rec1.Ni + rec1offi;
+        int i2 = (j*jm2+rec2offj)*rec2.Ni + rec2offi;
+        if( !dir )
+            BlendRow(data + j*Ni, rec1.data + i1, im1, rec2.data + i2, im2, Ni, d);
+        else
+            BlendAngleRow(data + j*Ni, rec1.data + i1, im1, rec2.data + i2, im2, Ni, d);
+
+        if(BMSbits) {
+            for (int i=0; i<Ni; i++, i1 += im1, i2 += im2) {
+                int in=j*Ni+i;
                 int b1 = rec1.BMSbits[i1>>3] & 1<<(i1&7);
                 int b2 = rec2.BMSbits[i2>>3] & 1<<(i2&7);
                 if(b1 && b2)
@@ -207,6 +283,7 @@ GribRecord * GribRecord::InterpolatedRecord(const GribRecord &rec1, const GribRe
                     BMSbits[in>>3] &= ~(1<<(in&7));
             }
         }
+    }
 
     /* should maybe update strCurDate ? */
 
@@ -221,6 +298,10 @@ GribRecord * GribRecord::InterpolatedRecord(const GribRecord &rec1, const GribRe
 
     ret->data = data;
     ret->BMSbits = BMSbits;
+    ret->m_bdeferred = false;
+    ret->m_dataCache = NULL;
+    ret->m_dataScale = 1.0;
+    ret->packedData = NULL;
 
     ret->latMin = wxMin(La1, La2), ret->latMax = wxMax(La1, La2);
     ret->lonMin = Lo1, ret->lonMax = Lo2;
@@ -230,12 +311,38 @@ GribRecord * GribRecord::InterpolatedRecord(const GribRecord &rec1, const GribRe
     return ret;
 }
 
+//-------------------------------------------------------------------------------
+double *GribRecord::PolarData(const GribRecord &recx, const GribRecord &recy)
+{
+    if(!recx.ensureData() || !recy.ensureData() || !recx.isOk() || !recy.isOk() ||
+       recx.Di != recy.Di || recx.Dj != recy.Dj ||
+       recx.Ni != recy.Ni || recx.Nj != recy.Nj)
+        return NULL;
+
+    int size = recx.Ni*recx.Nj;
+    double *polar = new double[2*size];
+    double *m = polar, *a = polar + size;
+    for (int k=0; k<size; k++) {
+        double datax = recx.data[k], datay = recy.data[k];
+        if(datax == GRIB_NOTDEF || datay == GRIB_NOTDEF) {
+            m[k] = GRIB_NOTDEF;
+            a[k] = 0;
+        } else {
+            m[k] = sqrt(pow(datax, 2) + pow(datay, 2));
+            a[k] = atan2(datay, datax);
+        }
+    }
+    return polar;
+}
+
 /* for interpolation for x and y records, we must do them together because otherwise
    we end up with a vector interpolation which is not what we want.. instead we want
    to interpolate from the polar magnitude, and angles */
 GribRecord *GribRecord::Interpolated2DRecord(GribRecord *&rety,
                                              const GribRecord &rec1x, const GribRecord &rec1y,
-                                             const GribRecord &rec2x, const GribRecord &rec2y, double d)
+                                             const GribRecord &rec2x, const GribRecord &rec2y, double d,
+                                             const double *polar1, const double *polar2,
+                                             GribRecord *reusex, GribRecord *reusey)
 {
     double La1, Lo1, La2, Lo2, Di, Dj;
     int im1, jm1, im2, jm2;
@@ -244,16 +351,23 @@ GribRecord *GribRecord::Interpolated2DRecord(GribRecord *&rety,
     rety = 0;
     if(!GetInterpolatedParameters(rec1x, rec2x, La1, Lo1, La2, Lo2, Di, Dj,
                                   im1, jm1, im2, jm2,
-                                  Ni, Nj, rec1offi, rec1offj, rec2offi, rec2offj))
+                                  Ni, Nj, rec1offi, rec1offj, rec2offi, rec2offj)) {
+        delete reusex;
+        delete reusey;
         return NULL;
+    }
 
+    double *polar1tmp = NULL, *polar2tmp = NULL;
+    if (polar1 == NULL)
+        polar1 = polar1tmp = PolarData(rec1x, rec1y);
+    if (polar2 == NULL && polar1 != NULL)
+        polar2 = polar2tmp = PolarData(rec2x, rec2y);
 
-    if(!rec1y.data || !rec2y.data || !rec1y.isOk() || !rec2y.isOk() ||
-       rec1x.Di != rec1y.Di ||rec1x.Dj != rec1y.Dj ||
-       rec2x.Di != rec2y.Di ||rec2x.Dj != rec2y.Dj ||
-       rec1x.Ni != rec1y.Ni ||rec1x.Nj != rec1y.Nj ||
-       rec2x.Ni != rec2y.Ni ||rec2x.Nj != rec2y.Nj)
+    if(polar1 == NULL || polar2 == NULL)
     {
+        delete [] polar1tmp;
+        delete reusex;
+        delete reusey;
         // could also make sure lat and lon min/max are the same...
         // copy first 
         rety = new GribRecord(rec1y);
@@ -262,34 +376,27 @@ GribRecord *GribRecord::Interpolated2DRecord(GribRecord *&rety,
     }
     // recopie les champs de bits
     int size = Ni*Nj;
-    double *datax = new double[size], *datay = new double[size];
-    for (int i=0; i<Ni; i++) {
-        for (int j=0; j<Nj; j++) {
-            int in=j*Ni+i;
-            int i1 = (j*jm1+rec1offj)*rec1x.Ni + i*im1+rec1offi;
-            int i2 = (j*jm2+rec2offj)*rec2x.Ni + i*im2+rec2offi;
-            double data1x = rec1x.data[i1], data1y = rec1y.data[i1];
-            double data2x = rec2x.data[i2], data2y = rec2y.data[i2];
-            if(data1x == GRIB_NOTDEF || data1y == GRIB_NOTDEF ||
-               data2x == GRIB_NOTDEF || data2y == GRIB_NOTDEF) {
-                datax[in] = GRIB_NOTDEF;
-                datay[in] = GRIB_NOTDEF;
-            } else {
-                double data1m = sqrt(pow(data1x, 2) + pow(data1y, 2));
-                double data2m = sqrt(pow(data2x, 2) + pow(data2y, 2));
-                double datam = (1-d)*data1m + d*data2m;
-
-                double data1a = atan2(data1y, data1x);
-                double data2a = atan2(data2y, data2x);
-                     if(data1a - data2a > M_PI) data1a -= 2*M_PI;
-                else if(data2a - data1a > M_PI) data2a -= 2*M_PI;
-                double dataa = (1-d)*data1a + d*data2a;
-
-                datax[in] = datam*cos(dataa);
-                datay[in] = datam*sin(dataa);
-            }
-        }
+    double *datax = NULL, *datay = NULL;
+    if (reusex && reusey && (int)(reusex->Ni*reusex->Nj) == size && (int)(reusey->Ni*reusey->Nj) == size) {
+        std::swap(datax, reusex->data);
+        std::swap(datay, reusey->data);
     }
+    delete reusex;
+    delete reusey;
+    if (datax == NULL)
+        datax = new double[size];
+    if (datay == NULL)
+        datay = new double[size];
+
+    const double *m1 = polar1, *a1 = polar1 + rec1x.Ni*rec1x.Nj;
+    const double *m2 = polar2, *a2 = polar2 + rec2x.Ni*rec2x.Nj;
+    for (int j=0; j<Nj; j++) {
+        int i1 = (j*jm1+rec1offj)*rec1x.Ni + rec1offi;
+        int i2 = (j*jm2+rec2offj)*rec2x.Ni + rec2offi;
+        BlendPolarRow(datax + j*Ni, datay + j*Ni, m1 + i1, a1 + i1, im1, m2 + i2, a2 + i2, im2, Ni, d);
+    }
+    delete [] polar1tmp;
+    delete [] polar2tmp;
 
     /* should maybe update strCurDate ? */
 
@@ -306,6 +413,10 @@ GribRecord *GribRecord::Interpolated2DRecord(GribRecord *&rety,
     ret->data = datax;
     ret->BMSbits = NULL;
     ret->hasBMS = false; // I don't think wind or current ever use BMS correct?
+    ret->m_bdeferred = false;
+    ret->m_dataCache = NULL;
+    ret->m_dataScale = 1.0;
+    ret->packedData = NULL;
 
     ret->latMin = wxMin(La1, La2), ret->latMax = wxMax(La1, La2);
     ret->lonMin = Lo1, ret->lonMax = Lo2;
@@ -325,7 +436,7 @@ GribRecord *GribRecord::MagnitudeRecord(const GribRecord &rec1, const GribRecord
     GribRecord *rec = new GribRecord(rec1);
 
     /* generate a record which is the combined magnitude of two records */
-    if (rec1.data && rec2.data && rec1.Ni == rec2.Ni && rec1.Nj == rec2.Nj) {
+    if (rec1.ensureData() && rec2.ensureData() && rec1.Ni == rec2.Ni && rec1.Nj == rec2.Nj) {
         int size = rec1.Ni*rec1.Nj;
         for (int i=0; i<size; i++)
             if(rec1.data[i] == GRIB_NOTDEF || rec2.data[i] == GRIB_NOTDEF)
@@ -349,6 +460,8 @@ GribRecord *GribRecord::MagnitudeRecord(const GribRecord &rec1, const GribRecord
 
 void GribRecord::Polar2UV(GribRecord *pDIR, GribRecord *pSPEED)
 {
+    pDIR->detachData();
+    pSPEED->detachData();
     if (pDIR->data && pSPEED->data && pDIR->Ni == pSPEED->Ni && pDIR->Nj == pSPEED->Nj) {
         int size = pDIR->Ni*pDIR->Nj;
         for (int i=0; i<size; i++) {
@@ -373,9 +486,11 @@ void GribRecord::Polar2UV(GribRecord *pDIR, GribRecord *pSPEED)
 void GribRecord::Substract(const GribRecord &rec, bool pos)
 {
     // for now only substract records of same size
-    if (rec.data == 0 || !rec.isOk())
+    if (!rec.ensureData() || !rec.isOk())
         return;
 
+    detachData();
+
     if (data == 0 || !isOk())
         return;
         
@@ -416,9 +531,10 @@ void GribRecord::Average(const GribRecord &rec)
     // rec  : 0-11
     // compute average 11-12
 
-    if (rec.data == 0 || !rec.isOk())
+    if (!rec.ensureData() || !rec.isOk())
         return;
 
+    detachData();
     if (data == 0 || !isOk())
         return;
 
@@ -467,6 +583,8 @@ std::string GribRecord::makeKey(int dataType,int levelType,int levelValue)
 //-----------------------------------------
 GribRecord::~GribRecord()
 {
+    if (m_dataCache)
+        m_dataCache->removeRecord(this);
     if (data) {
         delete [] data;
         data = NULL;
@@ -475,6 +593,7 @@ GribRecord::~GribRecord()
         delete [] BMSbits;
         BMSbits = NULL;
     }
+    delete [] packedData;
 
 //if (dataType==GRB_TEMP) printf("record destroyed %s   %d\n", dataKey.mb_str(), (int)curDate/3600);
 }
@@ -482,7 +601,14 @@ GribRecord::~GribRecord()
 //-------------------------------------------------------------------------------
 void  GribRecord::multiplyAllData(double k)
 {
-    if (data == 0 || !isOk())
+    if (!isOk())
+        return;
+
+    // applied again when the data is next read from the file,
+    // or when it's unpacked
+    if (m_bdeferred || packedData)
+        m_dataScale *= k;
+    if (data == 0)
         return;
 
     for (zuint j=0; j<Nj; j++) {
@@ -495,6 +621,98 @@ void  GribRecord::multiplyAllData(double k)
     }
 }
 
+//-------------------------------------------------------------------------------
+bool GribRecord::ensureData() const
+{
+    if (m_dataCache)
+        return m_dataCache->loadData(const_cast<GribRecord *>(this));
+    if (packedData)
+        return const_cast<GribRecord *>(this)->decodePackedData();
+    return data != NULL;
+}
+
+//-------------------------------------------------------------------------------
+void GribRecord::ensureData(const std::vector<GribRecord *> &recs)
+{
+    for (zuint i=0; i<recs.size(); i++) {
+        if (recs[i] && recs[i]->m_dataCache) {
+            recs[i]->m_dataCache->loadData(recs);
+            return;
+        }
+    }
+}
+
+//-------------------------------------------------------------------------------
+bool GribRecord::decodePackedData()
+{
+    bool ret = packedData != NULL && unpackData();
+    delete [] packedData;
+    packedData = NULL;
+    packedSize = 0;
+
+    zuint size = Ni*Nj;
+    if (!ret) {
+        delete [] data;
+        data = new double[size];
+        for (zuint i=0; i<size; i++)
+            data[i] = GRIB_NOTDEF;
+    }
+    else if (m_dataScale != 1.0) {
+        for (zuint j=0; j<Nj; j++)
+            for (zuint i=0; i<Ni; i++)
+                if (hasValue(i, j) && data[j*Ni+i] != GRIB_NOTDEF)
+                    data[j*Ni+i] *= m_dataScale;
+    }
+    // the data is read again from the file with its scale
+    if (!m_bdeferred)
+        m_dataScale = 1.0;
+    return ret;
+}
+
+//-------------------------------------------------------------------------------
+void GribRecord::setDataCache(GribDataCache *cache, int file)
+{
+    m_dataCache = cache;
+    m_dataFile = file;
+    if (m_dataCache)
+        m_dataCache->addRecord(this);
+}
+
+//-------------------------------------------------------------------------------
+void GribRecord::detachData()
+{
+    ensureData();
+    if (m_dataCache == NULL)
+        return;
+
+    m_dataCache->removeRecord(this);
+    m_dataCache = NULL;
+    m_bdeferred = false;
+    m_dataScale = 1.0;
+}
+
+//-------------------------------------------------------------------------------
+// Copies made with the copy constructor are plain GribRecords, they never
+// have packed or deferred data
+bool GribRecord::readPackedData(ZUFILE* file)
+{
+    if (GribV1Record *rec1 = dynamic_cast<GribV1Record *>(this))
+        return rec1->readPackedData(file);
+    if (GribV2Record *rec2 = dynamic_cast<GribV2Record *>(this))
+        return rec2->readPackedData(file);
+    return false;
+}
+
+//-------------------------------------------------------------------------------
+bool GribRecord::unpackData()
+{
+    if (GribV1Record *rec1 = dynamic_cast<GribV1Record *>(this))
+        return rec1->unpackData();
+    if (GribV2Record *rec2 = dynamic_cast<GribV2Record *>(this))
+        return rec2->unpackData();
+    return false;
+}
+
 //----------------------------------------------
 void  GribRecord::setRecordCurrentDate (time_t t)
 {
@@ -882,3 +1100,115 @@ bool GribRecord::getInterpolatedValues(double &M, double &A,
     return val;
 #endif
 }
+
+//-------------------------------------------------------------------------------
+// GribPolarField
+//-------------------------------------------------------------------------------
+GribPolarField::GribPolarField(const GribRecord *GRX, const GribRecord *GRY)
+{
+    Ni = Nj = 0;
+    La1 = Lo1 = Di = Dj = 0;
+    m_xmin = m_xmax = m_ymin = m_ymax = 0;
+
+    if (!GRX || !GRY || !GRX->ok || !GRY->ok || GRX->Di==0 || GRX->Dj==0)
+        return;
+    if (GRX->Ni != GRY->Ni || GRX->Nj != GRY->Nj)
+        return;
+
+    Ni = GRX->Ni;
+    Nj = GRX->Nj;
+    La1 = GRX->La1;
+    Lo1 = GRX->Lo1;
+    Di = GRX->Di;
+    Dj = GRX->Dj;
+
+    // intersection of the extents of both records, see isXInMap and isYInMap
+    const GribRecord *recs[2] = { GRX, GRY };
+    for (int r=0; r<2; r++) {
+        const GribRecord *rec = recs[r];
+        double minLo, maxLo, minLa, maxLa;
+        if (rec->Di > 0)
+            minLo = rec->Lo1, maxLo = rec->Lo2;
+        else
+            minLo = rec->Lo2, maxLo = rec->Lo1;
+        if (rec->Lo2+rec->Di >= 360)
+            maxLo += rec->Di;
+        if (rec->Dj < 0)
+            minLa = rec->La2, maxLa = rec->La1;
+        else
+            minLa = rec->La1, maxLa = rec->La2;
+
+        if (r == 0 || minLo > m_xmin) m_xmin = minLo;
+        if (r == 0 || maxLo < m_xmax) m_xmax = maxLo;
+        if (r == 0 || minLa > m_ymin) m_ymin = minLa;
+        if (r == 0 || maxLa < m_ymax) m_ymax = maxLa;
+    }
+
+    m_polar.resize(2*Ni*Nj);
+    for (zuint j=0; j<Nj; j++)
+        for (zuint i=0; i<Ni; i++) {
+            double vx = GRX->getValue(i, j), vy = GRY->getValue(i, j);
+            float *p = &m_polar[2*(j*Ni + i)];
+            if (vx == GRIB_NOTDEF || vy == GRIB_NOTDEF) {
+                p[0] = -1;
+                p[1] = 0;
+            } else {
+                p[0] = sqrt(vx*vx + vy*vy);
+                p[1] = atan2(vx, vy);
+            }
+        }
+}
+//-------------------------------------------------------------------------------
+bool GribPolarField::getInterpolatedValues(double &M, double &A, double px, double py) const
+{
+    if (!isOk())
+        return false;
+
+    if (!isPointInMap(px,py)) {
+        px += 360.0;
+        if (!isPointInMap(px,py)) {
+            px -= 2*360.0;
+            if (!isPointInMap(px,py))
+                return false;
+        }
+    }
+    double pi, pj;     // coord. in grid unit
+    pi = (px-Lo1)/Di;
+    pj = (py-La1)/Dj;
+
+    int i0 = (int) pi;  // point 00
+    int j0 = (int) pj;
+    // on the far edge of a grid covering the whole world
+    if (i0 >= (int)Ni)
+        i0 = Ni-1;
+    if (j0 >= (int)Nj)
+        j0 = Nj-1;
+
+    unsigned int i1 = pi+1, j1 = pj+1;
+    if(i1 >= Ni)
+        i1 = i0;
+
+    if(j1 >= Nj)
+        j1 = j0;
+
+    const float *x00 = &m_polar[2*(j0*Ni + i0)], *x10 = &m_polar[2*(j0*Ni + i1)];
+    const float *x01 = &m_polar[2*(j1*Ni + i0)], *x11 = &m_polar[2*(j1*Ni + i1)];
+    if (x00[0] < 0 || x10[0] < 0 || x01[0] < 0 || x11[0] < 0)
+        return false;
+
+    double dx = pi-i0;
+    double dy = pj-j0;
+
+    dx = (3.0 - 2.0*dx)*dx*dx;   // pseudo hermite interpolation
+    dy = (3.0 - 2.0*dy)*dy*dy;
+
+    double x0m = (1-dx)*x00[0] + dx*x10[0], x0a = interp_angle(x00[1], x10[1], dx, M_PI);
+    double x1m = (1-dx)*x01[0] + dx*x11[0], x1a = interp_angle(x01[1], x11[1], dx, M_PI);
+
+    M = (1-dy)*x0m + dy*x1m;
+    A = interp_angle(x0a, x1a, dy, M_PI);
+    A *= 180 / M_PI; // degrees
+    A += 180;
+
+    return true;
+}
@@ -26,6 +26,10 @@ Elément de base d'un fichier GRIB
 
 #include <iostream>
 #include <cmath>
+#include <stdint.h>
+#include <vector>
+
+#include "zuFile.h"
 
 #define DEBUG_INFO    false
 #define DEBUG_ERROR   true
@@ -135,20 +139,80 @@ class GribCode
 		}
 };
 
+//----------------------------------------------
+// Packed values, nbBits (at most 32) each, most significant bit first
+class GribBitReader
+{
+	public:
+		GribBitReader(const zuchar *buf, size_t first)
+			: p(buf + first/8), acc(0), nacc(0) {
+			if (first%8) {
+				acc = *p++;
+				nacc = 8 - first%8;
+			}
+		}
+		zuint read(int nbBits) {
+			if (nbBits <= 0)
+				return 0;
+			while (nacc < nbBits) {
+				acc = (acc << 8) | *p++;
+				nacc += 8;
+			}
+			nacc -= nbBits;
+			return (zuint)((acc >> nacc) & ((((uint64_t)1) << nbBits) - 1));
+		}
+		// Unpack count values at once, whole bytes are copied without shifts
+		void read(int nbBits, zuint count, int *out) {
+			if (nacc%8 == 0 && (nbBits == 8 || nbBits == 16)) {
+				p -= nacc/8;
+				nacc = 0;
+				if (nbBits == 8)
+					for (zuint i=0; i<count; i++)
+						out[i] = p[i];
+				else
+					for (zuint i=0; i<count; i++)
+						out[i] = (p[2*i] << 8) | p[2*i+1];
+				p += count*(nbBits/8);
+				return;
+			}
+			for (zuint i=0; i<count; i++)
+				out[i] = read(nbBits);
+		}
+		// Skip to the next byte
+		void align() { nacc -= nacc%8; }
+	private:
+		const zuchar *p;
+		uint64_t acc;
+		int      nacc;          // bits of acc not read yet
+};
+
+class GribDataCache;
+
 //----------------------------------------------
 class GribRecord
 {
     public:
         GribRecord(const GribRecord &rec);
-        GribRecord() { m_bfilled = false;}
+        GribRecord() { m_bfilled = false; m_bdeferred = false; m_dataCache = NULL;
+                       m_dataFile = -1; m_dataScale = 1.0;
+                       packedData = NULL; packedSize = 0; }
         
         virtual ~GribRecord();
   
   
-        static GribRecord *InterpolatedRecord(const GribRecord &rec1, const GribRecord &rec2, double d, bool dir=false);
+        // A record previously returned given back as reuse has its buffers
+        // filled again if they are the right size, it is deleted otherwise.
+        static GribRecord *InterpolatedRecord(const GribRecord &rec1, const GribRecord &rec2, double d, bool dir=false,
+                                              GribRecord *reuse=NULL);
+        // polar1 and polar2 are PolarData() of rec1 and rec2, computed here if NULL
         static GribRecord *Interpolated2DRecord(GribRecord *&rety,
                                                 const GribRecord &rec1x, const GribRecord &rec1y,
-                                                const GribRecord &rec2x, const GribRecord &rec2y, double d);
+                                                const GribRecord &rec2x, const GribRecord &rec2y, double d,
+                                                const double *polar1=NULL, const double *polar2=NULL,
+                                                GribRecord *reusex=NULL, GribRecord *reusey=NULL);
+        // Magnitudes then angles of the vectors of a x and y records pair,
+        // NULL if they don't match.  Magnitude is GRIB_NOTDEF where x or y is.
+        static double *PolarData(const GribRecord &recx, const GribRecord &recy);
 
         static GribRecord *MagnitudeRecord(const GribRecord &rec1, const GribRecord &rec2);
 
@@ -158,6 +222,7 @@ class GribRecord
         void Substract(const GribRecord &rec, bool positive=true);
         void   Average(const GribRecord &rec);
 
+        int   getId() const   {return id;};
         bool  isOk()  const   {return ok;};
         bool  isDataKnown()  const   {return knownData;};
         bool  isEof() const   {return eof;};
@@ -192,12 +257,39 @@ class GribRecord
         double  getDj() const    { return Dj; }
 
         // Value at one point of the grid
-        double getValue(int i, int j) const  { return data[j*Ni+i];}
+        double getValue(int i, int j) const
+                        { if (data == NULL && !ensureData())
+                              return GRIB_NOTDEF;
+                          return data[j*Ni+i]; }
 
         void setValue(zuint i, zuint j, double v)
-                        { if (i<Ni && j<Nj)
+                        { if (m_dataCache || packedData)
+                              detachData();
+                          if (data && i<Ni && j<Nj)
                               data[j*Ni+i] = v; }
 
+        // Data of a record read lazily is decoded from its file when first
+        // needed, and may be dropped again later by the reader's cache.
+        // False if there is no data.
+        bool   ensureData() const;
+        bool   isDataDeferred() const { return m_bdeferred; }
+        bool   isDataCached() const   { return m_dataCache != NULL; }
+        void   setDataCache(GribDataCache *cache, int file);
+
+        // Records of compressed files keep their data section packed
+        // when the file is read, the reader decodes them all at once,
+        // on several threads.  False if the data can't be decoded, it is
+        // then GRIB_NOTDEF everywhere.
+        bool   hasPackedData() const  { return packedData != NULL; }
+        bool   decodePackedData();
+
+        // Decode the data of several records of the reader's cache at once
+        static void ensureData(const std::vector<GribRecord *> &recs);
+
+        // Decode the data and keep it for the life of the record, out of
+        // the reader's cache, for records other plugins can reach
+        bool   keepData() { detachData(); return data != NULL; }
+
         // Value for one point interpolated
         double  getInterpolatedValue(double px, double py, bool numericalInterpolation=true, bool dir=false) const;
 
@@ -235,6 +327,20 @@ class GribRecord
         void setFilled(bool val=true){ m_bfilled = val;}
 
     private:
+        friend class GribDataCache;
+        friend class GribPolarField;
+
+        // Read the data section again from the file, for records read
+        // with their data deferred, and unpack packedData to data.
+        // Both are safe to call for different records at the same time.
+        // Not virtual, plugins built with an older GribRecord.h share
+        // these records and their vtable.
+        bool   readPackedData(ZUFILE* file);
+        bool   unpackData();
+
+        // Make the data our own, it is modified and can't be read again
+        void   detachData();
+
         // Is a point within the extent of the grid?
         inline bool   isPointInMap(double x, double y) const;
         inline bool   isXInMap(double x) const;
@@ -299,14 +405,48 @@ class GribRecord
         zuint  BMSsize;
         zuchar *BMSbits;
         // SECTION 4: BINARY DATA SECTION (BDS)
-        double  *data;
+        mutable double  *data;
         // SECTION 5: END SECTION (ES)
 
+        // Members above keep their place, plugins built with an older
+        // GribRecord.h read them from the records of GRIB_TIMELINE_RECORD
+        bool   m_bdeferred;          // data is read from the file on demand
+        GribDataCache *m_dataCache;  // which holds the decoded data
+        int    m_dataFile;
+        double m_dataScale;          // multiplyAllData() on deferred data
+        zuchar *packedData;          // data section not decoded yet
+        zuint  packedSize;
+
         time_t makeDate(zuint year,zuint month,zuint day,zuint hour,zuint min,zuint sec);
 
 //        void   print();
 };
 
+//==========================================================================
+// Magnitude and direction of a vector field at the grid points of its two
+// records, for many getInterpolatedValues() lookups in a row without
+// going back to the records.  Gives the same values as
+// GribRecord::getInterpolatedValues(), isOk() is false if the records
+// can't be used together, they must then be read directly.
+class GribPolarField
+{
+    public:
+        GribPolarField(const GribRecord *GRX, const GribRecord *GRY);
+
+        bool isOk() const { return !m_polar.empty(); }
+        bool getInterpolatedValues(double &M, double &A, double px, double py) const;
+
+    private:
+        bool isPointInMap(double x, double y) const
+            { return x >= m_xmin && x <= m_xmax && y >= m_ymin && y <= m_ymax; }
+
+        zuint  Ni, Nj;
+        double La1, Lo1, Di, Dj;
+        double m_xmin, m_xmax, m_ymin, m_ymax;
+        // magnitude and angle of each point, magnitude is negative if undefined
+        std::vector<float> m_polar;
+};
+
 //==========================================================================
 inline bool   GribRecord::hasValue(int i, int j) const
 {
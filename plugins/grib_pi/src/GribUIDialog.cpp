@@ -127,29 +127,295 @@ wxWindow *GetGRIBCanvas()
    a subset of the input, but also would need to be recomputed when panning the screen */
 GribTimelineRecordSet::GribTimelineRecordSet(unsigned int cnt): GribRecordSet(cnt)
 {
-    for(int i=0; i<Idx_COUNT; i++)
+    for(int i=0; i<Idx_COUNT; i++) {
         m_IsobarArray[i] = NULL;
+        m_IsobarEntries[i] = NULL;
+    }
 }
 
 GribTimelineRecordSet::~GribTimelineRecordSet()
 {
     // RemoveGribRecords();
     ClearCachedData();
+    for(unsigned int i=0; i<m_CacheEntries.size(); i++)
+        GribInterpolationCache::Release(m_CacheEntries[i]);
+}
+
+void GribTimelineRecordSet::SetCachedGribRecords(int i, int iy, GribInterpolationCache::Entry *entry)
+{
+    if(!entry)
+        return;
+    m_GribRecordPtrArray[i] = entry->rec;
+    if(iy >= 0)
+        m_GribRecordPtrArray[iy] = entry->recy;
+    m_CacheEntries.push_back(entry);
+}
+
+void GribTimelineRecordSet::SetCachedIsobars(int i, GribIsoLineCache::Entry *entry)
+{
+    if(m_IsobarEntries[i])
+        GribIsoLineCache::Release(m_IsobarEntries[i]);
+    m_IsobarEntries[i] = entry;
+    m_IsobarArray[i] = entry ? entry->isolines : NULL;
 }
 
 void GribTimelineRecordSet::ClearCachedData()
 {
-    for(int i=0; i<Idx_COUNT; i++) {
-        if(m_IsobarArray[i]) {
-            //    Clear out the cached isobars
-            for( unsigned int j = 0; j < m_IsobarArray[i]->GetCount(); j++ ) {
-                IsoLine *piso = (IsoLine *) m_IsobarArray[i]->Item( j );
-                delete piso;
-            }
-            delete m_IsobarArray[i];
-            m_IsobarArray[i] = NULL;
+    //    the isobars are owned by the isoline cache
+    for(int i=0; i<Idx_COUNT; i++)
+        SetCachedIsobars(i, NULL);
+}
+
+//---------------------------------------------------------------------------------------
+//          Isolines cache
+//---------------------------------------------------------------------------------------
+GribIsoLineCache::Entry *GribIsoLineCache::Find(unsigned int counter, time_t time, int idx)
+{
+    // another file may have the same times
+    if(counter != m_counter) {
+        Clear();
+        m_counter = counter;
+        return NULL;
+    }
+
+    for(std::list<Entry *>::iterator it = m_entries.begin(); it != m_entries.end(); it++) {
+        Entry *entry = *it;
+        if(entry->time == time && entry->idx == idx) {
+            m_entries.splice(m_entries.begin(), m_entries, it);
+            entry->refs++;
+            return entry;
+        }
+    }
+    return NULL;
+}
+
+GribIsoLineCache::Entry *GribIsoLineCache::Insert(unsigned int counter, time_t time, int idx,
+                                                  wxArrayPtrVoid *isolines)
+{
+    if(counter != m_counter) {
+        Clear();
+        m_counter = counter;
+    }
+
+    Entry *entry = new Entry;
+    entry->time = time;
+    entry->idx = idx;
+    entry->isolines = isolines;
+    entry->bytes = 0;
+    for(unsigned int j = 0; j < isolines->GetCount(); j++)
+        entry->bytes += sizeof(IsoLine) + sizeof(Segment) *
+            ((IsoLine *) isolines->Item( j ))->getNbSegments();
+    entry->refs = 1;
+    entry->cached = true;
+    m_entries.push_front(entry);
+    m_bytes += entry->bytes;
+
+    // drop the others no set uses which don't fit
+    std::list<Entry *>::iterator it = m_entries.end();
+    while(m_bytes > GRIB_ISOLINE_CACHE_SIZE && it != m_entries.begin()) {
+        --it;
+        if((*it)->refs)
+            continue;
+        Entry *old = *it;
+        m_bytes -= old->bytes;
+        it = m_entries.erase(it);
+        Delete(old);
+    }
+    return entry;
+}
+
+void GribIsoLineCache::Release(Entry *entry)
+{
+    if(--entry->refs > 0 || entry->cached)
+        return;
+    Delete(entry);
+}
+
+void GribIsoLineCache::Clear()
+{
+    // entries still used are deleted when released
+    for(std::list<Entry *>::iterator it = m_entries.begin(); it != m_entries.end(); it++) {
+        (*it)->cached = false;
+        if((*it)->refs == 0)
+            Delete(*it);
+    }
+    m_entries.clear();
+    m_bytes = 0;
+}
+
+void GribIsoLineCache::Delete(Entry *entry)
+{
+    for( unsigned int j = 0; j < entry->isolines->GetCount(); j++ )
+        delete (IsoLine *) entry->isolines->Item( j );
+    delete entry->isolines;
+    delete entry;
+}
+
+//---------------------------------------------------------------------------------------
+//          Interpolated records cache
+//---------------------------------------------------------------------------------------
+GribInterpolationCache::Entry *GribInterpolationCache::Interpolated(unsigned int counter,
+                        const GribRecord &rec1, const GribRecord &rec2, double d, bool dir)
+{
+    Entry *entry = Find(counter, &rec1, &rec2, NULL, NULL, d, dir);
+    if(entry)
+        return entry;
+
+    GribRecord *reuse, *reusey;
+    Recycle(reuse, reusey);
+    delete reusey;
+    GribRecord *rec = GribRecord::InterpolatedRecord(rec1, rec2, d, dir, reuse);
+    if(!rec)
+        return NULL;
+    return Insert(&rec1, &rec2, NULL, NULL, d, dir, rec, NULL);
+}
+
+GribInterpolationCache::Entry *GribInterpolationCache::Interpolated2D(unsigned int counter,
+                        const GribRecord &rec1x, const GribRecord &rec1y,
+                        const GribRecord &rec2x, const GribRecord &rec2y, double d)
+{
+    Entry *entry = Find(counter, &rec1x, &rec2x, &rec1y, &rec2y, d, false);
+    if(entry)
+        return entry;
+
+    GribRecord *reusex, *reusey;
+    Recycle(reusex, reusey);
+    const double *polar1 = Polar(rec1x, rec1y);
+    const double *polar2 = Polar(rec2x, rec2y);
+    GribRecord *recy;
+    GribRecord *recx = GribRecord::Interpolated2DRecord(recy, rec1x, rec1y, rec2x, rec2y, d,
+                                                        polar1, polar2, reusex, reusey);
+    if(!recx)
+        return NULL;
+    return Insert(&rec1x, &rec2x, &rec1y, &rec2y, d, false, recx, recy);
+}
+
+void GribInterpolationCache::Release(Entry *entry)
+{
+    if(--entry->refs > 0 || entry->cached)
+        return;
+    delete entry->rec;
+    delete entry->recy;
+    delete entry;
+}
+
+void GribInterpolationCache::Clear()
+{
+    // entries still used are deleted when released
+    for(std::list<Entry *>::iterator it = m_entries.begin(); it != m_entries.end(); it++) {
+        (*it)->cached = false;
+        if((*it)->refs == 0) {
+            (*it)->refs = 1;
+            Release(*it);
         }
     }
+    m_entries.clear();
+    m_bytes = 0;
+
+    for(std::list<PolarField>::iterator it = m_polar.begin(); it != m_polar.end(); it++)
+        delete [] it->polar;
+    m_polar.clear();
+}
+
+GribInterpolationCache::Entry *GribInterpolationCache::Find(unsigned int counter,
+                        const GribRecord *rec1, const GribRecord *rec2,
+                        const GribRecord *rec1y, const GribRecord *rec2y, double d, bool dir)
+{
+    // records of another file may be at the same addresses
+    if(counter != m_counter) {
+        Clear();
+        m_counter = counter;
+        return NULL;
+    }
+
+    for(std::list<Entry *>::iterator it = m_entries.begin(); it != m_entries.end(); it++) {
+        Entry *entry = *it;
+        if(entry->rec1 == rec1 && entry->rec2 == rec2 && entry->rec1y == rec1y &&
+           entry->rec2y == rec2y && entry->d == d && entry->dir == dir) {
+            m_entries.splice(m_entries.begin(), m_entries, it);
+            entry->refs++;
+            return entry;
+        }
+    }
+    return NULL;
+}
+
+void GribInterpolationCache::Recycle(GribRecord *&rec, GribRecord *&recy)
+{
+    // the least recently used entry no set uses gives its buffers, when full
+    rec = recy = NULL;
+    if(m_bytes <= GRIB_INTERP_CACHE_SIZE)
+        return;
+
+    for(std::list<Entry *>::reverse_iterator it = m_entries.rbegin(); it != m_entries.rend(); it++) {
+        Entry *entry = *it;
+        if(entry->refs)
+            continue;
+        m_bytes -= Bytes(entry);
+        m_entries.erase(--(it.base()));
+        rec = entry->rec;
+        recy = entry->recy;
+        delete entry;
+        return;
+    }
+}
+
+GribInterpolationCache::Entry *GribInterpolationCache::Insert(const GribRecord *rec1, const GribRecord *rec2,
+                        const GribRecord *rec1y, const GribRecord *rec2y, double d, bool dir,
+                        GribRecord *rec, GribRecord *recy)
+{
+    Entry *entry = new Entry;
+    entry->rec1 = rec1, entry->rec2 = rec2;
+    entry->rec1y = rec1y, entry->rec2y = rec2y;
+    entry->d = d, entry->dir = dir;
+    entry->rec = rec, entry->recy = recy;
+    entry->refs = 1;
+    entry->cached = true;
+    m_entries.push_front(entry);
+    m_bytes += Bytes(entry);
+
+    // drop the others no set uses which don't fit
+    std::list<Entry *>::iterator it = m_entries.end();
+    while(m_bytes > GRIB_INTERP_CACHE_SIZE && it != m_entries.begin()) {
+        --it;
+        if((*it)->refs)
+            continue;
+        Entry *old = *it;
+        m_bytes -= Bytes(old);
+        it = m_entries.erase(it);
+        old->refs = 1;
+        old->cached = false;
+        Release(old);
+    }
+    return entry;
+}
+
+const double *GribInterpolationCache::Polar(const GribRecord &recx, const GribRecord &recy)
+{
+    for(std::list<PolarField>::iterator it = m_polar.begin(); it != m_polar.end(); it++) {
+        if(it->recx == &recx && it->recy == &recy) {
+            m_polar.splice(m_polar.begin(), m_polar, it);
+            return it->polar;
+        }
+    }
+
+    PolarField field;
+    field.recx = &recx, field.recy = &recy;
+    field.polar = GribRecord::PolarData(recx, recy);
+    if(!field.polar)
+        return NULL;
+    m_polar.push_front(field);
+    if(m_polar.size() > GRIB_INTERP_POLAR_FIELDS) {
+        delete [] m_polar.back().polar;
+        m_polar.pop_back();
+    }
+    return field.polar;
+}
+
+size_t GribInterpolationCache::Bytes(const Entry *entry)
+{
+    size_t n = (size_t)entry->rec->getNi()*entry->rec->getNj();
+    return (entry->recy ? 2 : 1)*n*sizeof(double);
 }
 
 //---------------------------------------------------------------------------------------
@@ -1320,6 +1586,17 @@ GribTimelineRecordSet* GRIBUICtrlBar::GetTimeLineRecordSet(wxDateTime time)
     if(rsa->GetCount() == 0)
         return NULL;
 
+    // unpack the records of the sets around time at once, on several threads
+    std::vector<GribRecord *> around;
+    unsigned int next = 0;
+    while(next < rsa->GetCount() && rsa->Item(next).m_Reference_Time < time)
+        next++;
+    for(unsigned int j = next ? next-1 : 0; j <= next && j < rsa->GetCount(); j++)
+        for(int i=0; i<Idx_COUNT; i++)
+            if(rsa->Item(j).m_GribRecordPtrArray[i])
+                around.push_back(rsa->Item(j).m_GribRecordPtrArray[i]);
+    GribRecord::ensureData(around);
+
     GribTimelineRecordSet *set = new GribTimelineRecordSet(m_bGRIBActiveFile->GetCounter());
     for(int i=0; i<Idx_COUNT; i++) {
         GribRecordSet *GRS1 = NULL, *GRS2 = NULL;
@@ -1371,9 +1648,8 @@ GribTimelineRecordSet* GRIBUICtrlBar::GetTimeLineRecordSet(wxDateTime time)
             GribRecord *GR1y = GRS1->m_GribRecordPtrArray[i + Idx_WIND_VY];
             GribRecord *GR2y = GRS2->m_GribRecordPtrArray[i + Idx_WIND_VY];
             if(GR1y && GR2y) {
-                GribRecord *Ry;
-                set->SetUnRefGribRecord(i, GribRecord::Interpolated2DRecord(Ry, *GR1, *GR1y, *GR2, *GR2y, interp_const));
-                set->SetUnRefGribRecord(i + Idx_WIND_VY, Ry);
+                set->SetCachedGribRecords(i, i + Idx_WIND_VY, m_InterpolationCache.Interpolated2D(
+                        m_bGRIBActiveFile->GetCounter(), *GR1, *GR1y, *GR2, *GR2y, interp_const));
                 continue;
             }
         } else if(i <= Idx_WIND_VY300)
@@ -1382,15 +1658,15 @@ GribTimelineRecordSet* GRIBUICtrlBar::GetTimeLineRecordSet(wxDateTime time)
             GribRecord *GR1y = GRS1->m_GribRecordPtrArray[Idx_SEACURRENT_VY];
             GribRecord *GR2y = GRS2->m_GribRecordPtrArray[Idx_SEACURRENT_VY];
             if(GR1y && GR2y) {
-                GribRecord *Ry;
-                set->SetUnRefGribRecord(i,  GribRecord::Interpolated2DRecord(Ry, *GR1, *GR1y, *GR2, *GR2y, interp_const));
-                set->SetUnRefGribRecord(Idx_SEACURRENT_VY, Ry);
+                set->SetCachedGribRecords(i, Idx_SEACURRENT_VY, m_InterpolationCache.Interpolated2D(
+                        m_bGRIBActiveFile->GetCounter(), *GR1, *GR1y, *GR2, *GR2y, interp_const));
                 continue;
             }
         } else if(i == Idx_SEACURRENT_VY)
             continue;
 
-        set->SetUnRefGribRecord(i,  GribRecord::InterpolatedRecord(*GR1, *GR2, interp_const, i == Idx_WVDIR));
+        set->SetCachedGribRecords(i, -1, m_InterpolationCache.Interpolated(
+                m_bGRIBActiveFile->GetCounter(), *GR1, *GR2, interp_const, i == Idx_WVDIR));
     }
 
     set->m_Reference_Time = time.GetTicks();
@@ -1821,6 +2097,7 @@ void GRIBUICtrlBar::SetFactoryOptions()
 {
     if(m_pTimelineSet)
         m_pTimelineSet->ClearCachedData();
+    m_IsoLineCache.Clear();
 
     pPlugIn->GetGRIBOverlayFactory()->ClearCachedData();
 
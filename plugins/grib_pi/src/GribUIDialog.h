@@ -67,6 +67,94 @@ WX_DECLARE_OBJARRAY( GribRecordSet, ArrayOfGribRecordSets );
 
 enum ZoneSelection { AUTO_SELECTION, SAVED_SELECTION, START_SELECTION, DRAW_SELECTION, COMPLETE_SELECTION };
 
+//  Records interpolated in time are shared by the timeline record sets
+//  using them.  Moving the timeline back and forth, or looping playback,
+//  interpolates the same pairs of records at the same times again.
+//  Unused records are kept until they take GRIB_INTERP_CACHE_SIZE, then
+//  their buffers are filled by the next interpolations.
+#define GRIB_INTERP_CACHE_SIZE    (128*1024*1024)
+#define GRIB_INTERP_POLAR_FIELDS  4
+
+class GribInterpolationCache
+{
+public:
+    struct Entry {
+        const GribRecord *rec1, *rec2, *rec1y, *rec2y;
+        double      d;
+        bool        dir;
+        GribRecord  *rec, *recy;
+        int         refs;
+        bool        cached;     // else deleted when last released
+    };
+
+    GribInterpolationCache() : m_counter(0), m_bytes(0) {}
+    ~GribInterpolationCache() { Clear(); }
+
+    // Records of the GRIBFile counter interpolated at d, NULL if they
+    // can't be.  The entry is used until it's released.
+    Entry *Interpolated(unsigned int counter, const GribRecord &rec1, const GribRecord &rec2,
+                        double d, bool dir);
+    Entry *Interpolated2D(unsigned int counter, const GribRecord &rec1x, const GribRecord &rec1y,
+                          const GribRecord &rec2x, const GribRecord &rec2y, double d);
+    static void Release(Entry *entry);
+    void Clear();
+
+private:
+    struct PolarField {
+        const GribRecord *recx, *recy;
+        double *polar;
+    };
+
+    Entry *Find(unsigned int counter, const GribRecord *rec1, const GribRecord *rec2,
+                const GribRecord *rec1y, const GribRecord *rec2y, double d, bool dir);
+    void   Recycle(GribRecord *&rec, GribRecord *&recy);
+    Entry *Insert(const GribRecord *rec1, const GribRecord *rec2, const GribRecord *rec1y,
+                  const GribRecord *rec2y, double d, bool dir, GribRecord *rec, GribRecord *recy);
+    const double *Polar(const GribRecord &recx, const GribRecord &recy);
+    static size_t Bytes(const Entry *entry);
+
+    unsigned int            m_counter;
+    std::list<Entry *>      m_entries;  // most recently used first
+    size_t                  m_bytes;
+    std::list<PolarField>   m_polar;    // same
+};
+
+//  Isolines of the records of a timeline time, kept to draw the same time
+//  again without extracting them.  Unused ones are dropped once all the
+//  segments take more than GRIB_ISOLINE_CACHE_SIZE.
+#define GRIB_ISOLINE_CACHE_SIZE   (32*1024*1024)
+
+class GribIsoLineCache
+{
+public:
+    struct Entry {
+        time_t          time;
+        int             idx;
+        wxArrayPtrVoid  *isolines;
+        size_t          bytes;
+        int             refs;
+        bool            cached;     // else deleted when last released
+    };
+
+    GribIsoLineCache() : m_counter(0), m_bytes(0) {}
+    ~GribIsoLineCache() { Clear(); }
+
+    // Isolines of record idx of the GRIBFile counter at time, NULL if they
+    // aren't known.  The entry is used until it's released.
+    Entry *Find(unsigned int counter, time_t time, int idx);
+    // Keep isolines, they are owned by the cache
+    Entry *Insert(unsigned int counter, time_t time, int idx, wxArrayPtrVoid *isolines);
+    static void Release(Entry *entry);
+    void Clear();
+
+private:
+    static void Delete(Entry *entry);
+
+    unsigned int            m_counter;
+    std::list<Entry *>      m_entries;  // most recently used first
+    size_t                  m_bytes;
+};
+
 class GribTimelineRecordSet : public GribRecordSet
 {
 public:
@@ -75,9 +163,17 @@ public:
     ~GribTimelineRecordSet();
 
     void ClearCachedData();
+    // records i and iy (if not -1) of the entry are used by the set
+    void SetCachedGribRecords(int i, int iy, GribInterpolationCache::Entry *entry);
+    // isobars of the entry are the isobars of record i
+    void SetCachedIsobars(int i, GribIsoLineCache::Entry *entry);
 
     /* cache isobars here to speed up rendering */
     wxArrayPtrVoid *m_IsobarArray[Idx_COUNT];
+
+private:
+    std::vector<GribInterpolationCache::Entry *> m_CacheEntries;
+    GribIsoLineCache::Entry *m_IsobarEntries[Idx_COUNT];
 };
 
 //----------------------------------------------------------------------------------------------------------
@@ -130,6 +226,7 @@ public:
     GribRequestSetting  *pReq_Dialog;
     GRIBFile        *m_bGRIBActiveFile;
 	bool            m_bDataPlot[GribOverlaySettings::GEO_ALTITUDE];  //only for no altitude parameters
+    GribIsoLineCache m_IsoLineCache;
 	bool            m_CDataIsShown;
     int             m_ZoneSelAllowed;
     int             m_old_DialogStyle;
@@ -190,6 +287,8 @@ private:
     wxArrayString    m_file_names;   /* selected files */
     wxString         m_grib_dir;
 	wxSize           m_DialogsOffset;
+
+    GribInterpolationCache m_InterpolationCache;
 };
 
 //----------------------------------------------------------------------------------------------------------
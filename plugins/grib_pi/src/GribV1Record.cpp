@@ -191,9 +191,10 @@ void  GribV1Record::translateDataType()
 //-------------------------------------------------------------------------------
 // Lecture depuis un fichier
 //-------------------------------------------------------------------------------
-GribV1Record::GribV1Record(ZUFILE* file, int id_)
+GribV1Record::GribV1Record(ZUFILE* file, int id_, bool deferData)
 {
     id = id_;
+    m_bdeferred = deferData;
 //   seekStart = zu_tell(file);           // moved to section 0 read
     data    = NULL;
     BMSbits = NULL;
@@ -294,25 +295,6 @@ GribV1Record::~GribV1Record()
 {
 }
 
-//----------------------------------------------
-static zuint readPackedBits(zuchar *buf, zuint first, zuint nbBits)
-{
-#if 0
-    // should test when loading nbBitsInPack?
-    if (nbBits == 0 || nbBits > 31) {
-        // x >> 32 is undefined behavior, on x86 it returns x
-        return 0;
-    }
-#endif    
-    zuint oct = first / 8;
-    zuint bit = first % 8;
-
-    zuint val = (buf[oct]<<24) + (buf[oct+1]<<16) + (buf[oct+2]<<8) + (buf[oct+3]);
-    val = val << bit;
-    val = val >> (32-nbBits);
-    return val;
-}
-
 //==============================================================
 // Lecture des données
 //==============================================================
@@ -578,21 +560,44 @@ bool GribV1Record::readGribSection4_BDS(ZUFILE* file) {
         ok = false;
         return ok;
     }
-    zuint  startbit  = 0;
-    int  datasize = sectionSize4-11;
-    zuchar *buf = new zuchar[datasize+4]();  // +4 pour simplifier les décalages ds readPackedBits
+    // read later, by readPackedData()
+    if (m_bdeferred)
+        return ok;
 
-    if (zu_read(file, buf, datasize) != datasize) {
+    // unpacked later, by the reader
+    packedSize = sectionSize4-11;
+    packedData = new zuchar[packedSize+4]();  // +4 pour simplifier les décalages
+
+    if (zu_read(file, packedData, packedSize) != (int)packedSize) {
         erreur("Record %d: data read error",id);
         ok = false;
         eof = true;
     }
-    if (!ok) {
-        delete [] buf;
-        return ok;
+    return ok;
+}
+
+//----------------------------------------------
+bool GribV1Record::readPackedData(ZUFILE* file)
+{
+    packedSize = sectionSize4-11;
+    packedData = new zuchar[packedSize+4]();  // +4 pour simplifier les décalages
+
+    if (zu_seek(file, fileOffset4+11, SEEK_SET) != 0
+            || zu_read(file, packedData, packedSize) != (int)packedSize) {
+        delete [] packedData;
+        packedData = NULL;
+        return false;
     }
+    return true;
+}
+
+//----------------------------------------------
+bool GribV1Record::unpackData()
+{
+    GribBitReader bits(packedData, 0);
 
     // Allocate memory for the data
+    delete [] data;
     data = new double[Ni*Nj];
 
     // Read data in the order given by isAdjacentI
@@ -615,9 +620,8 @@ bool GribV1Record::readGribSection4_BDS(ZUFILE* file) {
 #endif
 
                 if (hasValue(i,j)) {
-                    x = readPackedBits(buf, startbit, nbBitsInPack);
+                    x = bits.read(nbBitsInPack);
                     data[ind] = (refValue + x*scaleFactorEpow2)/decimalFactorD;
-                    startbit += nbBitsInPack;
                     //printf(" %d %d %f ", i,j, data[ind]);
                 }
                 else {
@@ -641,8 +645,7 @@ bool GribV1Record::readGribSection4_BDS(ZUFILE* file) {
 #endif
 
                 if (hasValue(i,j)) {
-                    x = readPackedBits(buf, startbit, nbBitsInPack);
-                    startbit += nbBitsInPack;
+                    x = bits.read(nbBitsInPack);
                     data[ind] = (refValue + x*scaleFactorEpow2)/decimalFactorD;
                     //printf(" %d %d %f ", i,j, data[ind]);
                 }
@@ -652,9 +655,7 @@ bool GribV1Record::readGribSection4_BDS(ZUFILE* file) {
             }
         }
     }
-
-    delete [] buf;
-    return ok;
+    return true;
 }
 
 
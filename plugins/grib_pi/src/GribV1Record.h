@@ -35,7 +35,7 @@ Elément de base d'un fichier GRIB V1
 class GribV1Record : public GribRecord
 {
     public:
-        GribV1Record(ZUFILE* file, int id_);
+        GribV1Record(ZUFILE* file, int id_, bool deferData = false);
         GribV1Record(const GribRecord &rec);
         GribV1Record() {}
 
@@ -44,6 +44,12 @@ class GribV1Record : public GribRecord
     protected:
 
     private:
+        friend class GribRecord;
+
+        // Called by GribRecord::readPackedData() and unpackData()
+        bool   readPackedData(ZUFILE* file);
+        bool   unpackData();
+
         zuint  periodSeconds(zuchar unit, zuchar P1, zuchar P2, zuchar range);
         //-----------------------------------------
         void    translateDataType();  // adapte les codes des différents centres météo
@@ -43,6 +43,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 #ifdef JASPER
 #include <jasper/jasper.h>
+#include <wx/thread.h>
 #endif
 
 const double GRIB_MISSING_VALUE = GRIB_NOTDEF;
@@ -690,7 +691,7 @@ static bool unpackBMS(GRIBMessage *grib_msg)
 	grib_msg->md.bms = new zuchar[grib_msg->md.bmssize];
 	memcpy (grib_msg->md.bms, b + 6, grib_msg->md.bmssize);
 	for (n=0; n < len; n++) {
-	  getBits(grib_msg->buffer, &bit, grib_msg->offset+48+n, 1);
+	  bit = (b[6 +n/8] >> (7 -n%8)) & 1;
 	  grib_msg->md.bitmap[n]=bit;
 	}
 	break;
@@ -713,7 +714,7 @@ static bool unpackBMS(GRIBMessage *grib_msg)
 // Section 7: Data Section
 static bool unpackDS(GRIBMessage *grib_msg)
 {
-  int off,pval, l;
+  int pval, l;
   unsigned int n, m;
   struct {
     int *ref_vals,*widths;
@@ -727,15 +728,24 @@ static bool unpackDS(GRIBMessage *grib_msg)
   groups.omin = 0;
   groups.first_vals = nullptr;
 
-  off= grib_msg->offset+40;
+  GribBitReader bits(grib_msg->buffer, grib_msg->offset+40);
   switch (grib_msg->md.drs_templ_num) {
     case 0:
 	grib_msg->grids.gridpoints = new double[grib_msg->md.ny *grib_msg->md.nx];
+	if (grib_msg->md.bitmap == NULL) {
+	  // all the values at once, then scaled
+	  int npoints = grib_msg->md.ny*grib_msg->md.nx;
+	  int *pvals = new int[npoints];
+	  bits.read(grib_msg->md.pack_width, npoints, pvals);
+	  for (l=0; l < npoints; l++)
+	    grib_msg->grids.gridpoints[l]=grib_msg->md.R+pvals[l]*E/D;
+	  delete [] pvals;
+	  break;
+	}
 	for (l=0; l < grib_msg->md.ny*grib_msg->md.nx; l++) {
-	  if (grib_msg->md.bitmap == NULL || grib_msg->md.bitmap[l] == 1) {
-	    getBits(grib_msg->buffer,&pval,off,grib_msg->md.pack_width);
+	  if (grib_msg->md.bitmap[l] == 1) {
+	    pval = bits.read(grib_msg->md.pack_width);
 	    grib_msg->grids.gridpoints[l]=grib_msg->md.R+pval*E/D;
-	    off+=grib_msg->md.pack_width;
 	  }
 	  else
 	    grib_msg->grids.gridpoints[l]=GRIB_MISSING_VALUE;
@@ -746,16 +756,16 @@ static bool unpackDS(GRIBMessage *grib_msg)
           if (grib_msg->md.complex_pack.spatial_diff.order) {
 	      groups.first_vals= new int[grib_msg->md.complex_pack.spatial_diff.order];
 	      for (n=0; n < grib_msg->md.complex_pack.spatial_diff.order; ++n) {
-	          getBits(grib_msg->buffer,&groups.first_vals[n],off,grib_msg->md.complex_pack.spatial_diff.order_vals_width*8);
-	          off+=grib_msg->md.complex_pack.spatial_diff.order_vals_width*8;
+	          groups.first_vals[n] = bits.read(grib_msg->md.complex_pack.spatial_diff.order_vals_width*8);
               }
 	  }
-	  getBits(grib_msg->buffer,&groups.sign,off,1);
-	  getBits(grib_msg->buffer,&groups.omin,off+1,grib_msg->md.complex_pack.spatial_diff.order_vals_width*8-1);
-	  if (groups.sign == 1) {
-	    groups.omin=-groups.omin;
+	  if (grib_msg->md.complex_pack.spatial_diff.order_vals_width > 0) {
+	    groups.sign = bits.read(1);
+	    groups.omin = bits.read(grib_msg->md.complex_pack.spatial_diff.order_vals_width*8-1);
+	    if (groups.sign == 1) {
+	      groups.omin=-groups.omin;
+	    }
 	  }
-	  off+=grib_msg->md.complex_pack.spatial_diff.order_vals_width*8;
 	}
 	// fall through
     case 2:
@@ -777,24 +787,17 @@ static bool unpackDS(GRIBMessage *grib_msg)
 	groups.widths   = new int[grib_msg->md.complex_pack.num_groups];
 	groups.lengths  = new int[grib_msg->md.complex_pack.num_groups];
 
-	for (n=0; n < grib_msg->md.complex_pack.num_groups; ++n) {
-	  getBits(grib_msg->buffer,&groups.ref_vals[n],off,grib_msg->md.pack_width);
-	  off+=grib_msg->md.pack_width;
-	}
-	off = (off + 7) & ~7; // byte boundary padding 
+	bits.read(grib_msg->md.pack_width, grib_msg->md.complex_pack.num_groups, groups.ref_vals);
+	bits.align(); // byte boundary padding 
 
+	bits.read(grib_msg->md.complex_pack.width.pack_width, grib_msg->md.complex_pack.num_groups, groups.widths);
 	for (n=0; n < grib_msg->md.complex_pack.num_groups; ++n) {
-	  getBits(grib_msg->buffer,&groups.widths[n],off,grib_msg->md.complex_pack.width.pack_width);
           groups.widths[n] += grib_msg->md.complex_pack.width.ref;
-	  off+=grib_msg->md.complex_pack.width.pack_width;
 	}
-	off = (off + 7) & ~7;
+	bits.align();
 
-	for (n=0; n < grib_msg->md.complex_pack.num_groups; ++n) {
-	  getBits(grib_msg->buffer,&groups.lengths[n],off,grib_msg->md.complex_pack.length.pack_width);
-	  off+=grib_msg->md.complex_pack.length.pack_width;
-	}
-	off = (off + 7) & ~7;
+	bits.read(grib_msg->md.complex_pack.length.pack_width, grib_msg->md.complex_pack.num_groups, groups.lengths);
+	bits.align();
 
 	groups.max_length=0;
 	for (n=0; n < grib_msg->md.complex_pack.num_groups-1; ++n) {
@@ -821,8 +824,7 @@ static bool unpackDS(GRIBMessage *grib_msg)
                     grib_msg->grids.gridpoints[l]=GRIB_MISSING_VALUE;
                   }
                   else {
-                    getBits(grib_msg->buffer,&pval,off,groups.widths[n]);
-                    off+=groups.widths[n];
+                    pval = bits.read(groups.widths[n]);
 		      if (pval == groups.group_miss_val) {
                          grib_msg->grids.gridpoints[l]=GRIB_MISSING_VALUE;
 		      }
@@ -908,8 +910,12 @@ static bool unpackDS(GRIBMessage *grib_msg)
 	npoints = grib_msg->md.ny*grib_msg->md.nx;
 	jvals= new int[npoints];
 	grib_msg->grids.gridpoints= new double[npoints];
-	if (len > 0)
+	if (len > 0) {
+	  // records are unpacked on several threads, jasper isn't reentrant
+	  static wxMutex s_jasperMutex;
+	  wxMutexLocker lock(s_jasperMutex);
 	  dec_jpeg2000((char *)&grib_msg->buffer[grib_msg->offset/8+5],len,jvals);
+	}
 	cnt=0;
 	for (l=0; l < npoints; l++) {
 	  if (grib_msg->md.bitmap == NULL || grib_msg->md.bitmap[l] == 1) {
@@ -1388,6 +1394,7 @@ void GribV2Record::readDataSet(ZUFILE* file)
     hasBMS = false;
     knownData = false;
     IsDuplicated = false;
+    m_dataScale = 1.0;
 
     while (strncmp(&((char *)grib_msg->buffer)[grib_msg->offset/8],"7777",4) != 0) {
         DS = false;
@@ -1484,6 +1491,7 @@ void GribV2Record::readDataSet(ZUFILE* file)
 	case 5: //  Section 5: Data Representation Section 
 	     if (skip == true)  break;
 	     ok = unpackDRS(grib_msg);
+	     drsOffset = grib_msg->offset/8;
 	     break;
 	case 6: //  Section 6: Bit-Map Section 
 	     if (skip == true)  break;
@@ -1499,11 +1507,14 @@ void GribV2Record::readDataSet(ZUFILE* file)
 	     break;
 	case 7:  // Section 7: Data Section
 	     if (skip == false) {
-    	         ok = unpackDS(grib_msg);
-    	         if (ok) {
-	             data = grib_msg->grids.gridpoints;
-	             grib_msg->grids.gridpoints = 0;
-                 }
+	         // unpacked later, by the reader or the cache
+	         dsOffset = grib_msg->offset/8;
+	         dsEnd = dsOffset +len;
+	         if (!m_bdeferred && dsOffset > drsOffset) {
+	             packedSize = dsEnd -drsOffset;
+	             packedData = new zuchar[packedSize +4]();
+	             memcpy(packedData, grib_msg->buffer +drsOffset, packedSize);
+	         }
 	     }
 	     if (grib_msg->num_grids != 1)
     	         DS = true;
@@ -1539,9 +1550,11 @@ printf("hasBMS=%d\n", hasBMS);
 }
 
 // -----------------
-GribV2Record::GribV2Record(ZUFILE* file, int id_)
+GribV2Record::GribV2Record(ZUFILE* file, int id_, bool deferData)
 {
     id = id_;
+    m_bdeferred = deferData;
+    drsOffset = dsOffset = dsEnd = 0;
     seekStart = zu_tell(file);           // moved to section 0 read
     data    = NULL;
     BMSsize = 0;
@@ -1617,6 +1630,53 @@ GribV2Record::GribV2Record(ZUFILE* file, int id_)
     readDataSet(file);
 }
 
+// ---------------------------------------
+bool GribV2Record::readPackedData(ZUFILE* file)
+{
+    if (dsEnd <= dsOffset || dsOffset <= drsOffset)
+        return false;
+
+    // sections 5 to 7 only
+    packedSize = dsEnd -drsOffset;
+    packedData = new zuchar[packedSize +4]();
+    if (zu_seek(file, seekStart +drsOffset, SEEK_SET) != 0
+        || zu_read(file, packedData, packedSize) != (int)packedSize) {
+        delete [] packedData;
+        packedData = NULL;
+        return false;
+    }
+    return true;
+}
+
+// ---------------------------------------
+bool GribV2Record::unpackData()
+{
+    // decode sections 5 to 7 as a message of their own
+    GRIBMessage msg;
+    msg.buffer = packedData;
+    packedData = NULL;
+    msg.offset = 0;
+    if (!unpackDRS(&msg))
+        return false;
+
+    msg.md.nx = Ni;
+    msg.md.ny = Nj;
+    if (hasBMS) {
+        msg.md.bitmap = new unsigned char[BMSsize*8];
+        for (zuint n=0; n < BMSsize*8; n++)
+            msg.md.bitmap[n] = (BMSbits[n/8] >> (7 -n%8)) & 1;
+    }
+
+    msg.offset = (dsOffset -drsOffset)*8;
+    if (!unpackDS(&msg) || msg.grids.gridpoints == 0)
+        return false;
+
+    delete [] data;
+    data = msg.grids.gridpoints;
+    msg.grids.gridpoints = 0;
+    return true;
+}
+
 // ---------------------------------------
 bool GribV2Record::hasMoreDataSet() const
 {
@@ -1626,7 +1686,11 @@ bool GribV2Record::hasMoreDataSet() const
 // ---------------------------------------
 GribV2Record *GribV2Record::GribV2NextDataSet(ZUFILE* file, int id_)
 {
+    // the copy doesn't need this data set, don't unpack it now
+    zuchar *packed = packedData;
+    packedData = NULL;
     GribV2Record *rec1 = new GribV2Record(*this);
+    packedData = packed;
     // XXX should have a shallow copy constructor 
     delete [] rec1->data;
     delete [] rec1->BMSbits;
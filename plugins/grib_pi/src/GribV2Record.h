@@ -36,7 +36,7 @@ class  GRIBMessage;
 class GribV2Record : public GribRecord
 {
     public:
-        GribV2Record(ZUFILE* file, int id_);
+        GribV2Record(ZUFILE* file, int id_, bool deferData = false);
         GribV2Record(const GribRecord &rec);
         GribV2Record() { grib_msg = 0;}
 
@@ -47,6 +47,12 @@ class GribV2Record : public GribRecord
         bool hasMoreDataSet() const;
 
     private:
+        friend class GribRecord;
+
+        // Called by GribRecord::readPackedData() and unpackData()
+        bool   readPackedData(ZUFILE* file);
+        bool   unpackData();
+
         zuint  periodSeconds(zuchar unit, zuint P1, zuint P2, zuchar range);
         void   readDataSet(ZUFILE* file);
         class  GRIBMessage *grib_msg;
@@ -95,6 +101,11 @@ class GribV2Record : public GribRecord
         double scaleFactorEpow2;
         double refValue;
         zuint  nbBitsInPack;
+        // Data representation to end of data section, from seekStart,
+        // for decoding the data later.  packedData holds these bytes.
+        zuint  drsOffset;
+        zuint  dsOffset;
+        zuint  dsEnd;
         // SECTION 5: END SECTION (ES)
 
         //---------------------------------------------
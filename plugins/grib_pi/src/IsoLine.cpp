@@ -28,6 +28,9 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 //#include "georef.h"
 #include <wx/graphics.h>
 
+#include <algorithm>
+#include <unordered_map>
+
 #include "IsoLine.h"
 #include "GribSettingsDialog.h"
 #include "GribOverlayFactory.h"
@@ -168,7 +171,7 @@ double      round_msvc (double x)
 }
 
 //---------------------------------------------------------------
-IsoLine::IsoLine(double val, double coeff, double offset, const GribRecord *rec_)
+IsoLine::IsoLine(double val, const GribRecord *rec_)
 {
     if(wxGetDisplaySize().x > 0){
         m_pixelMM = PlugInGetDisplaySizeMM() / wxGetDisplaySize().x;
@@ -177,65 +180,57 @@ IsoLine::IsoLine(double val, double coeff, double offset, const GribRecord *rec_
     else
         m_pixelMM = 0.27;               // semi-standard number...
 
-    value = val/coeff-offset;
+    value = val;
 
     rec = rec_;
     W = rec_->getNi();
     H = rec_->getNj();
-
-    //---------------------------------------------------------
-    // Génère la liste des segments.
-    extractIsoLine(rec_);
-
-    value = val;
-
-    if(trace.size() == 0)
-          return;
-
-    //      Join the isoline segments into a nice list
-    //      Which is end-to-end continuous and unidirectional
-
-    //      Create a master wxList of the trace list
-    std::list<Segment *>::iterator it;
-    for (it=trace.begin(); it!=trace.end(); it++)
-    {
-          Segment *seg = *it;
-          seg->bUsed = false;
-          m_seglist.Append(*it);
+}
+//---------------------------------------------------------------
+IsoLine::IsoLine(double val, double coeff, double offset, const GribRecord *rec_)
+{
+    if(wxGetDisplaySize().x > 0){
+        m_pixelMM = PlugInGetDisplaySizeMM() / wxGetDisplaySize().x;
+        m_pixelMM = wxMax(.02, m_pixelMM);          // protect against bad data
     }
+    else
+        m_pixelMM = 0.27;               // semi-standard number...
 
-    //      Isoline may be discontinuous....
-    //      So build a list of continuous segments
-    bool bdone = false;
-    while(!bdone)
-    {
-          MySegList *ps = BuildContinuousSegment();
-
-          m_SegListList.Append(ps);
+    value = val;
 
-          MySegList::Node *node;
-          Segment *seg;
+    rec = rec_;
+    W = rec_->getNi();
+    H = rec_->getNj();
 
-          // recreate the master list, removing used segs
+    //---------------------------------------------------------
+    // Génère la liste des segments.
+    std::vector<std::vector<Segment *> > segs;
+    extractIsoLines(rec_, std::vector<double>(1, val/coeff-offset), segs);
+    trace.assign(segs[0].begin(), segs[0].end());
 
-          node = m_seglist.GetFirst();
-          while(node)
-          {
-                seg = node->GetData();
-                if(seg->bUsed)
-                {
-                      m_seglist.Erase(node);
-                      node = m_seglist.GetFirst();
-                }
-                else
-                      node = node->GetNext();
-          }
+    JoinSegments();
 
-          if(0 == m_seglist.GetCount())
-                bdone = true;
+///printf("create Isobar : press=%4.0f long=%d\n", pressure/100, trace.size());
+}
+//---------------------------------------------------------------
+void IsoLine::BuildIsoLines(const std::vector<double> &values, const std::vector<double> &raw,
+                            const GribRecord *rec, std::vector<IsoLine *> &isolines)
+{
+    std::vector<std::vector<Segment *> > segs;
+    extractIsoLines(rec, raw, segs);
+
+    size_t first = isolines.size();
+    for(size_t k = 0; k < values.size(); k++) {
+        IsoLine *piso = new IsoLine(values[k], rec);
+        piso->trace.assign(segs[k].begin(), segs[k].end());
+        isolines.push_back(piso);
     }
 
-///printf("create Isobar : press=%4.0f long=%d\n", pressure/100, trace.size());
+    // the isolines are independent
+    ParallelFor(values.size(), 1, [&](size_t begin, size_t end) {
+        for(size_t k = begin; k < end; k++)
+            isolines[first + k]->JoinSegments();
+    });
 }
 //---------------------------------------------------------------
 IsoLine::~IsoLine()
@@ -254,133 +249,87 @@ IsoLine::~IsoLine()
 
 }
 
+namespace {
+struct SegmentEnd {
+    double x, y;
+    bool operator==(const SegmentEnd &o) const { return x == o.x && y == o.y; }
+};
 
-MySegList *IsoLine::BuildContinuousSegment(void)
-{
-      MySegList::Node *node;
-      Segment *seg;
-
-      MySegList *ret_list = new MySegList;
-
-    //     Build a chain extending from the "2" end of the target segment
-    //      The joined list, side 2...
-      MySegList segjoin2;
-
-    //      Add any first segment to the list
-      node = m_seglist.GetFirst();
-      Segment *seg0 = node->GetData();
-      seg0->bUsed = true;
-      segjoin2.Append(seg0);
-
-      Segment *tseg = seg0;
-
-      while(tseg)
-      {
-            bool badded = false;
-            Segment *seg;
-            node = m_seglist.GetFirst();
-            while (node)
-            {
-                  seg = node->GetData();
-
-                  if((!seg->bUsed) && (seg->py1 == tseg->py2) && (seg->px1 == tseg->px2))              // fits without reverse
-                  {
-                        seg->bUsed = true;
-                        segjoin2.Append(seg);
-                        badded = true;
-                        break;
-                  }
-                  else if((!seg->bUsed) && (seg->py2 == tseg->py2) && (seg->px2 == tseg->px2))         // fits, needs reverse
-                  {
-                        seg->bUsed = true;
-                        double a = seg->px2; seg->px2 = seg->px1; seg->px1 = a;
-                        double b = seg->py2; seg->py2 = seg->py1; seg->py1 = b;
-                        segjoin2.Append(seg);
-                        badded = true;
-                        break;
-                  }
-
-                  node = node->GetNext();
-            }
-            if(badded == true)
-                  tseg = seg;
-            else
-                  tseg = NULL;
-      }
-
-
-
-    //     Build a chain extending from the "1" end of the target segment
-    //      The joined list, side 1...
-      MySegList segjoin1;
-
-    //      Add the same first segment to the list
-      node = m_seglist.GetFirst();
-      seg0 = node->GetData();
-      seg0->bUsed = true;
-      segjoin1.Append(seg0);
+struct SegmentEndHash {
+    size_t operator()(const SegmentEnd &e) const
+        { return std::hash<double>()(e.x) * 31 + std::hash<double>()(e.y); }
+};
+}
 
-      tseg = seg0;
+void IsoLine::JoinSegments()
+{
+    //      Join the isoline segments into a nice list
+    //      Which is end-to-end continuous and unidirectional
+    std::vector<Segment *> segs(trace.begin(), trace.end());
+    if(segs.empty())
+        return;
+
+    //      The segments at each end point, in trace order, 2*index for
+    //      the "1" end and 2*index + 1 for the "2" end.  Segments not used
+    //      yet are never reversed, so their ends don't change.
+    std::unordered_map<SegmentEnd, std::vector<size_t>, SegmentEndHash> ends;
+    for(size_t i = 0; i < segs.size(); i++) {
+        segs[i]->bUsed = false;
+        SegmentEnd e1 = { segs[i]->px1, segs[i]->py1 };
+        SegmentEnd e2 = { segs[i]->px2, segs[i]->py2 };
+        ends[e1].push_back(2*i);
+        ends[e2].push_back(2*i + 1);
+    }
 
-      while(tseg)
-      {
-            bool badded = false;
-            node = m_seglist.GetFirst();
-            while (node)
-            {
-                  seg = node->GetData();
-
-                  if((!seg->bUsed) && (seg->py2 == tseg->py1) && (seg->px2 == tseg->px1))              // fits without reverse
-                  {
-                        seg->bUsed = true;
-                        segjoin1.Append(seg);
-                        badded = true;
-                        break;
-                  }
-                  else if((!seg->bUsed) && (seg->py1 == tseg->py1) && (seg->px1 == tseg->px1))         // fits, needs reverse
-                  {
-                        seg->bUsed = true;
-                        double a = seg->px2; seg->px2 = seg->px1; seg->px1 = a;
-                        double b = seg->py2; seg->py2 = seg->py1; seg->py1 = b;
-                        segjoin1.Append(seg);
-                        badded = true;
-                        break;
-                  }
-
-                  node = node->GetNext();
+    //      First unused segment with an end at x, y; reversed so its
+    //      "1" end (side 2) or its "2" end (side 1) is there
+    auto next = [&](double x, double y, bool side2) -> Segment * {
+        SegmentEnd e = { x, y };
+        auto it = ends.find(e);
+        if(it == ends.end())
+            return NULL;
+        for(size_t n = 0; n < it->second.size(); n++) {
+            Segment *seg = segs[it->second[n] / 2];
+            if(seg->bUsed)
+                continue;
+            seg->bUsed = true;
+            if((it->second[n] % 2 == 1) == side2) {         // fits, needs reverse
+                double a = seg->px2; seg->px2 = seg->px1; seg->px1 = a;
+                double b = seg->py2; seg->py2 = seg->py1; seg->py1 = b;
             }
-            if(badded == true)
-                  tseg = seg;
-            else
-                  tseg = NULL;
-      }
-
-
-     //     Now have two lists...
-
-     //     Start with "1" side list,
-     //    starting from the end, and skipping the first segment
-
-      int n1 = segjoin1.GetCount();
-      for(int i=n1 - 1 ; i > 0 ; i--)
-      {
-            node = segjoin1.Item( i );
-            seg = node->GetData();
-            ret_list->Append(seg);
-      }
-
-     //     Now add the "2"side list
-      int n2 = segjoin2.GetCount();
-      for(int i=0 ; i < n2 ; i++)
-      {
-            node = segjoin2.Item(i);
-            seg = node->GetData();
-            ret_list->Append(seg);
-      }
-
-     //     And there it is
+            return seg;
+        }
+        return NULL;
+    };
 
-      return ret_list;
+    //      Isoline may be discontinuous....
+    //      So build a list of continuous segments
+    for(size_t first = 0; first < segs.size(); first++) {
+        Segment *seg0 = segs[first];
+        if(seg0->bUsed)
+            continue;
+        seg0->bUsed = true;
+
+        //     Build a chain extending from the "2" end of the target segment
+        std::vector<Segment *> segjoin2(1, seg0);
+        for(Segment *tseg = seg0; (tseg = next(tseg->px2, tseg->py2, true)); )
+            segjoin2.push_back(tseg);
+
+        //     Build a chain extending from the "1" end of the target segment
+        std::vector<Segment *> segjoin1(1, seg0);
+        for(Segment *tseg = seg0; (tseg = next(tseg->px1, tseg->py1, false)); )
+            segjoin1.push_back(tseg);
+
+        //     Start with "1" side list, from the end, skipping the first
+        //     segment, then add the "2" side list
+        MySegList *ps = new MySegList;
+        for(size_t i = segjoin1.size() - 1; i > 0; i--)
+            ps->Append(segjoin1[i]);
+        for(size_t i = 0; i < segjoin2.size(); i++)
+            ps->Append(segjoin2[i]);
+
+        m_SegListList.Append(ps);
+    }
 }
 
 
@@ -686,41 +635,11 @@ void Segment::traduitCode(int I, int w, int J, char c1, int &i, int &j) {
 }
 
 //-----------------------------------------------------------------------
-// Génère la liste des segments.
-// Les coordonnées sont les indices dans la grille du GribRecord
-//---------------------------------------------------------
-void IsoLine::extractIsoLine(const GribRecord *rec)
+// Segments of the value in the square ab-cd of the grid
+//-----------------------------------------------------------------------
+static void cellSegments(int ni, int W, int j, double a, double b, double c, double d,
+                         double value, const GribRecord *rec, std::vector<Segment *> &trace)
 {
-    int i, j, W, H;
-    double  a,b,c,d;
-    W = rec->getNi();
-    H = rec->getNj();
-
-    int We = W;
-    if(rec->getLonMax() + rec->getDi() - rec->getLonMin() == 360)
-        We++;
-
-    for (j=1; j<H; j++)     // !!!! 1 to end
-    {
-        a = rec->getValue( 0, j-1 );
-        c = rec->getValue( 0, j   );
-        for (i=1; i<We; i++, a = b, c = d)
-        {
-//            x = rec->getX(i);
-//            y = rec->getY(j);
-
-            int ni = i;
-            if (i == W)
-                ni = 0;
-            b = rec->getValue( ni,   j-1 );
-            d = rec->getValue( ni,   j   );
-
-            if( a == GRIB_NOTDEF || b == GRIB_NOTDEF || c == GRIB_NOTDEF || d == GRIB_NOTDEF ) continue;
-
-            if ((a< value && b< value && c< value  && d < value)
-                 || (a>value && b>value && c>value  && d > value))
-                continue;
-
             // Détermine si 1 ou 2 segments traversent la case ab-cd
             // a  b
             // c  d
@@ -759,9 +678,77 @@ void IsoLine::extractIsoLine(const GribRecord *rec)
                 trace.push_back(new Segment(ni,W,j, 'a','b',  'a','c', rec,value));
                 trace.push_back(new Segment(ni,W,j, 'b','d',  'c','d', rec,value));
             }
+}
+
+//-----------------------------------------------------------------------
+// Génère la liste des segments.
+// Les coordonnées sont les indices dans la grille du GribRecord
+// All the values are found in one pass over the grid, bands of rows
+// are done on different threads then put back in order.
+//---------------------------------------------------------
+void IsoLine::extractIsoLines(const GribRecord *rec, const std::vector<double> &raw,
+                              std::vector<std::vector<Segment *> > &segs)
+{
+    int W = rec->getNi();
+    int H = rec->getNj();
+
+    int We = W;
+    if(rec->getLonMax() + rec->getDi() - rec->getLonMin() == 360)
+        We++;
 
+    // the values of a square are found in the sorted values
+    std::vector<size_t> order(raw.size());
+    for(size_t k = 0; k < order.size(); k++)
+        order[k] = k;
+    std::sort(order.begin(), order.end(),
+              [&](size_t k1, size_t k2) { return raw[k1] < raw[k2]; });
+    std::vector<double> sorted(raw.size());
+    for(size_t k = 0; k < order.size(); k++)
+        sorted[k] = raw[order[k]];
+
+    // decode the data before the threads read it
+    rec->getValue(0, 0);
+
+    const int band = 16;
+    int bands = H > 1 ? (H - 1 + band - 1) / band : 0;
+    std::vector<std::vector<std::vector<Segment *> > > bandsegs(bands);
+
+    ParallelFor(bands, 1, [&](size_t begin, size_t end) {
+      for(size_t bi = begin; bi < end; bi++) {
+        std::vector<std::vector<Segment *> > &out = bandsegs[bi];
+        out.resize(raw.size());
+        int jend = wxMin(H, 1 + (int)(bi + 1)*band);
+        for (int j = 1 + bi*band; j < jend; j++)     // !!!! 1 to end
+        {
+            double a = rec->getValue( 0, j-1 );
+            double c = rec->getValue( 0, j   );
+            double b, d;
+            for (int i=1; i<We; i++, a = b, c = d)
+            {
+                int ni = i;
+                if (i == W)
+                    ni = 0;
+                b = rec->getValue( ni,   j-1 );
+                d = rec->getValue( ni,   j   );
+
+                if( a == GRIB_NOTDEF || b == GRIB_NOTDEF || c == GRIB_NOTDEF || d == GRIB_NOTDEF ) continue;
+
+                // values crossing the square, the others are all above or all below
+                double lo = wxMin(wxMin(a, b), wxMin(c, d));
+                double hi = wxMax(wxMax(a, b), wxMax(c, d));
+                size_t k = std::lower_bound(sorted.begin(), sorted.end(), lo) - sorted.begin();
+                for(; k < sorted.size() && sorted[k] <= hi; k++)
+                    cellSegments(ni, W, j, a, b, c, d, sorted[k], rec, out[order[k]]);
+            }
         }
-    }
+      }
+    });
+
+    segs.clear();
+    segs.resize(raw.size());
+    for(int bi = 0; bi < bands; bi++)
+        for(size_t k = 0; k < raw.size(); k++)
+            segs[k].insert(segs[k].end(), bandsegs[bi][k].begin(), bandsegs[bi][k].end());
 }
 
 
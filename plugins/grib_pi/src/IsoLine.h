@@ -111,6 +111,12 @@ class IsoLine
          IsoLine(double val, double coeff, double offset, const GribRecord *rec);
         ~IsoLine();
 
+        // Isolines of rec for several values at once, with one pass over
+        // the grid.  raw[k] is values[k] in the unit of the record.
+        static void BuildIsoLines(const std::vector<double> &values,
+                                  const std::vector<double> &raw,
+                                  const GribRecord *rec, std::vector<IsoLine *> &isolines);
+
 
         void drawIsoLine(GRIBOverlayFactory *pof, wxDC *dc, PlugIn_ViewPort *vp, bool bHiDef);
 
@@ -125,6 +131,8 @@ class IsoLine
 
         double getValue() {return value;}
     private:
+        IsoLine(double val, const GribRecord *rec);
+
         double value;
         int    W, H;     // taille de la grille
         const  GribRecord *rec;
@@ -140,10 +148,12 @@ class IsoLine
         // Génère la liste des segments.
         // Les coordonnées sont les indices dans la grille du GribRecord
         //---------------------------------------------------------
-        void extractIsoLine(const GribRecord *rec);
-        MySegList *BuildContinuousSegment(void);
+        // segs[k] are the segments for the value raw[k]
+        static void extractIsoLines(const GribRecord *rec, const std::vector<double> &raw,
+                                    std::vector<std::vector<Segment *> > &segs);
+        // Join the segments of the trace into continuous lists
+        void JoinSegments();
 
-        MySegList       m_seglist;
         MySegListList   m_SegListList;
         
         double m_pixelMM;
@@ -727,6 +727,13 @@ void grib_pi::SetPluginMessage(wxString &message_id, wxString &message_body)
 
         GribTimelineRecordSet *set = m_pGribCtrlBar ? m_pGribCtrlBar->GetTimeLineRecordSet(time) : NULL;
 
+        // the other plugin reads the records directly, for as long as it
+        // likes, their data must be there and stay there
+        if(set)
+            for(int i=0; i<Idx_COUNT; i++)
+                if(set->m_GribRecordPtrArray[i])
+                    set->m_GribRecordPtrArray[i]->keepData();
+
         char ptr[64];
         snprintf(ptr, sizeof ptr, "%p", set);
 
@@ -48,6 +48,13 @@ ZUFILE * zu_open(const char *fname, const char *mode, int type)
     f->ok = 1;
     f->pos = 0;
     f->fname = strdup(fname);
+    f->faux = NULL;
+    f->fcache = NULL;
+    f->zpos = 0;
+    f->zeof = 0;
+    f->block = NULL;
+    f->blockStart = -1;
+    f->blockLen = 0;
 
 	if (type == ZU_COMPRESS_AUTO)
 	{
@@ -102,6 +109,16 @@ ZUFILE * zu_open(const char *fname, const char *mode, int type)
             f->zfile = NULL;
     }
 
+    if (f->zfile != NULL && f->type != ZU_COMPRESS_NONE) {
+        f->block = (char *) malloc(ZU_BUFREADSIZE);
+        if (f->block == NULL) {
+            zu_close(f);
+            return NULL;
+        }
+        // without it seeking back decompresses again from the start
+        f->fcache = tmpfile();
+    }
+
     if (f->zfile == NULL) {
         free(f->fname);
         free(f);
@@ -110,23 +127,138 @@ ZUFILE * zu_open(const char *fname, const char *mode, int type)
 
     return f;
 }
+
+//----------------------------------------------------
+// Decompress the next len bytes, less only at the end of the file
+static long zu_decompress(ZUFILE *f, char *buf, long len)
+{
+    long nbread = 0;
+    int nb;
+    int bzerror=BZ_OK;
+    while (!f->zeof && nbread < len) {
+        switch(f->type) {
+            case ZU_COMPRESS_GZIP :
+                nb = gzread((gzFile)(f->zfile), buf+nbread, len-nbread);
+                if (nb <= 0)
+                    f->zeof = 1;
+                break;
+            case ZU_COMPRESS_BZIP :
+                nb = BZ2_bzRead(&bzerror,(BZFILE*)(f->zfile), buf+nbread, len-nbread);
+                if (bzerror != BZ_OK)     // BZ_STREAM_END or an error
+                    f->zeof = 1;
+                break;
+            default :
+                nb = 0;
+                f->zeof = 1;
+        }
+        if (nb > 0)
+            nbread += nb;
+    }
+    return nbread;
+}
+
+//----------------------------------------------------
+// Start decompressing again from the beginning of the file
+static int zu_restart(ZUFILE *f)
+{
+    int bzerror=BZ_OK;
+    f->zpos = 0;
+    f->zeof = 0;
+    f->blockStart = -1;
+    f->blockLen = 0;
+    switch(f->type) {
+        case ZU_COMPRESS_GZIP :
+            return gzrewind((gzFile)(f->zfile)) == 0;
+        case ZU_COMPRESS_BZIP :
+            BZ2_bzReadClose (&bzerror,(BZFILE*)(f->zfile));
+            bzerror=BZ_OK;
+            rewind(f->faux);
+            f->zfile = (void *) BZ2_bzReadOpen(&bzerror,f->faux,0,0,NULL,0);
+            if (bzerror != BZ_OK) {
+                BZ2_bzReadClose (&bzerror,(BZFILE*)(f->zfile));
+                f->zfile = NULL;
+                f->ok = 0;
+                f->zeof = 1;
+                return 0;
+            }
+            return 1;
+    }
+    return 0;
+}
+
+//----------------------------------------------------
+// Make the decompressed block starting at start the current one
+static int zu_loadBlock(ZUFILE *f, long start)
+{
+    if (f->blockStart == start)
+        return f->blockLen > 0;
+
+    if (start < f->zpos) {
+        if (f->fcache) {
+            long len = f->zpos - start;
+            if (len > ZU_BUFREADSIZE)
+                len = ZU_BUFREADSIZE;
+            f->blockStart = start;
+            f->blockLen = 0;
+            if (fseek(f->fcache, start, SEEK_SET) == 0)
+                f->blockLen = fread(f->block, 1, len, f->fcache);
+            return f->blockLen > 0;
+        }
+        if (!zu_restart(f))
+            return 0;
+    }
+
+    // forward only, every block on the way is kept
+    while (!f->zeof && f->zpos <= start) {
+        long nb = zu_decompress(f, f->block, ZU_BUFREADSIZE);
+        f->blockStart = f->zpos;
+        f->blockLen = nb;
+        if (nb > 0 && f->fcache) {
+            if (fseek(f->fcache, f->zpos, SEEK_SET) != 0
+                    || (long)fwrite(f->block, 1, nb, f->fcache) != nb) {
+                fclose(f->fcache);
+                f->fcache = NULL;
+            }
+        }
+        f->zpos += nb;
+    }
+    return f->blockStart == start && f->blockLen > 0;
+}
+
+//----------------------------------------------------
+static int zu_readBlocks(ZUFILE *f, void *buf, long len)
+{
+    long nbread = 0;
+    while (nbread < len) {
+        long start = f->pos - f->pos % ZU_BUFREADSIZE;
+        if (!zu_loadBlock(f, start))
+            break;
+        long off = f->pos - start;
+        if (off >= f->blockLen)
+            break;
+        long nb = f->blockLen - off;
+        if (nb > len - nbread)
+            nb = len - nbread;
+        memcpy((char *)buf + nbread, f->block + off, nb);
+        nbread += nb;
+        f->pos += nb;
+    }
+    return nbread;
+}
 //----------------------------------------------------
 int  zu_read(ZUFILE *f, void *buf, long len)
 {
     int nb = 0;
-    int bzerror=BZ_OK;
     switch(f->type) {
         case ZU_COMPRESS_NONE :
             nb = fread(buf, 1, len, (FILE*)(f->zfile));
+            f->pos += nb;
             break;
         case ZU_COMPRESS_GZIP :
-            nb = gzread((gzFile)(f->zfile), buf, len);
-            break;
         case ZU_COMPRESS_BZIP :
-            nb = BZ2_bzRead(&bzerror,(BZFILE*)(f->zfile), buf, len);
+            nb = zu_readBlocks(f, buf, len);
             break;
     }
-    f->pos += nb;
     return nb;
 }
 
@@ -138,6 +270,10 @@ int zu_close(ZUFILE *f)
         f->ok = 0;
         f->pos = 0;
         free(f->fname);
+        free(f->block);
+        if (f->fcache) {
+            fclose(f->fcache);
+        }
         if (f->zfile) {
             switch(f->type) {
                 case ZU_COMPRESS_NONE :
@@ -185,7 +321,6 @@ long   zu_filesize(ZUFILE *f)
 int zu_seek(ZUFILE *f, long offset, int whence)
 {
     int res = 0;
-    int bzerror=BZ_OK;
     if (whence == SEEK_END) {
         return -1;              // TODO
     }
@@ -196,66 +331,25 @@ int zu_seek(ZUFILE *f, long offset, int whence)
             f->pos = ftell((FILE*)(f->zfile));
             break;
         case ZU_COMPRESS_GZIP :
-            if (whence == SEEK_SET) {
-                res = gzseek((gzFile)(f->zfile), offset, whence);
-            }
-            else {     // !!! BUG with SEEK_CUR in ZLIB !!!
-                int p1 = gztell((gzFile)(f->zfile));
-                res = gzseek((gzFile)(f->zfile), p1+offset, SEEK_SET);
-            }
-            f->pos = gztell((gzFile)(f->zfile));
-            if (res >= 0)
-                res = 0;
-            break;
         case ZU_COMPRESS_BZIP :
-            if (whence==SEEK_SET  &&  offset >= f->pos) {
-                res = zu_bzSeekForward(f, offset-f->pos);
+            if (whence == SEEK_CUR) {
+                offset += f->pos;
             }
-            else if (whence==SEEK_CUR) {
-                res = zu_bzSeekForward(f, offset);
+            if (offset < 0) {
+                return -1;
             }
-            else {    // BAD : reopen file
-                BZ2_bzReadClose (&bzerror,(BZFILE*)(f->zfile));
-                bzerror=BZ_OK;
-                rewind(f->faux);
-                f->pos = 0;
-                f->zfile = (void *) BZ2_bzReadOpen(&bzerror,f->faux,0,0,NULL,0);
-                if (bzerror != BZ_OK) {
-                    BZ2_bzReadClose (&bzerror,(BZFILE*)(f->zfile));
-                    fclose(f->faux);
-                    f->zfile = NULL;
-                    f->ok = 0;
-                }
-                res = zu_bzSeekForward(f, offset);
+            f->pos = offset;
+            // fails past the end of file, the block is read anyway
+            if (offset > 0) {
+                long start = (offset-1) - (offset-1) % ZU_BUFREADSIZE;
+                if (!zu_loadBlock(f, start) || offset > start + f->blockLen)
+                    res = -1;
             }
             break;
     }
     return res;
 }
 
-//-----------------------------------------------------------------
-int  zu_bzSeekForward(ZUFILE *f, unsigned long nbytes_)
-// for internal use
-{
-    unsigned long nbytes = nbytes_;
-    char buf[ZU_BUFREADSIZE];
-    unsigned long nbread = 0;
-    int nb;
-    int bzerror=BZ_OK;
-    while (bzerror==BZ_OK  &&  nbytes>=ZU_BUFREADSIZE) {
-        nb = BZ2_bzRead(&bzerror,(BZFILE*)(f->zfile), buf, ZU_BUFREADSIZE);
-        nbytes -= nb;
-        nbread += nb;
-    }
-    if (bzerror==BZ_OK  &&  nbytes>0) {
-        nb = BZ2_bzRead(&bzerror,(BZFILE*)(f->zfile), buf, nbytes);
-        nbread += nb;
-    }
-    f->pos += nbread;
-
-    return nbread==nbytes_ ? 0 : -1;
-}
-
 //-----------------------------------------------------------------
 void   zu_rewind(ZUFILE *f)
 {
@@ -38,9 +38,12 @@ extern "C" {
 #define ZU_COMPRESS_GZIP   1
 #define ZU_COMPRESS_BZIP   2
 
-#define ZU_BUFREADSIZE   256000
+#define ZU_BUFREADSIZE   256000     // also the decompressed block size
 
 
+// Compressed files are decompressed forward only, one block at a time.
+// Blocks are kept in a temporary file so seeking back doesn't mean
+// decompressing the file again from the start.
 typedef struct
 {
     int   type;
@@ -51,6 +54,13 @@ typedef struct
     void *zfile;   // exact file type depends of compress type
 
     FILE *faux;   // auxiliary file for bzip
+
+    FILE *fcache;      // decompressed data [0, zpos), NULL if unavailable
+    long  zpos;        // decompressed bytes produced so far
+    int   zeof;        // decompressor reached the end of the file
+    char *block;       // decompressed block holding the last read
+    long  blockStart;
+    long  blockLen;
 } ZUFILE;
 
 
@@ -69,10 +79,6 @@ void   zu_rewind(ZUFILE *f);
 
 long   zu_filesize(ZUFILE *f);
 
-// for internal use :
-int zu_bzSeekForward(ZUFILE *f, unsigned long nbytes);
-
-
 #ifdef __cplusplus
 }
 #endif
@@ -41,6 +41,7 @@
 #include "OCPN_SignalKEvent.h"
 #include "OCPNPlatform.h"
 #include "pluginmanager.h"
+#include "PluginSnapshot.h"
 #include "Track.h"
 #include <multiplexer.h>
 #include "config.h"
@@ -200,6 +201,7 @@ AIS_Decoder::~AIS_Decoder( void )
 
         delete td;
     }
+    PluginSnapshot::Get().ClearAISTargets();
 
     delete AISTargetList;
     
@@ -2743,6 +2745,10 @@ void AIS_Decoder::OnTimerAIS( wxTimerEvent& event )
     UpdateAllCPA();
     UpdateAllAlarms();
 
+    //  CPA, range and alarms change with time, without any new report
+    for( it = ( *current_targets ).begin(); it != ( *current_targets ).end(); ++it )
+        UpdateSnapshot( it->second );
+
     //    Update the general suppression flag
     m_bSuppressed = false;
     if( g_bAIS_CPA_Alert_Suppress_Moored || g_bHideMoored 
@@ -3074,8 +3080,24 @@ wxString GetShipNameFromFile(int nmmsi)
     return name;
 }
 
+void AIS_Decoder::UpdateSnapshot(AIS_Target_Data* pTarget)
+{
+    if(pTarget->b_removed) {
+        PluginSnapshot::Get().RemoveAISTarget(pTarget->MMSI);
+        return;
+    }
+
+    PlugIn_AIS_Target target;
+    memset(&target, 0, sizeof(target));
+    Fill_PI_AIS_Target(&target, pTarget);
+    PluginSnapshot::Get().SetAISTarget(target);
+}
+
 void AIS_Decoder::SendJSONMsg(AIS_Target_Data* pTarget)
 {
+    //  The snapshot is kept whether or not anyone listens to the messages
+    UpdateSnapshot(pTarget);
+
     //  Only send messages if someone is listening...
     if(!g_pi_manager->GetJSONMessageTargetCount())
         return;
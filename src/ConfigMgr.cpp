@@ -1422,6 +1422,9 @@ bool ConfigMgr::CheckTemplate( wxString fileName)
     CHECK_INT( _T ( "LineSmoothing" ), &g_GLOptions.m_GLLineSmoothing);
     CHECK_INT( _T ( "GPUTextureDimension" ), &g_GLOptions.m_iTextureDimension );
     CHECK_INT( _T ( "GPUTextureMemSize" ), &g_GLOptions.m_iTextureMemorySize );
+    CHECK_INT( _T ( "GPUTexturePrefetchPercent" ), &g_GLOptions.m_iTexturePrefetchPercent );
+    CHECK_INT( _T ( "MaxFrameRate" ), &g_GLOptions.m_iMaxFrameRate );
+    CHECK_INT( _T ( "AdaptiveQuality" ), &g_GLOptions.m_bAdaptiveQuality );
 
 #endif
     CHECK_INT( _T ( "SmoothPanZoom" ), &g_bsmoothpanzoom );
@@ -0,0 +1,152 @@
+/******************************************************************************
+ *
+ * Project:  OpenCPN
+ * Purpose:  Read only memory mapped file
+ *
+ ***************************************************************************
+ *   Copyright (C) 2020 by David S. Register                               *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301,  USA.         *
+ ***************************************************************************
+ */
+
+#include <wx/wxprec.h>
+
+#ifndef  WX_PRECOMP
+  #include <wx/wx.h>
+#endif //precompiled headers
+
+#include <wx/ffile.h>
+
+#include "MappedFile.h"
+
+#ifdef __WXMSW__
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+MappedFile::MappedFile()
+{
+    m_data = NULL;
+    m_size = 0;
+    m_bmapped = false;
+#ifdef __WXMSW__
+    m_hFile = INVALID_HANDLE_VALUE;
+    m_hMapping = NULL;
+#endif
+}
+
+MappedFile::~MappedFile()
+{
+    Close();
+}
+
+bool MappedFile::Open(const wxString &path)
+{
+    Close();
+
+#ifdef __WXMSW__
+    HANDLE hFile = CreateFileW(path.wc_str(), GENERIC_READ,
+                               FILE_SHARE_READ | FILE_SHARE_WRITE, NULL,
+                               OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if(hFile != INVALID_HANDLE_VALUE) {
+        LARGE_INTEGER fsize;
+        if(GetFileSizeEx(hFile, &fsize) && fsize.QuadPart > 0) {
+            HANDLE hMapping = CreateFileMapping(hFile, NULL, PAGE_READONLY, 0, 0, NULL);
+            if(hMapping) {
+                void *p = MapViewOfFile(hMapping, FILE_MAP_READ, 0, 0, 0);
+                if(p) {
+                    m_hFile = hFile;
+                    m_hMapping = hMapping;
+                    m_data = (const unsigned char *)p;
+                    m_size = (size_t)fsize.QuadPart;
+                    m_bmapped = true;
+                    return true;
+                }
+                CloseHandle(hMapping);
+            }
+        }
+        CloseHandle(hFile);
+    }
+#else
+    int fd = open(path.fn_str(), O_RDONLY);
+    if(fd >= 0) {
+        struct stat st;
+        if(fstat(fd, &st) == 0 && st.st_size > 0) {
+            void *p = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+            if(p != MAP_FAILED) {
+                // the mapping stays valid after the descriptor is closed
+                close(fd);
+                m_data = (const unsigned char *)p;
+                m_size = st.st_size;
+                m_bmapped = true;
+                return true;
+            }
+        }
+        close(fd);
+    }
+#endif
+
+    //  No mapping available, so fall back to reading the whole file
+    wxFFile file(path, _T("rb"));
+    if(!file.IsOpened())
+        return false;
+
+    wxFileOffset len = file.Length();
+    if(len <= 0)
+        return false;
+
+    unsigned char *buf = (unsigned char *)malloc(len);
+    if(!buf)
+        return false;
+
+    if(file.Read(buf, len) != (size_t)len) {
+        free(buf);
+        return false;
+    }
+
+    m_data = buf;
+    m_size = len;
+    m_bmapped = false;
+    return true;
+}
+
+void MappedFile::Close()
+{
+    if(!m_data)
+        return;
+
+    if(m_bmapped) {
+#ifdef __WXMSW__
+        UnmapViewOfFile(m_data);
+        CloseHandle((HANDLE)m_hMapping);
+        CloseHandle((HANDLE)m_hFile);
+        m_hMapping = NULL;
+        m_hFile = INVALID_HANDLE_VALUE;
+#else
+        munmap((void *)m_data, m_size);
+#endif
+    } else
+        free((void *)m_data);
+
+    m_data = NULL;
+    m_size = 0;
+    m_bmapped = false;
+}
@@ -712,6 +712,7 @@ void MarkInfoDlg::OnClose( wxCloseEvent& event )
 }
 
 #define TIDESTATION_BATCH_SIZE 10
+#define TIDESTATION_MAX_LISTED (TIDESTATION_BATCH_SIZE * 10)
 
 void MarkInfoDlg::OnTideStationCombobox( wxCommandEvent& event)
 {
@@ -742,7 +743,7 @@ void MarkInfoDlg::OnNotebookPageChanged( wxNotebookEvent& event )
         m_lasttspos = m_textLatitude->GetValue() + m_textLongitude->GetValue();
         double lat = fromDMM(m_textLatitude->GetValue());
         double lon = fromDMM(m_textLongitude->GetValue());
-        m_tss = ptcmgr->GetStationsForLL(lat, lon);
+        m_tss = ptcmgr->GetStationsForLL(lat, lon, TIDESTATION_MAX_LISTED);
         wxString s = m_comboBoxTideStation->GetStringSelection();
         wxString n;
         int i = 0;
@@ -0,0 +1,308 @@
+/******************************************************************************
+ *
+ * Project:  OpenCPN
+ * Purpose:  Lightweight tracing of where the time goes
+ *
+ ***************************************************************************
+ *   Copyright (C) 2020 by David S. Register                               *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301,  USA.         *
+ ***************************************************************************
+ */
+
+#include <wx/wxprec.h>
+
+#ifndef  WX_PRECOMP
+  #include <wx/wx.h>
+#endif //precompiled headers
+
+#include <wx/ffile.h>
+#include <wx/thread.h>
+
+#include <algorithm>
+#include <chrono>
+#include <mutex>
+#include <set>
+#include <string>
+#include <string.h>
+#include <vector>
+
+#include "PerfTrace.h"
+
+std::atomic<int> PerfTrace::s_flags(0);
+
+namespace {
+
+const std::chrono::steady_clock::time_point s_origin = std::chrono::steady_clock::now();
+
+//  Enough for some minutes of busy rendering, about 64 MB
+const int MAX_EVENTS = 2000000;
+
+struct TraceEvent
+{
+    const char  *name;
+    double      ts;
+    double      dur;            // or the value of a counter
+    bool        bcounter;
+};
+
+//  Each thread adds to its own buffer, the lock is only contended while writing the file
+struct ThreadBuffer
+{
+    std::mutex                  mutex;
+    std::vector<TraceEvent>     events;
+    int                         tid;
+    bool                        bmain;
+};
+
+std::mutex                  s_mutex;        // the lists below, and the file name
+std::vector<ThreadBuffer *> s_buffers;      // not freed, threads may end before the file is written
+std::set<std::string>       s_names;
+wxString                    s_file;
+std::atomic<int>            s_nevents(0);
+std::atomic<int>            s_ndropped(0);
+
+thread_local ThreadBuffer   *t_buffer = NULL;
+
+ThreadBuffer *GetThreadBuffer()
+{
+    if(!t_buffer) {
+        ThreadBuffer *buffer = new ThreadBuffer;
+        buffer->bmain = wxThread::IsMain();
+
+        std::lock_guard<std::mutex> lock(s_mutex);
+        buffer->tid = s_buffers.size();
+        s_buffers.push_back(buffer);
+        t_buffer = buffer;
+    }
+    return t_buffer;
+}
+
+void AddEvent(const char *name, double ts, double dur, bool bcounter)
+{
+    if(++s_nevents > MAX_EVENTS) {
+        s_ndropped++;
+        return;
+    }
+
+    ThreadBuffer *buffer = GetThreadBuffer();
+    TraceEvent event = { name, ts, dur, bcounter };
+
+    std::lock_guard<std::mutex> lock(buffer->mutex);
+    buffer->events.push_back(event);
+}
+
+//  Frame statistics, main thread only
+
+const int FRAME_HISTORY = 64;
+
+struct FrameZone
+{
+    const char  *name;
+    double      frame;                  // time so far in this frame
+    double      history[FRAME_HISTORY];
+};
+
+std::vector<FrameZone>  s_frameZones;
+double                  s_frameHistory[FRAME_HISTORY];
+int                     s_nframes = 0;
+double                  s_lastFrameEnd = -1.;
+
+void AddFrameZone(const char *name, double dur)
+{
+    for(size_t i = 0 ; i < s_frameZones.size() ; i++) {
+        if(s_frameZones[i].name == name || !strcmp(s_frameZones[i].name, name)) {
+            s_frameZones[i].frame += dur;
+            return;
+        }
+    }
+
+    FrameZone zone;
+    zone.name = name;
+    zone.frame = dur;
+    for(int i = 0 ; i < FRAME_HISTORY ; i++)
+        zone.history[i] = 0.;
+    s_frameZones.push_back(zone);
+}
+
+void GetHistoryStats(const double *history, int n, double &avg, double &max)
+{
+    avg = max = 0.;
+    for(int i = 0 ; i < n ; i++) {
+        avg += history[i];
+        max = wxMax(max, history[i]);
+    }
+    if(n)
+        avg /= n;
+}
+
+void WriteJSONString(FILE *fp, const char *s)
+{
+    fputc('"', fp);
+    for( ; *s ; s++) {
+        unsigned char c = *s;
+        if(c == '"' || c == '\\')
+            fprintf(fp, "\\%c", c);
+        else if(c < 0x20)
+            fprintf(fp, "\\u%04x", c);
+        else
+            fputc(c, fp);
+    }
+    fputc('"', fp);
+}
+
+}
+
+double PerfTrace::Now()
+{
+    return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - s_origin).count();
+}
+
+void PerfTrace::StartRecording(const wxString &file)
+{
+    {
+        std::lock_guard<std::mutex> lock(s_mutex);
+        s_file = file;
+    }
+    //  No logging here, this may run before the log file is opened
+    s_flags |= RECORD;
+}
+
+bool PerfTrace::StopRecording()
+{
+    if(!IsRecording())
+        return false;
+    s_flags &= ~RECORD;
+
+    std::lock_guard<std::mutex> lock(s_mutex);
+
+    wxFFile file(s_file, _T("w"));
+    if(!file.IsOpened()) {
+        wxLogMessage(_T("Cannot write trace to %s"), s_file.c_str());
+        return false;
+    }
+    FILE *fp = file.fp();
+
+    fprintf(fp, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+    fprintf(fp, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"args\":{\"name\":\"OpenCPN\"}}");
+
+    for(size_t i = 0 ; i < s_buffers.size() ; i++) {
+        ThreadBuffer *buffer = s_buffers[i];
+        std::lock_guard<std::mutex> block(buffer->mutex);
+
+        fprintf(fp, ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":", buffer->tid);
+        if(buffer->bmain)
+            fprintf(fp, "\"main\"}}");
+        else
+            fprintf(fp, "\"worker %d\"}}", buffer->tid);
+
+        for(size_t j = 0 ; j < buffer->events.size() ; j++) {
+            const TraceEvent &event = buffer->events[j];
+            fprintf(fp, ",\n{\"name\":");
+            WriteJSONString(fp, event.name);
+            if(event.bcounter)
+                fprintf(fp, ",\"ph\":\"C\",\"ts\":%.3f,\"pid\":1,\"tid\":%d,\"args\":{\"value\":%g}}",
+                        event.ts, buffer->tid, event.dur);
+            else
+                fprintf(fp, ",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":1,\"tid\":%d}",
+                        event.ts, event.dur, buffer->tid);
+        }
+        buffer->events.clear();
+    }
+
+    fprintf(fp, "\n]}\n");
+    file.Close();
+
+    wxLogMessage(_T("Trace written to %s, %d events dropped"), s_file.c_str(), (int)s_ndropped);
+    s_nevents = 0;
+    s_ndropped = 0;
+    return true;
+}
+
+void PerfTrace::EnableFrameStats(bool benable)
+{
+    if(benable)
+        s_flags |= FRAME_STATS;
+    else
+        s_flags &= ~FRAME_STATS;
+}
+
+void PerfTrace::Record(const char *name, double start, double end)
+{
+    int flags = s_flags.load(std::memory_order_relaxed);
+
+    if(flags & RECORD)
+        AddEvent(name, start, end - start, false);
+
+    if((flags & FRAME_STATS) && wxThread::IsMain())
+        AddFrameZone(name, end - start);
+}
+
+void PerfTrace::Counter(const char *name, double value)
+{
+    if(IsRecording())
+        AddEvent(name, Now(), value, true);
+}
+
+const char *PerfTrace::Intern(const wxString &name)
+{
+    std::lock_guard<std::mutex> lock(s_mutex);
+    return s_names.insert(std::string(name.ToUTF8().data())).first->c_str();
+}
+
+void PerfTrace::FrameEnd()
+{
+    if(!IsFrameStatsEnabled())
+        return;
+
+    double now = Now();
+    int slot = s_nframes % FRAME_HISTORY;
+    s_frameHistory[slot] = s_lastFrameEnd < 0. ? 0. : now - s_lastFrameEnd;
+    s_lastFrameEnd = now;
+
+    for(size_t i = 0 ; i < s_frameZones.size() ; i++) {
+        s_frameZones[i].history[slot] = s_frameZones[i].frame;
+        s_frameZones[i].frame = 0.;
+    }
+    s_nframes++;
+}
+
+void PerfTrace::GetFrameStats(wxArrayString &lines)
+{
+    int n = wxMin(s_nframes, FRAME_HISTORY);
+    if(!n)
+        return;
+
+    double avg, max;
+    GetHistoryStats(s_frameHistory, n, avg, max);
+    lines.Add(wxString::Format(_T("%-28s %7s %7s"), _T("last frames, ms"), _T("avg"), _T("max")));
+    lines.Add(wxString::Format(_T("%-28s %7.1f %7.1f"), _T("frame interval"), avg / 1000., max / 1000.));
+
+    std::vector<std::pair<double, size_t> > order;
+    for(size_t i = 0 ; i < s_frameZones.size() ; i++) {
+        GetHistoryStats(s_frameZones[i].history, n, avg, max);
+        if(max > 0.)
+            order.push_back(std::make_pair(avg, i));
+    }
+    std::sort(order.rbegin(), order.rend());
+
+    for(size_t i = 0 ; i < order.size() ; i++) {
+        const FrameZone &zone = s_frameZones[order[i].second];
+        GetHistoryStats(zone.history, n, avg, max);
+        lines.Add(wxString::Format(_T("%-28s %7.2f %7.2f"), wxString::FromUTF8(zone.name).c_str(),
+                                   avg / 1000., max / 1000.));
+    }
+}
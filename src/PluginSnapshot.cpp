@@ -0,0 +1,193 @@
+/******************************************************************************
+ *
+ * Project:  OpenCPN
+ * Purpose:  Navigation data snapshot shared with the PlugIns
+ *
+ ***************************************************************************
+ *   Copyright (C) 2020 by David S. Register                               *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301,  USA.         *
+ ***************************************************************************
+ */
+
+#include <wx/wxprec.h>
+
+#ifndef  WX_PRECOMP
+  #include <wx/wx.h>
+#endif //precompiled headers
+
+#include "PluginSnapshot.h"
+
+PluginSnapshot &PluginSnapshot::Get()
+{
+    static PluginSnapshot s_snapshot;
+    return s_snapshot;
+}
+
+PluginSnapshot::PluginSnapshot()
+    : m_slots(MAX_AIS_TARGETS), m_nslots(0), m_layout(0), m_ais_generation(0)
+{
+    Fix fix;
+    memset(&fix, 0, sizeof(fix));
+    m_fix.Write(fix);
+}
+
+void PluginSnapshot::SetPositionFix(const PlugIn_Position_Fix_Ex &fix, bool bvalid)
+{
+    Fix value;
+    memset(&value, 0, sizeof(value));           // no stray bytes in the padding
+    value.fix = fix;
+    value.bvalid = bvalid;
+
+    std::lock_guard<std::mutex> lock(m_write_mutex);
+    m_fix.Write(value);
+}
+
+bool PluginSnapshot::GetPositionFix(PlugIn_Position_Fix_Ex *pfix, unsigned int *pgeneration) const
+{
+    Fix value;
+    unsigned int generation;
+    if(!m_fix.TryRead(value, generation)) {
+        std::lock_guard<std::mutex> lock(m_write_mutex);
+        generation = m_fix.ReadLocked(value);
+    }
+
+    if(pfix)
+        *pfix = value.fix;
+    if(pgeneration)
+        *pgeneration = generation;
+    return value.bvalid;
+}
+
+void PluginSnapshot::SetAISTarget(const PlugIn_AIS_Target &target)
+{
+    if(!target.MMSI)
+        return;
+
+    std::lock_guard<std::mutex> lock(m_write_mutex);
+
+    std::unordered_map<int, int>::iterator it = m_slot_of_mmsi.find(target.MMSI);
+    if(it != m_slot_of_mmsi.end()) {
+        m_slots[it->second].Write(target);
+        m_ais_generation.fetch_add(1, std::memory_order_release);
+        return;
+    }
+
+    int slot;
+    if(!m_free_slots.empty()) {
+        slot = m_free_slots.back();
+        m_free_slots.pop_back();
+    } else if(m_nslots.load(std::memory_order_relaxed) < MAX_AIS_TARGETS)
+        slot = m_nslots.load(std::memory_order_relaxed);
+    else
+        return;                                 // full, the target is left out
+
+    //  Odd while the table changes, as for the values themselves
+    unsigned int layout = m_layout.load(std::memory_order_relaxed);
+    m_layout.store(layout + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    m_slots[slot].Write(target);
+    if(slot == m_nslots.load(std::memory_order_relaxed))
+        m_nslots.store(slot + 1, std::memory_order_relaxed);
+    m_slot_of_mmsi[target.MMSI] = slot;
+
+    m_layout.store(layout + 2, std::memory_order_release);
+    m_ais_generation.fetch_add(1, std::memory_order_release);
+}
+
+void PluginSnapshot::RemoveAISTarget(int mmsi)
+{
+    std::lock_guard<std::mutex> lock(m_write_mutex);
+
+    std::unordered_map<int, int>::iterator it = m_slot_of_mmsi.find(mmsi);
+    if(it == m_slot_of_mmsi.end())
+        return;
+
+    unsigned int layout = m_layout.load(std::memory_order_relaxed);
+    m_layout.store(layout + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    PlugIn_AIS_Target empty;
+    memset(&empty, 0, sizeof(empty));
+    m_slots[it->second].Write(empty);
+
+    m_layout.store(layout + 2, std::memory_order_release);
+    m_ais_generation.fetch_add(1, std::memory_order_release);
+
+    m_free_slots.push_back(it->second);
+    m_slot_of_mmsi.erase(it);
+}
+
+void PluginSnapshot::ClearAISTargets()
+{
+    while(!m_slot_of_mmsi.empty())
+        RemoveAISTarget(m_slot_of_mmsi.begin()->first);
+}
+
+int PluginSnapshot::GetAISTargets(PlugIn_AIS_Target *ptargets, int max_targets, unsigned int *pgeneration) const
+{
+    PlugIn_AIS_Target target;
+    unsigned int seq;
+
+    for(int attempt = 0 ; attempt < 8 ; attempt++) {
+        unsigned int layout = m_layout.load(std::memory_order_acquire);
+        if(layout & 1) {
+            std::this_thread::yield();
+            continue;
+        }
+        unsigned int generation = m_ais_generation.load(std::memory_order_acquire);
+        int nslots = m_nslots.load(std::memory_order_relaxed);
+
+        int count = 0;
+        bool bread = true;
+        for(int i = 0 ; i < nslots && bread ; i++) {
+            bread = m_slots[i].TryRead(target, seq);
+            if(!bread || !target.MMSI)
+                continue;
+            if(ptargets && count < max_targets)
+                ptargets[count] = target;
+            count++;
+        }
+        if(!bread)
+            break;
+
+        //  A target that moved to another slot meanwhile might be missed, or seen twice
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if(m_layout.load(std::memory_order_relaxed) == layout) {
+            if(pgeneration)
+                *pgeneration = generation;
+            return count;
+        }
+    }
+
+    //  The writer kept getting in the way, copy with it held off
+    std::lock_guard<std::mutex> lock(m_write_mutex);
+
+    int count = 0;
+    int nslots = m_nslots.load(std::memory_order_relaxed);
+    for(int i = 0 ; i < nslots ; i++) {
+        m_slots[i].ReadLocked(target);
+        if(!target.MMSI)
+            continue;
+        if(ptargets && count < max_targets)
+            ptargets[count] = target;
+        count++;
+    }
+    if(pgeneration)
+        *pgeneration = m_ais_generation.load(std::memory_order_relaxed);
+    return count;
+}
@@ -35,6 +35,7 @@
 #include <algorithm>
 
 #include "s57chart.h"
+#include "PerfTrace.h"
 
 #include <wx/listimpl.cpp>
 WX_DEFINE_LIST( PatchList );
@@ -1530,6 +1531,8 @@ void Quilt::UnlockQuilt()
 
 bool Quilt::Compose( const ViewPort &vp_in )
 {
+    PERF_ZONE("Quilt::Compose");
+
     if( !ChartData )
         return false;
 
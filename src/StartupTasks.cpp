@@ -0,0 +1,222 @@
+/******************************************************************************
+ *
+ * Project:  OpenCPN
+ * Purpose:  Startup task scheduling and timing
+ *
+ ***************************************************************************
+ *   Copyright (C) 2020 by David S. Register                               *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301,  USA.         *
+ ***************************************************************************
+ */
+
+#include <wx/wxprec.h>
+
+#ifndef  WX_PRECOMP
+  #include <wx/wx.h>
+#endif //precompiled headers
+
+#include <system_error>
+#include <vector>
+
+#include "StartupTasks.h"
+#include "PerfTrace.h"
+
+//  Keeps what a worker logs in its task, for Wait() to log on the main thread
+class StartupTaskLog : public wxLog
+{
+public:
+    StartupTaskLog(std::vector< std::pair<wxLogLevel, wxString> > &log) : m_log(log) {}
+
+protected:
+    void DoLogRecord(wxLogLevel level, const wxString &msg, const wxLogRecordInfo &info)
+    {
+        m_log.push_back(std::make_pair(level, msg));
+    }
+
+private:
+    std::vector< std::pair<wxLogLevel, wxString> > &m_log;
+};
+
+StartupTasks &StartupTasks::Get()
+{
+    static StartupTasks s_tasks;
+    return s_tasks;
+}
+
+StartupTasks::StartupTasks()
+{
+    m_phase = NULL;
+}
+
+StartupTasks::~StartupTasks()
+{
+    //  Tasks nobody waited for, e.g. on an early exit
+    for(size_t i = 0 ; i < m_tasks.size() ; i++) {
+        if(m_tasks[i].thread.joinable())
+            m_tasks[i].thread.join();
+    }
+}
+
+double StartupTasks::Now() const
+{
+    //  The trace clock, so the steps line up with the zones in a trace
+    return PerfTrace::Now() / 1000.;
+}
+
+StartupTasks::Task *StartupTasks::Find(const wxString &name)
+{
+    for(size_t i = 0 ; i < m_tasks.size() ; i++) {
+        if(m_tasks[i].name == name)
+            return &m_tasks[i];
+    }
+    return NULL;
+}
+
+void StartupTasks::Done(Task &task)
+{
+    if(PerfTrace::IsActive())
+        PerfTrace::Record(task.tracename, task.start * 1000., task.end * 1000.);
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    task.bdone = true;
+    m_cond.notify_all();
+}
+
+void StartupTasks::Start(const wxString &name, const std::function<void()> &work,
+                         const wxArrayString &deps)
+{
+    //  A deque, so the workers may keep pointers to their tasks while more are added
+    m_tasks.push_back(Task());
+    Task &task = m_tasks.back();
+    task.name = name;
+    task.tracename = PerfTrace::Intern(name);
+    task.queued = Now();
+
+    std::vector<Task *> waitfor;
+    for(unsigned int i = 0 ; i < deps.GetCount() ; i++) {
+        Task *dep = Find(deps[i]);
+        if(dep)
+            waitfor.push_back(dep);
+    }
+
+    Task *ptask = &task;
+    std::function<void()> run = [this, ptask, waitfor, work]() {
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            for(size_t i = 0 ; i < waitfor.size() ; i++) {
+                Task *dep = waitfor[i];
+                m_cond.wait(lock, [dep]() { return dep->bdone; });
+            }
+        }
+
+        StartupTaskLog *log = NULL;
+        if(!wxThread::IsMain()) {
+            log = new StartupTaskLog(ptask->log);
+            wxLog::SetThreadActiveTarget(log);
+        }
+
+        ptask->start = Now();
+        work();
+        ptask->end = Now();
+
+        if(log) {
+            wxLog::SetThreadActiveTarget(NULL);
+            delete log;
+        }
+        Done(*ptask);
+    };
+
+    try {
+        task.thread = std::thread(run);
+        task.bworker = true;
+    } catch(std::system_error &) {
+        //  No thread to be had, so do it now
+        run();
+    }
+}
+
+void StartupTasks::Wait(const wxString &name)
+{
+    Task *task = Find(name);
+    if(!task || !task->thread.joinable())
+        return;
+
+    double t0 = Now();
+    task->thread.join();
+    task->waited += Now() - t0;
+
+    for(size_t i = 0 ; i < task->log.size() ; i++)
+        wxLogGeneric(task->log[i].first, _T("%s"), task->log[i].second.c_str());
+    task->log.clear();
+}
+
+void StartupTasks::Phase(const wxString &name)
+{
+    EndPhase();
+
+    m_tasks.push_back(Task());
+    m_phase = &m_tasks.back();
+    m_phase->name = name;
+    m_phase->tracename = PerfTrace::Intern(name);
+    m_phase->queued = m_phase->start = Now();
+}
+
+void StartupTasks::EndPhase()
+{
+    if(!m_phase)
+        return;
+
+    m_phase->end = Now();
+    Done(*m_phase);
+    m_phase = NULL;
+}
+
+void StartupTasks::Mark(const wxString &name)
+{
+    EndPhase();
+
+    m_tasks.push_back(Task());
+    Task &mark = m_tasks.back();
+    mark.name = name;
+    mark.tracename = PerfTrace::Intern(name);
+    mark.queued = mark.start = mark.end = Now();
+    Done(mark);
+}
+
+void StartupTasks::Report()
+{
+    wxLogMessage(_T("Startup timing, ms since start:"));
+    wxLogMessage(_T("  %-28s %9s %9s %9s %9s  %s"), _T("step"), _T("start"), _T("end"), _T("time"), _T("waited"), _T("thread"));
+
+    for(size_t i = 0 ; i < m_tasks.size() ; i++) {
+        Task &task = m_tasks[i];
+
+        bool bdone;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            bdone = task.bdone;
+        }
+
+        if(!bdone) {
+            wxLogMessage(_T("  %-28s %9.1f  ...still running"), task.name.c_str(), task.queued);
+            continue;
+        }
+
+        wxLogMessage(_T("  %-28s %9.1f %9.1f %9.1f %9.1f  %s"), task.name.c_str(), task.start, task.end,
+                     task.end - task.start, task.waited, task.bworker ? _T("worker") : _T("main"));
+    }
+}
@@ -0,0 +1,316 @@
+/***************************************************************************
+ *
+ * Project:  OpenCPN
+ * Purpose:  Tide station high/low water cache
+ *
+ ***************************************************************************
+ *   Copyright (C) 2020 by David S. Register                               *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301,  USA.         *
+ **************************************************************************/
+
+#include "wx/wxprec.h"
+#ifndef  WX_PRECOMP
+#include "wx/wx.h"
+#endif //precompiled headers
+
+#include <algorithm>
+
+#include "TCExtremaCache.h"
+
+//  A window spans this long before and after the time asked for
+#define TC_WINDOW_BEFORE        (24 * 3600)
+#define TC_WINDOW_AFTER         (3 * 24 * 3600)
+
+//  A new window is asked for once the time is this close to an edge
+#define TC_REFRESH_BEFORE       (12 * 3600)
+#define TC_REFRESH_AFTER        (2 * 24 * 3600)
+
+//  Spacing of the sampled levels, and of the high/low water refinement
+#define TC_SAMPLE_STEP          600
+#define TC_REFINE_STEP          60
+
+//  Windows kept, the least recently used goes first
+#define TC_MAX_STATIONS         128
+
+class TCExtremaThread : public wxThread
+{
+public:
+    TCExtremaThread(TCExtremaCache *cache)
+        : wxThread(wxTHREAD_JOINABLE), m_cache(cache) {}
+
+    void *Entry();
+
+private:
+    TCExtremaCache      *m_cache;
+};
+
+void *TCExtremaThread::Entry()
+{
+    SetPriority( WXTHREAD_MIN_PRIORITY );
+
+    TCExtremaCache::WindowRequest req = { 0, 0, TCPredictor(NULL) };
+    int generation;
+    while(m_cache->NextRequest(req, generation)) {
+        TCExtremaCache::StationWindow win;
+        TCExtremaCache::ComputeWindow(req.predictor, req.t, win);
+        m_cache->Finish(req.idx, generation, win);
+    }
+
+    return 0;
+}
+
+TCExtremaCache::TCExtremaCache()
+    : m_cond(m_mutex)
+{
+    m_clock = 0;
+    m_generation = 0;
+    m_bexit = false;
+    m_thread = NULL;
+}
+
+TCExtremaCache::~TCExtremaCache()
+{
+    Clear();
+}
+
+void TCExtremaCache::Clear()
+{
+    if(m_thread) {
+        {
+            wxMutexLocker lock(m_mutex);
+            m_bexit = true;
+            m_cond.Broadcast();
+        }
+        m_thread->Wait();
+        delete m_thread;
+        m_thread = NULL;
+    }
+
+    wxMutexLocker lock(m_mutex);
+    m_bexit = false;
+    m_queue.clear();
+    m_queued.clear();
+    m_stations.clear();
+    m_generation++;
+}
+
+bool TCExtremaCache::NeedsRequest(int idx, time_t t)
+{
+    wxMutexLocker lock(m_mutex);
+
+    if(m_queued.count(idx))
+        return false;
+
+    auto it = m_stations.find(idx);
+    if(it == m_stations.end())
+        return true;
+
+    const StationWindow &win = it->second;
+    return (t < win.t_start + TC_REFRESH_BEFORE) || (t > win.End() - TC_REFRESH_AFTER);
+}
+
+void TCExtremaCache::Request(int idx, const TCPredictor &predictor, time_t t)
+{
+    {
+        wxMutexLocker lock(m_mutex);
+        if(!m_queued.insert(idx).second)
+            return;
+
+        WindowRequest req = { idx, t, predictor };
+        m_queue.push_back(req);
+        m_cond.Signal();
+    }
+
+    if(!m_thread) {
+        m_thread = new TCExtremaThread(this);
+        if(m_thread->Create() != wxTHREAD_NO_ERROR || m_thread->Run() != wxTHREAD_NO_ERROR) {
+            delete m_thread;
+            m_thread = NULL;
+
+            //  No worker, so nothing will ever be computed
+            wxMutexLocker lock(m_mutex);
+            m_queue.clear();
+            m_queued.clear();
+        }
+    }
+}
+
+bool TCExtremaCache::NextRequest(WindowRequest &req, int &generation)
+{
+    wxMutexLocker lock(m_mutex);
+
+    while(!m_bexit && m_queue.empty())
+        m_cond.Wait();
+
+    if(m_bexit)
+        return false;
+
+    req = m_queue.front();
+    m_queue.pop_front();
+    generation = m_generation;
+    return true;
+}
+
+void TCExtremaCache::Finish(int idx, int generation, StationWindow &win)
+{
+    wxMutexLocker lock(m_mutex);
+
+    if(generation != m_generation)
+        return;
+
+    m_queued.erase(idx);
+
+    StationWindow &dest = m_stations[idx];
+    dest.t_start = win.t_start;
+    dest.t_end = win.t_end;
+    dest.step = win.step;
+    dest.extrema.swap(win.extrema);
+    dest.last_use = ++m_clock;
+
+    if(m_stations.size() > TC_MAX_STATIONS) {
+        auto oldest = m_stations.begin();
+        for(auto it = m_stations.begin(); it != m_stations.end(); ++it) {
+            if(it->second.last_use < oldest->second.last_use)
+                oldest = it;
+        }
+        m_stations.erase(oldest);
+    }
+}
+
+//  The window of a station, marked as used.  Called with m_mutex held.
+const TCExtremaCache::StationWindow *TCExtremaCache::Find(int idx)
+{
+    auto it = m_stations.find(idx);
+    if(it == m_stations.end())
+        return NULL;
+
+    it->second.last_use = ++m_clock;
+    return &it->second;
+}
+
+//  Sample the levels over the window, then refine each turning point
+//  of the samples to the minute.  Runs on the worker thread.
+void TCExtremaCache::ComputeWindow(TCPredictor &predictor, time_t t, StationWindow &win)
+{
+    //  Align the samples, so windows of one station line up
+    time_t t_start = t - TC_WINDOW_BEFORE;
+    t_start -= t_start % TC_SAMPLE_STEP;
+    int n = (TC_WINDOW_BEFORE + TC_WINDOW_AFTER) / TC_SAMPLE_STEP + 1;
+
+    win.t_start = t_start;
+    win.t_end = t_start + (time_t)(n - 1) * TC_SAMPLE_STEP;
+    win.step = TC_SAMPLE_STEP;
+
+    if(!predictor.IsOk())
+        return;
+
+    std::vector<float> levels(n);
+    predictor.GetLevels(t_start, TC_SAMPLE_STEP, n, &levels[0]);
+
+    const int nrefine = 2 * TC_SAMPLE_STEP / TC_REFINE_STEP + 1;
+    float fine[nrefine];
+    const float *v = &levels[0];
+
+    for(int k = 1; k < n - 1; k++) {
+        bool bhigh = v[k] > v[k-1] && v[k] >= v[k+1];
+        bool blow = v[k] < v[k-1] && v[k] <= v[k+1];
+        if(!bhigh && !blow)
+            continue;
+
+        time_t t0 = t_start + (time_t)(k - 1) * TC_SAMPLE_STEP;
+        predictor.GetLevels(t0, TC_REFINE_STEP, nrefine, fine);
+
+        int best = 0;
+        for(int j = 1; j < nrefine; j++) {
+            if(bhigh ? (fine[j] > fine[best]) : (fine[j] < fine[best]))
+                best = j;
+        }
+
+        TCExtremum ext;
+        ext.time = t0 + (time_t)best * TC_REFINE_STEP;
+        ext.level = fine[best];
+        ext.bhigh = bhigh;
+
+        if(!win.extrema.empty() && win.extrema.back().time >= ext.time)
+            continue;
+        win.extrema.push_back(ext);
+    }
+}
+
+//  First extremum strictly after t
+static std::vector<TCExtremum>::const_iterator TCExtremumAfter(const std::vector<TCExtremum> &e, time_t t)
+{
+    return std::partition_point(e.begin(), e.end(),
+                                [t](const TCExtremum &x) { return x.time <= t; });
+}
+
+bool TCExtremaCache::GetNextExtremum(int idx, time_t t, TCExtremum &ext)
+{
+    wxMutexLocker lock(m_mutex);
+
+    const StationWindow *pwin = Find(idx);
+    if(!pwin)
+        return false;
+
+    const StationWindow &win = *pwin;
+    if(t < win.t_start + win.step)
+        return false;
+
+    const std::vector<TCExtremum> &e = win.extrema;
+    auto next = TCExtremumAfter(e, t);
+    if(next == e.end())
+        return false;
+
+    ext = *next;
+    return true;
+}
+
+bool TCExtremaCache::GetExtremum(int idx, time_t t, bool bforward, bool bhigh, TCExtremum &ext)
+{
+    wxMutexLocker lock(m_mutex);
+
+    const StationWindow *pwin = Find(idx);
+    if(!pwin)
+        return false;
+
+    const StationWindow &win = *pwin;
+    if(t < win.t_start + win.step || t > win.End() - win.step)
+        return false;
+
+    const std::vector<TCExtremum> &e = win.extrema;
+    auto next = TCExtremumAfter(e, t);
+
+    if(bforward) {
+        for( ; next != e.end(); ++next) {
+            if(next->bhigh == bhigh) {
+                ext = *next;
+                return true;
+            }
+        }
+    }
+    else {
+        while(next != e.begin()) {
+            --next;
+            if(next->bhigh == bhigh) {
+                ext = *next;
+                return true;
+            }
+        }
+    }
+
+    return false;
+}
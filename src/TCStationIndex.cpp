@@ -0,0 +1,198 @@
+/***************************************************************************
+ *
+ * Project:  OpenCPN
+ * Purpose:  Spatial index of tide and current stations
+ *
+ ***************************************************************************
+ *   Copyright (C) 2020 by David S. Register                               *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301,  USA.         *
+ **************************************************************************/
+
+#include "wx/wxprec.h"
+#ifndef  WX_PRECOMP
+#include "wx/wx.h"
+#endif //precompiled headers
+
+#include <algorithm>
+#include <queue>
+#include <math.h>
+
+#include "TCStationIndex.h"
+#include "bbox.h"
+#include "georef.h"
+
+#define TC_INDEX_ROWS   180
+#define TC_INDEX_COLS   360
+
+TCStationIndex::TCStationIndex()
+{
+}
+
+void TCStationIndex::Clear()
+{
+    m_stations.clear();
+    m_cell_start.clear();
+}
+
+int TCStationIndex::Row(double lat)
+{
+    int row = (int)floor(lat + 90.);
+    return wxMax(0, wxMin(TC_INDEX_ROWS - 1, row));
+}
+
+int TCStationIndex::Col(double lon)
+{
+    double l = fmod(lon + 180., 360.);
+    if(l < 0)
+        l += 360.;
+    return wxMax(0, wxMin(TC_INDEX_COLS - 1, (int)floor(l)));
+}
+
+void TCStationIndex::Add(int idx, double lat, double lon)
+{
+    Station s;
+    s.idx = idx;
+    s.lat = lat;
+    s.lon = lon;
+    s.cell = Row(lat) * TC_INDEX_COLS + Col(lon);
+    m_stations.push_back(s);
+}
+
+void TCStationIndex::Build()
+{
+    std::sort(m_stations.begin(), m_stations.end(),
+              [](const Station &a, const Station &b) {
+                  return a.cell < b.cell || (a.cell == b.cell && a.idx < b.idx);
+              });
+
+    m_cell_start.assign(TC_INDEX_ROWS * TC_INDEX_COLS + 1, 0);
+    for(unsigned int i = 0; i < m_stations.size(); i++)
+        m_cell_start[m_stations[i].cell + 1]++;
+    for(int c = 0; c < TC_INDEX_ROWS * TC_INDEX_COLS; c++)
+        m_cell_start[c + 1] += m_cell_start[c];
+}
+
+void TCStationIndex::GetInBBox(const LLBBox &box, double marge, std::vector<int> &stations) const
+{
+    stations.clear();
+    if(m_cell_start.empty())
+        return;
+
+    int row0 = Row(box.GetMinLat() - marge);
+    int row1 = Row(box.GetMaxLat() + marge);
+
+    double lon0 = box.GetMinLon() - marge;
+    double lon1 = box.GetMaxLon() + marge;
+    int col0 = Col(lon0);
+    int ncols = TC_INDEX_COLS;
+    if(lon1 - lon0 < 360.)
+        ncols = wxMin(TC_INDEX_COLS, (int)(floor(lon1) - floor(lon0)) + 1);
+
+    for(int row = row0; row <= row1; row++) {
+        for(int j = 0; j < ncols; j++) {
+            int cell = row * TC_INDEX_COLS + (col0 + j) % TC_INDEX_COLS;
+            for(int i = m_cell_start[cell]; i < m_cell_start[cell + 1]; i++) {
+                const Station &s = m_stations[i];
+                if(box.ContainsMarge(s.lat, s.lon, marge))
+                    stations.push_back(s.idx);
+            }
+        }
+    }
+
+    std::sort(stations.begin(), stations.end());
+}
+
+void TCStationIndex::GetNearest(double lat, double lon, int count,
+                                std::vector<std::pair<double, int> > &stations,
+                                const std::function<bool(int)> &accept) const
+{
+    stations.clear();
+    if(m_cell_start.empty())
+        return;
+
+    unsigned int want = (count > 0) ? (unsigned int)count : m_stations.size();
+    std::priority_queue<std::pair<double, int> > best;
+
+    int row0 = Row(lat);
+    int col0 = Col(lon);
+
+    auto visit = [&](int row, int dj) {
+        int cell = row * TC_INDEX_COLS + ((col0 + dj) % TC_INDEX_COLS + TC_INDEX_COLS) % TC_INDEX_COLS;
+        for(int i = m_cell_start[cell]; i < m_cell_start[cell + 1]; i++) {
+            const Station &s = m_stations[i];
+            if(accept && !accept(s.idx))
+                continue;
+
+            double brg, dist;
+            DistanceBearingMercator(lat, lon, s.lat, s.lon, &brg, &dist);
+            std::pair<double, int> d(dist, s.idx);
+            if(best.size() < want)
+                best.push(d);
+            else if(d < best.top()) {
+                best.pop();
+                best.push(d);
+            }
+        }
+    };
+
+    //  Visit rings of cells around the one holding lat, lon.  Each cell is
+    //  (row0 + di, col0 + dj) with dj in [-180, 179], visited in ring
+    //  max(|di|, |dj|).
+    for(int r = 0; r <= TC_INDEX_COLS / 2; r++) {
+        int djmin = wxMax(-r, -TC_INDEX_COLS / 2);
+        int djmax = wxMin(r, TC_INDEX_COLS / 2 - 1);
+
+        for(int di = -r; di <= r; di++) {
+            int row = row0 + di;
+            if(row < 0 || row >= TC_INDEX_ROWS)
+                continue;
+
+            if(di == -r || di == r) {
+                for(int dj = djmin; dj <= djmax; dj++)
+                    visit(row, dj);
+            }
+            else {
+                if(-r >= djmin)
+                    visit(row, -r);
+                if(r <= djmax)
+                    visit(row, r);
+            }
+        }
+
+        if(best.size() < want || count <= 0)
+            continue;
+
+        //  Anything not visited yet is at least r degrees of latitude away,
+        //  or r degrees of longitude at no more than the latitude of the
+        //  rows visited.  The distance can't be shorter than either.
+        double bound = r;
+        if(r + 1 <= TC_INDEX_COLS / 2) {
+            double lat_lo = row0 - r - 90.;
+            double lat_hi = row0 + r + 1 - 90.;
+            double lmax = wxMin(90., wxMax(fabs(lat_lo), fabs(lat_hi)));
+            bound = wxMin(bound, r * cos(lmax * PI / 180.));
+        }
+        if(best.top().first <= bound * 60. * 0.999)
+            break;
+    }
+
+    stations.resize(best.size());
+    for(int i = best.size() - 1; i >= 0; i--) {
+        stations[i] = best.top();
+        best.pop();
+    }
+}
@@ -534,9 +534,13 @@ void TCWin::OnPaint( wxPaintEvent& event )
             ptcmgr->GetTideFlowSens( m_t_graphday_00_at_station, BACKWARD_ONE_HOUR_STEP,
                                      pIDX->IDX_rec_num, tcv[0], val, wt );
 
+            float tcdir[26];
+            ptcmgr->GetTideOrCurrentSeries( m_t_graphday_00_at_station, FORWARD_ONE_HOUR_STEP, 26,
+                                            pIDX->IDX_rec_num, tcv, tcdir );
+
             for( i = 0; i < 26; i++ ) {
                 int tt = m_t_graphday_00_at_station + ( i * FORWARD_ONE_HOUR_STEP );
-                ptcmgr->GetTideOrCurrent( tt, pIDX->IDX_rec_num, tcv[i], dir );
+                dir = tcdir[i];
                 tt_tcv[i] = tt;                         // store the corresponding time_t value
                 if( tcv[i] > tcmax ) tcmax = tcv[i];
 
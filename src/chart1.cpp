@@ -136,9 +136,12 @@
 #include "SoundFactory.h"
 #include "PluginHandler.h"
 #include "SignalKEventHandler.h"
+#include "StartupTasks.h"
+#include "PerfTrace.h"
 
 #ifdef ocpnUSE_GL
 #include "glChartCanvas.h"
+#include "mipmap/raster.h"
 #endif
 
 #include <wx/image.h>
@@ -494,6 +497,7 @@ bool                      g_bskew_comp;
 bool                      g_bopengl;
 bool                      g_bSoftwareGL;
 bool                      g_bShowFPS;
+bool                      g_bShowFrameStats;
 bool                      g_bsmoothpanzoom;
 bool                      g_fog_overzoom;
 double                    g_overzoom_emphasis_base;
@@ -1104,6 +1108,7 @@ void MyApp::OnInitCmdLine( wxCmdLineParser& parser )
     parser.AddSwitch( _T("parse_all_enc"), wxEmptyString, _T("Convert all S-57 charts to OpenCPN's internal format on start.") );
     parser.AddOption( _T("unit_test_1"), wxEmptyString, _("Display a slideshow of <num> charts and then exit. Zero or negative <num> specifies no limit."), wxCMD_LINE_VAL_NUMBER );
     parser.AddSwitch( _T("unit_test_2") );
+    parser.AddOption( _T("trace"), wxEmptyString, _T("Record a performance trace in Chrome trace format to <file>, written on exit."), wxCMD_LINE_VAL_STRING );
     parser.AddParam("import GPX files",
                         wxCMD_LINE_VAL_STRING,
                         wxCMD_LINE_PARAM_OPTIONAL | wxCMD_LINE_PARAM_MULTIPLE);
@@ -1128,6 +1133,9 @@ bool MyApp::OnCmdLineParsed( wxCmdLineParser& parser )
         if( g_unit_test_1 == 0 )
             g_unit_test_1 = -1;
     }
+    wxString trace;
+    if( parser.Found( _T("trace"), &trace ) )
+        PerfTrace::StartRecording( trace );
 
     for (size_t paramNr=0; paramNr < parser.GetParamCount(); ++paramNr)
             g_params.push_back(parser.GetParam(paramNr));
@@ -1395,6 +1403,58 @@ static bool isTransparentToolbarInOpenGLOK(void) {
 }
 
 static wxStopWatch init_sw;
+
+//  Loads done on worker threads while starting up, taken over by the main thread when needed
+static ChartDB *s_pStartupChartDB;
+static bool s_bStartupChartDBValid;
+static TCMgr *s_pStartupTCMgr;
+
+static void StartChartDBLoad( const ArrayOfCDI &dirs )
+{
+    //  wxString is not thread safe, so the worker gets copies of its own
+    ArrayOfCDI *pdirs = new ArrayOfCDI;
+    for( unsigned int i = 0; i < dirs.GetCount(); i++ ) {
+        ChartDirInfo cdi;
+        cdi.fullpath = wxString( dirs[i].fullpath.wc_str() );
+        cdi.magic_number = wxString( dirs[i].magic_number.wc_str() );
+        pdirs->Add( cdi );
+    }
+    wxString *pfile = new wxString( ChartListFileName.wc_str() );
+
+    //  Built here, the constructor logs and looks at g_pi_manager, which the worker must not.
+    //  The PlugIn chart classes are added when the main thread takes the database over.
+    s_pStartupChartDB = new ChartDB( );
+
+    StartupTasks::Get().Start( _T("chart database"), [pdirs, pfile]() {
+        s_bStartupChartDBValid = s_pStartupChartDB->LoadBinary( *pfile, *pdirs );
+        delete pdirs;
+        delete pfile;
+    });
+}
+
+static void StartHarmonicsLoad()
+{
+    //  Only worth it if a canvas is going to show tides or currents right away
+    bool b_needed = false;
+    for( unsigned int i = 0; i < g_canvasConfigArray.GetCount(); i++ ) {
+        canvasConfig *pcc = g_canvasConfigArray.Item( i );
+        if( pcc && ( pcc->bShowTides || pcc->bShowCurrents ) )
+            b_needed = true;
+    }
+    if( !b_needed )
+        return;
+
+    wxArrayString *psources = new wxArrayString;
+    for( unsigned int i = 0; i < TideCurrentDataSet.GetCount(); i++ )
+        psources->Add( wxString( TideCurrentDataSet[i].wc_str() ) );
+
+    StartupTasks::Get().Start( _T("tide harmonics"), [psources]() {
+        s_pStartupTCMgr = new TCMgr;
+        s_pStartupTCMgr->LoadDataSources( *psources );
+        delete psources;
+    });
+}
+
 class ParseENCWorkerThread : public wxThread
 {
 public:
@@ -1770,6 +1830,8 @@ bool MyApp::OnInit()
 
     g_start_time = wxDateTime::Now();
 
+    StartupTasks::Get().Phase( _T("configuration") );
+
     g_loglast_time = g_start_time;
     g_loglast_time.MakeGMT();
     g_loglast_time.Subtract( wxTimeSpan( 0, 29, 0, 0 ) ); // give 1 minute for GPS to get a fix
@@ -1941,6 +2003,7 @@ bool MyApp::OnInit()
     //      Open/Create the Config Object
     pConfig = g_Platform->GetConfigObject();
     pConfig->LoadMyConfig();
+    PerfTrace::EnableFrameStats( g_bShowFrameStats );
 
     //  Override for some safe and nice default values if the config file was created from scratch
     if(b_initial_load)
@@ -2184,8 +2247,67 @@ bool MyApp::OnInit()
     gpIDX = NULL;
     gpIDXn = 0;
 
+    //   Build the initial chart dir array
+    ArrayOfCDI ChartDirArray;
+    pConfig->LoadChartDirArray( ChartDirArray );
+
+    //  Windows installer may have left hints regarding the initial chart dir selection
+#ifdef __WXMSW__
+    if( g_bFirstRun && (ChartDirArray.GetCount() == 0) ) {
+        int ndirs = 0;
+
+        wxRegKey RegKey( wxString( _T("HKEY_LOCAL_MACHINE\\SOFTWARE\\OpenCPN") ) );
+        if( RegKey.Exists() ) {
+            wxLogMessage( _("Retrieving initial Chart Directory set from Windows Registry") );
+            wxString dirs;
+            RegKey.QueryValue( wxString( _T("ChartDirs") ), dirs );
+
+            wxStringTokenizer tkz( dirs, _T(";") );
+            while( tkz.HasMoreTokens() ) {
+                wxString token = tkz.GetNextToken();
+
+                ChartDirInfo cdi;
+                cdi.fullpath = token.Trim();
+                cdi.magic_number = _T("");
+
+                ChartDirArray.Add( cdi );
+                ndirs++;
+            }
+
+        }
+
+		if (g_bportable)
+		{
+			ChartDirInfo cdi;
+			cdi.fullpath =_T("charts");
+			cdi.fullpath.Prepend(g_Platform->GetSharedDataDir());
+			cdi.magic_number = _T("");
+			ChartDirArray.Add(cdi);
+			ndirs++;
+		}
+
+        if( ndirs ) pConfig->UpdateChartDirs( ChartDirArray );
+
+    }
+#endif
+
+//    If the ChartDirArray is empty at this point, any existing chart database file must be declared invalid,
+//    So it is best to simply delete it if present.
+//    TODO  There is a possibility of recreating the dir list from the database itself......
+
+    if( !ChartDirArray.GetCount() )
+        if(::wxFileExists( ChartListFileName ))
+            ::wxRemoveFile( ChartListFileName );
+
+//      Start the slow loads that need neither the GUI nor each other
+    StartChartDBLoad( ChartDirArray );
+    pConfig->PreloadNavObjects();
+    StartHarmonicsLoad();
+
     g_Platform->Initialize_2();
 
+    StartupTasks::Get().Phase( _T("frame and canvases") );
+
 //  Set up the frame initial visual parameters
 //      Default size, resized later
     wxSize new_frame_size( -1, -1 );
@@ -2331,61 +2453,13 @@ bool MyApp::OnInit()
     //  Yield to pick up the OnSize() calls that result from Maximize()
     Yield();
     
-    //   Build the initial chart dir array
-    ArrayOfCDI ChartDirArray;
-    pConfig->LoadChartDirArray( ChartDirArray );
-
-    //  Windows installer may have left hints regarding the initial chart dir selection
-#ifdef __WXMSW__
-    if( g_bFirstRun && (ChartDirArray.GetCount() == 0) ) {
-        int ndirs = 0;
-
-        wxRegKey RegKey( wxString( _T("HKEY_LOCAL_MACHINE\\SOFTWARE\\OpenCPN") ) );
-        if( RegKey.Exists() ) {
-            wxLogMessage( _("Retrieving initial Chart Directory set from Windows Registry") );
-            wxString dirs;
-            RegKey.QueryValue( wxString( _T("ChartDirs") ), dirs );
-
-            wxStringTokenizer tkz( dirs, _T(";") );
-            while( tkz.HasMoreTokens() ) {
-                wxString token = tkz.GetNextToken();
-
-                ChartDirInfo cdi;
-                cdi.fullpath = token.Trim();
-                cdi.magic_number = _T("");
-
-                ChartDirArray.Add( cdi );
-                ndirs++;
-            }
-
-        }
-
-		if (g_bportable)
-		{
-			ChartDirInfo cdi;
-			cdi.fullpath =_T("charts");
-			cdi.fullpath.Prepend(g_Platform->GetSharedDataDir());
-			cdi.magic_number = _T("");
-			ChartDirArray.Add(cdi);
-			ndirs++;
-		}
-
-        if( ndirs ) pConfig->UpdateChartDirs( ChartDirArray );
-
-    }
-#endif
-
-//    If the ChartDirArray is empty at this point, any existing chart database file must be declared invalid,
-//    So it is best to simply delete it if present.
-//    TODO  There is a possibility of recreating the dir list from the database itself......
-
-    if( !ChartDirArray.GetCount() )
-        if(::wxFileExists( ChartListFileName ))
-            ::wxRemoveFile( ChartListFileName );
-
-//      Try to load the current chart list Data file
-    ChartData = new ChartDB( );
-    if (!ChartData->LoadBinary(ChartListFileName, ChartDirArray)) {
+//      Take the current chart list Data file, read while the frame was built
+    StartupTasks::Get().Phase( _T("chart database") );
+    StartupTasks::Get().Wait( _T("chart database") );
+    ChartData = s_pStartupChartDB;
+    s_pStartupChartDB = NULL;
+    ChartData->UpdateChartClassDescriptorArray();       // now that g_pi_manager exists
+    if (!s_bStartupChartDBValid) {
         g_bNeedDBUpdate = true;
     }
 
@@ -2458,6 +2532,7 @@ extern ocpnGLOptions g_GLOptions;
 
     Yield();
 
+    StartupTasks::Get().Phase( _T("first chart render") );
     gFrame->DoChartUpdate();
 
     FontMgr::Get().ScrubList(); // Clean the font list, removing nonsensical entries
@@ -2559,6 +2634,8 @@ extern ocpnGLOptions g_GLOptions;
 #endif
         
         
+    StartupTasks::Get().Mark( _T("user interface ready") );
+
     // Start delayed initialization chain after some milliseconds
     gFrame->InitTimer.Start( 5, wxTIMER_CONTINUOUS );
     
@@ -2573,6 +2650,8 @@ int MyApp::OnExit()
 {
     wxLogMessage( _T("opencpn::MyApp starting exit.") );
 
+    PerfTrace::StopRecording();
+
     //  Send current nav status data to log file   // pjotrc 2010.02.09
 
     wxDateTime lognow = wxDateTime::Now();
@@ -6792,6 +6871,7 @@ void MyFrame::OnInitTimer(wxTimerEvent& event)
             
             // Rebuild chart database, if necessary
             if(g_bNeedDBUpdate){
+                StartupTasks::Get().Phase( _T("chart database rebuild") );
                 RebuildChartDatabase();
                 for(unsigned int i=0 ; i < g_canvasArray.GetCount() ; i++){
                     ChartCanvas *cc = g_canvasArray.Item(i);
@@ -6820,7 +6900,8 @@ void MyFrame::OnInitTimer(wxTimerEvent& event)
             }
 
             // Load the waypoints.. both of these routines are very slow to execute which is why
-            // they have been to defered until here
+            // they have been to defered until here.  The XML is parsed ahead by a worker.
+            StartupTasks::Get().Phase( _T("navobjects") );
             pWayPointMan = new WayPointman();
             pWayPointMan->SetColorScheme( global_color_scheme );
             
@@ -6851,6 +6932,7 @@ void MyFrame::OnInitTimer(wxTimerEvent& event)
                 wxString laymsg;
                 laymsg.Printf( wxT("Getting .gpx layer files from: %s"), layerdir.c_str() );
                 wxLogMessage( laymsg );
+                StartupTasks::Get().Phase( _T("layers") );
                 pConfig->LoadLayers(layerdir);
             }
 
@@ -6858,6 +6940,7 @@ void MyFrame::OnInitTimer(wxTimerEvent& event)
         }
         case 1:
             // Connect Datastreams
+            StartupTasks::Get().Phase( _T("data streams") );
 
 
             for ( size_t i = 0; i < g_pConnectionParams->Count(); i++ )
@@ -6889,6 +6972,7 @@ void MyFrame::OnInitTimer(wxTimerEvent& event)
             if (m_initializing)
                 break;
             m_initializing = true;
+            StartupTasks::Get().Phase( _T("plugins") );
             g_pi_manager->LoadAllPlugIns( true, false );
 
 //            RequestNewToolbars();
@@ -7009,6 +7093,7 @@ void MyFrame::OnInitTimer(wxTimerEvent& event)
 
         case 4:
         {
+            StartupTasks::Get().Phase( _T("options dialog") );
             g_options = new options( this, -1, _("Options") );
             //g_options->SetColorScheme(global_color_scheme);
             //applyDarkAppearanceToWindow(g_options->MacGetTopLevelWindowRef());
@@ -7026,6 +7111,7 @@ void MyFrame::OnInitTimer(wxTimerEvent& event)
 
         case 5:
         {
+            StartupTasks::Get().Phase( _T("command line files") );
             if ( !g_params.empty() ) {
                 for ( size_t n = 0; n < g_params.size(); n++ )
                 {
@@ -7081,10 +7167,16 @@ void MyFrame::OnInitTimer(wxTimerEvent& event)
             androidEnableRotation();
 #endif
 
+            StartupTasks::Get().Mark( _T("deferred init done") );
+            StartupTasks::Get().Report();
+
             break;
         }
     }   // switch
-    
+
+    //  The timer idles in between, which is not part of any phase
+    StartupTasks::Get().EndPhase();
+
     if(!g_bDeferredInitDone)
         InitTimer.Start( 100, wxTIMER_ONE_SHOT );
 
@@ -7513,7 +7605,7 @@ void MyFrame::OnFrameTimer1( wxTimerEvent& event )
             if( g_pRouteMan->UpdateProgress() ) {
         //    This RefreshRect will cause any active routepoint to blink
                 if( g_pRouteMan->GetpActiveRoute() )
-                    cc->RefreshRect( g_blink_rect, false );
+                    cc->RefreshDynamic( &g_blink_rect );
             }
 
 //  Force own-ship drawing parameters
@@ -7583,8 +7675,8 @@ void MyFrame::OnFrameTimer1( wxTimerEvent& event )
                     if( AnyAISTargetsOnscreen( cc, cc->GetVP() ) )
                         bnew_view = true;
 
-                    if(bnew_view) /* full frame in opengl mode */
-                        cc->Refresh(false);
+                    if(bnew_view) /* full frame in opengl mode, over the cached static layer */
+                        cc->RefreshDynamic();
 #endif
                 } else {
 //  Invalidate the ChartCanvas window appropriately
@@ -8847,6 +8939,8 @@ void MyFrame::OnEvtOCPN_SignalK(OCPN_SignalKEvent &event)
 
 void MyFrame::OnEvtOCPN_NMEA( OCPN_DataStreamEvent & event )
 {
+    PERF_ZONE("MyFrame::OnEvtOCPN_NMEA");
+
     wxString sfixtime;
     bool pos_valid = false, cog_sog_valid = false;
     bool bis_recognized_sentence = true;
@@ -9432,11 +9526,28 @@ void MyFrame::ResumeSockets( void )
 //TODO: Can be removed?
 }
 
+//  Tell the user when the Tide/Current data sources gave no stations at all
+static void CheckHarmonicsInstalled()
+{
+    if( ptcmgr->Get_max_IDX() < 1 )
+        OCPNMessageBox( NULL, _("It seems you have no tide/current harmonic data installed."),
+                        _("OpenCPN Info"), wxOK | wxCENTER );
+}
+
 void MyFrame::LoadHarmonics()
 {
+    //  The harmonics may have been read by a worker while starting up
+    StartupTasks::Get().Wait( _T("tide harmonics") );
+    if(!ptcmgr && s_pStartupTCMgr) {
+        ptcmgr = s_pStartupTCMgr;
+        s_pStartupTCMgr = NULL;
+        CheckHarmonicsInstalled();
+    }
+
     if(!ptcmgr) {
         ptcmgr = new TCMgr;
         ptcmgr->LoadDataSources(TideCurrentDataSet);
+        CheckHarmonicsInstalled();
     }
     else {
         bool b_newdataset = false;
@@ -9472,8 +9583,10 @@ void MyFrame::LoadHarmonics()
             }
         }
 
-        if(b_newdataset)
+        if(b_newdataset) {
             ptcmgr->LoadDataSources(TideCurrentDataSet);
+            CheckHarmonicsInstalled();
+        }
     }
 }
 
@@ -10217,13 +10330,8 @@ void MyPrintout::GenerateGLbmp( )
 
         unsigned char *e = (unsigned char *)malloc( gsx * gsy * 3 );
 
-        if(buffer && e){
-            for( int p = 0; p < gsx*gsy; p++ ) {
-                e[3*p+0] = buffer[4*p+0];
-                e[3*p+1] = buffer[4*p+1];
-                e[3*p+2] = buffer[4*p+2];
-            }
-        }
+        if(buffer && e)
+            Raster_RGBA32_RGB24( gsx*gsy, buffer, e );
         free(buffer);
 
         wxImage image( gsx,gsy );
@@ -56,6 +56,7 @@
 
 #include "s57chart.h"
 #include "cm93.h"
+#include "PerfTrace.h"
 
 extern ColorScheme GetColorScheme();
 
@@ -1159,6 +1160,8 @@ CacheEntry *ChartDB::FindOldestDeleteCandidate( bool blog)
 
 ChartBase *ChartDB::OpenChartUsingCache(int dbindex, ChartInitFlag init_flag)
 {
+      PERF_ZONE("ChartDB::OpenChartUsingCache");
+
       if((dbindex < 0) || (dbindex > GetChartTableEntries()-1))
             return NULL;
 
@@ -33,8 +33,11 @@
 #include <wx/encconv.h>
 #include <wx/regex.h>
 #include <wx/progdlg.h>
+#include <wx/stopwatch.h>
 #include "wx/tokenzr.h"
 #include "wx/dir.h"
+#include <wx/ffile.h>
+#include <wx/textfile.h>
 
 #include "chartdbs.h"
 #include "chartbase.h"
@@ -42,6 +45,12 @@
 #include "mbtiles.h"
 #include "mygeom.h"                     // For DouglasPeucker();
 #include "FlexHash.h"
+
+#include <algorithm>
+#include <atomic>
+#include <system_error>
+#include <thread>
+
 #ifndef UINT32
 #define UINT32 unsigned int
 #endif
@@ -68,6 +77,34 @@ bool FindMatchingFile(const wxString &theDir, const wxChar *theRegEx, int nameLe
 }
 
 
+//    Run work(i) for i in [0, n) on all cores.
+//    progress(i) is called on this thread only, after each item it did itself.
+template<typename Work, typename Progress>
+static void RunParallel(int n, Work work, Progress progress)
+{
+    std::atomic<int> next(0);
+    auto worker = [&](bool bmain) {
+        for(int i = next++; i < n; i = next++) {
+            work(i);
+            if(bmain)
+                progress(i);
+        }
+    };
+
+    std::vector<std::thread> threads;
+    int nthreads = wxMin((int)std::thread::hardware_concurrency(), n) - 1;
+    for(int i = 0; i < nthreads; i++) {
+        try {
+            threads.push_back(std::thread(worker, false));
+        } catch(std::system_error &) {
+            break;
+        }
+    }
+    worker(true);
+    for(auto &t : threads)
+        t.join();
+}
+
 static ChartFamilyEnum GetChartFamily(int charttype)
 {
       ChartFamilyEnum cf;
@@ -148,6 +185,69 @@ bool ChartTableHeader::CheckValid()
     return true;
 }
 
+///////////////////////////////////////////////////////////////////////
+// ChartTablePoolWriter
+//      Collects the pools of a version 19 database being written
+///////////////////////////////////////////////////////////////////////
+
+class ChartTablePoolWriter
+{
+public:
+    ChartTablePoolWriter() { m_strings.push_back(0); }   // offset 0 is ""
+
+    int AddString(const char *str)
+    {
+        int offset = m_strings.size();
+        m_strings.insert(m_strings.end(), str, str + strlen(str) + 1);
+        return offset;
+    }
+
+    int AddPoints(const float *points, int nPoints)
+    {
+        int offset = m_points.size() / 2;
+        if (nPoints > 0)
+            m_points.insert(m_points.end(), points, points + 2 * nPoints);
+        return offset;
+    }
+
+    void AddPlyTable(const float *points, int nPoints)
+    {
+        m_plyOffsets.push_back(AddPoints(points, nPoints));
+        m_plyCounts.push_back(nPoints);
+    }
+
+    int GetPlyTableCount() const { return m_plyCounts.size(); }
+
+    void Write(wxOutputStream &os)
+    {
+        //  Pad the strings so a following file stays aligned
+        while (m_strings.size() % sizeof(int))
+            m_strings.push_back(0);
+
+        if (m_plyCounts.size()) {
+            os.Write(&m_plyCounts[0], m_plyCounts.size() * sizeof(int));
+            os.Write(&m_plyOffsets[0], m_plyOffsets.size() * sizeof(int));
+        }
+        if (m_points.size())
+            os.Write(&m_points[0], m_points.size() * sizeof(float));
+        os.Write(&m_strings[0], m_strings.size());
+    }
+
+    void GetSections(ChartTableSections_19 &sections) const
+    {
+        sections.nPlyTables = m_plyCounts.size();
+        sections.nPlyPoints = m_points.size() / 2;
+        sections.nStringBytes = (m_strings.size() + sizeof(int) - 1) / sizeof(int) * sizeof(int);
+        sections.reserved = 0;
+    }
+
+private:
+    std::vector<char> m_strings;
+    std::vector<float> m_points;
+    std::vector<int> m_plyCounts;
+    std::vector<int> m_plyOffsets;
+};
+
 ///////////////////////////////////////////////////////////////////////
 // ChartTableEntry
 ///////////////////////////////////////////////////////////////////////
@@ -380,19 +480,21 @@ ChartTableEntry::ChartTableEntry(ChartBase &theChart, wxString& utf8Path)
 
 ChartTableEntry::~ChartTableEntry()
 {
-    free(pFullPath);
-    free(pPlyTable);
+    if (!m_bmapped) {
+        free(pFullPath);
+        free(pPlyTable);
     
-    for (int i = 0; i < nAuxPlyEntries; i++)
-        free(pAuxPlyTable[i]);
-    free(pAuxPlyTable);
-    free(pAuxCntTable);
+        for (int i = 0; i < nAuxPlyEntries; i++)
+            free(pAuxPlyTable[i]);
+        free(pAuxPlyTable);
+        free(pAuxCntTable);
 
-    if (nNoCovrPlyEntries) {
-        for (int i = 0; i < nNoCovrPlyEntries; i++) 
-            free( pNoCovrPlyTable[i] );
-        free( pNoCovrPlyTable );
-        free( pNoCovrCntTable );
+        if (nNoCovrPlyEntries) {
+            for (int i = 0; i < nNoCovrPlyEntries; i++) 
+                free( pNoCovrPlyTable[i] );
+            free( pNoCovrPlyTable );
+            free( pNoCovrCntTable );
+        }
     }
     
     delete m_pfilename;
@@ -401,6 +503,35 @@ ChartTableEntry::~ChartTableEntry()
 
 ///////////////////////////////////////////////////////////////////////
 
+wxString *ChartTableEntry::GetpsFullPath(void) const
+{
+    if (!m_psFullPath && pFullPath)
+        m_psFullPath = new wxString(pFullPath, wxConvUTF8);
+    return m_psFullPath;
+}
+
+const wxString *ChartTableEntry::GetpFileName(void) const
+{
+    if (!m_pfilename && pFullPath) {
+        wxFileName fn(*GetpsFullPath());
+        m_pfilename = new wxString(fn.GetFullName());
+    }
+    return m_pfilename;
+}
+
+wxString ChartTableEntry::GetFullSystemPath() const
+{
+    if (m_fullSystemPath.IsEmpty() && pFullPath) {
+        m_fullSystemPath = *GetpsFullPath();
+#ifdef __OCPN__ANDROID__
+        m_fullSystemPath = wxString(m_fullSystemPath.mb_str(wxConvUTF8));
+#endif
+    }
+    return m_fullSystemPath;
+}
+
+///////////////////////////////////////////////////////////////////////
+
 
 ///////////////////////////////////////////////////////////////////////
 
@@ -810,15 +941,71 @@ bool ChartTableEntry::Read(const ChartDatabase *pDb, wxInputStream &is)
 
 ///////////////////////////////////////////////////////////////////////
 
-bool ChartTableEntry::Write(const ChartDatabase *pDb, wxOutputStream &os)
+bool ChartTableEntry::Map(const ChartTableEntry_onDisk_19 &cte, const ChartTablePools_19 &pools)
 {
-    os.Write(pFullPath, strlen(pFullPath) + 1);
+    Clear();
 
-    //      Write the current version type only
-    //      Create an on_disk table entry
-    ChartTableEntry_onDisk_18 cte;
+    //  Check everything this entry points to is inside the pools
+    if (cte.PathOffset < 0 || cte.PathOffset >= pools.nStringBytes
+            || cte.nPlyEntries < 0 || cte.PlyOffset < 0
+            || cte.nPlyEntries > pools.nPlyPoints - cte.PlyOffset)
+        return false;
 
-      //    Transcribe the elements....
+    int tables[2][2] = { { cte.AuxPlyIndex, cte.nAuxPlyEntries },
+                         { cte.NoCovrPlyIndex, cte.nNoCovrPlyEntries } };
+    for (int k = 0; k < 2; k++) {
+        int index = tables[k][0], count = tables[k][1];
+        if (index < 0 || count < 0 || count > pools.nPlyTables - index)
+            return false;
+        for (int i = index; i < index + count; i++) {
+            if (pools.plyCounts[i] < 0 || pools.plyOffsets[i] < 0
+                    || pools.plyCounts[i] > pools.nPlyPoints - pools.plyOffsets[i])
+                return false;
+        }
+    }
+
+    //  The mapping is read only, none of it is ever written through these
+    m_bmapped = true;
+    m_pPointPool = pools.points;
+    pFullPath = (char *)pools.strings + cte.PathOffset;
+    pPlyTable = cte.nPlyEntries ? pools.points + 2 * cte.PlyOffset : NULL;
+    pAuxCntTable = pools.plyCounts + cte.AuxPlyIndex;
+    m_pAuxPlyOffsets = pools.plyOffsets + cte.AuxPlyIndex;
+    pNoCovrCntTable = pools.plyCounts + cte.NoCovrPlyIndex;
+    m_pNoCovrPlyOffsets = pools.plyOffsets + cte.NoCovrPlyIndex;
+
+    EntryOffset = cte.EntryOffset;
+    ChartType = cte.ChartType;
+    ChartFamily = cte.ChartFamily;
+    LatMax = cte.LatMax;
+    LatMin = cte.LatMin;
+    LonMax = cte.LonMax;
+    LonMin = cte.LonMin;
+
+    m_bbox.Set(LatMin, LonMin, LatMax, LonMax);
+
+    Skew = cte.skew;
+    ProjectionType = cte.ProjectionType;
+
+    SetScale(cte.Scale);
+    edition_date = cte.edition_date;
+    file_date = cte.file_date;
+
+    nPlyEntries = cte.nPlyEntries;
+    nAuxPlyEntries = cte.nAuxPlyEntries;
+    nNoCovrPlyEntries = cte.nNoCovrPlyEntries;
+
+    bValid = cte.bValid != 0;
+
+    return true;
+}
+
+///////////////////////////////////////////////////////////////////////
+
+bool ChartTableEntry::Write(const ChartDatabase *pDb, ChartTableEntry_onDisk_19 &cte, ChartTablePoolWriter &pools) const
+{
+    //      Write the current version type only
+    //      Transcribe the elements....
     cte.EntryOffset = EntryOffset;
     cte.ChartType = ChartType;
     cte.ChartFamily = ChartFamily;
@@ -833,45 +1020,86 @@ bool ChartTableEntry::Write(const ChartDatabase *pDb, wxOutputStream &os)
 
     cte.nPlyEntries = nPlyEntries;
     cte.nAuxPlyEntries = nAuxPlyEntries;
+    cte.nNoCovrPlyEntries = nNoCovrPlyEntries;
 
     cte.skew = Skew;
     cte.ProjectionType = ProjectionType;
 
     cte.bValid = bValid;
 
-    cte.nNoCovrPlyEntries = nNoCovrPlyEntries;
-    
-    os.Write(&cte, sizeof(ChartTableEntry_onDisk_18));
+    //      and add the path and tables to the pools
+    cte.PathOffset = pools.AddString(pFullPath ? pFullPath : "");
+    cte.PlyOffset = pools.AddPoints(pPlyTable, nPlyEntries);
+
+    cte.AuxPlyIndex = pools.GetPlyTableCount();
+    for (int i = 0; i < nAuxPlyEntries; i++)
+        pools.AddPlyTable(GetpAuxPlyTableEntry(i), GetAuxCntTableEntry(i));
+
+    cte.NoCovrPlyIndex = pools.GetPlyTableCount();
+    for (int i = 0; i < nNoCovrPlyEntries; i++)
+        pools.AddPlyTable(GetpNoCovrPlyTableEntry(i), GetNoCovrCntTableEntry(i));
+
     wxLogVerbose(_T("  Wrote Chart %s"), pFullPath);
 
-    //      Write out the tables
+    return true;
+}
+
+///////////////////////////////////////////////////////////////////////
+
+void ChartTableEntry::Detach()
+{
+    //  Copy what is in the mapped database into memory of our own
+    if (!m_bmapped)
+        return;
+
+    // the helper strings are made from the path, do it while it is valid
+    GetpFileName();
+    GetFullSystemPath();
+
+    char *path = (char *)malloc(strlen(pFullPath) + 1);
+    strcpy(path, pFullPath);
+
+    float *ply = NULL;
     if (nPlyEntries) {
-        int npeSize = nPlyEntries * 2 * sizeof(float);
-        os.Write(pPlyTable, npeSize);
+        ply = (float *)malloc(nPlyEntries * 2 * sizeof(float));
+        memcpy(ply, pPlyTable, nPlyEntries * 2 * sizeof(float));
     }
-        
-    if (nAuxPlyEntries) {
-        int napeSize = nAuxPlyEntries * sizeof(int);
-        os.Write(pAuxCntTable, napeSize);
 
-        for (int nAuxPlyEntry = 0; nAuxPlyEntry < nAuxPlyEntries; nAuxPlyEntry++) {
-            int nfSize = pAuxCntTable[nAuxPlyEntry] * 2 * sizeof(float);
-            os.Write(pAuxPlyTable[nAuxPlyEntry], nfSize);
+    float **pfp = NULL;
+    int *pip = NULL;
+    if (nAuxPlyEntries) {
+        pfp = (float **)malloc(nAuxPlyEntries * sizeof(float *));
+        pip = (int *)malloc(nAuxPlyEntries * sizeof(int));
+        for (int j = 0; j < nAuxPlyEntries; j++) {
+            pip[j] = GetAuxCntTableEntry(j);
+            pfp[j] = (float *)malloc(pip[j] * 2 * sizeof(float));
+            memcpy(pfp[j], GetpAuxPlyTableEntry(j), pip[j] * 2 * sizeof(float));
         }
     }
-    
-    if (nNoCovrPlyEntries ) {
-        int ncSize = nNoCovrPlyEntries * sizeof(int);
-        os.Write(pNoCovrCntTable, ncSize);
-        
-        for (int i = 0; i < nNoCovrPlyEntries; i++) {
-            int nctSize = pNoCovrCntTable[i] * 2 * sizeof(float);
-            os.Write(pNoCovrPlyTable[i], nctSize);
+
+    float **pfpnc = NULL;
+    int *pipnc = NULL;
+    if (nNoCovrPlyEntries) {
+        pfpnc = (float **)malloc(nNoCovrPlyEntries * sizeof(float *));
+        pipnc = (int *)malloc(nNoCovrPlyEntries * sizeof(int));
+        for (int j = 0; j < nNoCovrPlyEntries; j++) {
+            pipnc[j] = GetNoCovrCntTableEntry(j);
+            pfpnc[j] = (float *)malloc(pipnc[j] * 2 * sizeof(float));
+            memcpy(pfpnc[j], GetpNoCovrPlyTableEntry(j), pipnc[j] * 2 * sizeof(float));
         }
     }
-    
 
-    return true;
+    pFullPath = path;
+    pPlyTable = ply;
+    pAuxPlyTable = pfp;
+    pAuxCntTable = pip;
+    pNoCovrPlyTable = pfpnc;
+    pNoCovrCntTable = pipnc;
+
+    m_bmapped = false;
+    m_pPointPool = NULL;
+    m_pAuxPlyOffsets = NULL;
+    m_pNoCovrPlyOffsets = NULL;
 }
 
 ///////////////////////////////////////////////////////////////////////
@@ -893,6 +1121,12 @@ void ChartTableEntry::Clear()
     
     m_pfilename = NULL;             // a helper member, not on disk
     m_psFullPath = NULL;
+    m_fullSystemPath.Clear();
+
+    m_bmapped = false;
+    m_pPointPool = NULL;
+    m_pAuxPlyOffsets = NULL;
+    m_pNoCovrPlyOffsets = NULL;
     
 }
 
@@ -1208,6 +1442,22 @@ bool ChartDatabase::Read(const wxString &filePath)
     if (!file.FileExists()) return false;
 
     m_DBFileName = filePath;
+    ReadManifests(filePath);
+
+    //  The current version is used in place, older ones are read into memory
+    DetachMapped();
+    if (m_dbFile.Open(filePath)) {
+        ChartTableHeader cth;
+        const unsigned char *ph = m_dbFile.GetRange(0, sizeof(ChartTableHeader));
+        if (ph) {
+            memcpy(&cth, ph, sizeof(ChartTableHeader));
+            char vb[5];
+            sprintf(vb, "V%03d", DB_VERSION_CURRENT);
+            if (!strncmp(vb, cth.GetDBVersionString(), 4))
+                return ReadMapped(cth);
+        }
+        m_dbFile.Close();
+    }
 
     wxFFileInputStream ifs(filePath);
     if(!ifs.Ok()) return false;
@@ -1270,6 +1520,100 @@ read_error:
     return false;
 }
 
+//  Get the sections of a mapped database in turn, NULL if past its end
+static void *MapSection(const MappedFile &file, size_t &offset, int count, size_t size)
+{
+    if (count < 0 || (size_t)count > file.GetSize() / size)
+        return NULL;
+    const unsigned char *p = file.GetRange(offset, count * size);
+    offset += count * size;
+    return (void *)p;
+}
+
+bool ChartDatabase::ReadMapped(ChartTableHeader &cth)
+{
+    ChartTableSections_19 *ps;
+    int *pDirs;
+    ChartTablePools_19 pools;
+    ChartTableEntry_onDisk_19 *pEntries;
+    size_t offset = sizeof(ChartTableHeader);
+
+    if (!cth.CheckValid()) goto read_error;
+
+    m_dbversion = DB_VERSION_CURRENT;
+    s_dbVersion = m_dbversion;                  // save the static copy
+
+    ps = (ChartTableSections_19 *)MapSection(m_dbFile, offset, 1, sizeof(ChartTableSections_19));
+    if (!ps) goto read_error;
+
+    pDirs = (int *)MapSection(m_dbFile, offset, cth.GetDirEntries(), sizeof(int));
+    pEntries = (ChartTableEntry_onDisk_19 *)MapSection(m_dbFile, offset, cth.GetTableEntries(),
+                                                       sizeof(ChartTableEntry_onDisk_19));
+    pools.plyCounts = (int *)MapSection(m_dbFile, offset, ps->nPlyTables, sizeof(int));
+    pools.plyOffsets = (int *)MapSection(m_dbFile, offset, ps->nPlyTables, sizeof(int));
+    pools.points = (float *)MapSection(m_dbFile, offset, ps->nPlyPoints, 2 * sizeof(float));
+    pools.strings = (const char *)MapSection(m_dbFile, offset, ps->nStringBytes, 1);
+    pools.nPlyTables = ps->nPlyTables;
+    pools.nPlyPoints = ps->nPlyPoints;
+    pools.nStringBytes = ps->nStringBytes;
+
+    if (!pDirs || !pEntries || !pools.plyCounts || !pools.plyOffsets || !pools.points
+            || !pools.strings || pools.nStringBytes < 1 || pools.strings[pools.nStringBytes - 1])
+        goto read_error;
+
+    wxLogVerbose(wxT("Chartdb:Mapping %d directory entries, %d table entries"), cth.GetDirEntries(), cth.GetTableEntries());
+    wxLogMessage(_T("Chartdb: Chart directory list follows"));
+    if(0 == cth.GetDirEntries())
+          wxLogMessage(_T("  Nil"));
+
+    for (int iDir = 0; iDir < cth.GetDirEntries(); iDir++) {
+        if (pDirs[iDir] < 0 || pDirs[iDir] >= pools.nStringBytes)
+            goto read_error;
+        wxString dir(pools.strings + pDirs[iDir], wxConvUTF8);
+        wxString msg;
+        msg.Printf(wxT("  Chart directory #%d: "), iDir);
+        msg.Append(dir);
+        wxLogMessage(msg);
+        m_chartDirs.Add(dir);
+    }
+
+    //  The path index is built on first use, the entry strings are
+    //  not made until they are needed
+    active_chartTable.Alloc(cth.GetTableEntries());
+    active_chartTable_pathindex.clear();
+    for (int i = 0; i < cth.GetTableEntries(); i++) {
+        ChartTableEntry *pentry = new ChartTableEntry;
+        if (!pentry->Map(pEntries[i], pools)) {
+            delete pentry;
+            goto read_error;
+        }
+        active_chartTable.Add(pentry);
+    }
+
+    bValid = true;
+    m_nentries = active_chartTable.GetCount();
+    return true;
+
+read_error:
+    //  Nothing may point into the mapping once it is gone
+    active_chartTable.Clear();
+    m_chartDirs.Clear();
+    m_dbFile.Close();
+    bValid = false;
+    m_nentries = 0;
+    return false;
+}
+
+void ChartDatabase::DetachMapped()
+{
+    if (!m_dbFile.IsOpened())
+        return;
+
+    for (unsigned int i = 0; i < active_chartTable.GetCount(); i++)
+        active_chartTable[i].Detach();
+    m_dbFile.Close();
+}
+
 ///////////////////////////////////////////////////////////////////////
 
 bool ChartDatabase::Write(const wxString &filePath)
@@ -1279,33 +1623,128 @@ bool ChartDatabase::Write(const wxString &filePath)
 
     if (!dir.DirExists() && !dir.Mkdir()) return false;
 
+    //  The file written is usually the one mapped
+    DetachMapped();
+
+    ChartTablePoolWriter pools;
+    std::vector<int> dirs;
+    for (unsigned int iDir = 0; iDir < m_chartDirs.GetCount(); iDir++)
+        dirs.push_back(pools.AddString(m_chartDirs[iDir].mb_str(wxConvUTF8)));
+
+    std::vector<ChartTableEntry_onDisk_19> entries(active_chartTable.size());
+    for (UINT32 iTable = 0; iTable < active_chartTable.size(); iTable++)
+        active_chartTable[iTable].Write(this, entries[iTable], pools);
+
     wxFFileOutputStream ofs(filePath);
     if(!ofs.Ok()) return false;
 
-    ChartTableHeader cth(m_chartDirs.GetCount(), active_chartTable.GetCount());
+    ChartTableHeader cth(dirs.size(), entries.size());
     cth.Write(ofs);
 
-    for (int iDir = 0; iDir < cth.GetDirEntries(); iDir++) {
-        wxString &dir = m_chartDirs[iDir];
-        int dirlen = dir.length();
-        char s[200];
-        strncpy(s, dir.mb_str(wxConvUTF8), 199);
-        s[199] = 0;
-        dirlen = strlen(s);
-        ofs.Write(&dirlen, sizeof(int));
-//        ofs.Write(dir.fn_str(), dirlen);
-        ofs.Write(s, dirlen);
-    }
+    ChartTableSections_19 sections;
+    pools.GetSections(sections);
+    ofs.Write(&sections, sizeof(ChartTableSections_19));
 
-    for (UINT32 iTable = 0; iTable < active_chartTable.size(); iTable++)
-        active_chartTable[iTable].Write(this, ofs);
+    if (dirs.size())
+        ofs.Write(&dirs[0], dirs.size() * sizeof(int));
+    if (entries.size())
+        ofs.Write(&entries[0], entries.size() * sizeof(ChartTableEntry_onDisk_19));
+    pools.Write(ofs);
 
     //      Explicitly set the version
     m_dbversion = DB_VERSION_CURRENT;
 
+    if (!ofs.Close()) return false;
+
+    WriteManifests(filePath);
     return true;
 }
 
+///////////////////////////////////////////////////////////////////////
+//  Chart directory manifests, as text next to the database:
+//      OCPN_CHART_MANIFEST <version>
+//      D<tab>directory
+//      size<tab>time<tab>failed<tab>path       for each file, sorted
+static const int MANIFEST_VERSION = 1;
+
+wxString ChartDatabase::GetManifestFileName(const wxString &filePath)
+{
+    wxFileName file(filePath);
+    file.SetExt(_T("manifest"));
+    return file.GetFullPath();
+}
+
+void ChartDatabase::ReadManifests(const wxString &filePath)
+{
+    m_dirManifests.clear();
+
+    wxString name = GetManifestFileName(filePath);
+    wxTextFile file;
+    if (!wxFileExists(name) || !file.Open(name, wxConvUTF8))
+        return;
+
+    if (file.GetLineCount() == 0 ||
+        file.GetFirstLine() != wxString::Format(_T("OCPN_CHART_MANIFEST %d"), MANIFEST_VERSION))
+        return;
+
+    ChartDirManifest *manifest = NULL;
+    for (size_t i = 1; i < file.GetLineCount(); i++) {
+        wxString line = file.GetLine(i);
+        if (line.StartsWith(_T("D\t"))) {
+            manifest = &m_dirManifests[line.Mid(2)];
+            continue;
+        }
+
+        wxStringTokenizer tkz(line, _T("\t"), wxTOKEN_RET_EMPTY);
+        wxString size = tkz.GetNextToken();
+        wxString time = tkz.GetNextToken();
+        wxString failed = tkz.GetNextToken();
+        wxString path = tkz.GetString();
+
+        wxULongLong_t usize;
+        wxLongLong_t ltime;
+        if (!manifest || path.IsEmpty() || !size.ToULongLong(&usize) || !time.ToLongLong(&ltime)) {
+            //  Something is wrong with the file, better start again
+            wxLogMessage(_T("Chartdb: Ignoring bad chart manifest ") + name);
+            m_dirManifests.clear();
+            return;
+        }
+
+        manifest->files.Add(path);
+        manifest->sizes.push_back(wxULongLong(usize));
+        manifest->times.push_back((time_t)ltime);
+        manifest->failed.push_back(failed == _T("1"));
+    }
+}
+
+bool ChartDatabase::WriteManifests(const wxString &filePath)
+{
+    wxString name = GetManifestFileName(filePath);
+    wxFFile file(name, _T("w"));
+    if (!file.IsOpened()) {
+        wxLogMessage(_T("Chartdb: Cannot write chart manifest ") + name);
+        return false;
+    }
+
+    file.Write(wxString::Format(_T("OCPN_CHART_MANIFEST %d\n"), MANIFEST_VERSION), wxConvUTF8);
+
+    std::map<wxString, ChartDirManifest>::const_iterator it;
+    for (it = m_dirManifests.begin(); it != m_dirManifests.end(); ++it) {
+        const ChartDirManifest &manifest = it->second;
+        file.Write(_T("D\t") + it->first + _T("\n"), wxConvUTF8);
+        for (unsigned int i = 0; i < manifest.files.GetCount(); i++) {
+            wxString line = manifest.sizes[i].ToString();
+            line += _T("\t") + wxLongLong((wxLongLong_t)manifest.times[i]).ToString();
+            line += manifest.failed[i] ? _T("\t1\t") : _T("\t0\t");
+            line += manifest.files[i];
+            line += _T("\n");
+            file.Write(line, wxConvUTF8);
+        }
+    }
+
+    return file.Close();
+}
+
 ///////////////////////////////////////////////////////////////////////
 wxString SplitPath(wxString s, wxString tkd, int nchar, int offset, int *pn_split)
 {
@@ -1558,11 +1997,14 @@ bool ChartDatabase::Update(ArrayOfCDI& dir_array, bool bForce, wxGenericProgress
       bool lbForce = bForce;
 
       //    Do a dB Version upgrade if the current one is obsolete
+      //    The previous version holds everything the current one does
       if(s_dbVersion != DB_VERSION_CURRENT)
       {
 
-          active_chartTable.Clear();
+          if(s_dbVersion != DB_VERSION_PREVIOUS) {
+            active_chartTable.Clear();
             lbForce = true;
+          }
             s_dbVersion = DB_VERSION_CURRENT;         // Update the static indicator
             m_dbversion = DB_VERSION_CURRENT;         // and the member
 
@@ -1595,6 +2037,16 @@ bool ChartDatabase::Update(ArrayOfCDI& dir_array, bool bForce, wxGenericProgress
             m_chartDirs.Add(dir_info.fullpath);
       }           //for
 
+      //    Forget the manifests of directories no longer used
+      std::map<wxString, ChartDirManifest>::iterator it_manifest = m_dirManifests.begin();
+      while(it_manifest != m_dirManifests.end())
+      {
+            if(m_chartDirs.Index(it_manifest->first) == wxNOT_FOUND)
+                  m_dirManifests.erase(it_manifest++);
+            else
+                  ++it_manifest;
+      }
+
 
       for(unsigned int i=0 ; i<active_chartTable.GetCount() ; i++)
       {
@@ -1635,6 +2087,12 @@ int ChartDatabase::FinddbIndex(wxString PathToFind)
             }
       }
 #else
+      //  A mapped database builds its index on first use
+      if(active_chartTable_pathindex.empty()) {
+          for(unsigned int i=0 ; i<active_chartTable.GetCount() ; i++)
+              active_chartTable_pathindex[active_chartTable[i].GetFullSystemPath()] = i;
+      }
+
       if(active_chartTable_pathindex.find(PathToFind) != active_chartTable_pathindex.end())
           return active_chartTable_pathindex[PathToFind];
 #endif
@@ -1681,6 +2139,7 @@ int ChartDatabase::TraverseDirAndAddCharts(ChartDirInfo& dir_info, wxGenericProg
 
       bool b_skipDetectDirChange = false;
       bool b_dirchange = false;
+      ChartDirManifest manifest;
 
       // Does this directory actually exist?
       if(!wxDir::Exists(dir_path))
@@ -1700,7 +2159,7 @@ int ChartDatabase::TraverseDirAndAddCharts(ChartDirInfo& dir_info, wxGenericProg
       //    Quick scan the directory to see if it has changed
       //    If not, there is no need to scan again.....
       if(!b_skipDetectDirChange)
-            b_dirchange = DetectDirChange(dir_path, dir_info.fullpath, old_magic, new_magic, pprog);
+            b_dirchange = DetectDirChange(dir_path, dir_info.fullpath, old_magic, new_magic, pprog, &manifest);
 
       if( !bForce && !b_dirchange)
       {
@@ -1708,6 +2167,10 @@ int ChartDatabase::TraverseDirAndAddCharts(ChartDirInfo& dir_info, wxGenericProg
             msg.Append(dir_path);
             wxLogMessage(msg);
 
+            //    The manifest kept, if any, is the same and knows the files that failed
+            if(manifest.files.GetCount() && !m_dirManifests.count(dir_info.fullpath))
+                  m_dirManifests[dir_info.fullpath] = manifest;
+
             //    Traverse the database, and mark as valid all charts coming from this dir,
             //    or anywhere in its tree
 
@@ -1744,16 +2207,59 @@ int ChartDatabase::TraverseDirAndAddCharts(ChartDirInfo& dir_info, wxGenericProg
       //    There presumably was a change in the directory contents.  Return the new magic number
       dir_magic = new_magic;
 
-      //    Look for all possible defined chart classes
+      //    Files that failed on the last scan and did not change since are not read again,
+      //    unless the whole database is rebuilt
+      const ChartDirManifest *previous = NULL;
+      std::map<wxString, ChartDirManifest>::const_iterator it_previous = m_dirManifests.find(dir_info.fullpath);
+      if(!bForce && it_previous != m_dirManifests.end())
+            previous = &it_previous->second;
+
+      //    Look for all possible defined chart classes,
+      //    picking their files from the listing made by the change detection above
       for(unsigned int i = 0 ; i < m_ChartClassDescriptorArray.GetCount() ; i++)
       {
-            nAdd += SearchDirAndAddCharts(dir_info.fullpath, m_ChartClassDescriptorArray.Item(i), pprog);
+            nAdd += SearchDirAndAddCharts(dir_info.fullpath, m_ChartClassDescriptorArray.Item(i), pprog, &manifest, previous);
       }
 
+      if(manifest.files.GetCount())
+            m_dirManifests[dir_info.fullpath] = manifest;
+      else
+            m_dirManifests.erase(dir_info.fullpath);
+
       return nAdd;
 }
 
-bool ChartDatabase::DetectDirChange(const wxString & dir_path, const wxString& prog_label, const wxString & magic, wxString &new_magic, wxGenericProgressDialog *pprog)
+int ChartDirManifest::Index(const wxString &path) const
+{
+      wxArrayString::const_iterator it = std::lower_bound(files.begin(), files.end(), path);
+      if(it == files.end() || *it != path)
+            return -1;
+
+      return it - files.begin();
+}
+
+bool ChartDirManifest::Find(const wxString &path, time_t &time) const
+{
+      int i = Index(path);
+      if(i < 0)
+            return false;
+
+      time = times[i];
+      return true;
+}
+
+//    The interesting stuff of one file, as hashed by DetectDirChange()
+struct ChartFileStat
+{
+      wxString          path;
+      std::string       nameUTF8;
+      wxULongLong       fileSize;
+      wxULongLong       fileTime;
+      time_t            modTime;
+};
+
+bool ChartDatabase::DetectDirChange(const wxString & dir_path, const wxString& prog_label, const wxString & magic, wxString &new_magic,
+                                    wxGenericProgressDialog *pprog, ChartDirManifest *manifest)
 {
       if(pprog)
             pprog->SetTitle(_("OpenCPN Directory Scan...."));
@@ -1770,38 +2276,63 @@ bool ChartDatabase::DetectDirChange(const wxString & dir_path, const wxString& p
       int n_files = dir.GetAllFiles(dir_path, &FileList);
       FileList.Sort();  // Ensure persistent order of items being hashed.
 
-      FlexHash hash( sizeof nacc );
-      hash.Reset();
-
-      //Traverse the list of files, getting their interesting stuff to add to accumulator
+      //    Get the interesting stuff of all the files on all cores.
+      //    wxString is not thread safe, so each file gets a path string of its own.
+      std::vector<ChartFileStat> stats(n_files);
       for(int ifile=0 ; ifile < n_files ; ifile++)
-      {
-            if(pprog && (ifile % (n_files / 60 + 1)) == 0)
-                  pprog->Update(wxMin((ifile * 100) /n_files, 100), prog_label);
+            stats[ifile].path = wxString(FileList[ifile].wc_str());
 
-            wxFileName file(FileList[ifile]);
+      RunParallel(n_files, [&](int ifile) {
+            ChartFileStat &stat = stats[ifile];
+            wxFileName file(stat.path);
 
             // NOTE. Do not ever try to optimize this code by combining `wxString` calls.
             // Otherwise `fileNameUTF8` will point to a stale buffer overwritten by garbage.
             wxString fileNameNative = file.GetFullPath();
             wxScopedCharBuffer fileNameUTF8 = fileNameNative.ToUTF8();
-            hash.Update( fileNameUTF8.data(), fileNameUTF8.length() );
+            stat.nameUTF8.assign( fileNameUTF8.data(), fileNameUTF8.length() );
 
             //    File Size;
             wxULongLong size = file.GetSize();
-            wxULongLong fileSize = ( ( size != wxInvalidSize ) ? size : 0 );
-            hash.Update( &fileSize, ( sizeof fileSize ) );
+            stat.fileSize = ( ( size != wxInvalidSize ) ? size : 0 );
 
             //    Mod time, in ticks
             wxDateTime t = file.GetModificationTime();
-            wxULongLong fileTime = t.GetTicks();
-            hash.Update( &fileTime, ( sizeof fileTime ) );
+            stat.modTime = t.GetTicks();
+            stat.fileTime = wxULongLong(stat.modTime);
+      }, [&](int ifile) {
+            if(pprog && (ifile % (n_files / 60 + 1)) == 0)
+                  pprog->Update(wxMin((ifile * 100) /n_files, 100), prog_label);
+      });
+
+      //    Accumulate in the sorted order, so the magic number does not depend on the threads
+      FlexHash hash( sizeof nacc );
+      hash.Reset();
 
+      for(int ifile=0 ; ifile < n_files ; ifile++)
+      {
+            ChartFileStat &stat = stats[ifile];
+            hash.Update( stat.nameUTF8.data(), stat.nameUTF8.length() );
+            hash.Update( &stat.fileSize, ( sizeof stat.fileSize ) );
+            hash.Update( &stat.fileTime, ( sizeof stat.fileTime ) );
       }
 
       hash.Finish();
       hash.Receive( &nacc );
 
+      if(manifest)
+      {
+            manifest->files = FileList;
+            manifest->sizes.resize(n_files);
+            manifest->times.resize(n_files);
+            manifest->failed.assign(n_files, false);
+            for(int ifile=0 ; ifile < n_files ; ifile++)
+            {
+                  manifest->sizes[ifile] = stats[ifile].fileSize;
+                  manifest->times[ifile] = stats[ifile].modTime;
+            }
+      }
+
       //    Return the calculated magic number
       new_magic = nacc.ToString();
 
@@ -2020,9 +2551,115 @@ wxString ChartDatabase::Get_CM93_FileName(wxString dir_name)
 
 WX_DECLARE_STRING_HASH_MAP( int, ChartCollisionsHashMap );
 
+//    Would wxDir::GetAllFiles() have found this file with one of the masks?
+static bool MatchesChartFileSpec(const wxString &file_name, const wxArrayString &masks)
+{
+      for(unsigned int i = 0 ; i < masks.GetCount() ; i++)
+      {
+#ifdef __WXMSW__
+            if(wxMatchWild(masks[i].Upper(), file_name.Upper(), false))
+                  return true;
+#else
+            if(wxMatchWild(masks[i], file_name, false))
+                  return true;
+#endif
+      }
+      return false;
+}
+
+static time_t GetChartFileTime(const ChartDirManifest *manifest, const wxString &path)
+{
+      time_t t;
+      if(manifest && manifest->Find(path, t))
+            return t;
+
+      return wxFileName(path).GetModificationTime().GetTicks();
+}
+
+//    Did no chart come of this file on the last scan, with the file the same since?
+static bool ChartFileFailedBefore(const ChartDirManifest *previous, const ChartDirManifest *manifest,
+                                  const wxString &path)
+{
+      if(!previous || !manifest)
+            return false;
+
+      int iold = previous->Index(path);
+      int inew = manifest->Index(path);
+      return iold >= 0 && inew >= 0 && previous->failed[iold] &&
+             previous->sizes[iold] == manifest->sizes[inew] && previous->times[iold] == manifest->times[inew];
+}
+
+//    The full path of a chart file as shown to the user and kept in the database
+static wxString GetChartUTF8Path(const wxString &dir_name_base, const wxString &path)
+{
+#ifdef __OCPN__ANDROID__
+      // The full path is the broken Android files system interpretation, which does not display well onscreen.
+      // So, here we reconstruct a full path spec in UTF-8 encoding for later use in string displays.
+      // This utf-8 string will be used to construct the chart database entry if required.
+      wxFileName fnbase(dir_name_base);
+      int nDirs = fnbase.GetDirCount();
+
+      wxFileName file_target(path);
+
+      for(int i = 0 ; i < nDirs+1; i++)   // strip off the erroneous intial directories
+          file_target.RemoveDir(0);
+
+      wxString leftover_path = file_target.GetFullPath();
+      return dir_name_base + leftover_path;  // reconstruct a fully utf-8 version
+#else
+      return wxFileName(path).GetFullPath();
+#endif
+}
+
+//    Raster chart headers are independent of each other and of any shared state,
+//    so they may be read on all cores.  S57 headers stay serial:
+//    - s57chart::Init() fails any call made while another one runs, through
+//      its static s_bInS57 recursion guard.
+//    - InitENCMinimal() and GetChartFirstM_COVR() select M_COVR in the one
+//      global S57ClassRegistrar, and the GDAL/CPL S57 reader underneath keeps
+//      process wide error and option state.
+//    Plugin charts give no threading guarantees, so they stay serial too.
+//    The time spent on the headers of each class is logged, serial and
+//    parallel, so what is left to gain on ENC directories can be seen.
+static bool IsParallelChartClass(const ChartClassDescriptor &chart_desc)
+{
+      return chart_desc.m_descriptor_type == BUILTIN_DESCRIPTOR &&
+             (chart_desc.m_class_name == _T("ChartKAP") || chart_desc.m_class_name == _T("ChartGEO"));
+}
+
+//    A chart header read ahead of the serial add loop
+struct ChartHeaderJob
+{
+      int               ifile;
+      wxString          full_name;
+      wxString          utf8_path;
+      ChartBase         *pch;
+      bool              bcreated;
+      ChartTableEntry   *pentry;
+};
+
+//    Take the entry read ahead for a file, with the log CreateChartTableEntry() would give
+static ChartTableEntry *TakeChartHeader(ChartHeaderJob &job)
+{
+      wxString msg_fn(job.full_name);
+      msg_fn.Replace(_T("%"), _T("%%"));
+      wxLogMessage(wxString::Format(_T("Loading chart data for %s"), msg_fn.c_str()));
+
+      if(!job.bcreated)
+            wxLogMessage(wxString::Format(_T("   ...creation failed for %s"), msg_fn.c_str()));
+      else if(!job.pentry)
+            wxLogMessage(wxString::Format(_T("   ...initialization failed for %s"), msg_fn.c_str()));
+
+      ChartTableEntry *pentry = job.pentry;
+      job.pentry = NULL;
+      return pentry;
+}
+
 int ChartDatabase::SearchDirAndAddCharts(wxString& dir_name_base,
                                          ChartClassDescriptor &chart_desc,
-                                         wxGenericProgressDialog *pprog)
+                                         wxGenericProgressDialog *pprog,
+                                         ChartDirManifest *manifest,
+                                         const ChartDirManifest *previous)
 {
       wxString msg(_T("Searching directory: "));
       msg += dir_name_base;
@@ -2068,7 +2705,27 @@ int ChartDatabase::SearchDirAndAddCharts(wxString& dir_name_base,
       }
 
 
-      if(!b_found_cm93)
+      if(!b_found_cm93 && manifest && manifest->files.GetCount())
+      {
+            //    The whole tree was just listed by DetectDirChange(), so pick the files from there
+            wxArrayString masks;
+            masks.Add(filespec);
+            masks.Add(filespecXZ);
+#ifndef __WXMSW__
+            if (filespec != lowerFileSpec)
+            {
+                masks.Add(lowerFileSpec);
+                masks.Add(lowerFileSpecXZ);
+            }
+#endif
+            for(unsigned int i = 0 ; i < manifest->files.GetCount() ; i++)
+            {
+                if(MatchesChartFileSpec(wxFileName(manifest->files[i]).GetFullName(), masks))
+                    FileList.Add(manifest->files[i]);
+            }
+            FileList.Sort();
+      }
+      else if(!b_found_cm93)
       {
             // Note that `wxDir::GetAllFiles()` appends to the list rather than replaces existing contents.
             wxDir dir(dir_name);
@@ -2144,28 +2801,95 @@ int ChartDatabase::SearchDirAndAddCharts(wxString& dir_name_base,
       int nFileProgressQuantum = wxMax( nFile / 100, 2 );
       double rFileProgressRatio = 100.0 / wxMax( nFile, 1 );
 
+      //    Time spent reading chart headers, and how many were read
+      wxStopWatch header_sw;
+      header_sw.Pause();
+      int nHeaders = 0;
+
+      //    Read the headers of the charts that are going to be needed on all cores, if the class allows.
+      //    The charts are made and deleted on this thread, and the entries are picked up
+      //    in file order by the loop below, which still decides what goes into the database.
+      std::vector<ChartHeaderJob> jobs;
+      std::vector<int> job_index(nFile, -1);
+
+      if(!b_found_cm93 && IsParallelChartClass(chart_desc))
+      {
+            for(int ifile=0 ; ifile < nFile ; ifile++)
+            {
+                  wxFileName file(FileList[ifile]);
+                  wxString full_name = file.GetFullPath();
+                  wxString file_name = file.GetFullName();
+
+                  if(!file_name.Matches(lowerFileSpec) && !file_name.Matches(filespec) &&
+                     !file_name.Matches(lowerFileSpecXZ) && !file_name.Matches(filespecXZ))
+                        continue;
+
+                  if(ChartFileFailedBefore(previous, manifest, FileList[ifile]))
+                        continue;
+
+                  //    Charts already in the database with the same path and no newer file are not read again
+                  ChartCollisionsHashMap::const_iterator collision_ptr = collision_map.find( file_name );
+                  if( collision_ptr != collision_map.end() && bthis_dir_in_dB ) {
+                        ChartTableEntry &entry = active_chartTable[collision_ptr->second];
+                        if( full_name.IsSameAs(entry.GetFullSystemPath()) &&
+                            GetChartFileTime(manifest, FileList[ifile]) <= entry.GetFileTime() )
+                              continue;
+                  }
+
+                  ChartHeaderJob job;
+                  job.ifile = ifile;
+                  job.full_name = full_name;
+                  job.utf8_path = GetChartUTF8Path(dir_name_base, FileList[ifile]);
+                  job.pch = NULL;
+                  job.bcreated = false;
+                  job.pentry = NULL;
+
+                  job_index[ifile] = jobs.size();
+                  jobs.push_back(job);
+            }
+
+            //    Limit the number of charts open at once
+            const int nBatch = 256;
+            int last_step = -1;
+            header_sw.Resume();
+            for(int ib = 0 ; ib < (int)jobs.size() ; ib += nBatch)
+            {
+                  int nb = wxMin(nBatch, (int)jobs.size() - ib);
+
+                  for(int i = ib ; i < ib + nb ; i++) {
+                        jobs[i].pch = GetChart(jobs[i].full_name, chart_desc);
+                        jobs[i].bcreated = (jobs[i].pch != NULL);
+                  }
+
+                  RunParallel(nb, [&](int i) {
+                        ChartHeaderJob &job = jobs[ib + i];
+                        if(job.pch && job.pch->Init(job.full_name, HEADER_ONLY) == INIT_OK) {
+                              job.pentry = new ChartTableEntry(*job.pch, job.utf8_path);
+                              job.pentry->SetValid(true);
+                        }
+                  }, [&](int i) {
+                        ChartHeaderJob &job = jobs[ib + i];
+                        if( pprog && ( job.ifile / nFileProgressQuantum ) != last_step ) {
+                              last_step = job.ifile / nFileProgressQuantum;
+                              pprog->Update( static_cast<int>( job.ifile * rFileProgressRatio ), job.utf8_path );
+                        }
+                  });
+
+                  for(int i = ib ; i < ib + nb ; i++) {
+                        delete jobs[i].pch;
+                        jobs[i].pch = NULL;
+                  }
+            }
+            header_sw.Pause();
+            nHeaders = jobs.size();
+      }
+
       for(int ifile=0 ; ifile < nFile ; ifile++)
       {
             wxFileName file(FileList[ifile]);
             wxString full_name = file.GetFullPath();
             wxString file_name = file.GetFullName();
-            wxString utf8_path = full_name;
-            
-#ifdef __OCPN__ANDROID__
-            // The full path (full_name) is the broken Android files system interpretation, which does not display well onscreen.
-            // So, here we reconstruct a full path spec in UTF-8 encoding for later use in string displays.
-            // This utf-8 string will be used to construct the chart database entry if required.
-            wxFileName fnbase(dir_name_base);
-            int nDirs = fnbase.GetDirCount();
-
-            wxFileName file_target(FileList[ifile]);
-            
-            for(int i = 0 ; i < nDirs+1; i++)   // strip off the erroneous intial directories
-                file_target.RemoveDir(0);
-            
-            wxString leftover_path = file_target.GetFullPath();
-            utf8_path = dir_name_base + leftover_path;  // reconstruct a fully utf-8 version
-#endif            
+            wxString utf8_path = GetChartUTF8Path(dir_name_base, FileList[ifile]);
 
 
             //    Validate the file name again, considering MSW's semi-random treatment of case....
@@ -2203,7 +2927,7 @@ int ChartDatabase::SearchDirAndAddCharts(wxString& dir_name_base,
 
                     //    Check the file modification time
                     time_t t_oldFile = pEntry->GetFileTime();
-                    time_t t_newFile = file.GetModificationTime().GetTicks();
+                    time_t t_newFile = GetChartFileTime(manifest, FileList[ifile]);
 
                     if( t_newFile <= t_oldFile )
                     {
@@ -2225,11 +2949,29 @@ int ChartDatabase::SearchDirAndAddCharts(wxString& dir_name_base,
                 // Produce the same output without actually calling `CreateChartTableEntry()`.
                 wxLogMessage(wxString::Format(_T("Loading chart data for %s"), msg_fn.c_str()));
             } else {
-                pnewChart = CreateChartTableEntry(full_name, utf8_path, chart_desc);
+                bool bfailed_before = ChartFileFailedBefore(previous, manifest, FileList[ifile]);
+                if(bfailed_before) {
+                    wxLogMessage(wxString::Format(_T("Loading chart data for %s"), msg_fn.c_str()));
+                    wxLogMessage(wxString::Format(_T("   ...not read again, unchanged since it failed: %s"), msg_fn.c_str()));
+                }
+                else if(job_index[ifile] >= 0)
+                    pnewChart = TakeChartHeader(jobs[job_index[ifile]]);
+                else {
+                    header_sw.Resume();
+                    pnewChart = CreateChartTableEntry(full_name, utf8_path, chart_desc);
+                    header_sw.Pause();
+                    nHeaders++;
+                }
                 if(!pnewChart)
                 {
                     bAddFinal = false;
-                    wxLogMessage(wxString::Format(_T("   CreateChartTableEntry() failed for file: %s"), msg_fn.c_str()));
+                    if(!bfailed_before)
+                        wxLogMessage(wxString::Format(_T("   CreateChartTableEntry() failed for file: %s"), msg_fn.c_str()));
+
+                    //    Remembered with the database, not to be read again while it stays the same
+                    int im = manifest ? manifest->Index(FileList[ifile]) : -1;
+                    if(im >= 0)
+                        manifest->failed[im] = true;
                 }
             }
 
@@ -2296,6 +3038,14 @@ int ChartDatabase::SearchDirAndAddCharts(wxString& dir_name_base,
             }
       }
 
+      //    Headers read ahead for files that turned out not to need them
+      for(size_t i = 0 ; i < jobs.size() ; i++)
+            delete jobs[i].pentry;
+
+      if(nHeaders)
+            wxLogMessage(wxString::Format(_T("   %s: %d chart headers read in %ld ms, %d of them on all cores"),
+                                          chart_desc.m_class_name.c_str(), nHeaders, header_sw.Time(), (int)jobs.size()));
+
       m_nentries = active_chartTable.GetCount();
       
       return nDirEntry;
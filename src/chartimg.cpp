@@ -60,6 +60,10 @@
 #include "ocpn_pixel.h"
 #include "ChartDataInputStream.h"
 
+#ifdef ocpnUSE_GL
+#include "mipmap/raster.h"
+#endif
+
 #ifndef __WXMSW__
 #include <signal.h>
 #include <setjmp.h>
@@ -4669,54 +4673,16 @@ nocachestart:
                   memset(prgb, rgbval, nRunCount*3);
                   prgb += nRunCount*3;
               } else {
-                  // note: this may not be optimal for all processors and compilers
-                  // I optimized for x86_64 using gcc with -O3
-                  // it is probably possible to gain even faster performance by ensuring alignment
-                  // to 16 or 32byte boundary (depending on processor) then using inline assembly
-
-#ifdef __ARM_ARCH
-//  ARM needs 8 byte alignment for *(uint64_T *x) = *(uint64_T *y)
-//  because the compiler will (probably) use the ldrd/strd instuction pair.
-//  So, advance the prgb pointer until it is 8-byte aligned,
-//  and then carry on if enough bytes are left to process as 64 bit elements
-                  
-                  if((long)prgb & 7){
-                    while(count--) {
-                        *(uint32_t*)prgb = rgbval;
-                        prgb += 3;
-                        if( !((long)prgb & 7) ){
-                            if(count >= 8)
-                                break;
-                        }
-                    }
-                  }
-#endif                  
-                  
-
-                  // fill first 24 bytes
-                  uint64_t *b = (uint64_t*)prgb;
-                  for(int i=0; i < 8; i++) {
-                      *(uint32_t*)prgb = rgbval;
-                      prgb += 3;
-                  }
-                  count -= 8;
-
-                  // fill in blocks of 24 bytes
-                  uint64_t *y = (uint64_t*)prgb;
-                  int count_d8 = count >> 3;
-                  prgb += 24*count_d8;
-                  while(count_d8--) {
-                      *y++ = b[0];
-                      *y++ = b[1];
-                      *y++ = b[2];
-                  }
-
-                  // fill remaining bytes
-                  int rcount = count & 0x7;
-                  while(rcount--) {
+#ifdef ocpnUSE_GL
+                  // the raster kernels come with the opengl support libraries
+                  Raster_Fill_24(count, prgb, rgbval);
+                  prgb += count*3;
+#else
+                  while(count--) {
                       *(uint32_t*)prgb = rgbval;
                       prgb += 3;
                   }
+#endif
               }
           }
 
@@ -31,9 +31,15 @@
 #endif
 
 #include <wx/filename.h>
+#include <wx/file.h>
 #include <stdlib.h>
 
+#include <vector>
+
 #include "chartsymbols.h"
+#include "MappedFile.h"
+#include "PerfTrace.h"
+#include "ocpn_plugin.h"
 #ifdef ocpnUSE_GL
 #include <wx/glcanvas.h>
 #endif
@@ -63,8 +69,365 @@ WX_DECLARE_STRING_HASH_MAP( wxRect, symbolGraphicsHashMap );
 symbolGraphicsHashMap* symbolGraphicLocations;
 //--------------------------------------------------------------------------------------
 
+//--------------------------------------------------------------------------------------
+// Binary cache of chartsymbols.xml
+//
+// Parsing the XML is most of the cost of building the s52plib. The cache keeps
+// the records handed to the Build...() methods, in the order they were built,
+// so a load from the cache builds exactly what the XML would have built.
+// It is written to the private data directory and replaced whenever the XML file
+// changes, or another OpenCPN version or cache format finds it.
+//
+// Following the SymbolCacheHeader, every section 4 byte aligned:
+//      SymbolCacheColorTable   colorTable[nColorTables]
+//      SymbolCacheColor        color[nColors]
+//      SymbolCacheLookup       lookup[nLookups]
+//      int                     attrib[nAttribs]        string offsets
+//      SymbolCacheLineStyle    lineStyle[nLineStyles]
+//      SymbolCachePattern      pattern[nPatterns]
+//      SymbolCacheSymbol       symbol[nSymbols]
+//      char                    string[nStringBytes]    NUL terminated UTF-8
+//--------------------------------------------------------------------------------------
+
+#define SYMBOL_CACHE_MAGIC      "OCPNSYMB"
+#define SYMBOL_CACHE_VERSION    1           // bump when the records or the Build...() methods change
+
+struct SymbolCacheHeader
+{
+    char        magic[8];
+    int         version;
+    int         appVersion;             // string offset of VERSION_FULL
+    long long   xmlSize;
+    long long   xmlTime;
+    int         xmlPath;                // string offset
+    int         bSymbolsFirst;          // symbols were built before patterns
+    int         nColorTables;
+    int         nColors;
+    int         nLookups;
+    int         nAttribs;
+    int         nLineStyles;
+    int         nPatterns;
+    int         nSymbols;
+    int         nStringBytes;
+};
+
+struct SymbolCacheColorTable
+{
+    int         name;
+    int         rasterFile;
+    int         firstColor;
+    int         nColors;
+};
+
+struct SymbolCacheColor
+{
+    int             name;
+    unsigned char   R, G, B, pad;
+};
+
+struct SymbolCacheLookup
+{
+    int         RCID;
+    int         id;
+    int         name;
+    int         type;
+    int         displayPrio;
+    int         radarPrio;
+    int         tableName;
+    int         displayCat;
+    int         comment;
+    int         instruction;
+    int         firstAttrib;
+    int         nAttribs;
+};
+
+struct SymbolCacheSize
+{
+    int         width, height;
+    int         originX, originY;
+    int         pivotX, pivotY;
+    int         graphicsX, graphicsY;
+    int         minDistance, maxDistance;
+};
+
+struct SymbolCacheLineStyle
+{
+    int             RCID;
+    int             name, description, colorRef, HPGL;
+    SymbolCacheSize vectorSize;
+};
+
+struct SymbolCachePattern
+{
+    int             RCID;
+    int             name, description, colorRef, HPGL;
+    int             hasVector, hasBitmap, preferBitmap;
+    int             fillType, spacing;
+    SymbolCacheSize bitmapSize;
+    SymbolCacheSize vectorSize;
+};
+
+struct SymbolCacheSymbol
+{
+    int             RCID;
+    int             name, description, colorRef, HPGL;
+    int             hasVector, hasBitmap, preferBitmap;
+    SymbolCacheSize bitmapSize;
+    SymbolCacheSize vectorSize;
+};
+
+static void ToCacheSize( const SymbolSizeInfo_t &info, SymbolCacheSize &size )
+{
+    size.width = info.size.x;
+    size.height = info.size.y;
+    size.originX = info.origin.x;
+    size.originY = info.origin.y;
+    size.pivotX = info.pivot.x;
+    size.pivotY = info.pivot.y;
+    size.graphicsX = info.graphics.x;
+    size.graphicsY = info.graphics.y;
+    size.minDistance = info.minDistance;
+    size.maxDistance = info.maxDistance;
+}
+
+static void FromCacheSize( const SymbolCacheSize &size, SymbolSizeInfo_t &info )
+{
+    info.size = wxSize( size.width, size.height );
+    info.origin = wxPoint( size.originX, size.originY );
+    info.pivot = wxPoint( size.pivotX, size.pivotY );
+    info.graphics = wxPoint( size.graphicsX, size.graphicsY );
+    info.minDistance = size.minDistance;
+    info.maxDistance = size.maxDistance;
+}
+
+//  The key the cache is valid for
+static bool GetSymbolCacheKey( const wxString &xmlFile, long long &xmlSize, long long &xmlTime )
+{
+    wxFileName fn( xmlFile );
+    wxDateTime modTime = fn.GetModificationTime();
+    wxULongLong size = fn.GetSize();
+    if( !modTime.IsValid() || size == wxInvalidSize )
+        return false;
+
+    xmlSize = ( (long long) size.GetHi() << 32 ) | size.GetLo();
+    xmlTime = modTime.GetTicks();
+    return true;
+}
+
+static wxString GetSymbolCacheFile()
+{
+    wxString *dir = GetpPrivateApplicationDataLocation();
+    if( !dir || dir->IsEmpty() )
+        return wxEmptyString;
+
+    return *dir + wxFileName::GetPathSeparator() + _T("chartsymbols.cache");
+}
+
+class ChartSymbolsCacheWriter
+{
+public:
+    ChartSymbolsCacheWriter() : m_bSymbolsFirst( false ), m_bValid( true )
+    {
+        m_strings.push_back( 0 );       // offset 0 is ""
+    }
+
+    int AddString( const char *str )
+    {
+        if( !str || !*str )
+            return 0;
+        int offset = m_strings.size();
+        m_strings.insert( m_strings.end(), str, str + strlen( str ) + 1 );
+        return offset;
+    }
+
+    int AddString( const wxString &str )
+    {
+        return AddString( (const char *) str.ToUTF8() );
+    }
+
+    void AddColorTable( const colTable *ct )
+    {
+        SymbolCacheColorTable table;
+        table.name = AddString( *ct->tableName );
+        table.rasterFile = AddString( ct->rasterFileName );
+        table.firstColor = m_colors.size();
+        table.nColors = ct->colors.size();
+
+        for( colorHashMap::const_iterator it = ct->colors.begin(); it != ct->colors.end(); ++it ) {
+            SymbolCacheColor color;
+            color.name = AddString( it->first );
+            color.R = it->second.R;
+            color.G = it->second.G;
+            color.B = it->second.B;
+            color.pad = 0;
+            m_colors.push_back( color );
+        }
+        m_colorTables.push_back( table );
+    }
+
+    void Add( const Lookup &lookup )
+    {
+        SymbolCacheLookup rec;
+        rec.RCID = lookup.RCID;
+        rec.id = lookup.id;
+        rec.name = AddString( lookup.name );
+        rec.type = lookup.type;
+        rec.displayPrio = lookup.displayPrio;
+        rec.radarPrio = lookup.radarPrio;
+        rec.tableName = lookup.tableName;
+        rec.displayCat = lookup.displayCat;
+        rec.comment = lookup.comment;
+        rec.instruction = AddString( lookup.instruction );
+        rec.firstAttrib = m_attribs.size();
+        rec.nAttribs = lookup.attributeCodeArray.size();
+        for( size_t i = 0; i < lookup.attributeCodeArray.size(); i++ )
+            m_attribs.push_back( AddString( lookup.attributeCodeArray[i] ) );
+        m_lookups.push_back( rec );
+    }
+
+    void Add( const LineStyle &lineStyle )
+    {
+        SymbolCacheLineStyle rec;
+        rec.RCID = lineStyle.RCID;
+        rec.name = AddString( lineStyle.name );
+        rec.description = AddString( lineStyle.description );
+        rec.colorRef = AddString( lineStyle.colorRef );
+        rec.HPGL = AddString( lineStyle.HPGL );
+        ToCacheSize( lineStyle.vectorSize, rec.vectorSize );
+        m_lineStyles.push_back( rec );
+    }
+
+    void Add( const OCPNPattern &pattern )
+    {
+        //  Patterns and symbols share the graphics locations, so their order matters
+        if( !m_symbols.empty() ) {
+            if( m_patterns.empty() )
+                m_bSymbolsFirst = true;
+            else if( !m_bSymbolsFirst )
+                m_bValid = false;
+        }
+
+        SymbolCachePattern rec;
+        rec.RCID = pattern.RCID;
+        rec.name = AddString( pattern.name );
+        rec.description = AddString( pattern.description );
+        rec.colorRef = AddString( pattern.colorRef );
+        rec.HPGL = AddString( pattern.HPGL );
+        rec.hasVector = pattern.hasVector;
+        rec.hasBitmap = pattern.hasBitmap;
+        rec.preferBitmap = pattern.preferBitmap;
+        rec.fillType = pattern.fillType;
+        rec.spacing = pattern.spacing;
+        ToCacheSize( pattern.bitmapSize, rec.bitmapSize );
+        ToCacheSize( pattern.vectorSize, rec.vectorSize );
+        m_patterns.push_back( rec );
+    }
+
+    void Add( const ChartSymbol &symbol )
+    {
+        if( m_bSymbolsFirst && !m_patterns.empty() )
+            m_bValid = false;
+
+        SymbolCacheSymbol rec;
+        rec.RCID = symbol.RCID;
+        rec.name = AddString( symbol.name );
+        rec.description = AddString( symbol.description );
+        rec.colorRef = AddString( symbol.colorRef );
+        rec.HPGL = AddString( symbol.HPGL );
+        rec.hasVector = symbol.hasVector;
+        rec.hasBitmap = symbol.hasBitmap;
+        rec.preferBitmap = symbol.preferBitmap;
+        ToCacheSize( symbol.bitmapSize, rec.bitmapSize );
+        ToCacheSize( symbol.vectorSize, rec.vectorSize );
+        m_symbols.push_back( rec );
+    }
+
+    bool Write( const wxString &cacheFile, const wxString &xmlFile, long long xmlSize, long long xmlTime )
+    {
+        if( !m_bValid )
+            return false;
+
+        SymbolCacheHeader header;
+        memset( &header, 0, sizeof(header) );
+        memcpy( header.magic, SYMBOL_CACHE_MAGIC, sizeof(header.magic) );
+        header.version = SYMBOL_CACHE_VERSION;
+        header.appVersion = AddString( VERSION_FULL );
+        header.xmlSize = xmlSize;
+        header.xmlTime = xmlTime;
+        header.xmlPath = AddString( xmlFile );
+        header.bSymbolsFirst = m_bSymbolsFirst;
+        header.nColorTables = m_colorTables.size();
+        header.nColors = m_colors.size();
+        header.nLookups = m_lookups.size();
+        header.nAttribs = m_attribs.size();
+        header.nLineStyles = m_lineStyles.size();
+        header.nPatterns = m_patterns.size();
+        header.nSymbols = m_symbols.size();
+
+        while( m_strings.size() % sizeof(int) )
+            m_strings.push_back( 0 );
+        header.nStringBytes = m_strings.size();
+
+        //  Write aside and rename, so a reader never sees half a file
+        wxString tmpFile = cacheFile + _T(".tmp");
+        wxFile file;
+        if( !file.Create( tmpFile, true ) )
+            return false;
+
+        bool ok = file.Write( &header, sizeof(header) ) == sizeof(header);
+        ok = ok && WriteSection( file, m_colorTables );
+        ok = ok && WriteSection( file, m_colors );
+        ok = ok && WriteSection( file, m_lookups );
+        ok = ok && WriteSection( file, m_attribs );
+        ok = ok && WriteSection( file, m_lineStyles );
+        ok = ok && WriteSection( file, m_patterns );
+        ok = ok && WriteSection( file, m_symbols );
+        ok = ok && WriteSection( file, m_strings );
+        file.Close();
+
+        if( !ok || !wxRenameFile( tmpFile, cacheFile, true ) ) {
+            wxRemoveFile( tmpFile );
+            return false;
+        }
+        return true;
+    }
+
+private:
+    template <typename T>
+    static bool WriteSection( wxFile &file, const std::vector<T> &section )
+    {
+        size_t len = section.size() * sizeof(T);
+        return !len || file.Write( &section[0], len ) == len;
+    }
+
+    std::vector<SymbolCacheColorTable>  m_colorTables;
+    std::vector<SymbolCacheColor>       m_colors;
+    std::vector<SymbolCacheLookup>      m_lookups;
+    std::vector<int>                    m_attribs;
+    std::vector<SymbolCacheLineStyle>   m_lineStyles;
+    std::vector<SymbolCachePattern>     m_patterns;
+    std::vector<SymbolCacheSymbol>      m_symbols;
+    std::vector<char>                   m_strings;
+    bool                                m_bSymbolsFirst;
+    bool                                m_bValid;       // false if the build order cannot be replayed
+};
+
+//  Sections of a mapped cache file, NULL if out of range
+template <typename T>
+static const T *GetSymbolCacheSection( const MappedFile &file, size_t &offset, int n )
+{
+    if( n < 0 )
+        return NULL;
+    const T *section = (const T *) file.GetRange( offset, n * sizeof(T) );
+    offset += n * sizeof(T);
+    return section;
+}
+
+//--------------------------------------------------------------------------------------
+
 ChartSymbols::ChartSymbols( void )
 {
+    m_cache = NULL;
 }
 
 ChartSymbols::~ChartSymbols( void )
@@ -631,6 +994,8 @@ void ChartSymbols::ProcessLookups( TiXmlElement* lookupNodes )
 
 void ChartSymbols::BuildLookup( Lookup &lookup )
 {
+    if( m_cache ) m_cache->Add( lookup );
+
 
     LUPrec *LUP = (LUPrec*) calloc( 1, sizeof(LUPrec) );
     plib->pAlloc->Add( LUP );
@@ -750,6 +1115,8 @@ void ChartSymbols::ProcessLinestyles( TiXmlElement* linestyleNodes )
 
 void ChartSymbols::BuildLineStyle( LineStyle &lineStyle )
 {
+    if( m_cache ) m_cache->Add( lineStyle );
+
     Rule *lnstmp = NULL;
     Rule *lnst = (Rule*) calloc( 1, sizeof(Rule) );
     plib->pAlloc->Add( lnst );
@@ -888,6 +1255,8 @@ void ChartSymbols::ProcessPatterns( TiXmlElement* patternNodes )
 
 void ChartSymbols::BuildPattern( OCPNPattern &pattern )
 {
+    if( m_cache ) m_cache->Add( pattern );
+
     Rule *pattmp = NULL;
 
     Rule *patt = (Rule*) calloc( 1, sizeof(Rule) );
@@ -1065,6 +1434,8 @@ void ChartSymbols::ProcessSymbols( TiXmlElement* symbolNodes )
 
 void ChartSymbols::BuildSymbol( ChartSymbol& symbol )
 {
+    if( m_cache ) m_cache->Add( symbol );
+
     Rule *symb = (Rule*) calloc( 1, sizeof(Rule) );
     plib->pAlloc->Add( symb );
 
@@ -1123,6 +1494,8 @@ void ChartSymbols::BuildSymbol( ChartSymbol& symbol )
 
 bool ChartSymbols::LoadConfigFile(s52plib* plibArg, const wxString & s52ilePath)
 {
+    PERF_ZONE("ChartSymbols::LoadConfigFile");
+
     TiXmlDocument doc;
 
     plib = plibArg;
@@ -1148,7 +1521,22 @@ bool ChartSymbols::LoadConfigFile(s52plib* plibArg, const wxString & s52ilePath)
         return false;
     }
 
+    wxFileName xmlFile( fullFilePath );
+    xmlFile.MakeAbsolute();
+    wxString cacheFile = GetSymbolCacheFile();
+
+    if( !cacheFile.IsEmpty() && LoadCache( cacheFile, xmlFile.GetFullPath() ) ) {
+        wxString msg( _T("ChartSymbols loaded from cache of ") );
+        msg += fullFilePath;
+        wxLogMessage( msg );
+        return true;
+    }
+
 #if 1   
+    unsigned int firstColorTable = colorTables->GetCount();
+    if( !cacheFile.IsEmpty() )
+        m_cache = new ChartSymbolsCacheWriter;
+
     if(m_symbolsDoc.load_file( fullFilePath.fn_str() ) ){
         wxString msg( _T("ChartSymbols loaded from ") );
         msg += fullFilePath;
@@ -1165,8 +1553,13 @@ bool ChartSymbols::LoadConfigFile(s52plib* plibArg, const wxString & s52ilePath)
             
         }
         m_symbolsDoc.reset();           // purge the document to recover memory;
-        
+
+        if( m_cache )
+            SaveCache( cacheFile, xmlFile.GetFullPath(), firstColorTable );
     }    
+
+    delete m_cache;
+    m_cache = NULL;
     
 #else
     if( !doc.LoadFile( (const char *) fullFilePath.mb_str() ) ) {
@@ -1205,6 +1598,228 @@ bool ChartSymbols::LoadConfigFile(s52plib* plibArg, const wxString & s52ilePath)
 
     return true;
 }
+
+bool ChartSymbols::LoadCache( const wxString &cacheFile, const wxString &xmlFile )
+{
+    MappedFile file;
+    if( !file.Open( cacheFile ) )
+        return false;
+
+    const SymbolCacheHeader *header =
+            (const SymbolCacheHeader *) file.GetRange( 0, sizeof(SymbolCacheHeader) );
+    if( !header || memcmp( header->magic, SYMBOL_CACHE_MAGIC, sizeof(header->magic) )
+            || header->version != SYMBOL_CACHE_VERSION )
+        return false;
+
+    long long xmlSize, xmlTime;
+    if( !GetSymbolCacheKey( xmlFile, xmlSize, xmlTime )
+            || header->xmlSize != xmlSize || header->xmlTime != xmlTime )
+        return false;
+
+    size_t offset = sizeof(SymbolCacheHeader);
+    const SymbolCacheColorTable *colorTableRecs =
+            GetSymbolCacheSection<SymbolCacheColorTable>( file, offset, header->nColorTables );
+    const SymbolCacheColor *colorRecs =
+            GetSymbolCacheSection<SymbolCacheColor>( file, offset, header->nColors );
+    const SymbolCacheLookup *lookupRecs =
+            GetSymbolCacheSection<SymbolCacheLookup>( file, offset, header->nLookups );
+    const int *attribs = GetSymbolCacheSection<int>( file, offset, header->nAttribs );
+    const SymbolCacheLineStyle *lineStyleRecs =
+            GetSymbolCacheSection<SymbolCacheLineStyle>( file, offset, header->nLineStyles );
+    const SymbolCachePattern *patternRecs =
+            GetSymbolCacheSection<SymbolCachePattern>( file, offset, header->nPatterns );
+    const SymbolCacheSymbol *symbolRecs =
+            GetSymbolCacheSection<SymbolCacheSymbol>( file, offset, header->nSymbols );
+    const char *strings = GetSymbolCacheSection<char>( file, offset, header->nStringBytes );
+
+    if( !colorTableRecs || !colorRecs || !lookupRecs || !attribs || !lineStyleRecs
+            || !patternRecs || !symbolRecs || !strings )
+        return false;
+
+    //  Check everything before building anything, a damaged cache is just rebuilt
+    int nStrings = header->nStringBytes;
+    if( !nStrings || strings[nStrings - 1] )
+        return false;
+
+    auto stringOk = [nStrings]( int offset ) { return offset >= 0 && offset < nStrings; };
+    auto rangeOk = [] ( int first, int n, int total ) { return first >= 0 && n >= 0 && first <= total - n; };
+    auto str = [strings]( int offset ) { return wxString::FromUTF8( strings + offset ); };
+
+    if( !stringOk( header->appVersion ) || strcmp( strings + header->appVersion, VERSION_FULL )
+            || !stringOk( header->xmlPath ) || str( header->xmlPath ) != xmlFile )
+        return false;
+
+    if( !header->nColorTables || !header->nLookups )
+        return false;
+
+    for( int i = 0; i < header->nColorTables; i++ ) {
+        const SymbolCacheColorTable &rec = colorTableRecs[i];
+        if( !stringOk( rec.name ) || !stringOk( rec.rasterFile )
+                || !rangeOk( rec.firstColor, rec.nColors, header->nColors ) )
+            return false;
+    }
+    for( int i = 0; i < header->nColors; i++ ) {
+        if( !stringOk( colorRecs[i].name ) )
+            return false;
+    }
+    for( int i = 0; i < header->nLookups; i++ ) {
+        const SymbolCacheLookup &rec = lookupRecs[i];
+        if( !stringOk( rec.name ) || !stringOk( rec.instruction )
+                || !rangeOk( rec.firstAttrib, rec.nAttribs, header->nAttribs ) )
+            return false;
+    }
+    for( int i = 0; i < header->nAttribs; i++ ) {
+        if( !stringOk( attribs[i] ) )
+            return false;
+    }
+    for( int i = 0; i < header->nLineStyles; i++ ) {
+        const SymbolCacheLineStyle &rec = lineStyleRecs[i];
+        if( !stringOk( rec.name ) || !stringOk( rec.description ) || !stringOk( rec.colorRef )
+                || !stringOk( rec.HPGL ) )
+            return false;
+    }
+    for( int i = 0; i < header->nPatterns; i++ ) {
+        const SymbolCachePattern &rec = patternRecs[i];
+        if( !stringOk( rec.name ) || !stringOk( rec.description ) || !stringOk( rec.colorRef )
+                || !stringOk( rec.HPGL ) )
+            return false;
+    }
+    for( int i = 0; i < header->nSymbols; i++ ) {
+        const SymbolCacheSymbol &rec = symbolRecs[i];
+        if( !stringOk( rec.name ) || !stringOk( rec.description ) || !stringOk( rec.colorRef )
+                || !stringOk( rec.HPGL ) )
+            return false;
+    }
+
+    //  Build in the order the XML was processed
+
+    for( int i = 0; i < header->nColorTables; i++ ) {
+        const SymbolCacheColorTable &rec = colorTableRecs[i];
+        colTable *colortable = new colTable;
+        colortable->tableName = new wxString( str( rec.name ) );
+        colortable->rasterFileName = str( rec.rasterFile );
+
+        for( int j = rec.firstColor; j < rec.firstColor + rec.nColors; j++ ) {
+            wxString key = str( colorRecs[j].name );
+            S52color color;
+            strncpy( color.colName, strings + colorRecs[j].name, 5 );
+            color.colName[5] = 0;
+            color.R = colorRecs[j].R;
+            color.G = colorRecs[j].G;
+            color.B = colorRecs[j].B;
+
+            colortable->colors[key] = color;
+            colortable->wxColors[key] = wxColour( color.R, color.G, color.B );
+        }
+
+        colorTables->Add( (void *) colortable );
+    }
+
+    for( int i = 0; i < header->nLookups; i++ ) {
+        const SymbolCacheLookup &rec = lookupRecs[i];
+        Lookup lookup;
+        lookup.RCID = rec.RCID;
+        lookup.id = rec.id;
+        lookup.name = str( rec.name );
+        lookup.type = (Object_t) rec.type;
+        lookup.displayPrio = (DisPrio) rec.displayPrio;
+        lookup.radarPrio = (RadPrio) rec.radarPrio;
+        lookup.tableName = (LUPname) rec.tableName;
+        lookup.displayCat = (DisCat) rec.displayCat;
+        lookup.comment = rec.comment;
+        lookup.instruction = str( rec.instruction );
+
+        for( int j = rec.firstAttrib; j < rec.firstAttrib + rec.nAttribs; j++ ) {
+            const char *code = strings + attribs[j];
+            int nc = strlen( code );
+            char *attVal = (char *) calloc( nc + 2, sizeof(char) );
+            memcpy( attVal, code, nc );
+            lookup.attributeCodeArray.push_back( attVal );
+        }
+
+        BuildLookup( lookup );
+    }
+
+    for( int i = 0; i < header->nLineStyles; i++ ) {
+        const SymbolCacheLineStyle &rec = lineStyleRecs[i];
+        LineStyle lineStyle;
+        lineStyle.RCID = rec.RCID;
+        lineStyle.name = str( rec.name );
+        lineStyle.description = str( rec.description );
+        lineStyle.colorRef = str( rec.colorRef );
+        lineStyle.HPGL = str( rec.HPGL );
+        FromCacheSize( rec.vectorSize, lineStyle.vectorSize );
+
+        BuildLineStyle( lineStyle );
+    }
+
+    auto buildPatterns = [&]() {
+        for( int i = 0; i < header->nPatterns; i++ ) {
+            const SymbolCachePattern &rec = patternRecs[i];
+            OCPNPattern pattern;
+            pattern.RCID = rec.RCID;
+            pattern.name = str( rec.name );
+            pattern.description = str( rec.description );
+            pattern.colorRef = str( rec.colorRef );
+            pattern.HPGL = str( rec.HPGL );
+            pattern.hasVector = rec.hasVector != 0;
+            pattern.hasBitmap = rec.hasBitmap != 0;
+            pattern.preferBitmap = rec.preferBitmap != 0;
+            pattern.fillType = rec.fillType;
+            pattern.spacing = rec.spacing;
+            FromCacheSize( rec.bitmapSize, pattern.bitmapSize );
+            FromCacheSize( rec.vectorSize, pattern.vectorSize );
+
+            BuildPattern( pattern );
+        }
+    };
+
+    auto buildSymbols = [&]() {
+        for( int i = 0; i < header->nSymbols; i++ ) {
+            const SymbolCacheSymbol &rec = symbolRecs[i];
+            ChartSymbol symbol;
+            symbol.RCID = rec.RCID;
+            symbol.name = str( rec.name );
+            symbol.description = str( rec.description );
+            symbol.colorRef = str( rec.colorRef );
+            symbol.HPGL = str( rec.HPGL );
+            symbol.hasVector = rec.hasVector != 0;
+            symbol.hasBitmap = rec.hasBitmap != 0;
+            symbol.preferBitmap = rec.preferBitmap != 0;
+            FromCacheSize( rec.bitmapSize, symbol.bitmapSize );
+            FromCacheSize( rec.vectorSize, symbol.vectorSize );
+
+            BuildSymbol( symbol );
+        }
+    };
+
+    if( header->bSymbolsFirst ) {
+        buildSymbols();
+        buildPatterns();
+    } else {
+        buildPatterns();
+        buildSymbols();
+    }
+
+    return true;
+}
+
+void ChartSymbols::SaveCache( const wxString &cacheFile, const wxString &xmlFile, unsigned int firstColorTable )
+{
+    //  The color tables are not built through a Build...() method, so collect them now
+    for( unsigned int i = firstColorTable; i < colorTables->GetCount(); i++ )
+        m_cache->AddColorTable( (colTable *) colorTables->Item( i ) );
+
+    long long xmlSize, xmlTime;
+    if( !GetSymbolCacheKey( xmlFile, xmlSize, xmlTime ) )
+        return;
+
+    if( m_cache->Write( cacheFile, xmlFile, xmlSize, xmlTime ) )
+        wxLogMessage( _T("ChartSymbols cache written to ") + cacheFile );
+    else
+        wxLogMessage( _T("ChartSymbols cache could not be written to ") + cacheFile );
+}
+
 void ChartSymbols::SetColorTableIndex( int index )
 {
     ColorTableIndex = index;
@@ -110,6 +110,7 @@
 #include "s52utils.h"
 
 #include "ais.h"
+#include "PerfTrace.h"
 
 #ifdef __MSVC__
 #define _CRTDBG_MAP_ALLOC
@@ -381,6 +382,9 @@ ChartCanvas::ChartCanvas ( wxFrame *frame, int canvasIndex ) :
     m_canvasIndex = canvasIndex;
     
     pscratch_bm = NULL;
+    m_bStaticLayerDirty = true;
+    m_bdynamic_refresh = false;
+    m_static_layer_key = 0;
 
     SetBackgroundColour ( wxColour(0,0,0) );
     SetBackgroundStyle ( wxBG_STYLE_CUSTOM );  // on WXMSW, this prevents flashing on color scheme change
@@ -2358,6 +2362,8 @@ void ChartCanvas::OnEvtCompressProgress( OCPN_CompressProgressEvent & event )
 #endif
 void ChartCanvas::InvalidateGL()
 {
+    InvalidateStaticLayer();
+
     if(!m_glcc)
         return;
 #ifdef ocpnUSE_GL
@@ -6331,7 +6337,7 @@ void ChartCanvas::UpdateShips()
         own_ship_update_rect.Inflate( 2 );
     }
 
-    if( !own_ship_update_rect.IsEmpty() ) RefreshRect( own_ship_update_rect, false );
+    if( !own_ship_update_rect.IsEmpty() ) RefreshDynamic( &own_ship_update_rect );
 
     ship_draw_last_rect = ship_draw_rect;
 
@@ -6377,7 +6383,7 @@ void ChartCanvas::UpdateAlerts()
         alert_update_rect.Union( alert_rect );
 
         //  Invalidate the rectangular region
-        RefreshRect( alert_update_rect, false );
+        RefreshDynamic( &alert_update_rect );
     }
 
     //  Save this rectangle for next time
@@ -6442,7 +6448,7 @@ void ChartCanvas::UpdateAIS()
         ais_update_rect.Union( ais_rect );
 
         //  Invalidate the rectangular region
-        RefreshRect( ais_update_rect, false );
+        RefreshDynamic( &ais_update_rect );
     }
 
     //  Save this rectangle for next time
@@ -9713,6 +9719,7 @@ void ChartCanvas::UpdateCanvasS52PLIBConfig()
             if(ps52plib->GetStateHash() != m_s52StateHash){
                 UpdateS52State();
                 m_s52StateHash = ps52plib->GetStateHash();
+                InvalidateStaticLayer();
             }
         }
     }
@@ -9720,6 +9727,7 @@ void ChartCanvas::UpdateCanvasS52PLIBConfig()
         if(ps52plib->GetStateHash() != m_s52StateHash){
             UpdateS52State();
             m_s52StateHash = ps52plib->GetStateHash();
+            InvalidateStaticLayer();
         }
     }
     
@@ -9809,6 +9817,8 @@ void ChartCanvas::OnPaint( wxPaintEvent& event )
 
     if( ( GetVP().pix_width == 0 ) || ( GetVP().pix_height == 0 ) ) return;
 
+    PERF_ZONE("ChartCanvas::OnPaint");
+
     wxRegion ru = GetUpdateRegion();
 
     int rx, ry, rwidth, rheight;
@@ -9882,6 +9892,46 @@ void ChartCanvas::OnPaint( wxPaintEvent& event )
     if( fabs( VPoint.skew ) > 0.01 || fabs( VPoint.rotation ) > 0.01)
         b_rcache_ok = !b_newview;
 
+    //  If only the moving objects changed, paint them over the cached static layer
+    if( !b_newview && m_static_bm.IsOk() && ( m_static_bm.GetWidth() == VPoint.pix_width )
+            && ( m_static_bm.GetHeight() == VPoint.pix_height ) && IsStaticLayerValid() ) {
+        wxMemoryDC mscratch_dc;
+        mscratch_dc.SelectObject( *pscratch_bm );
+
+        mscratch_dc.ResetBoundingBox();
+        mscratch_dc.DestroyClippingRegion();
+        mscratch_dc.SetDeviceClippingRegion( rgn_chart );
+
+        wxMemoryDC static_dc;
+        static_dc.SelectObject( m_static_bm );
+        wxRegionIterator upd( rgn_blit );
+        while( upd ) {
+            wxRect rect = upd.GetRect();
+            mscratch_dc.Blit( rect.x, rect.y, rect.width, rect.height, &static_dc, rect.x, rect.y );
+            upd++;
+        }
+        static_dc.SelectObject( wxNullBitmap );
+
+        DrawDynamicLayer( mscratch_dc, ru );
+
+        wxRegionIterator upd_final( rgn_blit );
+        while( upd_final ) {
+            wxRect rect = upd_final.GetRect();
+            dc.Blit( rect.x, rect.y, rect.width, rect.height, &mscratch_dc, rect.x, rect.y );
+            upd_final++;
+        }
+
+        mscratch_dc.SelectObject( wxNullBitmap );
+        dc.DestroyClippingRegion();
+
+        if(m_muiBar){
+            m_muiBar->Refresh();
+        }
+
+        PaintCleanup();
+        return;
+    }
+
     //  Make a special VP
     if( VPoint.b_MercatorProjectionOverride ) VPoint.SetProjectionType( PROJECTION_MERCATOR );
     ViewPort svp = VPoint;
@@ -10209,21 +10259,6 @@ void ChartCanvas::OnPaint( wxPaintEvent& event )
         upd++;
     }
 
-    // If multi-canvas, indicate which canvas has keyboard focus
-    // by drawing a simple blue bar at the top.
-    if(g_canvasConfig != 0){             // multi-canvas?
-        if( this == wxWindow::FindFocus()){
-            g_focusCanvas = this;
-
-            wxColour colour = GetGlobalColor(_T("BLUE4"));
-            mscratch_dc.SetPen(wxPen(colour));
-            mscratch_dc.SetBrush(wxBrush(colour));
-            
-            wxRect activeRect(0, 0, GetClientSize().x, m_focus_indicator_pix);
-            mscratch_dc.DrawRectangle(activeRect);
-        }
-    }
-
     
 // Any MBtiles?
     std::vector<int> stackIndexArray = m_pQuilt->GetExtendedStackIndexArray();
@@ -10245,145 +10280,26 @@ void ChartCanvas::OnPaint( wxPaintEvent& event )
             SetAlertString( _("MBTile requires OpenGL to be enabled"));
     }
 
-//    Draw the rest of the overlay objects directly on the scratch dc
-    ocpnDC scratch_dc( mscratch_dc );
-    DrawOverlayObjects( scratch_dc, ru );
+//    Draw the static overlays and the chart text on the scratch dc
+    DrawStaticLayer( mscratch_dc, svp );
 
-    if( m_bShowTide ){
-        RebuildTideSelectList( GetVP().GetBBox() );
-        DrawAllTidesInBBox( scratch_dc, GetVP().GetBBox() );
-    }
+    //  Keep them as the static layer, if the whole canvas was drawn
+    if( rgn_blit.Contains( wxRect( 0, 0, VPoint.pix_width, VPoint.pix_height ) ) == wxInRegion ) {
+        if( !m_static_bm.IsOk() || ( m_static_bm.GetWidth() != VPoint.pix_width )
+                || ( m_static_bm.GetHeight() != VPoint.pix_height ) )
+            m_static_bm.Create( VPoint.pix_width, VPoint.pix_height, -1 );
 
-    if( m_bShowCurrent ){
-        RebuildCurrentSelectList( GetVP().GetBBox() );
-        DrawAllCurrentsInBBox( scratch_dc, GetVP().GetBBox() );
-    }
+        wxMemoryDC static_dc;
+        static_dc.SelectObject( m_static_bm );
+        static_dc.Blit( 0, 0, VPoint.pix_width, VPoint.pix_height, &mscratch_dc, 0, 0 );
+        static_dc.SelectObject( wxNullBitmap );
 
-    if( m_brepaint_piano && g_bShowChartBar ) {
-        m_Piano->Paint(GetClientSize().y - m_Piano->GetHeight(), mscratch_dc);
-        //m_brepaint_piano = false;
+        SetStaticLayerValid();
     }
 
-    if(m_Compass)
-        m_Compass->Paint(scratch_dc);
-
-    RenderAlertMessage( mscratch_dc, GetVP());
+//    And the rest of the overlay objects
+    DrawDynamicLayer( mscratch_dc, ru );
 
-    //quiting?
-    if( g_bquiting ) {
-#ifdef ocpnUSE_DIBSECTION
-        ocpnMemDC q_dc;
-#else
-        wxMemoryDC q_dc;
-#endif
-        wxBitmap qbm( GetVP().pix_width, GetVP().pix_height );
-        q_dc.SelectObject( qbm );
-
-        // Get a copy of the screen
-        q_dc.Blit( 0, 0, GetVP().pix_width, GetVP().pix_height, &mscratch_dc, 0, 0 );
-
-        //  Draw a rectangle over the screen with a stipple brush
-        wxBrush qbr( *wxBLACK, wxBRUSHSTYLE_FDIAGONAL_HATCH );
-        q_dc.SetBrush( qbr );
-        q_dc.DrawRectangle( 0, 0, GetVP().pix_width, GetVP().pix_height );
-
-        // Blit back into source
-        mscratch_dc.Blit( 0, 0, GetVP().pix_width, GetVP().pix_height, &q_dc, 0, 0, wxCOPY );
-
-        q_dc.SelectObject( wxNullBitmap );
-
-    }
-#if 0
-    //  It is possible that this two-step method may be reuired for some platforms.
-    //  So, retain in the code base to aid recovery if necessary
-    
-    // Create and Render the Vector quilt decluttered text overlay, omitting CM93 composite
-    if( VPoint.b_quilt ) {
-        if(m_pQuilt->IsQuiltVector() && ps52plib && ps52plib->GetShowS57Text()){
-            ChartBase *chart = m_pQuilt->GetRefChart();
-            if( chart && chart->GetChartType() != CHART_TYPE_CM93COMP){
-                
-                //        Clear the text Global declutter list
-                ChartPlugInWrapper *ChPI = dynamic_cast<ChartPlugInWrapper*>( chart );
-                if(ChPI)
-                    ChPI->ClearPLIBTextList();
-                else{
-                    if(ps52plib)
-                        ps52plib->ClearTextList();
-                }
-                
-                wxMemoryDC t_dc;
-                wxBitmap qbm(  GetVP().pix_width, GetVP().pix_height );
-                
-                wxColor maskBackground = wxColour(1,0,0);
-                t_dc.SelectObject( qbm );
-                t_dc.SetBackground(wxBrush(maskBackground));
-                t_dc.Clear();
-
-                //  Copy the scratch DC into the new bitmap
-                t_dc.Blit( 0, 0, GetVP().pix_width, GetVP().pix_height, scratch_dc.GetDC(), 0, 0, wxCOPY );
-
-                //  Render the text to the new bitmap
-                OCPNRegion chart_all_text_region( wxRect( 0, 0, GetVP().pix_width, GetVP().pix_height ) );
-                m_pQuilt->RenderQuiltRegionViewOnDCTextOnly( t_dc, svp, chart_all_text_region );
-                
-                //  Copy the new bitmap back to the scratch dc
-                wxRegionIterator upd_final( ru );
-                while( upd_final ) {
-                    wxRect rect = upd_final.GetRect();
-                    scratch_dc.GetDC()->Blit( rect.x, rect.y, rect.width, rect.height, &t_dc, rect.x, rect.y, wxCOPY, true );
-                    upd_final++;
-                }
-                
-                t_dc.SelectObject( wxNullBitmap );
-            }
-        }
-    }
-#endif
-    // Direct rendering model...
-    if( VPoint.b_quilt ) {
-        if(m_pQuilt->IsQuiltVector() && ps52plib && ps52plib->GetShowS57Text()){
-            ChartBase *chart = m_pQuilt->GetRefChart();
-            if( chart && chart->GetChartType() != CHART_TYPE_CM93COMP){
-                
-                //        Clear the text Global declutter list
-                ChartPlugInWrapper *ChPI = dynamic_cast<ChartPlugInWrapper*>( chart );
-                if(ChPI)
-                    ChPI->ClearPLIBTextList();
-                else{
-                    if(ps52plib)
-                        ps52plib->ClearTextList();
-                }
-                
-                //  Render the text directly to the scratch bitmap
-                OCPNRegion chart_all_text_region( wxRect( 0, 0, GetVP().pix_width, GetVP().pix_height ) );
-                
-                if(g_bShowChartBar && m_Piano) {
-                    wxRect chart_bar_rect(0, GetVP().pix_height - m_Piano->GetHeight(),
-                                          GetVP().pix_width, m_Piano->GetHeight());
-                    
-                    ocpnStyle::Style* style = g_StyleManager->GetCurrentStyle();
-                    if(!style->chartStatusWindowTransparent)
-                        chart_all_text_region.Subtract(chart_bar_rect);
-                }
-                
-                if(m_Compass && m_Compass->IsShown()){
-                    wxRect compassRect = m_Compass->GetRect();
-                    if(chart_all_text_region.Contains(compassRect) != wxOutRegion) {
-                        chart_all_text_region.Subtract(compassRect);
-                    }
-                }
-                
-                
-                mscratch_dc.DestroyClippingRegion();
-                
-                m_pQuilt->RenderQuiltRegionViewOnDCTextOnly( mscratch_dc, svp, chart_all_text_region );
-                
-            }
-        }
-    }
-    
-    
 //    And finally, blit the scratch dc onto the physical dc
     wxRegionIterator upd_final( rgn_blit );
     while( upd_final ) {
@@ -10591,6 +10507,10 @@ void ChartCanvas::Refresh( bool eraseBackground, const wxRect *rect )
 {
     if( g_bquiting )
         return;
+
+    if( !m_bdynamic_refresh )
+        InvalidateStaticLayer();
+
     //  Keep the mouse position members up to date
     GetCanvasPixPoint( mouse_x, mouse_y, m_cursor_lat, m_cursor_lon );
 
@@ -10641,6 +10561,69 @@ void ChartCanvas::Refresh( bool eraseBackground, const wxRect *rect )
 
 }
 
+void ChartCanvas::RefreshDynamic( const wxRect *rect )
+{
+    m_bdynamic_refresh = true;
+    if( rect )
+        RefreshRect( *rect, false );
+    else
+        Refresh( false );
+    m_bdynamic_refresh = false;
+}
+
+bool ChartCanvas::IsDynamicTrack( Track *track )
+{
+    ActiveTrack *pActiveTrack = dynamic_cast<ActiveTrack *>( track );
+    return pActiveTrack && pActiveTrack->IsRunning();
+}
+
+bool ChartCanvas::IsDynamicRoute( Route *route )
+{
+    return route->IsActive() || route->IsSelected() || route->m_bIsBeingEdited;
+}
+
+bool ChartCanvas::IsDynamicWaypoint( RoutePoint *point )
+{
+    return point->m_bRPIsBeingEdited;
+}
+
+//  Objects move between the layers without a refresh, e.g. when a route is
+//  activated or completed, so which ones are dynamic is part of the key.
+unsigned int ChartCanvas::GetStaticLayerKey()
+{
+    unsigned int key = 2166136261u;             // FNV-1a, a single change always shows
+    key = ( key ^ m_bShowNavobjects ) * 16777619u;
+
+    for(wxTrackListNode *node = pTrackList->GetFirst(); node; node = node->GetNext())
+        key = ( key ^ IsDynamicTrack( node->GetData() ) ) * 16777619u;
+
+    for(wxRouteListNode *node = pRouteList->GetFirst(); node; node = node->GetNext()) {
+        Route *pRoute = node->GetData();
+        key = ( key ^ ( pRoute && IsDynamicRoute( pRoute ) ) ) * 16777619u;
+    }
+
+    if( pWayPointMan ) {
+        wxRoutePointListNode *node = pWayPointMan->GetWaypointList()->GetFirst();
+        for( ; node; node = node->GetNext() ) {
+            RoutePoint *pWP = node->GetData();
+            key = ( key ^ ( pWP && IsDynamicWaypoint( pWP ) ) ) * 16777619u;
+        }
+    }
+
+    return key;
+}
+
+bool ChartCanvas::IsStaticLayerValid()
+{
+    return !m_bStaticLayerDirty && m_static_layer_key == GetStaticLayerKey();
+}
+
+void ChartCanvas::SetStaticLayerValid()
+{
+    m_bStaticLayerDirty = false;
+    m_static_layer_key = GetStaticLayerKey();
+}
+
 void ChartCanvas::Update()
 {
     if( m_glcc && g_bopengl ) {
@@ -10751,10 +10734,188 @@ emboss_data *ChartCanvas::EmbossOverzoomIndicator( ocpnDC &dc )
     return m_pEM_OverZoom;
 }
 
-void ChartCanvas::DrawOverlayObjects( ocpnDC &dc, const wxRegion& ru )
+//  The static overlays and the chart text, over the chart already drawn on dc
+void ChartCanvas::DrawStaticLayer( wxMemoryDC &dc, ViewPort &svp )
+{
+    ocpnDC scratch_dc( dc );
+    DrawStaticOverlayObjects( scratch_dc );
+
+#if 0
+    //  It is possible that this two-step method may be reuired for some platforms.
+    //  So, retain in the code base to aid recovery if necessary
+    
+    // Create and Render the Vector quilt decluttered text overlay, omitting CM93 composite
+    if( VPoint.b_quilt ) {
+        if(m_pQuilt->IsQuiltVector() && ps52plib && ps52plib->GetShowS57Text()){
+            ChartBase *chart = m_pQuilt->GetRefChart();
+            if( chart && chart->GetChartType() != CHART_TYPE_CM93COMP){
+                
+                //        Clear the text Global declutter list
+                ChartPlugInWrapper *ChPI = dynamic_cast<ChartPlugInWrapper*>( chart );
+                if(ChPI)
+                    ChPI->ClearPLIBTextList();
+                else{
+                    if(ps52plib)
+                        ps52plib->ClearTextList();
+                }
+                
+                wxMemoryDC t_dc;
+                wxBitmap qbm(  GetVP().pix_width, GetVP().pix_height );
+                
+                wxColor maskBackground = wxColour(1,0,0);
+                t_dc.SelectObject( qbm );
+                t_dc.SetBackground(wxBrush(maskBackground));
+                t_dc.Clear();
+
+                //  Copy the scratch DC into the new bitmap
+                t_dc.Blit( 0, 0, GetVP().pix_width, GetVP().pix_height, scratch_dc.GetDC(), 0, 0, wxCOPY );
+
+                //  Render the text to the new bitmap
+                OCPNRegion chart_all_text_region( wxRect( 0, 0, GetVP().pix_width, GetVP().pix_height ) );
+                m_pQuilt->RenderQuiltRegionViewOnDCTextOnly( t_dc, svp, chart_all_text_region );
+                
+                //  Copy the new bitmap back to the scratch dc
+                wxRegionIterator upd_final( ru );
+                while( upd_final ) {
+                    wxRect rect = upd_final.GetRect();
+                    scratch_dc.GetDC()->Blit( rect.x, rect.y, rect.width, rect.height, &t_dc, rect.x, rect.y, wxCOPY, true );
+                    upd_final++;
+                }
+                
+                t_dc.SelectObject( wxNullBitmap );
+            }
+        }
+    }
+#endif
+    // Direct rendering model...
+    if( VPoint.b_quilt ) {
+        if(m_pQuilt->IsQuiltVector() && ps52plib && ps52plib->GetShowS57Text()){
+            ChartBase *chart = m_pQuilt->GetRefChart();
+            if( chart && chart->GetChartType() != CHART_TYPE_CM93COMP){
+                
+                //        Clear the text Global declutter list
+                ChartPlugInWrapper *ChPI = dynamic_cast<ChartPlugInWrapper*>( chart );
+                if(ChPI)
+                    ChPI->ClearPLIBTextList();
+                else{
+                    if(ps52plib)
+                        ps52plib->ClearTextList();
+                }
+                
+                //  Render the text directly to the scratch bitmap
+                OCPNRegion chart_all_text_region( wxRect( 0, 0, GetVP().pix_width, GetVP().pix_height ) );
+                
+                if(g_bShowChartBar && m_Piano) {
+                    wxRect chart_bar_rect(0, GetVP().pix_height - m_Piano->GetHeight(),
+                                          GetVP().pix_width, m_Piano->GetHeight());
+                    
+                    ocpnStyle::Style* style = g_StyleManager->GetCurrentStyle();
+                    if(!style->chartStatusWindowTransparent)
+                        chart_all_text_region.Subtract(chart_bar_rect);
+                }
+                
+                if(m_Compass && m_Compass->IsShown()){
+                    wxRect compassRect = m_Compass->GetRect();
+                    if(chart_all_text_region.Contains(compassRect) != wxOutRegion) {
+                        chart_all_text_region.Subtract(compassRect);
+                    }
+                }
+                
+                
+                dc.DestroyClippingRegion();
+                
+                m_pQuilt->RenderQuiltRegionViewOnDCTextOnly( dc, svp, chart_all_text_region );
+                
+            }
+        }
+    }
+}
+
+//  Everything drawn on every paint, over the static layer on dc
+void ChartCanvas::DrawDynamicLayer( wxMemoryDC &dc, const wxRegion& ru )
+{
+    // If multi-canvas, indicate which canvas has keyboard focus
+    // by drawing a simple blue bar at the top.
+    if(g_canvasConfig != 0){             // multi-canvas?
+        if( this == wxWindow::FindFocus()){
+            g_focusCanvas = this;
+
+            wxColour colour = GetGlobalColor(_T("BLUE4"));
+            dc.SetPen(wxPen(colour));
+            dc.SetBrush(wxBrush(colour));
+            
+            wxRect activeRect(0, 0, GetClientSize().x, m_focus_indicator_pix);
+            dc.DrawRectangle(activeRect);
+        }
+    }
+
+    ocpnDC scratch_dc( dc );
+    DrawDynamicOverlayObjects( scratch_dc, ru );
+
+    if( m_bShowTide ){
+        RebuildTideSelectList( GetVP().GetBBox() );
+        DrawAllTidesInBBox( scratch_dc, GetVP().GetBBox() );
+    }
+
+    if( m_bShowCurrent ){
+        RebuildCurrentSelectList( GetVP().GetBBox() );
+        DrawAllCurrentsInBBox( scratch_dc, GetVP().GetBBox() );
+    }
+
+    if( m_brepaint_piano && g_bShowChartBar ) {
+        m_Piano->Paint(GetClientSize().y - m_Piano->GetHeight(), dc);
+        //m_brepaint_piano = false;
+    }
+
+    if(m_Compass)
+        m_Compass->Paint(scratch_dc);
+
+    RenderAlertMessage( dc, GetVP());
+
+    //quiting?
+    if( g_bquiting ) {
+#ifdef ocpnUSE_DIBSECTION
+        ocpnMemDC q_dc;
+#else
+        wxMemoryDC q_dc;
+#endif
+        wxBitmap qbm( GetVP().pix_width, GetVP().pix_height );
+        q_dc.SelectObject( qbm );
+
+        // Get a copy of the screen
+        q_dc.Blit( 0, 0, GetVP().pix_width, GetVP().pix_height, &dc, 0, 0 );
+
+        //  Draw a rectangle over the screen with a stipple brush
+        wxBrush qbr( *wxBLACK, wxBRUSHSTYLE_FDIAGONAL_HATCH );
+        q_dc.SetBrush( qbr );
+        q_dc.DrawRectangle( 0, 0, GetVP().pix_width, GetVP().pix_height );
+
+        // Blit back into source
+        dc.Blit( 0, 0, GetVP().pix_width, GetVP().pix_height, &q_dc, 0, 0, wxCOPY );
+
+        q_dc.SelectObject( wxNullBitmap );
+
+    }
+}
+
+//  The overlays which only change with the view, or on edits
+void ChartCanvas::DrawStaticOverlayObjects( ocpnDC &dc )
 {
     GridDraw( dc );
 
+    DrawEmboss( dc, EmbossDepthScale( ) );
+    DrawEmboss( dc, EmbossOverzoomIndicator( dc ) );
+
+    if( m_bShowNavobjects )
+        DrawStaticRoutesTracksAndWaypoints( dc, GetVP().GetBBox() );
+
+    RenderAllChartOutlines( dc, GetVP() );
+    ScaleBarDraw( dc );
+}
+
+//  The overlays drawn on every paint, above the static layer
+void ChartCanvas::DrawDynamicOverlayObjects( ocpnDC &dc, const wxRegion& ru )
+{
 //     bool pluginOverlayRender = true;
 //     
 //     if(g_canvasConfig > 0){     // Multi canvas
@@ -10770,8 +10931,6 @@ void ChartCanvas::DrawOverlayObjects( ocpnDC &dc, const wxRegion& ru )
     }
 
     AISDrawAreaNotices( dc, GetVP(), this);
-    DrawEmboss( dc, EmbossDepthScale( ) );
-    DrawEmboss( dc, EmbossOverzoomIndicator( dc ) );
 
     wxDC *pdc = dc.GetDC();
     if( pdc ) {
@@ -10780,9 +10939,7 @@ void ChartCanvas::DrawOverlayObjects( ocpnDC &dc, const wxRegion& ru )
     }
 
     if( m_bShowNavobjects ) {
-        DrawAllTracksInBBox( dc, GetVP().GetBBox() );
-        DrawAllRoutesInBBox( dc, GetVP().GetBBox() );
-        DrawAllWaypointsInBBox( dc, GetVP().GetBBox() );
+        DrawDynamicRoutesTracksAndWaypoints( dc, GetVP().GetBBox() );
         DrawAnchorWatchPoints( dc );
     } else {
         DrawActiveTrackInBBox( dc, GetVP().GetBBox() );
@@ -10793,9 +10950,7 @@ void ChartCanvas::DrawOverlayObjects( ocpnDC &dc, const wxRegion& ru )
     ShipDraw( dc );
     AlertDraw( dc );
 
-    RenderAllChartOutlines( dc, GetVP() );
     RenderRouteLegs( dc );
-    ScaleBarDraw( dc );
     s57_DrawExtendedLightSectors( dc, VPoint, extendedSectorLegs );
 
     if( m_pTrackRolloverWin ) {
@@ -11011,23 +11166,59 @@ emboss_data *ChartCanvas::CreateEmbossMapData( wxFont &font, int width, int heig
 }
 
 
-void ChartCanvas::DrawAllTracksInBBox( ocpnDC& dc, LLBBox& BltBBox )
+void ChartCanvas::DrawStaticRoutesTracksAndWaypoints( ocpnDC& dc, LLBBox& BltBBox )
 {
-    Track *active_track = NULL;
     for(wxTrackListNode *node = pTrackList->GetFirst();
         node; node = node->GetNext()) {
         Track *pTrackDraw = node->GetData();
+        if( !IsDynamicTrack( pTrackDraw ) )
+            pTrackDraw->Draw( this, dc, GetVP(), BltBBox );
+    }
 
-        if( g_pActiveTrack == pTrackDraw ) {
-            active_track = pTrackDraw;
-            continue;
-        }
+    for(wxRouteListNode *node = pRouteList->GetFirst();
+        node; node = node->GetNext()) {
+        Route *pRouteDraw = node->GetData();
+        if( pRouteDraw && !IsDynamicRoute( pRouteDraw ) )
+            pRouteDraw->Draw( dc, this, BltBBox );
+    }
 
-        pTrackDraw->Draw( this, dc, GetVP(), BltBBox );
+    if(!pWayPointMan)
+        return;
+
+    wxRoutePointListNode *node = pWayPointMan->GetWaypointList()->GetFirst();
+    for( ; node; node = node->GetNext() ) {
+        RoutePoint *pWP = node->GetData();
+        if( pWP && !pWP->m_bIsInRoute && !IsDynamicWaypoint( pWP ) )
+            DrawWaypointInBBox( dc, BltBBox, pWP );
     }
+}
 
-    if( active_track )
-        active_track->Draw( this, dc, GetVP(), BltBBox );
+//  Drawn last, so that the active or selected route (or track) is always on top
+void ChartCanvas::DrawDynamicRoutesTracksAndWaypoints( ocpnDC& dc, LLBBox& BltBBox )
+{
+    for(wxTrackListNode *node = pTrackList->GetFirst();
+        node; node = node->GetNext()) {
+        Track *pTrackDraw = node->GetData();
+        if( IsDynamicTrack( pTrackDraw ) )
+            pTrackDraw->Draw( this, dc, GetVP(), BltBBox );
+    }
+
+    for(wxRouteListNode *node = pRouteList->GetFirst();
+        node; node = node->GetNext()) {
+        Route *pRouteDraw = node->GetData();
+        if( pRouteDraw && IsDynamicRoute( pRouteDraw ) )
+            pRouteDraw->Draw( dc, this, BltBBox );
+    }
+
+    if(!pWayPointMan)
+        return;
+
+    wxRoutePointListNode *node = pWayPointMan->GetWaypointList()->GetFirst();
+    for( ; node; node = node->GetNext() ) {
+        RoutePoint *pWP = node->GetData();
+        if( pWP && !pWP->m_bIsInRoute && IsDynamicWaypoint( pWP ) )
+            DrawWaypointInBBox( dc, BltBBox, pWP );
+    }
 }
 
 
@@ -11048,28 +11239,6 @@ void ChartCanvas::DrawActiveTrackInBBox( ocpnDC& dc, LLBBox& BltBBox )
 }
 
 
-void ChartCanvas::DrawAllRoutesInBBox( ocpnDC& dc, LLBBox& BltBBox )
-{
-    Route *active_route = NULL;
-
-    for(wxRouteListNode *node = pRouteList->GetFirst();
-        node; node = node->GetNext()) {
-
-        Route *pRouteDraw = node->GetData();
-        if( pRouteDraw->IsActive() || pRouteDraw->IsSelected() ) {
-            active_route = pRouteDraw;
-            continue;
-        }
-
-//        if(m_canvasIndex == 1)
-        pRouteDraw->Draw( dc, this, BltBBox );
-    }
-
-    //  Draw any active or selected route (or track) last, so that is is always on top
-    if( active_route )
-        active_route->Draw( dc, this, BltBBox );
-}
-
 void ChartCanvas::DrawActiveRouteInBBox( ocpnDC& dc, LLBBox& BltBBox )
 {
     Route *active_route = NULL;
@@ -11087,44 +11256,27 @@ void ChartCanvas::DrawActiveRouteInBBox( ocpnDC& dc, LLBBox& BltBBox )
         active_route->Draw( dc, this, BltBBox );
 }
 
-void ChartCanvas::DrawAllWaypointsInBBox( ocpnDC& dc, LLBBox& BltBBox )
+void ChartCanvas::DrawWaypointInBBox( ocpnDC& dc, LLBBox& BltBBox, RoutePoint *pWP )
 {
-    if(!pWayPointMan)
-        return;
-
-    wxRoutePointListNode *node = pWayPointMan->GetWaypointList()->GetFirst();
-
-    while( node ) {
-        RoutePoint *pWP = node->GetData();
-        if( pWP ) {
-            if( pWP->m_bIsInRoute ) {
-                node = node->GetNext();
-                continue;
-            }
-
-            /* technically incorrect... waypoint has bounding box */
-            if( BltBBox.Contains( pWP->m_lat, pWP->m_lon ) )
+    /* technically incorrect... waypoint has bounding box */
+    if( BltBBox.Contains( pWP->m_lat, pWP->m_lon ) )
+        pWP->Draw( dc, this, NULL );
+    else{
+        // Are Range Rings enabled?
+        if(pWP->GetShowWaypointRangeRings() && (pWP->GetWaypointRangeRingsNumber() > 0)){
+            double factor = 1.00;
+            if( pWP->GetWaypointRangeRingsStepUnits() == 1 )          // convert kilometers to NMi
+                factor = 1 / 1.852;
+            
+            double radius = factor * pWP->GetWaypointRangeRingsNumber() * pWP->GetWaypointRangeRingsStep()  / 60.;
+            radius *= 2;                // Fudge factor
+            
+            LLBBox radar_box;
+            radar_box.Set(pWP->m_lat-radius, pWP->m_lon-radius, pWP->m_lat+radius, pWP->m_lon+radius);
+            if( !BltBBox.IntersectOut( radar_box ) ){
                 pWP->Draw( dc, this, NULL );
-            else{
-                // Are Range Rings enabled?
-                if(pWP->GetShowWaypointRangeRings() && (pWP->GetWaypointRangeRingsNumber() > 0)){
-                    double factor = 1.00;
-                    if( pWP->GetWaypointRangeRingsStepUnits() == 1 )          // convert kilometers to NMi
-                        factor = 1 / 1.852;
-                    
-                    double radius = factor * pWP->GetWaypointRangeRingsNumber() * pWP->GetWaypointRangeRingsStep()  / 60.;
-                    radius *= 2;                // Fudge factor
-                    
-                    LLBBox radar_box;
-                    radar_box.Set(pWP->m_lat-radius, pWP->m_lon-radius, pWP->m_lat+radius, pWP->m_lon+radius);
-                    if( !BltBBox.IntersectOut( radar_box ) ){
-                        pWP->Draw( dc, this, NULL );
-                    }
-                }
             }
         }
-
-        node = node->GetNext();
     }
 }
 
@@ -11240,7 +11392,10 @@ void ChartCanvas::RebuildTideSelectList( LLBBox& BBox )
     
     pSelectTC->DeleteAllSelectableTypePoints( SELTYPE_TIDEPOINT );
     
-    for( int i = 1; i < ptcmgr->Get_max_IDX() + 1; i++ ) {
+    std::vector<int> stations;
+    ptcmgr->GetStationsInBBox( BBox, 0., false, stations );
+    for( unsigned int k = 0; k < stations.size(); k++ ) {
+        int i = stations[k];
         const IDX_entry *pIDX = ptcmgr->GetIDX_entry( i );
         double lon = pIDX->IDX_lon;
         double lat = pIDX->IDX_lat;
@@ -11360,7 +11515,10 @@ void ChartCanvas::DrawAllTidesInBBox( ocpnDC& dc, LLBBox& BBox )
         double lon_last = 0.;
         double lat_last = 0.;
         double marge = 0.05;
-        for( int i = 1; i < ptcmgr->Get_max_IDX() + 1; i++ ) {
+        std::vector<int> stations;
+        ptcmgr->GetStationsInBBox( BBox, marge, false, stations );
+        for( unsigned int k = 0; k < stations.size(); k++ ) {
+            int i = stations[k];
             const IDX_entry *pIDX = ptcmgr->GetIDX_entry( i );
 
             char type = pIDX->IDX_type;             // Entry "TCtcIUu" identifier
@@ -11534,7 +11692,10 @@ void ChartCanvas::RebuildCurrentSelectList( LLBBox& BBox )
     
     double lon_last = 0.;
     double lat_last = 0.;
-    for( int i = 1; i < ptcmgr->Get_max_IDX() + 1; i++ ) {
+    std::vector<int> stations;
+    ptcmgr->GetStationsInBBox( BBox, 0., true, stations );
+    for( unsigned int k = 0; k < stations.size(); k++ ) {
+        int i = stations[k];
         const IDX_entry *pIDX = ptcmgr->GetIDX_entry( i );
         double lon = pIDX->IDX_lon;
         double lat = pIDX->IDX_lat;
@@ -11639,7 +11800,10 @@ void ChartCanvas::DrawAllCurrentsInBBox( ocpnDC& dc, LLBBox& BBox )
     
     {
 
-        for( int i = 1; i < ptcmgr->Get_max_IDX() + 1; i++ ) {
+        std::vector<int> stations;
+        ptcmgr->GetStationsInBBox( BBox, marge, true, stations );
+        for( unsigned int k = 0; k < stations.size(); k++ ) {
+            int i = stations[k];
             const IDX_entry *pIDX = ptcmgr->GetIDX_entry( i );
             double lon = pIDX->IDX_lon;
             double lat = pIDX->IDX_lat;
@@ -103,6 +103,7 @@ private:
 #include "s52plib.h"
 
 #include "lz4.h"
+#include "PerfTrace.h"
 
 #ifdef __OCPN__ANDROID__
 //  arm gcc compiler has a lot of trouble passing doubles as function aruments.
@@ -572,6 +573,7 @@ void glChartCanvas::Init()
 
     m_cache_tex[0] = m_cache_tex[1] = 0;
     m_cache_page = 0;
+    m_static_tex = 0;
 
     m_b_BuiltFBO = false;
     m_b_DisableFBO = false;
@@ -596,7 +598,21 @@ void glChartCanvas::Init()
     m_inFade = false;
 
     m_gldc.SetGLCanvas( this );
-    
+
+    m_frame_start = -1.;
+    m_frame_cost = 0.;
+    m_render_cost = -1.;
+    m_bLowQuality = false;
+    m_bmoving = false;
+
+    m_prefetch_motion = new glTexPrefetchMotion;
+
+    Connect( FRAME_TIMER, wxEVT_TIMER,
+             (wxObjectEventFunction) (wxEventFunction) &glChartCanvas::onFrameTimerEvent, NULL, this );
+    Connect( QUALITY_TIMER, wxEVT_TIMER,
+             (wxObjectEventFunction) (wxEventFunction) &glChartCanvas::onQualityTimerEvent, NULL, this );
+    m_frameTimer.SetOwner( this, FRAME_TIMER );
+    m_qualityTimer.SetOwner( this, QUALITY_TIMER );
     
 #ifdef __OCPN__ANDROID__    
     //  Create/connect a dynamic event handler slot for gesture and some timer events
@@ -636,6 +652,8 @@ void glChartCanvas::Init()
 
 glChartCanvas::~glChartCanvas()
 {
+    delete m_prefetch_motion;
+
 #ifdef __OCPN__ANDROID__    
     unloadShaders();
 #endif    
@@ -798,6 +816,8 @@ bool glChartCanvas::buildFBOSize(int fboSize)
     
     if( m_b_BuiltFBO ) {
         glDeleteTextures( 2, m_cache_tex );
+        glDeleteTextures( 1, &m_static_tex );
+        m_static_tex = 0;
         ( s_glDeleteFramebuffers )( 1, &m_fb0 );
         ( s_glDeleteRenderbuffers )( 1, &m_renderbuffer );
         m_b_BuiltFBO = false;
@@ -878,8 +898,9 @@ bool glChartCanvas::buildFBOSize(int fboSize)
 
     // initialize color textures
     glGenTextures( 2, m_cache_tex );
-    for(int i=0; i<2; i++) {
-        glBindTexture( g_texture_rectangle_format, m_cache_tex[i] );
+    glGenTextures( 1, &m_static_tex );
+    for(int i=0; i<3; i++) {
+        glBindTexture( g_texture_rectangle_format, i < 2 ? m_cache_tex[i] : m_static_tex );
         glTexParameterf( g_texture_rectangle_format, GL_TEXTURE_MIN_FILTER, GL_NEAREST );
         glTexParameteri( g_texture_rectangle_format, GL_TEXTURE_MAG_FILTER, GL_NEAREST );
         glTexImage2D( g_texture_rectangle_format, 0, GL_RGBA, m_cache_tex_x, m_cache_tex_y, 0, GL_RGBA,
@@ -1134,6 +1155,8 @@ void glChartCanvas::BuildFBO( )
     if( m_b_BuiltFBO ) {
         //return;
         glDeleteTextures( 2, m_cache_tex );
+        glDeleteTextures( 1, &m_static_tex );
+        m_static_tex = 0;
         glDeleteFramebuffers( 1, &m_fb0 );
         glDeleteRenderbuffers( 1, &m_renderbuffer );
         m_b_BuiltFBO = false;
@@ -1157,6 +1180,8 @@ void glChartCanvas::BuildFBO( )
     if(!buildFBOSize(initialSize)){
         
         glDeleteTextures( 2, m_cache_tex );
+        glDeleteTextures( 1, &m_static_tex );
+        m_static_tex = 0;
         glDeleteFramebuffers( 1, &m_fb0 );
         glDeleteRenderbuffers( 1, &m_renderbuffer );
         
@@ -1657,11 +1682,91 @@ void glChartCanvas::OnPaint( wxPaintEvent &event )
 //     }
     
     m_in_glpaint++;
+    UpdateRenderQuality();
+
+    m_frame_start = PerfTrace::Now();
+    m_render_cost = -1.;
     Render();
+
+    //  The cost of full quality moving frames decides on draft quality for the next ones
+    if( !m_bLowQuality && m_bmoving && m_render_cost >= 0. )
+        m_frame_cost = m_frame_cost > 0. ? 0.75 * m_frame_cost + 0.25 * m_render_cost : m_render_cost;
+
+    if( ps52plib )
+        ps52plib->SetDraftMode( false );
     m_in_glpaint--;
 
+    PerfTrace::FrameEnd();
+
+}
+
+
+//  Redraw requests come from many timers and events.  A frame due sooner than
+//  the frame rate allows waits on a timer, and the requests meanwhile join it.
+void glChartCanvas::Refresh( bool eraseBackground, const wxRect *rect )
+{
+    if( m_frameTimer.IsRunning() )
+        return;
+
+    int wait = 0;
+    if( g_GLOptions.m_iMaxFrameRate > 0 && m_frame_start >= 0. ) {
+        double interval = 1e6 / g_GLOptions.m_iMaxFrameRate;
+        wait = ( m_frame_start + interval - PerfTrace::Now() ) / 1000.;
+    }
+
+    if( wait > 0 )
+        m_frameTimer.Start( wait, wxTIMER_ONE_SHOT );
+    else
+        wxGLCanvas::Refresh( eraseBackground, rect );
 }
 
+void glChartCanvas::onFrameTimerEvent( wxTimerEvent &event )
+{
+    wxGLCanvas::Refresh( false );
+}
+
+//  While the view moves, frames which took longer than the frame budget are
+//  drawn in draft quality: no text declutter, no line smoothing and coarser
+//  raster tiles.  Full quality comes back once the view has been still a while.
+void glChartCanvas::UpdateRenderQuality()
+{
+    const ViewPort &vp = m_pParentCanvas->VPoint;
+
+    m_bmoving = m_binPinch || m_binPan;
+    if( m_last_frame_vp.IsValid() ) {
+        if( vp.clat != m_last_frame_vp.clat || vp.clon != m_last_frame_vp.clon
+                || vp.view_scale_ppm != m_last_frame_vp.view_scale_ppm
+                || vp.rotation != m_last_frame_vp.rotation || vp.tilt != m_last_frame_vp.tilt )
+            m_bmoving = true;
+    }
+    m_last_frame_vp = vp;
+
+    if( m_bmoving ) {
+        m_qualityTimer.Start( 300, wxTIMER_ONE_SHOT );
+
+        int rate = g_GLOptions.m_iMaxFrameRate > 0 ? g_GLOptions.m_iMaxFrameRate : 60;
+        if( g_GLOptions.m_bAdaptiveQuality && m_frame_cost > 1e6 / rate )
+            m_bLowQuality = true;
+    }
+
+    if( ps52plib )
+        ps52plib->SetDraftMode( m_bLowQuality );
+}
+
+void glChartCanvas::onQualityTimerEvent( wxTimerEvent &event )
+{
+    if( !m_bLowQuality )
+        return;
+
+    //  The cached charts and the static layer were drawn in draft quality.
+    //  The next moving frame is measured afresh, rather than this redraw
+    //  of everything which costs far more than a frame reusing the caches.
+    m_bLowQuality = false;
+    m_frame_cost = 0.;
+    Invalidate();
+    m_pParentCanvas->InvalidateStaticLayer();
+    Refresh( false );
+}
 
 //   These routines allow reusable coordinates
 bool glChartCanvas::HasNormalizedViewPort(const ViewPort &vp)
@@ -2911,6 +3016,52 @@ void glChartCanvas::DrawCloseMessage(wxString msg)
 #endif    
 }
 
+void glChartCanvas::DrawFrameStats()
+{
+#ifndef USE_ANDROID_GLES2    
+    wxArrayString lines;
+    PerfTrace::GetFrameStats(lines);
+    if(!lines.GetCount())
+        return;
+
+    if(!m_statsfont.IsBuilt()){
+        wxFont *pfont = FontMgr::Get().FindOrCreateFont(9, wxFONTFAMILY_TELETYPE,
+                                                        wxFONTSTYLE_NORMAL,
+                                                        wxFONTWEIGHT_NORMAL);
+        m_statsfont.Build(*pfont);
+    }
+
+    int w = 0, h = 0;
+    for(unsigned int i = 0 ; i < lines.GetCount() ; i++) {
+        int lw, lh;
+        m_statsfont.GetTextExtent( lines[i], &lw, &lh);
+        w = wxMax(w, lw);
+        h = wxMax(h, lh);
+    }
+
+    int xp = 10, yp = 10;
+    int hp = h * lines.GetCount();
+
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+
+    glColor4ub( 0, 0, 0, 160 );
+    glBegin(GL_QUADS);
+    glVertex2i(xp - 4, yp - 2);
+    glVertex2i(xp + w + 4, yp - 2);
+    glVertex2i(xp + w + 4, yp + hp + 2);
+    glVertex2i(xp - 4, yp + hp + 2);
+    glEnd();
+
+    glColor3ub( 255, 255, 255 );
+    glEnable(GL_TEXTURE_2D);
+    for(unsigned int i = 0 ; i < lines.GetCount() ; i++)
+        m_statsfont.RenderString( lines[i], xp, yp + i * h);
+    glDisable(GL_TEXTURE_2D);
+    glDisable(GL_BLEND);
+#endif    
+}
+
 void glChartCanvas::RotateToViewPort(const ViewPort &vp)
 {
 #ifndef USE_ANDROID_GLES2
@@ -3339,7 +3490,12 @@ void glChartCanvas::RenderRasterChartRegionGL( ChartBase *chart, ViewPort &vp, L
             if( bGLMemCrunch)
                 pTexFact->DeleteTexture( tile->rect );
         } else {
-            bool texture = pTexFact->PrepareTexture( base_level, tile->rect, global_color_scheme, mem_used );
+            //  In draft quality, tiles not uploaded yet come a mipmap level coarser
+            int level = base_level;
+            if( m_bLowQuality && level < g_mipmap_max_level && !pTexFact->IsTextureResident( tile->rect, level ) )
+                level++;
+
+            bool texture = pTexFact->PrepareTexture( level, tile->rect, global_color_scheme, mem_used );
 
             float *coords;
             if(use_norm_vp)
@@ -3374,6 +3530,9 @@ void glChartCanvas::RenderRasterChartRegionGL( ChartBase *chart, ViewPort &vp, L
         }
     }
 
+    // upload a few of the tiles we expect to need next
+    g_glTextureManager->PrefetchTiles( *m_prefetch_motion, pTexFact, region, base_level );
+
     glDisable(GL_TEXTURE_2D);
 
 #ifndef USE_ANDROID_GLES2
@@ -3630,6 +3789,8 @@ void glChartCanvas::RenderQuiltViewGLText( ViewPort &vp, const OCPNRegion &rect_
 
 void glChartCanvas::RenderCharts(ocpnDC &dc, const OCPNRegion &rect_region)
 {
+    PERF_ZONE("glChartCanvas::RenderCharts");
+
     ViewPort &vp = m_pParentCanvas->VPoint;
 
     // Only for cm93 (not quilted), SetVPParms can change the valid region of the chart
@@ -3853,6 +4014,38 @@ void glChartCanvas::DrawGroundedOverlayObjects(ocpnDC &dc, ViewPort &vp)
     DisableClipRegion();
 }
 
+/* The static layer texture holds the charts with the grounded overlays
+   already composed, so a frame which only moves the floating objects
+   costs one textured quad here. */
+void glChartCanvas::DrawStaticLayer( int sx, int sy )
+{
+#ifndef USE_ANDROID_GLES2
+    glBindTexture( g_texture_rectangle_format, m_static_tex );
+    glEnable( g_texture_rectangle_format );
+    //  The overlays left partial alpha in the texture, which must not show here
+    GLboolean bblend = glIsEnabled( GL_BLEND );
+    glDisable( GL_BLEND );
+    glTexEnvi( GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_REPLACE );
+
+    float tx = sx, ty = sy;
+    if( GL_TEXTURE_RECTANGLE_ARB != g_texture_rectangle_format ) {
+        tx /= m_cache_tex_x;
+        ty /= m_cache_tex_y;
+    }
+
+    glBegin( GL_QUADS );
+    glTexCoord2f( 0,  ty );  glVertex2f( 0,  0 );
+    glTexCoord2f( tx, ty );  glVertex2f( sx, 0 );
+    glTexCoord2f( tx, 0 );   glVertex2f( sx, sy );
+    glTexCoord2f( 0,  0 );   glVertex2f( 0,  sy );
+    glEnd();
+
+    glDisable( g_texture_rectangle_format );
+    if( bblend )
+        glEnable( GL_BLEND );
+#endif
+}
+
 
 void glChartCanvas::DrawGLTidesInBBox(ocpnDC& dc, LLBBox& BBox)
 {
@@ -3930,7 +4123,10 @@ void glChartCanvas::DrawGLTidesInBBox(ocpnDC& dc, LLBBox& BBox)
 #ifndef USE_ANDROID_GLES2
         glTexEnvi( GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_REPLACE );
         
-        for( int i = 1; i < ptcmgr->Get_max_IDX() + 1; i++ ) {
+        std::vector<int> stations;
+        ptcmgr->GetStationsInBBox( BBox, 0., false, stations );
+        for( unsigned int k = 0; k < stations.size(); k++ ) {
+            int i = stations[k];
             const IDX_entry *pIDX = ptcmgr->GetIDX_entry( i );
             
             char type = pIDX->IDX_type;             // Entry "TCtcIUu" identifier
@@ -3963,7 +4159,10 @@ void glChartCanvas::DrawGLTidesInBBox(ocpnDC& dc, LLBBox& BBox)
             } // type 'T"
         }       //loop
 #else
-        for( int i = 1; i < ptcmgr->Get_max_IDX() + 1; i++ ) {
+        std::vector<int> stations;
+        ptcmgr->GetStationsInBBox( BBox, 0., false, stations );
+        for( unsigned int k = 0; k < stations.size(); k++ ) {
+            int i = stations[k];
             const IDX_entry *pIDX = ptcmgr->GetIDX_entry( i );
     
             char type = pIDX->IDX_type;             // Entry "TCtcIUu" identifier
@@ -4067,6 +4266,8 @@ int refChartIndex;
 int n_render;
 void glChartCanvas::Render()
 {
+    PERF_ZONE("glChartCanvas::Render");
+
     if( !m_bsetup || !m_pParentCanvas->m_pQuilt ||
         ( m_pParentCanvas->VPoint.b_quilt && !m_pParentCanvas->m_pQuilt ) ||
         ( !m_pParentCanvas->VPoint.b_quilt && !m_pParentCanvas->m_singleChart ) ) {
@@ -4138,6 +4339,8 @@ void glChartCanvas::Render()
     ViewPort VPoint = m_pParentCanvas->VPoint;
     ocpnDC gldc( *this );
 
+    m_prefetch_motion->Update( VPoint );
+
     int gl_width, gl_height;
     m_pParentCanvas->GetClientSize( &gl_width, &gl_height );
 
@@ -4188,6 +4391,7 @@ void glChartCanvas::Render()
     
     bool bpost_hilite = !m_pParentCanvas->m_pQuilt->GetHiliteRegion( ).Empty();
     bool useFBO = false;
+    bool bcharts_drawn = false;
     int sx = gl_width;
     int sy = gl_height;
 
@@ -4235,6 +4439,7 @@ void glChartCanvas::Render()
 #endif        
         
         if( b_newview ) {
+            bcharts_drawn = true;
 
             bool busy = false;
             if(VPoint.b_quilt && m_pParentCanvas->m_pQuilt->IsQuiltVector() &&
@@ -4601,57 +4806,76 @@ void glChartCanvas::Render()
     }
 #endif
 
+    //  The charts with the text and grounded overlays on top are kept as the static
+    //  layer, and drawn again only when the charts or these overlays changed.
+    bool bstatic_layer = false;
+    bool bcompose = false;
+#ifndef USE_ANDROID_GLES2
+    if( useFBO && m_static_tex && !VPoint.tilt ) {
+        bstatic_layer = true;
+        bcompose = bcharts_drawn || !m_pParentCanvas->IsStaticLayerValid();
+    }
+#endif
+
+    if( bcompose ) {
+        ( s_glBindFramebuffer )( GL_FRAMEBUFFER_EXT, m_fb0 );
+        ( s_glFramebufferTexture2D )( GL_FRAMEBUFFER_EXT, GL_COLOR_ATTACHMENT0_EXT,
+                                      g_texture_rectangle_format, m_static_tex, 0 );
+    }
+
     if(useFBO) {
-        // Render the cached texture as quad to screen
-        glBindTexture( g_texture_rectangle_format, m_cache_tex[m_cache_page]);
-        glEnable( g_texture_rectangle_format );
+        if( !bstatic_layer || bcompose ) {
+            // Render the cached texture as quad to screen
+            glBindTexture( g_texture_rectangle_format, m_cache_tex[m_cache_page]);
+            glEnable( g_texture_rectangle_format );
 
-        float tx, ty, tx0, ty0, divx, divy;
+            float tx, ty, tx0, ty0, divx, divy;
         
-        //  Normalize, or not?
-        if( GL_TEXTURE_RECTANGLE_ARB == g_texture_rectangle_format ){
-            divx = divy = 1.0f;
-         }
-        else{
-            divx = m_cache_tex_x;
-            divy = m_cache_tex_y;
-        }
+            //  Normalize, or not?
+            if( GL_TEXTURE_RECTANGLE_ARB == g_texture_rectangle_format ){
+                divx = divy = 1.0f;
+             }
+            else{
+                divx = m_cache_tex_x;
+                divy = m_cache_tex_y;
+            }
 
-        tx0 = m_fbo_offsetx/divx;
-        ty0 = m_fbo_offsety/divy;
-        tx =  (m_fbo_offsetx + m_fbo_swidth)/divx;
-        ty =  (m_fbo_offsety + m_fbo_sheight)/divy;
+            tx0 = m_fbo_offsetx/divx;
+            ty0 = m_fbo_offsety/divy;
+            tx =  (m_fbo_offsetx + m_fbo_swidth)/divx;
+            ty =  (m_fbo_offsety + m_fbo_sheight)/divy;
         
-#ifndef USE_ANDROID_GLES2        
-        glTexEnvi( GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_REPLACE );
-        glBegin( GL_QUADS );
-        glTexCoord2f( tx0, ty );  glVertex2f( 0,  0 );
-        glTexCoord2f( tx,  ty );  glVertex2f( sx, 0 );
-        glTexCoord2f( tx,  ty0 ); glVertex2f( sx, sy );
-        glTexCoord2f( tx0, ty0 ); glVertex2f( 0,  sy );
-        glEnd();
-#else
-        float coords[8];
-        float uv[8];
+    #ifndef USE_ANDROID_GLES2        
+            glTexEnvi( GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_REPLACE );
+            glBegin( GL_QUADS );
+            glTexCoord2f( tx0, ty );  glVertex2f( 0,  0 );
+            glTexCoord2f( tx,  ty );  glVertex2f( sx, 0 );
+            glTexCoord2f( tx,  ty0 ); glVertex2f( sx, sy );
+            glTexCoord2f( tx0, ty0 ); glVertex2f( 0,  sy );
+            glEnd();
+    #else
+            float coords[8];
+            float uv[8];
         
-        //normal uv
-        uv[0] = tx0; uv[1] = ty; uv[2] = tx; uv[3] = ty;
-        uv[4] = tx; uv[5] = ty0; uv[6] = tx0; uv[7] = ty0;
+            //normal uv
+            uv[0] = tx0; uv[1] = ty; uv[2] = tx; uv[3] = ty;
+            uv[4] = tx; uv[5] = ty0; uv[6] = tx0; uv[7] = ty0;
         
-        // pixels
-        coords[0] = 0; coords[1] = 0; coords[2] = sx; coords[3] = 0;
-        coords[4] = sx; coords[5] = sy; coords[6] = 0; coords[7] = sy;
+            // pixels
+            coords[0] = 0; coords[1] = 0; coords[2] = sx; coords[3] = 0;
+            coords[4] = sx; coords[5] = sy; coords[6] = 0; coords[7] = sy;
         
-        if(!m_inFade){
-            RenderTextures(coords, uv, 4, m_pParentCanvas->GetpVP());
-        }
-        else
-            qDebug() << "skip FBO update for inFade";
+            if(!m_inFade){
+                RenderTextures(coords, uv, 4, m_pParentCanvas->GetpVP());
+            }
+            else
+                qDebug() << "skip FBO update for inFade";
         
-#endif
+    #endif
         
 
-        glDisable( g_texture_rectangle_format );
+            glDisable( g_texture_rectangle_format );
+        }
 
         m_cache_vp = VPoint;
         m_cache_current_ch = m_pParentCanvas->m_singleChart;
@@ -4668,17 +4892,26 @@ void glChartCanvas::Render()
     // Done with base charts.
     // Now the overlays
 
-    RenderS57TextOverlay( VPoint );
-    RenderMBTilesOverlay( VPoint );
-    
-     
-    // Render static overlay objects
-    for(OCPNRegionIterator upd ( screen_region ); upd.HaveRects(); upd.NextRect()) {
-         LLRegion region = VPoint.GetLLRegion(upd.GetRect());
-         ViewPort cvp = ClippedViewport(VPoint, region);
-         DrawGroundedOverlayObjects(gldc, cvp);
+    if( !bstatic_layer || bcompose ) {
+        RenderS57TextOverlay( VPoint );
+        RenderMBTilesOverlay( VPoint );
+
+        // Render static overlay objects
+        for(OCPNRegionIterator upd ( screen_region ); upd.HaveRects(); upd.NextRect()) {
+            LLRegion region = VPoint.GetLLRegion(upd.GetRect());
+            ViewPort cvp = ClippedViewport(VPoint, region);
+            DrawGroundedOverlayObjects(gldc, cvp);
+        }
     }
 
+    if( bcompose ) {
+        ( s_glBindFramebuffer )( GL_FRAMEBUFFER_EXT, 0 );
+        m_pParentCanvas->SetStaticLayerValid();
+    }
+
+    if( bstatic_layer )
+        DrawStaticLayer( sx, sy );
+
 
     if( m_pParentCanvas->m_bShowTide  || m_pParentCanvas->m_bShowCurrent ){
         LLRegion screenLLRegion = VPoint.GetLLRegion( screen_region );
@@ -4820,8 +5053,13 @@ void glChartCanvas::Render()
     if( g_bcompression_wait)
         DrawCloseMessage( _("Waiting for raster chart compression thread exit."));
 
+    if( PerfTrace::IsFrameStatsEnabled() )
+        DrawFrameStats();
     
     
+    //  Up to here, as the swap may wait for the display
+    m_render_cost = PerfTrace::Now() - m_frame_start;
+
      //  Some older MSW OpenGL drivers are generally very unstable.
      //  This helps...   
 
@@ -55,6 +55,7 @@
 #include "squish.h"
 #include "lz4.h"
 #include "lz4hc.h"
+#include "PerfTrace.h"
 
 extern long g_tex_mem_used;
 extern int g_mipmap_max_level;
@@ -75,63 +76,12 @@ extern bool GetMemoryStatus( int *mem_total, int *mem_used );
 extern wxString CompressedCachePath(wxString path);
 extern glTextureManager   *g_glTextureManager;
 
-//      CatalogEntry implementation
-CatalogEntry::CatalogEntry()
-{
-}
-
-CatalogEntry::~CatalogEntry()
-{
-}
-
-CatalogEntry::CatalogEntry(int level, int x0, int y0, ColorScheme colorscheme)
-{
-    k.mip_level = level;
-    k.x = x0;
-    k.y = y0;
-    k.tcolorscheme = colorscheme;
-}
-
-int CatalogEntry::GetSerialSize()
-{
-    return CATALOG_ENTRY_SERIAL_SIZE;
-}
-
-void CatalogEntry::Serialize( unsigned char *t)
-{
-    uint32_t *p = (uint32_t *)t;
-    
-    *p++ = k.mip_level;
-    *p++ = k.x;
-    *p++ = k.y;
-    *p++ = k.tcolorscheme;
-    *p++ = v.texture_offset;
-    *p++ = v.compressed_size;
-    
-}
-
-
-void CatalogEntry::DeSerialize( unsigned char *t)
-{
-    uint32_t *p = (uint32_t *)t;
-    
-     k.mip_level = *p++;
-     k.x = *p++;
-     k.y = *p++;
-     k.tcolorscheme = (ColorScheme)*p++;
-     v.texture_offset = *p++;
-     v.compressed_size = *p++;
-     
-}
-
 //      glTexFactory Implementation
 enum TextureDataType {COMPRESSED_BUFFER_OK, MAP_BUFFER_OK};
 
 glTexFactory::glTexFactory(ChartBase *chart, int raster_format)
 {
 //    m_pchart = chart;
-    n_catalog_entries = 0;
-    m_catalog_offset = sizeof(CompressedCacheHeader);
     wxDateTime ed = chart->GetEditionDate();
     m_chart_date_binary = (uint32_t)ed.GetTicks();
     m_chartfile_date_binary = ::wxFileModificationTime(chart->GetFullPath());
@@ -143,17 +93,14 @@ glTexFactory::glTexFactory(ChartBase *chart, int raster_format)
     m_catalogOK = false;
     m_newCatalog = true;
 
-    m_catalogCorrupted = false;
-
     m_fs = 0;
+    m_file_end = 0;
+    m_catalog = NULL;
+    m_catalog_size = 0;
     m_LRUtime = 0;
+    m_bprefetching = false;
     m_ntex = 0;
     m_tiles = NULL;
-    for (int i = 0; i < N_COLOR_SCHEMES; i++) {
-        for (int j = 0; j < MAX_TEX_LEVEL; j++) {
-            m_cache[i][j] = NULL;
-        }
-    }
     //  Initialize the TextureDescriptor array
     ChartBaseBSB *pBSBChart = dynamic_cast<ChartBaseBSB*>( chart );
     
@@ -172,26 +119,36 @@ glTexFactory::glTexFactory(ChartBase *chart, int raster_format)
     m_ntex = m_nx_tex * m_ny_tex;
     m_td_array = (glTextureDescriptor **)calloc(m_ntex, sizeof(glTextureDescriptor *));
 
+    m_catalog_size = N_COLOR_SCHEMES * MAX_TEX_LEVEL * m_ntex;
+    m_catalog = (CatalogEntryValue *)calloc(m_catalog_size, sizeof(CatalogEntryValue));
+
+    //  The header we expect to find in a valid cache file for this chart
+    m_hdr.magic = COMPRESSED_CACHE_MAGIC;
+    m_hdr.format = raster_format;
+    m_hdr.chartdate = m_chart_date_binary;
+    m_hdr.chartfile_date = m_chartfile_date_binary;
+    m_hdr.chartfile_size = m_chartfile_size;
+    m_hdr.tex_dim = m_tex_dim;
+    m_hdr.nx_tex = m_nx_tex;
+    m_hdr.ny_tex = m_ny_tex;
+    m_hdr.n_levels = MAX_TEX_LEVEL;
+    m_hdr.n_color_schemes = N_COLOR_SCHEMES;
+    m_hdr.catalog_offset = sizeof(CompressedCacheHeader);
+    m_hdr.data_offset = m_hdr.catalog_offset + m_catalog_size * sizeof(CatalogEntryValue);
+
     m_prepared_projection_type = 0;
 }
 
 glTexFactory::~glTexFactory()
 {
+    m_map.Close();
     delete m_fs;
 
     PurgeBackgroundCompressionPool();
     DeleteAllTextures();
     DeleteAllDescriptors();
 
-    for (int i = 0; i < N_COLOR_SCHEMES; i++) {
-        for (int j = 0; j < MAX_TEX_LEVEL; j++) {
-            CatalogEntryValue *v = m_cache[i][j];
-            if (v) {
-                free(v);
-            }
-        }
-    }
- 
+    free( m_catalog );
     free( m_td_array );         // array is empty
 
     if(m_tiles)
@@ -397,6 +354,12 @@ void glTexFactory::DeleteSingleTexture( glTextureDescriptor *ptd )
     if(!ptd->tex_name)
         return;
 
+    //  Uploaded ahead of time, but never shown
+    if(ptd->prefetch_mem) {
+        g_glTextureManager->NotePrefetchDiscarded(ptd->prefetch_mem);
+        ptd->prefetch_mem = 0;
+    }
+
     g_tex_mem_used -= ptd->tex_mem_used;
     ptd->level_min = g_mipmap_max_level + 1;  // default, nothing loaded
 
@@ -417,18 +380,17 @@ CatalogEntryValue *glTexFactory::GetCacheEntryValue(int level, int x, int y, Col
     if (level < 0 || level >= MAX_TEX_LEVEL)
         return 0;
 
+    if (!m_catalog || (int)color_scheme < 0 || color_scheme >= N_COLOR_SCHEMES)
+        return 0;
+
     //  Look in the cache
     LoadCatalog();
 
-    CatalogEntryValue *v = m_cache[color_scheme][level];
-    if (v == 0)
-        return 0;
-
     int array_index = ArrayIndex(x, y);
-    if (array_index >= m_ntex)
+    if (array_index < 0 || array_index >= m_ntex)
         return 0;
 
-    CatalogEntryValue *r = &v[array_index];
+    CatalogEntryValue *r = &m_catalog[CatalogIndex(level, array_index, color_scheme)];
     if (r->compressed_size == 0)
         return 0;
 
@@ -490,6 +452,8 @@ static void CreateTexture(GLuint &tex_name, bool b_use_mipmaps)
 
 bool glTexFactory::BuildTexture(glTextureDescriptor *ptd, int base_level, const wxRect &rect)
 {
+    PERF_ZONE("glTexFactory::BuildTexture");
+
     bool busy_shown = false;
     
     // the quality is only slightly worse because linear_mipmap_linear
@@ -640,9 +604,20 @@ bool glTexFactory::PrepareTexture( int base_level, const wxRect &rect, ColorSche
     
     //glTexEnvi( GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_REPLACE ); // why?
     
-    if(!BuildTexture(ptd, base_level, rect))
+    // take the prefetch mark before BuildTexture might replace the texture
+    int prefetch_mem = 0;
+    if(!m_bprefetching) {
+        prefetch_mem = ptd->prefetch_mem;
+        ptd->prefetch_mem = 0;
+    }
+
+    bool b_uploaded = BuildTexture(ptd, base_level, rect);
+    if(!b_uploaded)
         glBindTexture( GL_TEXTURE_2D, ptd->tex_name );
 
+    if(!m_bprefetching)
+        g_glTextureManager->NoteTileShown(prefetch_mem, b_uploaded);
+
     // should we schedule compression?
     if(g_GLOptions.m_bTextureCompression &&
        ptd->nGPU_compressed == GPU_TEXTURE_UNCOMPRESSED) {
@@ -694,6 +669,54 @@ bool glTexFactory::PrepareTexture( int base_level, const wxRect &rect, ColorSche
     }
 }
 
+bool glTexFactory::IsTextureResident( const wxRect &rect, int base_level )
+{
+    int array_index = ArrayIndex(rect.x, rect.y);
+    if(array_index < 0 || array_index >= m_ntex)
+        return false;
+
+    glTextureDescriptor *ptd = m_td_array[array_index];
+    return ptd && ptd->tex_name && ptd->level_min <= base_level;
+}
+
+//  Upload a tile that is expected to become visible shortly.
+//  Returns the texture memory used, or 0 if nothing was done
+int glTexFactory::PrefetchTexture( int base_level, const wxRect &rect, ColorScheme color_scheme )
+{
+    if( IsTextureResident( rect, base_level ) )
+        return 0;
+
+    m_bprefetching = true;
+    bool ok = PrepareTexture( base_level, rect, color_scheme, 0 );
+    m_bprefetching = false;
+
+    glTextureDescriptor *ptd = m_td_array[ArrayIndex(rect.x, rect.y)];
+    if( !ok || !ptd || !ptd->tex_name )
+        return 0;
+
+    ptd->prefetch_mem = wxMax(ptd->tex_mem_used, 1);
+
+    //  Also have the next finer and coarser levels ready in ram,
+    //  so a zoom step only costs an upload
+    StageTextureLevel( ptd, rect, base_level - 1 );
+    StageTextureLevel( ptd, rect, base_level + 1 );
+
+    return ptd->prefetch_mem;
+}
+
+void glTexFactory::StageTextureLevel( glTextureDescriptor *ptd, const wxRect &rect, int level )
+{
+    if( level < 0 || level > g_mipmap_max_level )
+        return;
+
+    if( !g_GLOptions.m_bTextureCompression || ptd->comp_array[level] )
+        return;
+
+    //  Only worth doing when it is a cheap decompress, never a chart read
+    if( ptd->compcomp_array[level] || IsLevelInCache( level, rect, ptd->m_colorscheme ) )
+        GetTextureLevel( ptd, rect, level, ptd->m_colorscheme );
+}
+
 void glTexFactory::PrepareTiles(const ViewPort &vp, bool use_norm_vp, ChartBase *chart)
 {
     ChartBaseBSB *pChartBSB = dynamic_cast<ChartBaseBSB*>( chart );
@@ -900,9 +923,8 @@ bool glTexFactory::UpdateCacheAllLevels( const wxRect &rect, ColorScheme color_s
 
     for (int level = 0; level < g_mipmap_max_level + 1; level++ )
         work |= UpdateCacheLevel( rect, level, color_scheme, compcomp_array[level], compcomp_size[level] );
-    if (work) {
-        WriteCatalogAndHeader();
-    }    
+    if (work)
+        m_fs->Flush();
     
     return work;
 }
@@ -932,10 +954,18 @@ int glTexFactory::GetTextureLevel( glTextureDescriptor *ptd, const wxRect &rect,
             if( p != 0 ) {
                 int size = TextureTileSize(level, true);
 
-                if(m_fs->IsOpened()){
+                //  Decompress straight out of the mapped file if we can,
+                //  data appended since the file was mapped needs a remap
+                const unsigned char *src = m_map.GetRange(p->texture_offset, p->compressed_size);
+                if(!src && MapCacheFile())
+                    src = m_map.GetRange(p->texture_offset, p->compressed_size);
+
+                if(src) {
+                    ptd->comp_array[level] = (unsigned char*)malloc(size);
+                    LZ4_decompress_fast((const char*)src, (char*)ptd->comp_array[level], size);
+                } else if(m_fs && m_fs->IsOpened()){
                     m_fs->Seek(p->texture_offset);
                     ptd->comp_array[level] = (unsigned char*)malloc(size);
-                    int max_compressed_size = LZ4_COMPRESSBOUND(g_tile_size);
                     char *compressed_data = (char*)malloc(p->compressed_size);
                     m_fs->Read(compressed_data, p->compressed_size);
                     LZ4_decompress_fast(compressed_data, (char*)ptd->comp_array[level], size);
@@ -956,97 +986,87 @@ int glTexFactory::GetTextureLevel( glTextureDescriptor *ptd, const wxRect &rect,
 }
 
 
-// return not used
-// false? never
-// true 
 bool glTexFactory::LoadHeader(void)
 {
     if(m_hdrOK)
         return true;
 
-    bool need_new = false;
+    bool need_new = true;
 
     if(wxFileName::FileExists(m_CompressedCacheFilePath)) {
         
         m_fs = new wxFFile(m_CompressedCacheFilePath, _T("rb+"));
         if(m_fs->IsOpened()){
-        
             CompressedCacheHeader hdr;
-            
-            //  Header is located at the end of the file
-            wxFileOffset hdr_offset = m_fs->Length() -sizeof( hdr);
-            hdr_offset = m_fs->Seek( hdr_offset );
-            
-            if( sizeof( hdr) == m_fs->Read(&hdr, sizeof( hdr ))) {
-                if( hdr.magic != COMPRESSED_CACHE_MAGIC ||
-                    hdr.chartdate != m_chart_date_binary ||
-                    hdr.chartfile_date != m_chartfile_date_binary ||
-                    hdr.chartfile_size != m_chartfile_size ||
-                    hdr.format != g_raster_format) {
-                    
-                    //  Bad header signature    
-                    delete m_fs;
-                    need_new = true;
-                }
-                else {      // good header
-                    n_catalog_entries = hdr.m_nentries;
-                    m_catalog_offset = hdr.catalog_offset;
-                }
-            }
-            else{  // file exists, and is empty
-                n_catalog_entries = 0;
-                m_catalog_offset = 0;
-                WriteCatalogAndHeader();
-            }
-        }  // is open
-        
-        else{               // some problem opening file, probably permissions on Win7
+            m_file_end = m_fs->Length();
+
+            //  Header is located at the start of the file, and must match
+            //  this chart and the current texture layout exactly
+            if( m_file_end >= (wxFileOffset)m_hdr.data_offset &&
+                sizeof( hdr) == m_fs->Read(&hdr, sizeof( hdr )) &&
+                !memcmp(&hdr, &m_hdr, sizeof( hdr )))
+                need_new = false;
+        }
+
+        if(need_new) {
+            //  Bad header signature, old format, or some problem opening file,
+            //  probably permissions on Win7
             delete m_fs;
-            need_new = true;
+            m_fs = 0;
             wxRemoveFile(m_CompressedCacheFilePath);
         }
-        
     }   // exists
     
     else {   // File does not exist
         wxFileName fn(m_CompressedCacheFilePath);
         if(!fn.DirExists())
             fn.Mkdir();
-        need_new = true;
     }
 
-    if (need_new) {
-        //  Create new file, with empty catalog, and correct header
-        m_fs = new wxFFile(m_CompressedCacheFilePath, _T("wb"));
-        n_catalog_entries = 0;
-        m_catalog_offset = 0;
-        WriteCatalogAndHeader();
-        delete m_fs;
+    if (need_new)
+        CreateCacheFile();
 
-        m_fs = new wxFFile(m_CompressedCacheFilePath, _T("rb+"));
-    }
     m_hdrOK = true;
     return true;
 }
 
-bool glTexFactory::AddCacheEntryValue(const CatalogEntry &p)
+bool glTexFactory::CreateCacheFile()
 {
-    if ((int)p.k.tcolorscheme < 0 || p.k.tcolorscheme >= N_COLOR_SCHEMES) 
+    //  Create new file, with correct header and empty catalog
+    memset(m_catalog, 0, m_catalog_size * sizeof(CatalogEntryValue));
+
+    wxFFile fs(m_CompressedCacheFilePath, _T("wb"));
+    if(!fs.IsOpened())
         return false;
 
-    if (p.k.mip_level < 0 || p.k.mip_level >= MAX_TEX_LEVEL) 
+    fs.Write(&m_hdr, sizeof(m_hdr));
+    fs.Write(m_catalog, m_catalog_size * sizeof(CatalogEntryValue));
+    fs.Close();
+
+    m_file_end = m_hdr.data_offset;
+    m_fs = new wxFFile(m_CompressedCacheFilePath, _T("rb+"));
+    return m_fs->IsOpened();
+}
+
+bool glTexFactory::MapCacheFile()
+{
+    //  Nothing to do unless the file has grown past the current mapping
+    if(m_map.IsOpened() && (wxFileOffset)m_map.GetSize() >= m_file_end)
         return false;
 
-    int array_index = ArrayIndex(p.k.x, p.k.y);
-    if (array_index < 0 || array_index >= m_ntex) 
+    if(m_fs && m_fs->IsOpened())
+        m_fs->Flush();
+
+    if(!m_map.Open(m_CompressedCacheFilePath))
         return false;
 
-    if (m_cache[p.k.tcolorscheme][p.k.mip_level] == 0) 
-        m_cache[p.k.tcolorscheme][p.k.mip_level] = (CatalogEntryValue* )calloc(m_ntex, sizeof (CatalogEntryValue) );
+    //  Reading the whole file to the heap defeats the purpose,
+    //  so on platforms without mmap fall back to reading single textures
+    if(!m_map.IsMapped()) {
+        m_map.Close();
+        return false;
+    }
 
-    CatalogEntryValue *v = m_cache[p.k.tcolorscheme][p.k.mip_level];
-    CatalogEntryValue *r = &v[array_index];
-    *r = p.v; 
     return true;
 }
 
@@ -1058,96 +1078,51 @@ bool glTexFactory::LoadCatalog(void)
 
     if( !LoadHeader() )
         return false;
-    
-    if (n_catalog_entries == 0) {
-        // new empty header
-        m_catalogOK = true;
+
+    m_catalogOK = true;
+
+    if (m_file_end <= (wxFileOffset)m_hdr.data_offset) {
+        // new empty catalog
         m_newCatalog = true;
         return true;
     }
-    
-    m_fs->Seek(m_catalog_offset);
- 
-    CatalogEntry ps;
-    int buf_size =  ps.GetSerialSize();
-    unsigned char *buf = (unsigned char *)malloc(buf_size);
-    
-    CatalogEntry p;
+
+    //  The catalog is a flat array, so bring it in with a single copy
+    size_t catalog_bytes = m_catalog_size * sizeof(CatalogEntryValue);
+    const unsigned char *src = NULL;
+    if(MapCacheFile())
+        src = m_map.GetRange(m_hdr.catalog_offset, catalog_bytes);
+
+    if(src)
+        memcpy(m_catalog, src, catalog_bytes);
+    else if(m_fs && m_fs->IsOpened()) {
+        m_fs->Seek(m_hdr.catalog_offset);
+        if(m_fs->Read(m_catalog, catalog_bytes) != catalog_bytes)
+            memset(m_catalog, 0, catalog_bytes);
+    }
+
+    //  Drop any entries pointing outside the data area, e.g. from an interrupted write
     bool bad = false;
-    for(int i=0 ; i < n_catalog_entries ; i++){
-        m_fs->Read(buf, buf_size);
-        p.DeSerialize(buf);
-        if (!AddCacheEntryValue(p))
+    for(int i=0 ; i < m_catalog_size ; i++){
+        CatalogEntryValue &v = m_catalog[i];
+        if(v.compressed_size == 0)
+            continue;
+        if(v.texture_offset < m_hdr.data_offset ||
+           (wxFileOffset)v.texture_offset + v.compressed_size > m_file_end) {
+            v.texture_offset = 0;
+            v.compressed_size = 0;
             bad = true;
+        }
     }
-    
-    free(buf);
-    if (bad && !m_catalogCorrupted) {
-        wxLogMessage(_T("Bad cache catalog %s %s"), m_ChartPath.c_str(), m_CompressedCacheFilePath.c_str());
-        m_catalogCorrupted = true;
-    }
-    m_catalogOK = true;
-    return true;
-}
-
-
-bool glTexFactory::WriteCatalogAndHeader()
-{
-    if(m_fs && m_fs->IsOpened()){
-
-        m_fs->Seek(m_catalog_offset);
-        
-        CatalogEntry ps;
-        int buf_size =  ps.GetSerialSize();
-        unsigned char buf[CATALOG_ENTRY_SERIAL_SIZE];   // MSVC requires constant stack array size...
-        int new_n_catalog_entries = 0;
-        CatalogEntry p;
-        wxRect rect;
-        for (int i = 0; i < N_COLOR_SCHEMES; i++) {
-            p.k.tcolorscheme = (ColorScheme)i;
-            for (int j = 0; j < MAX_TEX_LEVEL; j++) {
-                CatalogEntryValue *v = m_cache[i][j];
-                if (!v) 
-                    continue;
-                p.k.mip_level = j;
-                for (int k = 0; k < m_ntex; k++) {
-                    ArrayXY(&rect, k);
-                    p.k.y = rect.y;
-                    p.k.x = rect.x;
-                    CatalogEntryValue *r = &v[k];
-                    if (r->compressed_size == 0)
-                        continue;
-                    p.v = *r;
-                    new_n_catalog_entries++;
-                    p.Serialize(buf);
-                    m_fs->Write( buf, buf_size);
 
-                }
-            }
-        }
+    if (bad)
+        wxLogMessage(_T("Bad cache catalog %s %s"), m_ChartPath.c_str(), m_CompressedCacheFilePath.c_str());
 
-        n_catalog_entries = new_n_catalog_entries;
-        //   Write header at file end
-        CompressedCacheHeader hdr;
-        hdr.magic = COMPRESSED_CACHE_MAGIC;
-        hdr.format = g_raster_format;
-        hdr.m_nentries = n_catalog_entries;
-        hdr.catalog_offset = m_catalog_offset;
-        hdr.chartdate = m_chart_date_binary;
-        hdr.chartfile_date = m_chartfile_date_binary;
-        hdr.chartfile_size = m_chartfile_size;
-        
-        m_fs->Write( &hdr, sizeof(hdr));
-        m_fs->Flush();
-        
-        return true;
-    }
-    else
-        return false;
+    return true;
 }
 
 bool glTexFactory::UpdateCachePrecomp(unsigned char *data, int data_size, const wxRect &rect,
-                                      int level, ColorScheme color_scheme, bool write_catalog)
+                                      int level, ColorScheme color_scheme)
 {
     if (level < 0 || level >= MAX_TEX_LEVEL)
         return false;	// XXX BUG
@@ -1155,31 +1130,33 @@ bool glTexFactory::UpdateCachePrecomp(unsigned char *data, int data_size, const
     //  Search the catalog for this particular texture
     if (GetCacheEntryValue(level, rect.x, rect.y, color_scheme) != 0) 
         return false;
-    
+
+    int array_index = ArrayIndex(rect.x, rect.y);
+    if (array_index < 0 || array_index >= m_ntex)
+        return false;
+
     // Make sure the file exists
     wxASSERT(m_fs != 0);
         
-    if( ! m_fs->IsOpened() )
+    if( !m_fs || ! m_fs->IsOpened() )
         return false;
 
-    //      Create a new catalog entry
-    CatalogEntry p( level, rect.x, rect.y, color_scheme);
-    
-    //      Write the compressed data to disk
-    p.v.texture_offset = m_catalog_offset;
-    
-    p.v.compressed_size = data_size;
-    AddCacheEntryValue(p);            
-    n_catalog_entries++;
+    //      Append the compressed data to the end of the file
+    CatalogEntryValue v;
+    v.texture_offset = m_file_end;
+    v.compressed_size = data_size;
+
+    m_fs->Seek( m_file_end );
+    if( m_fs->Write( data, data_size ) != (size_t)data_size )
+        return false;
+    m_file_end += data_size;
+
+    //      and only then fill in its slot, so a partial write never shows in the catalog
+    int index = CatalogIndex(level, array_index, color_scheme);
+    m_fs->Seek( m_hdr.catalog_offset + index * sizeof(CatalogEntryValue) );
+    m_fs->Write( &v, sizeof(v) );
+    m_catalog[index] = v;
+    m_newCatalog = false;
 
-    //      We write the new data at the current catalog offset, overwriting the old catalog
-    m_fs->Seek( m_catalog_offset );
-    m_fs->Write( data, data_size );
-    
-    //      Write the catalog and Header (which follows the catalog at the end of the file
-    m_catalog_offset += data_size;
-    if (write_catalog)
-        WriteCatalogAndHeader();
-    
     return true;
 }
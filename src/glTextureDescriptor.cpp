@@ -40,6 +40,7 @@ glTextureDescriptor::glTextureDescriptor()
     nGPU_compressed = GPU_TEXTURE_UNKNOWN;
     tex_mem_used = 0;
     compdata_ticks = 0;
+    prefetch_mem = 0;
 }
 
 glTextureDescriptor::~glTextureDescriptor()
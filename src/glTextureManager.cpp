@@ -48,9 +48,14 @@
 #endif
 
 #include "squish.h"
+#include "texcmp_mt.h"
 #include "lz4.h"
 #include "lz4hc.h"
 
+#include <vector>
+#include <algorithm>
+
+#include <wx/atomic.h>
 #include <wx/listimpl.cpp>
 WX_DEFINE_LIST(JobList);
 WX_DEFINE_LIST(ProgressInfoList);
@@ -82,6 +87,16 @@ extern bool GetMemoryStatus( int *mem_total, int *mem_used );
 bool bthread_debug;
 bool g_throttle_squish;
 
+//  number of compression worker threads currently inside DoJob
+static wxAtomicInt s_running_compression_jobs = 0;
+
+class RunningJobCounter
+{
+public:
+    RunningJobCounter() { wxAtomicInc(s_running_compression_jobs); }
+    ~RunningJobCounter() { wxAtomicDec(s_running_compression_jobs); }
+};
+
 glTextureManager   *g_glTextureManager;
 
 #include "ssl/sha1.h"
@@ -230,26 +245,30 @@ void FlattenColorsForCompression(unsigned char *data, int dim, bool swap_colors=
 /* return malloced data which is the etc compressed texture of the source */
 static 
 void CompressDataETC(const unsigned char *data, int dim, int size,
-                     unsigned char *tex_data, volatile bool &b_abort)
+                     unsigned char *tex_data, volatile bool &b_abort, int nthreads)
 {
     wxASSERT(dim*dim == 2*size || (dim < 4 && size==8)); // must be 4bpp
-    uint64_t *tex_data64 = (uint64_t*)tex_data;
     
     int mbrow = wxMin(4, dim), mbcol = wxMin(4, dim);
-    uint8_t block[48] = {};
-    for(int row=0; row<dim; row+=4) {
-        for(int col=0; col<dim; col+=4) {
-            for(int brow=0; brow<mbrow; brow++)
-                for(int bcol=0; bcol<mbcol; bcol++)
-                    memcpy(block + (bcol*4+brow)*3,
-                           data + ((row+brow)*dim + col+bcol)*3, 3);
+    int nblocks = wxMax(dim / 4, 1);
+
+    TexCmp_ForEachBlockRowBand(nblocks, nthreads, [&](int row0, int row1) {
+        uint64_t *tex_data64 = (uint64_t*)tex_data + row0*nblocks;
+        uint8_t block[48] = {};
+        for(int row=row0*4; row<row1*4; row+=4) {
+            for(int col=0; col<dim; col+=4) {
+                for(int brow=0; brow<mbrow; brow++)
+                    for(int bcol=0; bcol<mbcol; bcol++)
+                        memcpy(block + (bcol*4+brow)*3,
+                               data + ((row+brow)*dim + col+bcol)*3, 3);
                     
-            extern uint64_t ProcessRGB( const uint8_t* src );
-            *tex_data64++ = ProcessRGB( block );
+                extern uint64_t ProcessRGB( const uint8_t* src );
+                *tex_data64++ = ProcessRGB( block );
+            }
+            if(b_abort)
+                break;
         }
-        if(b_abort)
-            break;
-    }
+    });
 }
 
 static
@@ -477,6 +496,24 @@ static void throttle_func(void *data)
     }
 }
 
+//  How many threads may share the compression of one texture level.
+//  Throttled jobs are on demand tiles that must stay out of the way of the
+//  gui thread, and small levels are not worth the thread startup.  When
+//  several jobs run at once (building the cache) the cores are divided
+//  between them, so this only pays off as the job queue drains.
+static int BlockRowThreads(int dim, bool b_throttle)
+{
+    if(b_throttle || dim < 128)
+        return 1;
+
+    int nCPU =  wxMax(1, wxThread::GetCPUCount());
+    if(g_nCPUCount > 0)
+        nCPU = g_nCPUCount;
+
+    int njobs = wxMax((int)s_running_compression_jobs, 1);
+    return wxMax(nCPU / njobs, 1);
+}
+
 bool JobTicket::DoJob(const wxRect &rect)
 {
     unsigned char *bit_array[10];
@@ -543,12 +580,22 @@ bool JobTicket::DoJob(const wxRect &rect)
                 flags = squish::kDxt1 | squish::kColourClusterFit;
             }
             
-            OCPNStopWatch sww;
-            squish::CompressImageRGBpow2_Flatten_Throttle_Abort( bit_array[level], dim, dim, tex_data, flags,
-                                                                 true, b_throttle ? throttle_func : 0, &sww, b_abort );
+            int nthreads = BlockRowThreads(dim, b_throttle);
+            if(nthreads > 1) {
+                unsigned char *bits = bit_array[level];
+                TexCmp_ForEachBlockRowBand(dim / 4, nthreads, [&](int row0, int row1) {
+                    squish::CompressImageRGBpow2_Flatten_Throttle_Abort_Rows( bits, dim, dim, tex_data, flags,
+                                                                              true, row0*4, row1*4, 0, 0, b_abort );
+                });
+            } else {
+                OCPNStopWatch sww;
+                squish::CompressImageRGBpow2_Flatten_Throttle_Abort( bit_array[level], dim, dim, tex_data, flags,
+                                                                     true, b_throttle ? throttle_func : 0, &sww, b_abort );
+            }
             
         } else if(g_raster_format == GL_ETC1_RGB8_OES) 
-            CompressDataETC(bit_array[level], dim, size, tex_data, b_abort);
+            CompressDataETC(bit_array[level], dim, size, tex_data, b_abort,
+                            BlockRowThreads(dim, b_throttle));
         else if(g_raster_format == GL_COMPRESSED_RGB_FXT1_3DFX) {
             if(!CompressUsingGPU(bit_array[level], dim, size, tex_data, texture_level, binplace)) {
                 b_abort = true;
@@ -706,8 +753,11 @@ void * CompressionPoolThread::Entry()
     {
     SetPriority( WXTHREAD_MIN_PRIORITY );
 
-    if(!m_ticket->DoJob())
-        m_ticket->b_isaborted = true;
+    {
+        RunningJobCounter counter;
+        if(!m_ticket->DoJob())
+            m_ticket->b_isaborted = true;
+    }
 
     if( m_pMessageTarget ) {
         OCPN_CompressionThreadEvent Nevent(wxEVT_OCPN_COMPRESSIONTHREAD, 0);
@@ -773,6 +823,12 @@ glTextureManager::glTextureManager()
     Connect( wxEVT_OCPN_COMPRESSIONTHREAD,
              (wxObjectEventFunction) (wxEventFunction) &glTextureManager::OnEvtThread );
     
+    m_prefetch_mem = 0;
+    m_prefetch_issued = 0;
+    m_prefetch_hits = 0;
+    m_prefetch_wasted = 0;
+    m_demand_loads = 0;
+
     m_ticks = 0;
     m_skip = false;
     m_bcompact = false;
@@ -786,6 +842,7 @@ glTextureManager::~glTextureManager()
 {
 //    ClearAllRasterTextures();
     ClearJobList();
+    LogPrefetchStats();
 }
 
 #define NBAR_LENGTH 40
@@ -943,6 +1000,9 @@ void glTextureManager::OnEvtThread( OCPN_CompressionThreadEvent & event )
 void glTextureManager::OnTimer(wxTimerEvent &event)
 {
     m_ticks++;
+
+    if(bthread_debug && (m_ticks % 120) == 0)
+        LogPrefetchStats();
     
     //  Scrub all the TD's, looking for any completed compression jobs
     //  that have finished
@@ -1630,3 +1690,172 @@ void glTextureManager::BuildCompressedCache()
     m_progDialog = nullptr;
 }
 
+
+//      Predictive texture prefetch
+//      While panning, zooming or following a moving ship at large scale, the
+//      tiles at the edge of the view are uploaded a few frames ahead of need.
+
+#define PREFETCH_PAN_HORIZON            1.0     // seconds of pan/zoom motion to look ahead
+#define PREFETCH_SHIP_HORIZON           60.0    // seconds of ownship motion to look ahead
+#define PREFETCH_RING                   0.25    // always include a ring this fraction of the view
+#define PREFETCH_TILES_PER_FRAME        2       // bound the extra work done in one render
+
+glTexPrefetchMotion::glTexPrefetchMotion()
+{
+    m_bvalid = false;
+    m_clat = m_clon = m_log_scale = 0;
+    m_vlat = m_vlon = m_vzoom = 0;
+}
+
+void glTexPrefetchMotion::Update(const ViewPort &vp)
+{
+    wxLongLong now = wxGetLocalTimeMillis();
+    double log_scale = log(wxMax(vp.view_scale_ppm, 1e-12));
+
+    if(m_bvalid) {
+        double dt = (now - m_time).ToDouble() / 1000.;
+        if(dt < 0.005)
+            return;     // same frame, keep the first sample
+
+        if(dt > 2.0) {
+            // the view sat still, any old motion is stale
+            m_vlat = m_vlon = m_vzoom = 0;
+        } else {
+            double dlon = vp.clon - m_clon;
+            if(dlon > 180.) dlon -= 360.;
+            else if(dlon < -180.) dlon += 360.;
+
+            //  smooth, so a single jump of the view does not dominate
+            const double a = 0.5;
+            m_vlat  = a * (vp.clat - m_clat) / dt + (1 - a) * m_vlat;
+            m_vlon  = a * dlon / dt + (1 - a) * m_vlon;
+            m_vzoom = a * (log_scale - m_log_scale) / dt + (1 - a) * m_vzoom;
+        }
+    }
+
+    m_clat = vp.clat;
+    m_clon = vp.clon;
+    m_log_scale = log_scale;
+    m_time = now;
+    m_bvalid = true;
+}
+
+LLBBox glTexPrefetchMotion::PredictBox(const LLBBox &box) const
+{
+    double dlat = m_vlat * PREFETCH_PAN_HORIZON;
+    double dlon = m_vlon * PREFETCH_PAN_HORIZON;
+
+    //  zooming out widens the view about its center
+    double grow = 1.0;
+    if(m_vzoom < 0)
+        grow = wxMin(exp(-m_vzoom * PREFETCH_PAN_HORIZON), 4.0);
+
+    double hlat = box.GetLatRange() * grow / 2, hlon = box.GetLonRange() * grow / 2;
+    double clat = (box.GetMinLat() + box.GetMaxLat()) / 2 + dlat;
+    double clon = (box.GetMinLon() + box.GetMaxLon()) / 2 + dlon;
+
+    LLBBox predicted;
+    predicted.Set(clat - hlat, clon - hlon, clat + hlat, clon + hlon);
+    return predicted;
+}
+
+void glTextureManager::PrefetchTiles(const glTexPrefetchMotion &motion, glTexFactory *ptf,
+                                     const LLRegion &region, int base_level)
+{
+    if(b_inCompressAllCharts || g_GLOptions.m_iTexturePrefetchPercent <= 0)
+        return;
+
+    //  Stay within the prefetch share of texture memory, and well clear of the crunch limit
+    double mem_limit = (double)g_GLOptions.m_iTextureMemorySize * 1024 * 1024;
+    if(g_tex_mem_used > mem_limit * 0.8 ||
+       m_prefetch_mem > mem_limit * g_GLOptions.m_iTexturePrefetchPercent / 100.)
+        return;
+
+    LLBBox box = region.GetBox();
+    if(!box.GetValid())
+        return;
+
+    LLBBox predicted = motion.PredictBox(box);
+    LLBBox target = box;
+    target.Expand(predicted);
+
+    //  Look ahead along ownship course when the ship is in view
+    if(gSog > 0.5 && !wxIsNaN(gCog) && box.Contains(gLat, gLon)) {
+        double dist = gSog * PREFETCH_SHIP_HORIZON / 3600. / 60.;   // degrees of latitude
+        double dlat = dist * cos(gCog * PI / 180.);
+        double dlon = dist * sin(gCog * PI / 180.) / wxMax(cos(gLat * PI / 180.), 0.01);
+
+        LLBBox shipbox;
+        shipbox.Set(box.GetMinLat() + dlat, box.GetMinLon() + dlon,
+                    box.GetMaxLat() + dlat, box.GetMaxLon() + dlon);
+        target.Expand(shipbox);
+    }
+
+    target.EnLarge(wxMax(box.GetLatRange(), box.GetLonRange()) * PREFETCH_RING);
+
+    //  Collect tiles in the target area which are not yet visible,
+    //  nearest to where the view is going first
+    double plat = (predicted.GetMinLat() + predicted.GetMaxLat()) / 2;
+    double plon = (predicted.GetMinLon() + predicted.GetMaxLon()) / 2;
+
+    std::vector< std::pair<double, glTexTile *> > candidates;
+    int numtiles;
+    glTexTile **tiles = ptf->GetTiles(numtiles);
+    for(int i = 0; i < numtiles; i++) {
+        glTexTile *tile = tiles[i];
+        if(!tile || !region.IntersectOut(tile->box) || target.IntersectOut(tile->box))
+            continue;
+        if(ptf->IsTextureResident(tile->rect, base_level))
+            continue;
+
+        double tlat = (tile->box.GetMinLat() + tile->box.GetMaxLat()) / 2 - plat;
+        double tlon = (tile->box.GetMinLon() + tile->box.GetMaxLon()) / 2 - plon;
+        candidates.push_back(std::make_pair(tlat * tlat + tlon * tlon, tile));
+    }
+
+    if(candidates.empty())
+        return;
+
+    std::sort(candidates.begin(), candidates.end());
+
+    int n = wxMin((int)candidates.size(), PREFETCH_TILES_PER_FRAME);
+    for(int i = 0; i < n; i++) {
+        int mem = ptf->PrefetchTexture(base_level, candidates[i].second->rect, global_color_scheme);
+        if(mem) {
+            m_prefetch_mem += mem;
+            m_prefetch_issued++;
+        }
+    }
+}
+
+void glTextureManager::NoteTileShown(int prefetch_mem, bool b_uploaded)
+{
+    if(prefetch_mem) {
+        m_prefetch_mem -= prefetch_mem;
+        if(b_uploaded)
+            m_prefetch_wasted++;        // prefetched at the wrong level
+        else
+            m_prefetch_hits++;
+    }
+
+    if(b_uploaded)
+        m_demand_loads++;
+}
+
+void glTextureManager::NotePrefetchDiscarded(int prefetch_mem)
+{
+    m_prefetch_mem -= prefetch_mem;
+    m_prefetch_wasted++;
+}
+
+void glTextureManager::LogPrefetchStats()
+{
+    if(!m_prefetch_issued)
+        return;
+
+    wxString msg;
+    msg.Printf(_T("Texture prefetch: issued %lu  hits %lu (%.0f%%)  wasted %lu  demand loads %lu"),
+               m_prefetch_issued, m_prefetch_hits, 100. * m_prefetch_hits / m_prefetch_issued,
+               m_prefetch_wasted, m_demand_loads);
+    wxLogMessage(msg);
+}
@@ -39,6 +39,10 @@
 
 #include <wx/file.h>
 
+#include <algorithm>
+#include <deque>
+#include <map>
+
 #include "dychart.h"
 
 #ifdef ocpnUSE_GL
@@ -47,6 +51,8 @@
 
 #include "gshhs.h"
 #include "chartbase.h" // for projections
+#include "chart1.h"
+#include "PerfTrace.h"
 #include "wx28compat.h"
 
 
@@ -65,6 +71,13 @@
 //typedef void (APIENTRY * PFNGLBINDBUFFERPROC) (GLenum target, GLuint buffer);
 
 extern wxString gWorldMapLocation;
+extern MyFrame *gFrame;
+
+//  Cells of all the qualities kept around before the least recently drawn are dropped
+#define GSHHS_CELL_BUDGET_BYTES         (128 * 1024 * 1024)
+//  Limits of the cells built ahead, per quality
+#define GSHHS_PREFETCH_CELLS            256
+#define GSHHS_PREFETCH_ZOOM_CELLS       128
 
 #ifdef USE_ANDROID_GLES2
 static const GLchar* vertex_shader_source =
@@ -188,17 +201,21 @@ void GSHHSChart::RenderViewOnDC( ocpnDC& dc, ViewPort& vp )
 //    reader->drawBoundaries( dc, vp );
 }
 
-GshhsPolyCell::GshhsPolyCell( FILE *fpoly_, int x0_, int y0_, PolygonFileHeader *header_ )
+GshhsPolyCell::GshhsPolyCell( const MappedFile &file, int x0_, int y0_, int quality_, PolygonFileHeader *header_ )
 {
     header = header_;
-    fpoly = fpoly_;
     x0cell = x0_;
     y0cell = y0_;
+    quality = quality_;
+    memoryUsed = 0;
+    lastUsed = 0;
 
-    for(int i=0; i<6; i++)
+    for(int i=0; i<6; i++) {
         polyv[i] = NULL;
+        polyc[i] = 0;
+    }
 
-    ReadPolygonFile( );
+    ReadPolygonFile( file );
 
     for(int i=0; i<GSSH_SUBM*GSSH_SUBM; i++)
         high_res_map[i] = NULL;
@@ -219,47 +236,52 @@ void GshhsPolyCell::ClearPolyV()
     for(int i=0; i<6; i++) {
         delete [] polyv[i];
         polyv[i] = NULL;
+        memoryUsed -= polyc[i] * sizeof(float_2Dpt);
+        polyc[i] = 0;
     }
 }
 
-void GshhsPolyCell::ReadPoly(contour_list &poly)
+bool GshhsPolyCell::ReadPoly(contour_list &poly, const unsigned char *&data, const unsigned char *end)
 {
-    double X,Y;
     contour tmp_contour;
     int32_t num_vertices, num_contours;
     poly.clear();
-    if(fread(&num_contours, sizeof num_contours, 1, fpoly) != 1)
-        goto fail;
+    if(end - data < (ptrdiff_t)sizeof num_contours)
+        return false;
+    memcpy(&num_contours, data, sizeof num_contours);
+    data += sizeof num_contours;
 
     for (int c= 0; c < num_contours; c++)
     {
-        int32_t value;
-        if(fread(&value, sizeof value, 1, fpoly) != 1 ||  /* discarding hole value */
-           fread(&value, sizeof value, 1, fpoly) != 1)
-            goto fail;
+        int32_t value[2];       /* discarding hole value */
+        if(end - data < (ptrdiff_t)sizeof value)
+            return false;
+        memcpy(value, data, sizeof value);
+        data += sizeof value;
 
-        num_vertices=value;
+        num_vertices=value[1];
+        if(num_vertices < 0 || (end - data) / (ptrdiff_t)(2 * sizeof(double)) < num_vertices)
+            return false;
 
         tmp_contour.clear();
+        tmp_contour.reserve(num_vertices);
         for (int v= 0; v < num_vertices; v++)
         {
-            if(fread(&X, sizeof X, 1, fpoly) != 1 ||
-               fread(&Y, sizeof Y, 1, fpoly) != 1)
-                goto fail;
+            double XY[2];
+            memcpy(XY, data, sizeof XY);
+            data += sizeof XY;
 
-            tmp_contour.push_back(wxRealPoint(X*GSHHS_SCL,Y*GSHHS_SCL));
+            tmp_contour.push_back(wxRealPoint(XY[0]*GSHHS_SCL,XY[1]*GSHHS_SCL));
         }
         poly.push_back(tmp_contour);
+        memoryUsed += sizeof(contour) + num_vertices * sizeof(wxRealPoint);
     }
-    return;
-
-fail:
-    wxLogMessage( _T("gshhs ReadPoly failed") );
+    return true;
 }
 
-void GshhsPolyCell::ReadPolygonFile()
+void GshhsPolyCell::ReadPolygonFile( const MappedFile &file )
 {
-    if(!fpoly)
+    if(!file.IsOpened())
         return;
 
     int pos_data;
@@ -267,21 +289,19 @@ void GshhsPolyCell::ReadPolygonFile()
 
     tab_data = ( x0cell / header->pasx ) * ( 180 / header->pasy )
         + ( y0cell + 90 ) / header->pasy;
-    fseek( fpoly, sizeof(PolygonFileHeader) + tab_data * sizeof(int), SEEK_SET );
-    if(fread( &pos_data, sizeof(int), 1, fpoly ) != 1)
-        goto fail;
-
-    fseek( fpoly, pos_data, SEEK_SET );
-
-    ReadPoly( poly1 );
-    ReadPoly( poly2 );
-    ReadPoly( poly3 );
-    ReadPoly( poly4 );
-    ReadPoly( poly5 );
-    return;
-
-fail:
-    wxLogMessage( _T("gshhs ReadPolygon failed") );
+    const unsigned char *tab = file.GetRange( sizeof(PolygonFileHeader) + tab_data * sizeof(int), sizeof(int) );
+    if(tab)
+        memcpy( &pos_data, tab, sizeof(int) );
+
+    const unsigned char *data = tab && pos_data >= 0 ? file.GetRange( pos_data, 0 ) : NULL;
+    const unsigned char *end = file.GetData() + file.GetSize();
+    if( !data ||
+        !ReadPoly( poly1, data, end ) ||
+        !ReadPoly( poly2, data, end ) ||
+        !ReadPoly( poly3, data, end ) ||
+        !ReadPoly( poly4, data, end ) ||
+        !ReadPoly( poly5, data, end ) )
+        wxLogMessage( _T("gshhs ReadPolygon failed") );
 }
 
 wxPoint2DDouble GetDoublePixFromLL(ViewPort &vp, double lat, double lon)
@@ -354,20 +374,22 @@ typedef union {
     } info;
 } GLvertex;
 
-#include <list>
-
-static std::list<float_2Dpt> g_pv;
-static std::list<GLvertex*> g_vertexes;
-static int g_type, g_pos;
-static float_2Dpt g_p1, g_p2;
+//  The tessellation state is per polygon, so cells may be built on any thread
+struct GshhsTessState {
+    std::vector<float_2Dpt> pv;
+    std::vector<GLvertex*> vertexes;
+    int type, pos;
+    float_2Dpt p1, p2;
+};
 
 void __CALL_CONVENTION gshhscombineCallback( GLdouble coords[3], GLdouble *vertex_data[4], GLfloat weight[4],
-        GLdouble **dataOut )
+        GLdouble **dataOut, void *user_data )
 {
+    GshhsTessState *t = (GshhsTessState*)user_data;
     GLvertex *vertex;
 
     vertex = new GLvertex();
-    g_vertexes.push_back(vertex);
+    t->vertexes.push_back(vertex);
 
     vertex->info.x = coords[0];
     vertex->info.y = coords[1];
@@ -375,8 +397,9 @@ void __CALL_CONVENTION gshhscombineCallback( GLdouble coords[3], GLdouble *verte
     *dataOut = vertex->data;
 }
 
-void __CALL_CONVENTION gshhsvertexCallback( GLvoid* arg )
+void __CALL_CONVENTION gshhsvertexCallback( GLvoid* arg, void *user_data )
 {
+    GshhsTessState *t = (GshhsTessState*)user_data;
     GLvertex* vertex;
     vertex = (GLvertex*) arg;
     float_2Dpt p;
@@ -384,21 +407,21 @@ void __CALL_CONVENTION gshhsvertexCallback( GLvoid* arg )
     p.x = vertex->info.y;
 
     // convert strips and fans into triangles
-    if(g_type != GL_TRIANGLES) {
-        if(g_pos > 2) {
-            g_pv.push_back(g_p1);
-            g_pv.push_back(g_p2);
+    if(t->type != GL_TRIANGLES) {
+        if(t->pos > 2) {
+            t->pv.push_back(t->p1);
+            t->pv.push_back(t->p2);
         }
 
-        if(g_type == GL_TRIANGLE_STRIP)
-            g_p1 = g_p2;
-        else if(g_pos == 0)
-            g_p1 = p;
-        g_p2 = p;
+        if(t->type == GL_TRIANGLE_STRIP)
+            t->p1 = t->p2;
+        else if(t->pos == 0)
+            t->p1 = p;
+        t->p2 = p;
     }
 
-    g_pv.push_back(p);
-    g_pos++;
+    t->pv.push_back(p);
+    t->pos++;
 }
 
 void __CALL_CONVENTION gshhserrorCallback( GLenum errorCode )
@@ -408,102 +431,120 @@ void __CALL_CONVENTION gshhserrorCallback( GLenum errorCode )
    //wxLogMessage( _T("OpenGL Tessellation Error: %s"), estring );
 }
 
-void __CALL_CONVENTION gshhsbeginCallback( GLenum type )
+void __CALL_CONVENTION gshhsbeginCallback( GLenum type, void *user_data )
 {
+    GshhsTessState *t = (GshhsTessState*)user_data;
     switch(type) {
     case GL_TRIANGLES:
     case GL_TRIANGLE_STRIP:
     case GL_TRIANGLE_FAN:
-        g_type = type;
+        t->type = type;
         break;
     default:
     printf("tess unhandled begin type: %d\n", type);
     }
 
-    g_pos = 0;
+    t->pos = 0;
 }
 
 void __CALL_CONVENTION gshhsendCallback()
 {
 }
 
-void GshhsPolyCell::DrawPolygonFilledGL( contour_list * p, float_2Dpt **pv, int *pvc, ViewPort &vp,  wxColor const &color, bool idl )
+void GshhsPolyCell::BuildPolyV( ViewPort &vp, bool idl )
 {
-    if( !p->size() ) // size of 0 is very common, exit early
+    BuildPolygonFilledGL( &poly1, &polyv[1], &polyc[1], vp, idl );
+    BuildPolygonFilledGL( &poly2, &polyv[2], &polyc[2], vp, idl );
+    BuildPolygonFilledGL( &poly3, &polyv[3], &polyc[3], vp, idl );
+    BuildPolygonFilledGL( &poly4, &polyv[4], &polyc[4], vp, idl );
+    BuildPolygonFilledGL( &poly5, &polyv[5], &polyc[5], vp, idl );
+}
+
+// build the contour vertex array converted to normalized coordinates (if needed)
+void GshhsPolyCell::BuildPolygonFilledGL( contour_list * p, float_2Dpt **pv, int *pvc, ViewPort &vp, bool idl )
+{
+    if( *pv || !p->size() )
         return;
 
-    // build the contour vertex array converted to normalized coordinates (if needed)
-    if(!*pv) {
-        for(unsigned int c = 0; c < p->size(); c++ ) {
-            if( !p->at( c ).size() ) continue;
-
-            contour &cp = p->at( c );
-
-            GLUtesselator *tobj = gluNewTess();
-            
-            gluTessCallback( tobj, GLU_TESS_VERTEX, (_GLUfuncptr) &gshhsvertexCallback );
-            gluTessCallback( tobj, GLU_TESS_BEGIN, (_GLUfuncptr) &gshhsbeginCallback );
-            gluTessCallback( tobj, GLU_TESS_END, (_GLUfuncptr) &gshhsendCallback );
-            gluTessCallback( tobj, GLU_TESS_COMBINE, (_GLUfuncptr) &gshhscombineCallback );
-            gluTessCallback( tobj, GLU_TESS_ERROR, (_GLUfuncptr) &gshhserrorCallback );
-            
-            gluTessNormal( tobj, 0, 0, 1);
-            gluTessProperty( tobj, GLU_TESS_WINDING_RULE, GLU_TESS_WINDING_NONZERO );
-            
-            gluTessBeginPolygon( tobj, NULL );
-            gluTessBeginContour( tobj );
-
-            for(unsigned int v = 0; v < p->at( c ).size(); v++ ) {
-                wxRealPoint &ccp = cp.at( v );
-
-                if( v == 0 || ccp != cp.at(v-1) ) {
-                    GLvertex* vertex = new GLvertex();
-                    g_vertexes.push_back(vertex);
-
-                    wxPoint2DDouble q;
-                    if(glChartCanvas::HasNormalizedViewPort(vp))
-                        q = GetDoublePixFromLL(vp, ccp.y, ccp.x );
-                    else // tesselation directly from lat/lon
-                        q.m_x = ccp.y, q.m_y = ccp.x;
-
-                    if(vp.m_projection_type != PROJECTION_POLAR) {
-                        // need to correctly pick +180 or -180 longitude for projections
-                        // that have a discontiguous date line
-                            
-                        if(idl && ccp.x == 180) {
-                            if(vp.m_projection_type == PROJECTION_MERCATOR ||
-                               vp.m_projection_type == PROJECTION_EQUIRECTANGULAR)
-                                q.m_x -= 40058986*4096.0; // 360 degrees in normalized viewport
-                            else
-                                q.m_x -= 360; // lat/lon coordinates
-                        }
-                    }
+    GshhsTessState t;
+    t.type = GL_TRIANGLES;
+    t.pos = 0;
+
+    for(unsigned int c = 0; c < p->size(); c++ ) {
+        if( !p->at( c ).size() ) continue;
+
+        contour &cp = p->at( c );
+
+        GLUtesselator *tobj = gluNewTess();
 
-                    vertex->info.x = q.m_x;
-                    vertex->info.y = q.m_y;
+        gluTessCallback( tobj, GLU_TESS_VERTEX_DATA, (_GLUfuncptr) &gshhsvertexCallback );
+        gluTessCallback( tobj, GLU_TESS_BEGIN_DATA, (_GLUfuncptr) &gshhsbeginCallback );
+        gluTessCallback( tobj, GLU_TESS_END, (_GLUfuncptr) &gshhsendCallback );
+        gluTessCallback( tobj, GLU_TESS_COMBINE_DATA, (_GLUfuncptr) &gshhscombineCallback );
+        gluTessCallback( tobj, GLU_TESS_ERROR, (_GLUfuncptr) &gshhserrorCallback );
 
-                    gluTessVertex( tobj, (GLdouble*)vertex, (GLdouble*)vertex);
+        gluTessNormal( tobj, 0, 0, 1);
+        gluTessProperty( tobj, GLU_TESS_WINDING_RULE, GLU_TESS_WINDING_NONZERO );
+
+        gluTessBeginPolygon( tobj, &t );
+        gluTessBeginContour( tobj );
+
+        for(unsigned int v = 0; v < p->at( c ).size(); v++ ) {
+            wxRealPoint &ccp = cp.at( v );
+
+            if( v == 0 || ccp != cp.at(v-1) ) {
+                GLvertex* vertex = new GLvertex();
+                t.vertexes.push_back(vertex);
+
+                wxPoint2DDouble q;
+                if(glChartCanvas::HasNormalizedViewPort(vp))
+                    q = GetDoublePixFromLL(vp, ccp.y, ccp.x );
+                else // tesselation directly from lat/lon
+                    q.m_x = ccp.y, q.m_y = ccp.x;
+
+                if(vp.m_projection_type != PROJECTION_POLAR) {
+                    // need to correctly pick +180 or -180 longitude for projections
+                    // that have a discontiguous date line
+
+                    if(idl && ccp.x == 180) {
+                        if(vp.m_projection_type == PROJECTION_MERCATOR ||
+                           vp.m_projection_type == PROJECTION_EQUIRECTANGULAR)
+                            q.m_x -= 40058986*4096.0; // 360 degrees in normalized viewport
+                        else
+                            q.m_x -= 360; // lat/lon coordinates
+                    }
                 }
-            }
 
-            gluTessEndContour( tobj );
-            gluTessEndPolygon( tobj );
-            gluDeleteTess( tobj );
+                vertex->info.x = q.m_x;
+                vertex->info.y = q.m_y;
 
-            for(std::list<GLvertex*>::iterator it = g_vertexes.begin(); it != g_vertexes.end(); it++)
-                delete *it;
-            g_vertexes.clear();
+                gluTessVertex( tobj, (GLdouble*)vertex, (GLdouble*)vertex);
+            }
         }
 
-        *pv = new float_2Dpt[g_pv.size()];
-        int i=0;
-        for(std::list<float_2Dpt>::iterator it = g_pv.begin(); it != g_pv.end(); it++)
-            (*pv)[i++] = *it;
-            
-        *pvc = g_pv.size();
-        g_pv.clear();
+        gluTessEndContour( tobj );
+        gluTessEndPolygon( tobj );
+        gluDeleteTess( tobj );
+
+        for(std::vector<GLvertex*>::iterator it = t.vertexes.begin(); it != t.vertexes.end(); it++)
+            delete *it;
+        t.vertexes.clear();
     }
 
+    *pv = new float_2Dpt[t.pv.size()];
+    if(t.pv.size())
+        memcpy(*pv, &t.pv[0], t.pv.size() * sizeof(float_2Dpt));
+
+    *pvc = t.pv.size();
+    memoryUsed += *pvc * sizeof(float_2Dpt);
+}
+
+void GshhsPolyCell::DrawPolygonFilledGL( contour_list * p, float_2Dpt **pv, int *pvc, ViewPort &vp,  wxColor const &color, bool idl )
+{
+    if( !p->size() ) // size of 0 is very common, exit early
+        return;
+
+    BuildPolygonFilledGL( p, pv, pvc, vp, idl );
 
 #ifdef USE_ANDROID_GLES2
 
@@ -731,73 +772,322 @@ void GshhsPolyCell::drawSeaBorderLines( ocpnDC &pnt, double dx, ViewPort &vp )
 
 //========================================================================
 
-GshhsPolyReader::GshhsPolyReader( int quality )
+static inline int GshhsCellKey( int quality, int x, int y )
+{
+    return ( quality * 360 + x ) * 180 + y;
+}
+
+class GshhsCellLoadThread;
+
+//  Builds cells from the mapped polygon files on a worker thread, nearest
+//  to the view first.  The render thread picks up the finished cells.
+class GshhsCellLoader : public wxEvtHandler
+{
+public:
+    GshhsCellLoader( MappedFile *files, PolygonFileHeader *headers );
+    ~GshhsCellLoader();
+
+    bool IsRunning() const { return m_thread != NULL; }
+
+    //  Cells drawn with a stand in now, kept until built
+    void RequestVisible( const std::vector<int> &keys );
+    //  Cells which may be needed soon, replacing the previous list
+    void SetPrefetch( const std::vector<int> &keys );
+    //  Hands over the finished cells, the caller owns them
+    void TakeReady( std::vector<GshhsPolyCell *> &cells );
+    //  The viewport to build the opengl vertex caches for, if bvertexes
+    void SetVertexViewPort( const ViewPort &vp, bool bvertexes, bool bnewprojection );
+
+private:
+    friend class GshhsCellLoadThread;
+
+    bool NextRequest( int &key, ViewPort &vp, bool &bvertexes, int &generation );
+    void Finish( int key, int generation, GshhsPolyCell *cell );
+    void OnCellReady( wxThreadEvent &event );
+
+    MappedFile          *m_files;
+    PolygonFileHeader   *m_headers;
+
+    wxMutex             m_mutex;
+    wxCondition         m_cond;
+    std::deque<int>     m_visible, m_prefetch;
+    std::map<int, bool> m_queued;               // key -> requested visible
+    int                 m_building;             // key of the cell on the worker, or -1
+    bool                m_bbuilding_visible;
+    std::vector<GshhsPolyCell *> m_ready;
+    ViewPort            m_vp;
+    bool                m_bvertexes;
+    int                 m_generation;
+    bool                m_bexit;
+    bool                m_brefresh_pending;
+    GshhsCellLoadThread *m_thread;
+};
+
+class GshhsCellLoadThread : public wxThread
 {
-    fpoly = NULL;
+public:
+    GshhsCellLoadThread( GshhsCellLoader *loader )
+        : wxThread( wxTHREAD_JOINABLE ), m_loader( loader ) {}
 
-    for( int i = 0; i < 360; i++ ) {
-        for( int j = 0; j < 180; j++ ) {
-            allCells[i][j] = NULL;
+    void *Entry();
+
+private:
+    GshhsCellLoader     *m_loader;
+};
+
+void *GshhsCellLoadThread::Entry()
+{
+    SetPriority( WXTHREAD_MIN_PRIORITY );
+
+    int key, generation;
+    ViewPort vp;
+    bool bvertexes;
+    while( m_loader->NextRequest( key, vp, bvertexes, generation ) ) {
+        PERF_ZONE("GshhsCellLoadThread::BuildCell");
+
+        int quality = key / ( 360 * 180 ), x = key / 180 % 360, y = key % 180;
+        GshhsPolyCell *cel = new GshhsPolyCell( m_loader->m_files[quality], x, y - 90, quality,
+                                                &m_loader->m_headers[quality] );
+#ifdef ocpnUSE_GL
+        if( bvertexes ) {
+            // only mercator needs the special idl fixes, see drawGshhsPolyMapPlain
+            bool idl = x >= 180 && ( vp.m_projection_type == PROJECTION_MERCATOR ||
+                                     vp.m_projection_type == PROJECTION_EQUIRECTANGULAR );
+            cel->BuildPolyV( vp, idl );
         }
+#endif
+        m_loader->Finish( key, generation, cel );
     }
-    currentQuality = -1;
-    polyHeader.version = -1;
-    InitializeLoadQuality( quality );
+    return 0;
 }
 
-//-------------------------------------------------------------------------
-GshhsPolyReader::~GshhsPolyReader()
+GshhsCellLoader::GshhsCellLoader( MappedFile *files, PolygonFileHeader *headers )
+    : m_cond( m_mutex )
 {
-    for( int i = 0; i < 360; i++ ) {
-        for( int j = 0; j < 180; j++ ) {
-            if( allCells[i][j] != NULL ) {
-                delete allCells[i][j];
-                allCells[i][j] = NULL;
-            }
-        }
+    m_files = files;
+    m_headers = headers;
+    m_bvertexes = false;
+    m_generation = 0;
+    m_bexit = false;
+    m_brefresh_pending = false;
+    m_building = -1;
+    m_bbuilding_visible = false;
+
+    Connect( wxEVT_THREAD, wxThreadEventHandler( GshhsCellLoader::OnCellReady ) );
+
+    m_thread = new GshhsCellLoadThread( this );
+    if( m_thread->Create() != wxTHREAD_NO_ERROR || m_thread->Run() != wxTHREAD_NO_ERROR ) {
+        delete m_thread;
+        m_thread = NULL;
+    }
+}
+
+GshhsCellLoader::~GshhsCellLoader()
+{
+    {
+        wxMutexLocker lock( m_mutex );
+        m_bexit = true;
+        m_cond.Broadcast();
     }
 
-    if (fpoly) {
-        fclose(fpoly);
+    if( m_thread ) {
+        m_thread->Wait();
+        delete m_thread;
     }
+
+    for( unsigned int i = 0; i < m_ready.size(); i++ )
+        delete m_ready[i];
 }
 
-//-------------------------------------------------------------------------
-int GshhsPolyReader::ReadPolyVersion()
+void GshhsCellLoader::RequestVisible( const std::vector<int> &keys )
 {
-    wxString fname = GshhsReader::getFileName_Land( 0 );
-    if( fpoly ) fclose( fpoly );
-    fpoly = fopen( fname.mb_str(), "rb" );
+    if( keys.empty() )
+        return;
 
-    /* init header */
-    if( !fpoly ) return 0;
+    wxMutexLocker lock( m_mutex );
+    for( unsigned int i = 0; i < keys.size(); i++ ) {
+        if( keys[i] == m_building ) {
+            m_bbuilding_visible = true;
+            continue;
+        }
+        std::map<int, bool>::iterator it = m_queued.find( keys[i] );
+        if( it != m_queued.end() && it->second )
+            continue;
+        m_queued[keys[i]] = true;
+        m_visible.push_back( keys[i] );
+    }
+    m_cond.Signal();
+}
+
+void GshhsCellLoader::SetPrefetch( const std::vector<int> &keys )
+{
+    wxMutexLocker lock( m_mutex );
+
+    //  Forget what was only wanted for the previous view
+    for( unsigned int i = 0; i < m_prefetch.size(); i++ ) {
+        std::map<int, bool>::iterator it = m_queued.find( m_prefetch[i] );
+        if( it != m_queued.end() && !it->second )
+            m_queued.erase( it );
+    }
+    m_prefetch.clear();
 
-    readPolygonFileHeader( fpoly, &polyHeader );
+    for( unsigned int i = 0; i < keys.size(); i++ ) {
+        if( keys[i] == m_building || m_queued.count( keys[i] ) )
+            continue;
+        m_queued[keys[i]] = false;
+        m_prefetch.push_back( keys[i] );
+    }
+    if( !m_prefetch.empty() )
+        m_cond.Signal();
+}
 
-    return polyHeader.version;
+void GshhsCellLoader::TakeReady( std::vector<GshhsPolyCell *> &cells )
+{
+    wxMutexLocker lock( m_mutex );
+    cells.swap( m_ready );
+    m_ready.clear();
 }
 
-void GshhsPolyReader::InitializeLoadQuality( int quality )  // 5 levels: 0=low ... 4=full
+void GshhsCellLoader::SetVertexViewPort( const ViewPort &vp, bool bvertexes, bool bnewprojection )
+{
+    wxMutexLocker lock( m_mutex );
+    m_vp = vp;
+    m_bvertexes = bvertexes;
+    if( bnewprojection ) {
+        m_generation++;
+        for( unsigned int i = 0; i < m_ready.size(); i++ )
+            m_ready[i]->ClearPolyV();
+    }
+}
+
+bool GshhsCellLoader::NextRequest( int &key, ViewPort &vp, bool &bvertexes, int &generation )
+{
+    wxMutexLocker lock( m_mutex );
+
+    while( !m_bexit ) {
+        while( !m_visible.empty() || !m_prefetch.empty() ) {
+            std::deque<int> &q = m_visible.empty() ? m_prefetch : m_visible;
+            key = q.front();
+            q.pop_front();
+
+            //  Built already (duplicate entry), or no longer wanted
+            std::map<int, bool>::iterator it = m_queued.find( key );
+            if( it == m_queued.end() )
+                continue;
+            m_building = key;
+            m_bbuilding_visible = it->second;
+            m_queued.erase( it );
+
+            vp = m_vp;
+            bvertexes = m_bvertexes;
+            generation = m_generation;
+            return true;
+        }
+        m_cond.Wait();
+    }
+    return false;
+}
+
+void GshhsCellLoader::Finish( int key, int generation, GshhsPolyCell *cell )
 {
-    if( currentQuality != quality ) {
-        currentQuality = quality;
+    wxMutexLocker lock( m_mutex );
 
-        wxString fname = GshhsReader::getFileName_Land( quality );
+    bool bvisible = m_bbuilding_visible;
+    m_building = -1;
 
-        if( fpoly ) fclose( fpoly );
+    if( m_bexit ) {
+        delete cell;
+        return;
+    }
 
-        fpoly = fopen( fname.mb_str(), "rb" );
-        if( fpoly ) readPolygonFileHeader( fpoly, &polyHeader );
+    //  Vertexes for an old projection
+    if( generation != m_generation )
+        cell->ClearPolyV();
+    m_ready.push_back( cell );
 
+    //  Ask for one repaint at a time while the stand ins get replaced
+    if( bvisible && !m_brefresh_pending ) {
+        m_brefresh_pending = true;
+        QueueEvent( new wxThreadEvent() );
+    }
+}
+
+void GshhsCellLoader::OnCellReady( wxThreadEvent &event )
+{
+    {
+        wxMutexLocker lock( m_mutex );
+        m_brefresh_pending = false;
+    }
+    gFrame->InvalidateAllGL();
+}
+
+//========================================================================
+
+GshhsPolyReader::GshhsPolyReader( int quality )
+{
+    for( int q = 0; q < 5; q++ ) {
         for( int i = 0; i < 360; i++ ) {
             for( int j = 0; j < 180; j++ ) {
-                if( allCells[i][j] != NULL ) {
-                    delete allCells[i][j];
-                    allCells[i][j] = NULL;
-                }
+                allCells[q][i][j] = NULL;
             }
         }
+
+        polyHeaders[q].version = -1;
+        prefetchArea[q] = -1;
+
+        //  Mapping costs no reads, the pages come in as the cells are built
+        wxString fname = GshhsReader::getFileName_Land( q );
+        if( wxFile::Exists( fname ) && polyFiles[q].Open( fname ) &&
+            !readPolygonFileHeader( polyFiles[q], &polyHeaders[q] ) )
+            polyFiles[q].Close();
     }
+
+    residentBytes = 0;
+    frameCount = 0;
+    cellLoader = NULL;
+    bcellLoaderStarted = false;
+
+    currentQuality = -1;
+    InitializeLoadQuality( quality );
+}
+
+//-------------------------------------------------------------------------
+GshhsPolyReader::~GshhsPolyReader()
+{
+    delete cellLoader;
+
+    for( unsigned int i = 0; i < residentCells.size(); i++ )
+        delete residentCells[i];
+}
+
+//-------------------------------------------------------------------------
+int GshhsPolyReader::ReadPolyVersion()
+{
+    /* init header */
+    if( !polyFiles[0].IsOpened() ) return 0;
+
+    return polyHeaders[0].version;
+}
+
+void GshhsPolyReader::InitializeLoadQuality( int quality )  // 5 levels: 0=low ... 4=full
+{
+    //  The cells of the other qualities stay, see trimCells()
+    if( quality < 0 ) quality = 0;
+    else if( quality > 4 ) quality = 4;
+    currentQuality = quality;
+}
+
+GshhsPolyCell *GshhsPolyReader::newCell( int quality, int x, int y )
+{
+    return new GshhsPolyCell( polyFiles[quality], x, y - 90, quality, &polyHeaders[quality] );
+}
+
+//  Callers hold mutex1
+void GshhsPolyReader::addCell( GshhsPolyCell *cel )
+{
+    allCells[cel->getQuality()][cel->getX()][cel->getY() + 90] = cel;
+    residentCells.push_back( cel );
+    residentBytes += cel->getMemoryUsed();
 }
 
 static inline bool my_intersects( const wxLineF &line1, const wxLineF &line2 )
@@ -880,12 +1170,12 @@ bool GshhsPolyReader::crossing1( wxLineF trajectWorld )
 
         for( clat = clatmin; clat < clatmax; clat++ ) {
             int cloni = clonx/GSSH_SUBM, clati = (GSSH_SUBM*90+clat)/GSSH_SUBM;
-            GshhsPolyCell *&cel = allCells[cloni][clati];
+            GshhsPolyCell *&cel = allCells[currentQuality][cloni][clati];
             if(!cel) {
                 mutex1.Lock();
                 if(!cel) {
-                    /* load the needed cell from disk */
-                    cel = new GshhsPolyCell(fpoly, cloni, clati-90, &polyHeader);
+                    /* load the needed cell from the mapped file */
+                    addCell( newCell( currentQuality, cloni, clati ) );
                     wxASSERT( cel );
                 }
                 mutex1.Unlock();
@@ -946,18 +1236,183 @@ bool GshhsPolyReader::crossing1( wxLineF trajectWorld )
     return false;
 }
 
-void GshhsPolyReader::readPolygonFileHeader( FILE *polyfile, PolygonFileHeader *header )
+bool GshhsPolyReader::readPolygonFileHeader( const MappedFile &file, PolygonFileHeader *header )
 {
-    fseek( polyfile, 0, SEEK_SET );
-    if(fread( header, sizeof(PolygonFileHeader), 1, polyfile ) != 1)
+    const unsigned char *data = file.GetRange( 0, sizeof(PolygonFileHeader) );
+    if( data )
+        memcpy( header, data, sizeof(PolygonFileHeader) );
+    if( !data || header->pasx <= 0 || header->pasy <= 0 ) {
         wxLogMessage( _T("gshhs ReadPolygonFileHeader failed") );
+        return false;
+    }
+    return true;
+}
+
+//  The loaded cell.  For the opengl canvas, a cell not loaded yet is asked
+//  of the worker, and meanwhile the cell of the nearest loaded quality stands
+//  in, or NULL when there is none: nothing is read from the files here.
+//  The other callers still read a missing cell right away.
+GshhsPolyCell *GshhsPolyReader::getDrawCell( int x, int y, bool bplaceholder, std::vector<int> &requests )
+{
+    GshhsPolyCell *cel = allCells[currentQuality][x][y];
+    if( !cel && bplaceholder ) {
+        static const int nearest[] = { -1, 1, -2, 2, -3, 3, -4, 4 };
+        for( unsigned int i = 0; i < sizeof nearest / sizeof *nearest && !cel; i++ ) {
+            int q = currentQuality + nearest[i];
+            if( q >= 0 && q < 5 )
+                cel = allCells[q][x][y];
+        }
+        requests.push_back( GshhsCellKey( currentQuality, x, y ) );
+        if( !cel )
+            return NULL;                // drawn once the worker has it
+    }
+
+    if( !cel ) {
+        cel = newCell( currentQuality, x, y );
+        wxMutexLocker lock( mutex1 );
+        addCell( cel );
+    }
+
+    cel->lastUsed = frameCount;
+    return cel;
+}
+
+void GshhsPolyReader::adoptReadyCells()
+{
+    std::vector<GshhsPolyCell *> cells;
+    cellLoader->TakeReady( cells );
+
+    wxMutexLocker lock( mutex1 );
+    for( unsigned int i = 0; i < cells.size(); i++ ) {
+        GshhsPolyCell *cel = cells[i];
+        if( allCells[cel->getQuality()][cel->getX()][cel->getY() + 90] ) {
+            delete cel;
+            continue;
+        }
+        cel->lastUsed = frameCount;
+        addCell( cel );
+    }
+}
+
+void GshhsPolyReader::clearPolyV()
+{
+    residentBytes = 0;
+    for( unsigned int i = 0; i < residentCells.size(); i++ ) {
+        residentCells[i]->ClearPolyV();
+        residentBytes += residentCells[i]->getMemoryUsed();
+    }
+}
+
+//  Build the cells around the view for panning, and the visible cells of
+//  the neighbouring qualities for zooming, nearest to the center first
+void GshhsPolyReader::prefetchCells( int clonmin, int clonmax, int clatmin, int clatmax )
+{
+    int area[5] = { currentQuality, clonmin, clonmax, clatmin, clatmax };
+    if( !memcmp( area, prefetchArea, sizeof area ) )
+        return;
+    memcpy( prefetchArea, area, sizeof area );
+
+    double clon = ( clonmin + clonmax ) / 2., clat = ( clatmin + clatmax ) / 2.;
+    int mlon = wxMax( 1, ( clonmax - clonmin ) / 2 ), mlat = wxMax( 1, ( clatmax - clatmin ) / 2 );
+
+    std::vector<int> keys;
+    for( int pass = 0; pass < 3; pass++ ) {
+        int quality = currentQuality, margin_lon = mlon, margin_lat = mlat;
+        unsigned int limit = GSHHS_PREFETCH_CELLS;
+        if( pass > 0 ) {
+            quality = pass == 1 ? currentQuality + 1 : currentQuality - 1;
+            if( quality < 0 || quality > 4 || !polyFiles[quality].IsOpened() )
+                continue;
+            margin_lon = margin_lat = 0;
+            limit = GSHHS_PREFETCH_ZOOM_CELLS;
+        }
+
+        std::vector<std::pair<double, int> > order;
+        int lonmax = wxMin( clonmax + margin_lon, clonmin - margin_lon + 360 );
+        for( int lon = clonmin - margin_lon; lon < lonmax; lon++ ) {
+            int lonx = ( lon % 360 + 360 ) % 360;
+            for( int lat = wxMax( -90, clatmin - margin_lat ); lat < wxMin( 90, clatmax + margin_lat ); lat++ ) {
+                GshhsPolyCell *cel = allCells[quality][lonx][lat + 90];
+                if( cel ) {
+                    //  Keep what may be panned to
+                    cel->lastUsed = frameCount;
+                    continue;
+                }
+                double d = ( lon + .5 - clon ) * ( lon + .5 - clon ) + ( lat + .5 - clat ) * ( lat + .5 - clat );
+                order.push_back( std::make_pair( d, GshhsCellKey( quality, lonx, lat + 90 ) ) );
+            }
+        }
+
+        std::sort( order.begin(), order.end() );
+        for( unsigned int i = 0; i < order.size() && i < limit; i++ )
+            keys.push_back( order[i].second );
+    }
+
+    cellLoader->SetPrefetch( keys );
+}
+
+//  Drop the least recently drawn cells, those of the qualities not next to
+//  the current one first, until well under the budget.  Only drawing trims,
+//  the land crossing test has a reader of its own which is never drawn.
+void GshhsPolyReader::trimCells()
+{
+    if( residentBytes <= GSHHS_CELL_BUDGET_BYTES )
+        return;
+
+    std::vector<GshhsPolyCell *> order;
+    for( unsigned int i = 0; i < residentCells.size(); i++ )
+        if( residentCells[i]->lastUsed != frameCount )
+            order.push_back( residentCells[i] );
+
+    int quality = currentQuality;
+    std::sort( order.begin(), order.end(), [quality]( GshhsPolyCell *a, GshhsPolyCell *b ) {
+        bool afar = abs( a->getQuality() - quality ) > 1, bfar = abs( b->getQuality() - quality ) > 1;
+        if( afar != bfar )
+            return afar;
+        return a->lastUsed < b->lastUsed;
+    } );
+
+    wxMutexLocker lock( mutex1 );
+    unsigned int ntrim = 0;
+    for( ; ntrim < order.size() && residentBytes > GSHHS_CELL_BUDGET_BYTES / 4 * 3; ntrim++ ) {
+        GshhsPolyCell *cel = order[ntrim];
+        allCells[cel->getQuality()][cel->getX()][cel->getY() + 90] = NULL;
+        residentBytes -= cel->getMemoryUsed();
+    }
+
+    std::vector<GshhsPolyCell *> cells;
+    for( unsigned int i = 0; i < residentCells.size(); i++ ) {
+        GshhsPolyCell *cel = residentCells[i];
+        if( allCells[cel->getQuality()][cel->getX()][cel->getY() + 90] == cel )
+            cells.push_back( cel );
+    }
+    residentCells.swap( cells );
+
+    for( unsigned int i = 0; i < ntrim; i++ )
+        delete order[i];
 }
 
 //-------------------------------------------------------------------------
 void GshhsPolyReader::drawGshhsPolyMapPlain( ocpnDC &pnt, ViewPort &vp, wxColor const &seaColor,
                                              wxColor const &landColor )
 {
-    if( !fpoly ) return;
+    if( !polyFiles[currentQuality].IsOpened() ) return;
+
+    PERF_ZONE("GshhsPolyReader::drawGshhsPolyMapPlain");
+
+    //  The worker is only started by drawing, the land crossing reader needs none
+    if( !bcellLoaderStarted ) {
+        bcellLoaderStarted = true;
+        cellLoader = new GshhsCellLoader( polyFiles, polyHeaders );
+        if( !cellLoader->IsRunning() ) {
+            delete cellLoader;
+            cellLoader = NULL;
+        }
+    }
+
+    frameCount++;
+    if( cellLoader )
+        adoptReadyCells();
 
     pnt.SetPen( wxNullPen );
 
@@ -970,19 +1425,21 @@ void GshhsPolyReader::drawGshhsPolyMapPlain( ocpnDC &pnt, ViewPort &vp, wxColor
     if(clonmax >= 0) clonmax++;
     int dx, clon, clonx, clat;
     GshhsPolyCell *cel;
+    bool bgl = false;
 
     ViewPort nvp = vp;
 #ifdef ocpnUSE_GL
     if(!pnt.GetDC()) { // opengl
+        bgl = true;
+
         // clear cached data when the projection changes
+        bool bnewprojection = false;
         if(vp.m_projection_type != last_rendered_vp.m_projection_type ||
            (last_rendered_vp.m_projection_type == PROJECTION_POLAR &&
             last_rendered_vp.clat*vp.clat <= 0)) {
             last_rendered_vp = vp;
-            for(int clon = 0; clon<360; clon++)
-                for(int clat = 0; clat<180; clat++)
-                    if(allCells[clon][clat])
-                        allCells[clon][clat]->ClearPolyV();
+            clearPolyV();
+            bnewprojection = true;
         }
 #ifndef USE_ANDROID_GLES2
         glEnableClientState(GL_VERTEX_ARRAY);
@@ -995,8 +1452,11 @@ void GshhsPolyReader::drawGshhsPolyMapPlain( ocpnDC &pnt, ViewPort &vp, wxColor
              nvp = glChartCanvas::NormalizedViewPort(vp);
          }
 #endif
+        if( cellLoader )
+            cellLoader->SetVertexViewPort( nvp, true, bnewprojection );
     }
 #endif
+    std::vector<int> requests;
     for( clon = clonmin; clon < clonmax; clon++ ) {
         clonx = clon;
         while( clonx < 0 )
@@ -1006,13 +1466,10 @@ void GshhsPolyReader::drawGshhsPolyMapPlain( ocpnDC &pnt, ViewPort &vp, wxColor
 
         for( clat = clatmin; clat < clatmax; clat++ ) {
             if( clonx >= 0 && clonx <= 359 && clat >= -90 && clat <= 89 ) {
-                if( allCells[clonx][clat + 90] == NULL ) {
-                    cel = new GshhsPolyCell( fpoly, clonx, clat, &polyHeader );
-                    wxASSERT( cel );
-                    allCells[clonx][clat + 90] = cel;
-                } else {
-                    cel = allCells[clonx][clat + 90];
-                }
+                //  A stand in would stay until the next repaint, which only opengl asks for
+                cel = getDrawCell( clonx, clat + 90, bgl && cellLoader != NULL, requests );
+                if( !cel )
+                    continue;
                 bool idl = false;
 
                 // only mercator needs the special idl fixes
@@ -1035,7 +1492,9 @@ void GshhsPolyReader::drawGshhsPolyMapPlain( ocpnDC &pnt, ViewPort &vp, wxColor
                         dx = 0;
                 }
 
+                size_t memoryUsed = cel->getMemoryUsed();
                 cel->drawMapPlain( pnt, dx, nvp, seaColor, landColor, idl );
+                residentBytes += cel->getMemoryUsed() - memoryUsed;
             }
         }
     }
@@ -1049,18 +1508,25 @@ void GshhsPolyReader::drawGshhsPolyMapPlain( ocpnDC &pnt, ViewPort &vp, wxColor
     }
 #endif
 #endif
+
+    if( cellLoader ) {
+        cellLoader->RequestVisible( requests );
+        prefetchCells( clonmin, clonmax, clatmin, clatmax );
+    }
+    trimCells();
 }
 
 //-------------------------------------------------------------------------
 void GshhsPolyReader::drawGshhsPolyMapSeaBorders( ocpnDC &pnt, ViewPort &vp )
 {
-    if( !fpoly ) return;
+    if( !polyFiles[currentQuality].IsOpened() ) return;
     int clonmin, clonmax, clatmax, clatmin;  // cellules visibles
     LLBBox bbox = vp.GetBBox();
     clonmin = bbox.GetMinLon(), clonmax = bbox.GetMaxLon(), clatmin = bbox.GetMinLat(), clatmax = bbox.GetMaxLat();
 
     int dx, clon, clonx, clat;
     GshhsPolyCell *cel;
+    std::vector<int> requests;
 
     for( clon = clonmin; clon < clonmax; clon++ ) {
         clonx = clon;
@@ -1071,13 +1537,7 @@ void GshhsPolyReader::drawGshhsPolyMapSeaBorders( ocpnDC &pnt, ViewPort &vp )
 
         for( clat = clatmin; clat < clatmax; clat++ ) {
             if( clonx >= 0 && clonx <= 359 && clat >= -90 && clat <= 89 ) {
-                if( allCells[clonx][clat + 90] == NULL ) {
-                    cel = new GshhsPolyCell( fpoly, clonx, clat, &polyHeader );
-                    wxASSERT( cel );
-                    allCells[clonx][clat + 90] = cel;
-                } else {
-                    cel = allCells[clonx][clat + 90];
-                }
+                cel = getDrawCell( clonx, clat + 90, false, requests );
                 dx = clon - clonx;
                 cel->drawSeaBorderLines( pnt, dx, vp );
             }
@@ -52,10 +52,14 @@
 #include <wx/image.h>
 #include <wx/fileconf.h>
 #include <wx/mstream.h>
+#include <wx/stopwatch.h>
 #include <sys/stat.h>
 #include <sstream>
 #include <map>
 #include <unordered_map>
+#include <unordered_set>
+#include <deque>
+#include <vector>
 
 #include <sqlite3.h> //We need some defines
 #include <SQLiteCpp/SQLiteCpp.h>
@@ -64,6 +68,7 @@
 #include "chart1.h"
 #include "chcanv.h"
 #include "glChartCanvas.h"
+#include "mipmap/raster.h"
 
 //  Missing from MSW include files
 #ifdef _MSC_VER
@@ -259,6 +264,387 @@ public:
     std::unordered_map<unsigned int, mbTileDescriptor *> tileMap;
 };    
 
+//  Decoded tiles are kept until uploaded, up to this many bytes
+#define MBTILE_DECODE_CACHE_BYTES       (64 * 1024 * 1024)
+
+//  A queued request nobody asked for again within this time is dropped
+#define MBTILE_REQUEST_TIMEOUT_MS       1000
+
+//  Most tiles requested ahead for the next zoom level per render
+#define MBTILE_PREFETCH_MAX             64
+
+#define MBTILE_TEX_DIM                  256
+
+static const char *s_tileQuerySQL =
+    "select tile_data from tiles where zoom_level = ? AND tile_column = ? AND tile_row = ?";
+
+static inline uint64_t mbTileKey(int zoom, int x, int y)
+{
+    return ((uint64_t)zoom << 56) | ((uint64_t)(x & 0xfffffff) << 28) | (uint64_t)(y & 0xfffffff);
+}
+
+static double mbTileDimLevel(ColorScheme cs)
+{
+    switch( cs ){
+        case GLOBAL_COLOR_SCHEME_DUSK:
+            return 0.8;
+        case GLOBAL_COLOR_SCHEME_NIGHT:
+            return 0.3;
+        default:
+            return 1.0;
+    }
+}
+
+//  Fetch one tile with a prepared query and decode it to a malloced
+//  MBTILE_TEX_DIM square rgba image, dimmed for the color scheme.
+//  Returns NULL if the tile is not in the database (bmissing set) or
+//  cannot be decoded.  Safe to call from any thread that owns the query.
+static unsigned char *mbReadTileRGBA( SQLite::Statement &query, int zoom, int x, int y,
+                                      wxBitmapType &type, ColorScheme cs, bool &bmissing )
+{
+    bmissing = false;
+
+    query.reset();
+    query.bind(1, zoom);
+    query.bind(2, x);
+    query.bind(3, y);
+
+    if(!query.executeStep()){
+        bmissing = true;                        // requested ROW not found
+        return NULL;
+    }
+
+    SQLite::Column blobColumn = query.getColumn(0);
+    wxMemoryInputStream blobStream(blobColumn.getBlob(), blobColumn.getBytes());
+    wxImage blobImage(blobStream, type);
+    if(!blobImage.IsOk())
+        return NULL;
+    type = blobImage.GetType();
+
+    if(blobImage.GetWidth() != MBTILE_TEX_DIM || blobImage.GetHeight() != MBTILE_TEX_DIM)
+        blobImage.Rescale(MBTILE_TEX_DIM, MBTILE_TEX_DIM);
+
+    int npixels = MBTILE_TEX_DIM * MBTILE_TEX_DIM;
+    unsigned char *imgdata = blobImage.GetData();
+
+    //  Scaling the hsv value keeps hue and saturation, which is
+    //  the same as scaling each of r, g and b directly
+    if( (cs != GLOBAL_COLOR_SCHEME_RGB) && (cs != GLOBAL_COLOR_SCHEME_DAY) )
+        Raster_Dim_24( npixels, imgdata, (int)(mbTileDimLevel(cs) * 256) );
+
+    unsigned char *teximage = (unsigned char *) malloc( 4 * npixels );
+    if(!teximage)
+        return NULL;
+    unsigned char *alpha = blobImage.HasAlpha() ? blobImage.GetAlpha() : NULL;
+
+    // Some NOAA Tilesets do not give transparent tiles, so we detect NOAA's idea of blank
+    // as RGB(1,0,0) and force  alpha = 0;
+    Raster_RGB24_RGBA32( npixels, imgdata, alpha, 0x000001, teximage );
+
+    return teximage;
+}
+
+class mbTileDecodeThread;
+
+//  Fetches and decodes tiles on worker threads, each with its own
+//  database connection and prepared query, into a bounded cache of
+//  rgba images.  The render thread only uploads tiles which are ready.
+class mbTileDecoder : public wxEvtHandler
+{
+public:
+    enum TileState { TILE_PENDING, TILE_READY, TILE_MISSING };
+
+    mbTileDecoder(const wxString &path, wxBitmapType type, ColorScheme cs);
+    ~mbTileDecoder();
+
+    bool IsRunning() const { return !m_threads.empty(); }
+
+    //  Hands over a decoded tile (caller frees) if there is one
+    TileState Take(int zoom, int x, int y, unsigned char **rgba);
+    void Request(int zoom, int x, int y, bool bvisible);
+    void SetColorScheme(ColorScheme cs);
+
+private:
+    friend class mbTileDecodeThread;
+
+    struct TileRequest {
+        uint64_t key;
+        int zoom, x, y;
+        bool bvisible;
+    };
+
+    bool NextRequest(TileRequest &req, ColorScheme &cs, int &generation);
+    void Finish(const TileRequest &req, int generation, unsigned char *rgba);
+    void Clear();
+    void OnTileReady(wxThreadEvent &event);
+
+    wxMutex             m_mutex;
+    wxCondition         m_cond;
+    std::deque<TileRequest> m_visible, m_prefetch;
+    std::unordered_map<uint64_t, wxLongLong> m_queued;      // key -> last request time
+    std::unordered_map<uint64_t, unsigned char *> m_ready;
+    std::deque<uint64_t> m_ready_order;
+    std::unordered_set<uint64_t> m_missing;
+    size_t              m_ready_bytes;
+    ColorScheme         m_cs;
+    int                 m_generation;
+    bool                m_bexit;
+    bool                m_brefresh_pending;
+    std::vector<mbTileDecodeThread *> m_threads;
+};
+
+class mbTileDecodeThread : public wxThread
+{
+public:
+    mbTileDecodeThread(mbTileDecoder *decoder, SQLite::Database *db, wxBitmapType type)
+        : wxThread(wxTHREAD_JOINABLE), m_decoder(decoder), m_db(db), m_type(type) {}
+    ~mbTileDecodeThread() { delete m_db; }
+
+    void *Entry();
+
+private:
+    mbTileDecoder       *m_decoder;
+    SQLite::Database    *m_db;
+    wxBitmapType        m_type;
+};
+
+void *mbTileDecodeThread::Entry()
+{
+    SetPriority( WXTHREAD_MIN_PRIORITY );
+
+    SQLite::Statement *query = NULL;
+    try {
+        query = new SQLite::Statement(*m_db, s_tileQuerySQL);
+    }
+    catch (std::exception& e) {
+        wxLogMessage("mbtiles exception: %s", e.what());
+    }
+
+    mbTileDecoder::TileRequest req;
+    ColorScheme cs;
+    int generation;
+    while(m_decoder->NextRequest(req, cs, generation)) {
+        unsigned char *rgba = NULL;
+        bool bmissing;
+        if(query) {
+            try {
+                rgba = mbReadTileRGBA(*query, req.zoom, req.x, req.y, m_type, cs, bmissing);
+            }
+            catch (std::exception& e) {
+                wxLogMessage("mbtiles exception: %s", e.what());
+            }
+        }
+        m_decoder->Finish(req, generation, rgba);
+    }
+
+    delete query;
+    return 0;
+}
+
+mbTileDecoder::mbTileDecoder(const wxString &path, wxBitmapType type, ColorScheme cs)
+    : m_cond(m_mutex)
+{
+    m_ready_bytes = 0;
+    m_cs = cs;
+    m_generation = 0;
+    m_bexit = false;
+    m_brefresh_pending = false;
+
+    Connect(wxEVT_THREAD, wxThreadEventHandler(mbTileDecoder::OnTileReady));
+
+    int nthreads = wxMax(1, wxMin(4, wxThread::GetCPUCount() - 1));
+
+    const char *name_UTF8 = "";
+    wxCharBuffer utf8CB = path.ToUTF8();
+    if ( utf8CB.data() )
+        name_UTF8 = utf8CB.data();
+
+    for(int i=0 ; i < nthreads ; i++){
+        SQLite::Database *db;
+        try {
+            db = new SQLite::Database(name_UTF8);
+            db->exec("PRAGMA cache_size=-10000");
+        }
+        catch (std::exception& e) {
+            wxLogMessage("mbtiles exception: %s", e.what());
+            break;
+        }
+
+        mbTileDecodeThread *thread = new mbTileDecodeThread(this, db, type);
+        if(thread->Create() != wxTHREAD_NO_ERROR || thread->Run() != wxTHREAD_NO_ERROR) {
+            delete thread;
+            break;
+        }
+        m_threads.push_back(thread);
+    }
+}
+
+mbTileDecoder::~mbTileDecoder()
+{
+    {
+        wxMutexLocker lock(m_mutex);
+        m_bexit = true;
+        m_cond.Broadcast();
+    }
+
+    for(unsigned int i=0 ; i < m_threads.size() ; i++){
+        m_threads[i]->Wait();
+        delete m_threads[i];
+    }
+
+    Clear();
+}
+
+void mbTileDecoder::Clear()
+{
+    for (auto const &it : m_ready)
+        free(it.second);
+    m_ready.clear();
+    m_ready_order.clear();
+    m_ready_bytes = 0;
+
+    m_visible.clear();
+    m_prefetch.clear();
+    m_queued.clear();
+    m_missing.clear();
+}
+
+mbTileDecoder::TileState mbTileDecoder::Take(int zoom, int x, int y, unsigned char **rgba)
+{
+    uint64_t key = mbTileKey(zoom, x, y);
+    wxMutexLocker lock(m_mutex);
+
+    auto it = m_ready.find(key);
+    if(it != m_ready.end()) {
+        *rgba = it->second;
+        m_ready_bytes -= 4 * MBTILE_TEX_DIM * MBTILE_TEX_DIM;
+        m_ready.erase(it);
+        return TILE_READY;
+    }
+
+    if(m_missing.erase(key))
+        return TILE_MISSING;
+
+    return TILE_PENDING;
+}
+
+void mbTileDecoder::Request(int zoom, int x, int y, bool bvisible)
+{
+    uint64_t key = mbTileKey(zoom, x, y);
+    wxMutexLocker lock(m_mutex);
+
+    if(m_ready.count(key) || m_missing.count(key))
+        return;
+
+    //  Queue again if it was only a prefetch, or just refresh the request time
+    bool bqueued = m_queued.count(key) > 0;
+    m_queued[key] = wxGetLocalTimeMillis();
+    if(bqueued && !bvisible)
+        return;
+
+    TileRequest req = { key, zoom, x, y, bvisible };
+    if(bvisible)
+        m_visible.push_back(req);
+    else
+        m_prefetch.push_back(req);
+
+    m_cond.Signal();
+}
+
+void mbTileDecoder::SetColorScheme(ColorScheme cs)
+{
+    wxMutexLocker lock(m_mutex);
+    Clear();
+    m_cs = cs;
+    m_generation++;
+}
+
+bool mbTileDecoder::NextRequest(TileRequest &req, ColorScheme &cs, int &generation)
+{
+    wxMutexLocker lock(m_mutex);
+
+    while(!m_bexit) {
+        wxLongLong now = wxGetLocalTimeMillis();
+        while(!m_visible.empty() || !m_prefetch.empty()) {
+            std::deque<TileRequest> &q = m_visible.empty() ? m_prefetch : m_visible;
+            req = q.front();
+            q.pop_front();
+
+            //  Already decoded (duplicate entry), or no longer wanted
+            auto it = m_queued.find(req.key);
+            if(it == m_queued.end())
+                continue;
+            bool bstale = now - it->second > MBTILE_REQUEST_TIMEOUT_MS;
+            m_queued.erase(it);
+            if(bstale)
+                continue;
+
+            cs = m_cs;
+            generation = m_generation;
+            return true;
+        }
+        m_cond.Wait();
+    }
+    return false;
+}
+
+void mbTileDecoder::Finish(const TileRequest &req, int generation, unsigned char *rgba)
+{
+    wxMutexLocker lock(m_mutex);
+
+    //  Decoded for an old color scheme
+    if(generation != m_generation || m_bexit) {
+        free(rgba);
+        return;
+    }
+
+    //  Undecodable tiles are reported missing too, so they are not retried
+    if(!rgba)
+        m_missing.insert(req.key);
+    else {
+        if(m_ready.count(req.key)) {
+            free(rgba);
+            return;
+        }
+        m_ready[req.key] = rgba;
+        m_ready_order.push_back(req.key);
+        m_ready_bytes += 4 * MBTILE_TEX_DIM * MBTILE_TEX_DIM;
+
+        //  Drop the oldest tiles that were never picked up
+        while(m_ready_bytes > MBTILE_DECODE_CACHE_BYTES && !m_ready_order.empty()) {
+            auto it = m_ready.find(m_ready_order.front());
+            m_ready_order.pop_front();
+            if(it != m_ready.end()) {
+                free(it->second);
+                m_ready.erase(it);
+                m_ready_bytes -= 4 * MBTILE_TEX_DIM * MBTILE_TEX_DIM;
+            }
+        }
+        if(m_ready_order.size() > 2 * m_ready.size() + 64) {
+            std::deque<uint64_t> order;
+            for(auto key : m_ready_order)
+                if(m_ready.count(key))
+                    order.push_back(key);
+            m_ready_order.swap(order);
+        }
+    }
+
+    //  Ask for one repaint at a time when visible tiles come in
+    if(req.bvisible && !m_brefresh_pending && !m_bexit) {
+        m_brefresh_pending = true;
+        QueueEvent(new wxThreadEvent());
+    }
+}
+
+void mbTileDecoder::OnTileReady(wxThreadEvent &event)
+{
+    {
+        wxMutexLocker lock(m_mutex);
+        m_brefresh_pending = false;
+    }
+    gFrame->InvalidateAllGL();
+}
+
 
 
 
@@ -305,12 +691,16 @@ ChartMBTiles::ChartMBTiles()
       pfc->Read ( _T ( "DebugMBTiles" ),  &m_b_cdebug, 0 );
 #endif
       m_pDB = NULL;
+      m_pTileQuery = NULL;
+      m_pDecoder = NULL;
 
 }
 
 ChartMBTiles::~ChartMBTiles()
 {
     FlushTiles();
+    delete m_pDecoder;
+    delete m_pTileQuery;
     if(m_pDB){
         delete m_pDB;
     }
@@ -684,7 +1074,15 @@ InitReturn ChartMBTiles::PostInit(void)
           name_UTF8 = utf8CB.data();
 
       m_pDB = new SQLite::Database(name_UTF8);
-      m_pDB->exec("PRAGMA locking_mode=EXCLUSIVE");
+
+      //  Tiles are normally read by the decoder's own connections, so only
+      //  take the database exclusively when this one does all the reading
+      m_pDecoder = new mbTileDecoder(m_FullPath, m_imageType, m_global_color_scheme);
+      if(!m_pDecoder->IsRunning()){
+          delete m_pDecoder;
+          m_pDecoder = NULL;
+          m_pDB->exec("PRAGMA locking_mode=EXCLUSIVE");
+      }
       m_pDB->exec("PRAGMA cache_size=-50000");
 
       bReadyToRender = true;
@@ -780,6 +1178,8 @@ void ChartMBTiles::SetColorScheme(ColorScheme cs, bool bApplyImmediate)
     if(m_global_color_scheme != cs){
         m_global_color_scheme = cs;
         FlushTextures();
+        if(m_pDecoder)
+            m_pDecoder->SetColorScheme(cs);
     }
 }
 
@@ -817,132 +1217,88 @@ bool ChartMBTiles::getTileTexture( mbTileDescriptor *tile)
         
         return true;
     }
+
+    if(!tile->m_bAvailable)
+        return false;
+
+    unsigned char *teximage = NULL;
+    if(m_pDecoder){
+        // upload it if the decoder has it ready, otherwise ask for it
+        switch(m_pDecoder->Take(tile->m_zoomLevel, tile->tile_x, tile->tile_y, &teximage)){
+            case mbTileDecoder::TILE_MISSING:
+                tile->m_bAvailable = false;
+                return false;
+            case mbTileDecoder::TILE_PENDING:
+                m_pDecoder->Request(tile->m_zoomLevel, tile->tile_x, tile->tile_y, true);
+                return false;
+            default:
+                break;
+        }
+    }
     else{
-        if(!tile->m_bAvailable)
-            return false;
         // fetch the tile data from the mbtile database
         try
         {
-          
-            char qrs[2100];
-            sprintf(qrs, "select tile_data, length(tile_data) from tiles where zoom_level = %d AND tile_column=%d AND tile_row=%d", tile->m_zoomLevel, tile->tile_x, tile->tile_y);
-            
-            // Compile a SQL query, getting the specific  blob
-            SQLite::Statement query(*m_pDB, qrs);
-            
-            int queryResult = query.tryExecuteStep();
-            if(SQLITE_DONE == queryResult){
-                tile->m_bAvailable = false;
-                return false;                           // requested ROW not found, should never happen
-            }
-            else{
-                SQLite::Column blobColumn = query.getColumn(0);         // Get the blob
-                const void* blob = blobColumn.getBlob();
-                
-                int length = query.getColumn(1);         // Get the length
-                
-                wxMemoryInputStream blobStream(blob, length);
-                wxImage blobImage;
-
-                blobImage = wxImage(blobStream, m_imageType);
-                
-                int blobWidth = blobImage.GetWidth();
-                int blobHeight = blobImage.GetHeight();
-                unsigned char *imgdata = blobImage.GetData();
-                
-                if( (m_global_color_scheme != GLOBAL_COLOR_SCHEME_RGB) && (m_global_color_scheme != GLOBAL_COLOR_SCHEME_DAY) ){
-                    double dimLevel;
-                    switch( m_global_color_scheme ){
-                        case GLOBAL_COLOR_SCHEME_DUSK: {
-                            dimLevel = 0.8;
-                            break;
-                        }
-                        case GLOBAL_COLOR_SCHEME_NIGHT: {
-                            dimLevel = 0.3;
-                            break;
-                        }
-                        default: {
-                            dimLevel = 1.0;
-                            break;
-                        }
-                    }
-
-//                      for( int iy = 0; iy < blobHeight; iy++ ) {
-//                           for( int ix = 0; ix < blobWidth; ix++ ) {
-//                                  wxImage::RGBValue rgb( blobImage.GetRed( ix, iy ), blobImage.GetGreen( ix, iy ), blobImage.GetBlue( ix, iy ) );
-//                                  wxImage::HSVValue hsv = wxImage::RGBtoHSV( rgb );
-//                                  hsv.value = hsv.value * dimLevel;
-//                                  wxImage::RGBValue nrgb = wxImage::HSVtoRGB( hsv );
-//                                  blobImage.SetRGB( ix, iy, nrgb.red, nrgb.green, nrgb.blue );
-//                           }
-//                      }
-                     
-                     for( int j = 0; j < blobHeight*blobWidth; j++ ){
-                         unsigned char *d = &imgdata[3*j];
-                         wxImage::RGBValue rgb( *d, *(d+1), *(d+2) );
-                         wxImage::HSVValue hsv = wxImage::RGBtoHSV( rgb );
-                         hsv.value = hsv.value * dimLevel;
-                         wxImage::RGBValue nrgb = wxImage::HSVtoRGB( hsv );
-                         *d = nrgb.red; *(d+1) = nrgb.green; *(d+2) = nrgb.blue; 
-                     }
- 
-                }
-                    
-                
-                int stride = 4;
-                int tex_w = 256;
-                int tex_h = 256;
-                if( !imgdata )
-                    return false;
-                m_imageType = blobImage.GetType();
-
-                unsigned char *teximage = (unsigned char *) malloc( stride * tex_w * tex_h );
-                bool transparent = blobImage.HasAlpha();
-                
-                for( int j = 0; j < tex_w*tex_h; j++ ){
-                    for( int k = 0; k < 3; k++ )
-                        teximage[j * stride + k] = imgdata[3*j + k];
-                    
-                    // Some NOAA Tilesets do not give transparent tiles, so we detect NOAA's idea of blank
-                    // as RGB(1,0,0) and force  alpha = 0;
-                    if( imgdata[3*j] == 1 && imgdata[3*j + 1] == 0 && imgdata[3*j+2] == 0) {
-                        teximage[j * stride + 3] = 0;
-                    } else {
-                        if( transparent ) {
-                            teximage[j * stride + 3] = blobImage.GetAlpha(j % tex_w, j / tex_w);
-                        } else {
-                            teximage[j * stride + 3] = 255;
-                        }
-                    }
-                }
-                
-                    
-                glGenTextures( 1, &tile->glTextureName );
-                glBindTexture( GL_TEXTURE_2D, tile->glTextureName );
-                
-                glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE );
-                glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE );
-                glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR );
-                glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR );
-
-                glTexImage2D( GL_TEXTURE_2D, 0, GL_RGBA, tex_w, tex_h, 0, GL_RGBA, GL_UNSIGNED_BYTE, teximage );
-                
-                free(teximage);
-                
-                return true;
-            }
-            
+            if(!m_pTileQuery)
+                m_pTileQuery = new SQLite::Statement(*m_pDB, s_tileQuerySQL);
+
+            bool bmissing;
+            teximage = mbReadTileRGBA(*m_pTileQuery, tile->m_zoomLevel, tile->tile_x, tile->tile_y,
+                                      m_imageType, m_global_color_scheme, bmissing);
+            if(bmissing)
+                tile->m_bAvailable = false;                     // requested ROW not found, should never happen
         }
         catch (std::exception& e)
         {
-            const char *t = e.what();
             wxLogMessage("mbtiles exception: %s", e.what());
-        }     
+        }
     }
-        
-        
+
+    if(!teximage)
+        return false;
+
+    glGenTextures( 1, &tile->glTextureName );
+    glBindTexture( GL_TEXTURE_2D, tile->glTextureName );
     
-    return false;
+    glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE );
+    glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE );
+    glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR );
+    glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR );
+
+    glTexImage2D( GL_TEXTURE_2D, 0, GL_RGBA, MBTILE_TEX_DIM, MBTILE_TEX_DIM, 0, GL_RGBA, GL_UNSIGNED_BYTE, teximage );
+    
+    free(teximage);
+    
+    return true;
+}
+
+void ChartMBTiles::PrefetchZoom( int zoomFactor, const LLBBox &box )
+{
+    mbTileZoomDescriptor *tzd = m_tileArray[zoomFactor - m_minZoom];
+
+    int topTile =   wxMin(tzd->tile_y_max, lat2tiley(box.GetMaxLat(), zoomFactor));
+    int botTile =   wxMax(tzd->tile_y_min, lat2tiley(box.GetMinLat(), zoomFactor));
+    int leftTile =  long2tilex(box.GetMinLon(), zoomFactor);
+    int rightTile = long2tilex(box.GetMaxLon(), zoomFactor);
+
+    int count = 0;
+    for(int i=botTile ; i <= topTile ; i++){
+        for(int j = leftTile ; j <= rightTile ; j++){
+            if( (tzd->tile_x_max >= tzd->tile_x_min) && ((j > tzd->tile_x_max) || (j < tzd->tile_x_min)) )
+                continue;
+
+            // skip tiles already on the gpu or known to be absent
+            unsigned int index = ((i- tzd->tile_y_min) * (tzd->nx_tile + 1)) + j;
+            auto it = tzd->tileMap.find(index);
+            if(it != tzd->tileMap.end() &&
+               (it->second->glTextureName > 0 || !it->second->m_bAvailable))
+                continue;
+
+            if(count++ >= MBTILE_PREFETCH_MAX)
+                return;
+            m_pDecoder->Request(zoomFactor, j, i, false);
+        }
+    }
 }
 
 class wxPoint2DDouble;
@@ -1218,6 +1574,10 @@ bool ChartMBTiles::RenderRegionViewOnGL(const wxGLContext &glc, const ViewPort&
         zoomFactor++;
     }
     
+    // decode the next zoom level ahead of a zoom in
+    if(m_pDecoder && !btwoPass && viewZoom < m_maxZoom)
+        PrefetchZoom(viewZoom + 1, box);
+
     glDisable(GL_TEXTURE_2D);
     
     m_zoomScaleFactor = 2.0 * OSM_zoomMPP[maxrenZoom] * VPoint.view_scale_ppm;
@@ -38,6 +38,7 @@
 #include "OCPN_SignalKEvent.h"
 #include "datastream.h"
 #include "SerialDataStream.h"
+#include "PerfTrace.h"
 
 extern PlugInManager    *g_pi_manager;
 extern wxString         g_GPS_Ident;
@@ -242,6 +243,8 @@ void Multiplexer::SetGPSHandler(wxEvtHandler *handler)
 
 void Multiplexer::OnEvtStream(OCPN_DataStreamEvent& event)
 {
+    PERF_ZONE("Multiplexer::OnEvtStream");
+
     wxString message = event.ProcessNMEA4Tags();
     
     DataStream *stream = event.GetStream();
@@ -50,6 +50,7 @@
 #include <time.h>
 #include <locale>
 #include <list>
+#include <string>
 
 #include <wx/listimpl.cpp>
 #include <wx/progdlg.h>
@@ -81,6 +82,7 @@
 #include "Track.h"
 #include "chartdb.h"
 #include "CanvasConfig.h"
+#include "StartupTasks.h"
 
 #include "s52plib.h"
 #include "cm93.h"
@@ -149,6 +151,7 @@ extern bool             g_bopengl;
 extern bool             g_bdisable_opengl;
 extern bool             g_bSoftwareGL;
 extern bool             g_bShowFPS;
+extern bool             g_bShowFrameStats;
 extern bool             g_bsmoothpanzoom;
 extern bool             g_fog_overzoom;
 extern double           g_overzoom_emphasis_base;
@@ -495,6 +498,7 @@ MyConfig::MyConfig( const wxString &LocalFileName ) :
     m_sNavObjSetChangesFile = m_sNavObjSetFile + _T ( ".changes" );
 
     m_pNavObjectInputSet = NULL;
+    m_bNavObjectInputLoaded = false;
     m_pNavObjectChangesSet = NULL;
 
     m_bSkipChangeSetUpdate = false;
@@ -573,6 +577,13 @@ int MyConfig::LoadMyConfig()
     g_GLOptions.m_GLLineSmoothing = true;
     g_GLOptions.m_iTextureDimension = 512;
     g_GLOptions.m_iTextureMemorySize = 128;
+    g_GLOptions.m_iTexturePrefetchPercent = 25;
+#if defined(__OCPN__ANDROID__) || defined(__arm__) || defined(__aarch64__)
+    g_GLOptions.m_iMaxFrameRate = 30;           // tablets and small boards, spare the battery
+#else
+    g_GLOptions.m_iMaxFrameRate = 60;
+#endif
+    g_GLOptions.m_bAdaptiveQuality = true;
     if(!g_bGLexpert){
         g_GLOptions.m_iTextureMemorySize = wxMax(128, g_GLOptions.m_iTextureMemorySize);
         g_GLOptions.m_bTextureCompressionCaching = g_GLOptions.m_bTextureCompression;
@@ -868,6 +879,7 @@ int MyConfig::LoadMyConfigRaw( bool bAsTemplate )
     Read( _T ( "SkewToNorthUp" ), &g_bskew_comp );
     
     Read( _T ( "ShowFPS" ), &g_bShowFPS );
+    Read( _T ( "ShowFrameStats" ), &g_bShowFrameStats );
     
     Read( _T( "NMEAAPBPrecision" ), &g_NMEAAPBPrecision );
     
@@ -886,6 +898,9 @@ int MyConfig::LoadMyConfigRaw( bool bAsTemplate )
         Read( _T ( "LineSmoothing" ), &g_GLOptions.m_GLLineSmoothing);
         Read( _T ( "GPUTextureDimension" ), &g_GLOptions.m_iTextureDimension );
         Read( _T ( "GPUTextureMemSize" ), &g_GLOptions.m_iTextureMemorySize );
+        Read( _T ( "GPUTexturePrefetchPercent" ), &g_GLOptions.m_iTexturePrefetchPercent );
+        Read( _T ( "MaxFrameRate" ), &g_GLOptions.m_iMaxFrameRate );
+        Read( _T ( "AdaptiveQuality" ), &g_GLOptions.m_bAdaptiveQuality );
         Read( _T ( "DebugOpenGL" ), &g_bDebugOGL );
         Read( _T ( "OpenGL" ), &g_bopengl );
         Read( _T ( "SoftwareGL" ), &g_bSoftwareGL );
@@ -1588,22 +1603,47 @@ void MyConfig::LoadS57Config()
     }
 }
 
+void MyConfig::PreloadNavObjects()
+{
+    if( m_pNavObjectInputSet || !::wxFileExists( m_sNavObjSetFile ) )
+        return;
+
+    //  Only the XML parse is done by the worker, the objects are made by LoadNavObjects()
+    NavObjectCollection1 *pSet = new NavObjectCollection1();
+    m_pNavObjectInputSet = pSet;
+#ifdef __WXMSW__
+    std::wstring path( m_sNavObjSetFile.fn_str() );
+#else
+    std::string path( m_sNavObjSetFile.fn_str() );
+#endif
+    bool *ploaded = &m_bNavObjectInputLoaded;
+
+    StartupTasks::Get().Start( _T("navobj.xml parse"), [pSet, path, ploaded]() {
+        *ploaded = pSet->load_file( path.c_str() );
+    });
+}
+
 void MyConfig::LoadNavObjects()
 {
     //      next thing to do is read tracks, etc from the NavObject XML file,
     wxLogMessage( _T("Loading navobjects from navobj.xml") );
     CreateRotatingNavObjBackup();
 
-    if( NULL == m_pNavObjectInputSet )
+    StartupTasks::Get().Wait( _T("navobj.xml parse") );
+    if( NULL == m_pNavObjectInputSet ) {
         m_pNavObjectInputSet = new NavObjectCollection1();
+        m_bNavObjectInputLoaded = ::wxFileExists( m_sNavObjSetFile ) &&
+            m_pNavObjectInputSet->load_file( m_sNavObjSetFile.fn_str() );
+    }
 
     int wpt_dups = 0;
-    if( ::wxFileExists( m_sNavObjSetFile ) &&
-        m_pNavObjectInputSet->load_file( m_sNavObjSetFile.fn_str() ) )
+    if( m_bNavObjectInputLoaded )
         m_pNavObjectInputSet->LoadAllGPXObjects(false, wpt_dups);
 
     wxLogMessage( _T("Done loading navobjects, %d duplicate waypoints ignored"), wpt_dups );
     delete m_pNavObjectInputSet;
+    m_pNavObjectInputSet = NULL;
+    m_bNavObjectInputLoaded = false;
 
     if( ::wxFileExists( m_sNavObjSetChangesFile ) ) {
 
@@ -2318,6 +2358,7 @@ void MyConfig::UpdateSettings()
     Write( _T ( "OpenGL" ), g_bopengl );
     Write( _T ( "SoftwareGL" ), g_bSoftwareGL );
     Write( _T ( "ShowFPS" ), g_bShowFPS );
+    Write( _T ( "ShowFrameStats" ), g_bShowFrameStats );
     
     Write( _T ( "ZoomDetailFactor" ), g_chart_zoom_modifier );
     Write( _T ( "ZoomDetailFactorVector" ), g_chart_zoom_modifier_vector );
@@ -2336,6 +2377,9 @@ void MyConfig::UpdateSettings()
     Write( _T ( "GPUTextureCompressionCaching" ), g_GLOptions.m_bTextureCompressionCaching);
     Write( _T ( "GPUTextureDimension" ), g_GLOptions.m_iTextureDimension );
     Write( _T ( "GPUTextureMemSize" ), g_GLOptions.m_iTextureMemorySize );
+    Write( _T ( "GPUTexturePrefetchPercent" ), g_GLOptions.m_iTexturePrefetchPercent );
+    Write( _T ( "MaxFrameRate" ), g_GLOptions.m_iMaxFrameRate );
+    Write( _T ( "AdaptiveQuality" ), g_GLOptions.m_bAdaptiveQuality );
     Write( _T ( "PolygonSmoothing" ), g_GLOptions.m_GLPolygonSmoothing);
     Write( _T ( "LineSmoothing" ), g_GLOptions.m_GLLineSmoothing);
 #endif
@@ -48,6 +48,7 @@
 #include <wx/app.h>
 #include <wx/hashset.h>
 #include <wx/hashmap.h>
+#include <wx/textfile.h>
 #ifndef __WXMSW__
 #include <cxxabi.h>
 #endif // __WXMSW__
@@ -77,6 +78,10 @@
 #include <sstream>
 #include <fstream>
 #include <unordered_map>
+#include <atomic>
+#include <map>
+#include <system_error>
+#include <thread>
 #include "config.h"
 #include "SoundFactory.h"
 #include "dychart.h"
@@ -110,6 +115,7 @@
 #include "mygeom.h"
 #include "OCPNPlatform.h"
 #include "PluginPaths.h"
+#include "PluginSnapshot.h"
 #include "toolbar.h"
 #include "Track.h"
 #include "Route.h"
@@ -119,6 +125,7 @@
 #include "download_mgr.h"
 #include "catalog_handler.h"
 #include "semantic_vers.h"
+#include "MappedFile.h"
 
 #ifdef __OCPN__ANDROID__
 #include "androidUTIL.h"
@@ -154,6 +161,7 @@ extern RouteManagerDialog *pRouteManagerDialog;
 extern RouteList       *pRouteList;
 extern TrackList       *pTrackList;
 extern PlugInManager   *g_pi_manager;
+extern bool             bGPSValid;
 extern s52plib         *ps52plib;
 extern wxString         ChartListFileName;
 extern bool             g_boptionsactive;
@@ -635,10 +643,12 @@ PlugInManager::PlugInManager(MyFrame *parent)
 #endif
     
     m_benable_blackdialog_done = false;
+    m_manifest = NULL;
 }
 
 PlugInManager::~PlugInManager()
 {
+    delete m_manifest;
 #ifdef OCPN_USE_CURL
     #ifndef __OCPN__ANDROID__
     wxCurlBase::Shutdown();
@@ -708,6 +718,145 @@ static void setLoadPath()
 } 
 
 
+//  What was learned about each plugin library the last time it was probed,
+//  so unchanged libraries are not scanned again.  Kept in the private data
+//  directory, and discarded by any other build of OpenCPN or of wxWidgets.
+class PluginManifest
+{
+public:
+    enum State { PLUGIN_LOADABLE, PLUGIN_INCOMPATIBLE, PLUGIN_UNLOADABLE };
+
+    struct Entry
+    {
+        wxULongLong     size;
+        time_t          mtime;
+        int             state;
+    };
+
+    PluginManifest() : m_bdirty(false) {}
+
+    void Load();
+    void Save();
+
+    //  The entry of file, if the file is unchanged since
+    const Entry *Find(const wxString &file, wxULongLong size, time_t mtime) const;
+    void Set(const wxString &file, const Entry &entry);
+
+private:
+    static wxString GetFileName();
+    static wxString GetHeader();
+
+    std::map<wxString, Entry>   m_entries;
+    bool                        m_bdirty;
+};
+
+wxString PluginManifest::GetFileName()
+{
+    wxString *dir = GetpPrivateApplicationDataLocation();
+    if( !dir || dir->IsEmpty() )
+        return wxEmptyString;
+
+    return *dir + wxFileName::GetPathSeparator() + _T("plugins.manifest");
+}
+
+//  Whether a library is compatible depends on the wx build it links to
+//  as much as on ours
+wxString PluginManifest::GetHeader()
+{
+    return wxString::Format( _T("OpenCPN plugin manifest\t%s\twx %d.%d %s"), _T(VERSION_FULL),
+                             wxMAJOR_VERSION, wxMINOR_VERSION,
+                             wxPlatformInfo::Get().GetPortIdShortName().c_str() );
+}
+
+void PluginManifest::Load()
+{
+    wxString file = GetFileName();
+    wxTextFile tFile;
+    if( file.IsEmpty() || !wxFileExists( file ) || !tFile.Open( file, wxConvUTF8 ) )
+        return;
+
+    if( !tFile.GetLineCount() || tFile.GetFirstLine() != GetHeader() )
+        return;
+
+    //  size, time and state, then the path
+    for( size_t i = 1; i < tFile.GetLineCount(); i++ ) {
+        wxStringTokenizer tk( tFile[i], _T("\t"), wxTOKEN_RET_EMPTY_ALL );
+        Entry entry;
+        wxULongLong_t size;
+        long mtime, state;
+        if( tk.CountTokens() != 4 ||
+            !tk.GetNextToken().ToULongLong( &size ) ||
+            !tk.GetNextToken().ToLong( &mtime ) ||
+            !tk.GetNextToken().ToLong( &state ) )
+            continue;
+        entry.size = size;
+        entry.mtime = mtime;
+        entry.state = state;
+        m_entries[tk.GetNextToken()] = entry;
+    }
+}
+
+void PluginManifest::Save()
+{
+    if( !m_bdirty )
+        return;
+    m_bdirty = false;
+
+    wxString file = GetFileName();
+    if( file.IsEmpty() )
+        return;
+
+    wxTextFile tFile( file );
+    if( wxFileExists( file ) ? !tFile.Open( wxConvUTF8 ) : !tFile.Create() )
+        return;
+    tFile.Clear();
+
+    tFile.AddLine( GetHeader() );
+    for( std::map<wxString, Entry>::const_iterator it = m_entries.begin(); it != m_entries.end(); ++it ) {
+        //  Forget uninstalled plugins
+        if( !wxFileExists( it->first ) )
+            continue;
+
+        const Entry &entry = it->second;
+        tFile.AddLine( wxString::Format( _T("%s\t%ld\t%d\t%s"),
+                                         entry.size.ToString().c_str(), (long)entry.mtime, entry.state,
+                                         it->first.c_str() ) );
+    }
+    tFile.Write( wxTextFileType_None, wxConvUTF8 );
+    tFile.Close();
+}
+
+const PluginManifest::Entry *PluginManifest::Find(const wxString &file, wxULongLong size, time_t mtime) const
+{
+    std::map<wxString, Entry>::const_iterator it = m_entries.find( file );
+    if( it == m_entries.end() || it->second.size != size || it->second.mtime != mtime )
+        return NULL;
+    return &it->second;
+}
+
+void PluginManifest::Set(const wxString &file, const Entry &entry)
+{
+    const Entry *old = Find( file, entry.size, entry.mtime );
+    if( old && old->state == entry.state )
+        return;
+
+    m_entries[file] = entry;
+    m_bdirty = true;
+}
+
+//  Read a whole file, so a following dlopen() finds it in the page cache
+static void PreloadFile(const wxString &file)
+{
+    MappedFile mapped;
+    if( !mapped.Open( file ) )
+        return;
+
+    const unsigned char *data = mapped.GetData();
+    volatile unsigned char sum = 0;
+    for( size_t i = 0; i < mapped.GetSize(); i += 4096 )
+        sum += data[i];
+}
+
 bool PlugInManager::LoadAllPlugIns(bool load_enabled, bool b_enable_blackdialog)
 {
     using namespace std;
@@ -716,6 +865,13 @@ bool PlugInManager::LoadAllPlugIns(bool load_enabled, bool b_enable_blackdialog)
     wxLogMessage(_T("PlugInManager: loading plugins from %s"),
                  ocpn::join(dirs, ';'));
     setLoadPath();
+
+    //  Read once, the plugins tab loads all plugins again each time it is shown
+    if(!m_manifest) {
+        m_manifest = new PluginManifest;
+        m_manifest->Load();
+    }
+
     bool any_dir_loaded = false;
     for (auto dir: dirs) {
         wxString wxdir(dir);
@@ -723,6 +879,7 @@ wxLogMessage("Loading plugins from dir: %s", wxdir.mb_str().data());
         if (LoadPlugInDirectory(wxdir, load_enabled, b_enable_blackdialog))
             any_dir_loaded = true;
     }
+    m_manifest->Save();
     
     // Read the default ocpn-plugins.xml, and update/merge the plugin array
     // This only needs to happen when the entire universe (enabled and disabled) of plugins are loaded for management.
@@ -783,48 +940,52 @@ bool PlugInManager::LoadPlugInDirectory(const wxString& plugin_dir, bool load_en
     wxDir::GetAllFiles( m_plugin_location, &file_list, pispec, get_flags );
     
     wxLogMessage("Found %d candidates", (int)file_list.GetCount());
+
+    // this gets called every time we switch to the plugins tab.
+    // this allows plugins to be installed and enabled without restarting opencpn.
+    // For this reason we must check that we didn't already load this plugin
+    std::map<wxString, PlugInContainer *> loaded_plugins;
+    for(unsigned int i = 0 ; i < plugin_array.GetCount() ; i++)
+        loaded_plugins[plugin_array[i]->m_plugin_filename] = plugin_array[i];
+
+    struct Candidate {
+        wxString        file_name;
+        wxString        plugin_file;
+        wxDateTime      modification;
+        wxULongLong     size;
+        bool            enabled;
+        const PluginManifest::Entry *known;     // unchanged since last probed
+        std::string     worker_file;            // for the probe, wxString is not thread safe
+        bool            b_checked;
+        bool            b_compat;
+    };
+    std::vector<Candidate> candidates;
+
     for(unsigned int i=0 ; i < file_list.GetCount() ; i++) {
         wxString file_name = file_list[i];
         wxString plugin_file = wxFileName(file_name).GetFullName();
         wxLogMessage("Checking plugin candidate: %s", file_name.mb_str().data());
         wxDateTime plugin_modification = wxFileName(file_name).GetModificationTime();
 
-        // this gets called every time we switch to the plugins tab.
-        // this allows plugins to be installed and enabled without restarting opencpn.
-        // For this reason we must check that we didn't already load this plugin
-        bool loaded = false;
-        for(unsigned int i = 0 ; i < plugin_array.GetCount() ; i++)
-        {
-            PlugInContainer *pic = plugin_array[i];
-            
-            // Checking for dynamically updated plugins
-            if(pic->m_plugin_filename == plugin_file) {
-                
-                // Do not re-load same-name plugins from different directories.  Certain to crash...
-                if(pic->m_plugin_file == file_name){ 
-                    if(pic->m_plugin_modification != plugin_modification) {
-                        // modification times don't match, reload plugin
-                        plugin_array.Remove(pic);
-                        i--;
-
-                        DeactivatePlugIn(pic);
-                        pic->m_destroy_fn(pic->m_pplugin);
-                        
-                        delete pic->m_plibrary;            // This will unload the PlugIn
-                        delete pic;
-                        ret = true;
-                    } else {
-                        loaded = true;
-                        break;
-                    }
-                } else {
-                    loaded = true;
-                    break;
-                }
-            }
+        std::map<wxString, PlugInContainer *>::iterator it = loaded_plugins.find(plugin_file);
+        if(it != loaded_plugins.end()) {
+            PlugInContainer *pic = it->second;
+
+            // Do not re-load same-name plugins from different directories.  Certain to crash...
+            if(pic->m_plugin_file != file_name || pic->m_plugin_modification == plugin_modification)
+                continue;
+
+            // modification times don't match, reload plugin
+            plugin_array.Remove(pic);
+            loaded_plugins.erase(it);
+
+            DeactivatePlugIn(pic);
+            pic->m_destroy_fn(pic->m_pplugin);
+
+            delete pic->m_plibrary;            // This will unload the PlugIn
+            delete pic;
+            ret = true;
         }
-        if(loaded)
-            continue;
 
         //    Check the config file to see if this PlugIn is user-enabled
         wxString config_section = ( _T ( "/PlugIns/" ) );
@@ -838,9 +999,81 @@ bool PlugInManager::LoadPlugInDirectory(const wxString& plugin_dir, bool load_en
             wxLogMessage("Skipping not enabled candidate.");
             continue;
         }
-            
-        bool b_compat = CheckPluginCompatibility(file_name);
-            
+
+        Candidate c;
+        c.file_name = file_name;
+        c.plugin_file = plugin_file;
+        c.modification = plugin_modification;
+        c.size = wxFileName(file_name).GetSize();
+        c.enabled = enabled;
+        c.known = NULL;
+        if(plugin_modification.IsValid() && c.size != wxInvalidSize)
+            c.known = m_manifest->Find(file_name, c.size, plugin_modification.GetTicks());
+        c.worker_file = std::string(file_name.ToUTF8().data());
+        c.b_checked = false;
+        c.b_compat = false;
+        candidates.push_back(c);
+    }
+
+    //  Scan the new and changed libraries for compatibility, and read the
+    //  others through, all on worker threads.  The libraries are then
+    //  loaded and initialized on this thread.  Their static constructors
+    //  and create_pi() build wx objects, which is only safe here.
+    if(!candidates.empty()) {
+        //  The first scan queries our own executable once, before the workers start
+        for(size_t i = 0 ; i < candidates.size() ; i++) {
+            if(!candidates[i].known) {
+                candidates[i].b_compat = CheckPluginCompatibility(candidates[i].file_name);
+                candidates[i].b_checked = true;
+                break;
+            }
+        }
+
+        std::atomic<int> next(0);
+        int n = candidates.size();
+        auto worker = [&]() {
+            for(int i = next++; i < n; i = next++) {
+                Candidate &c = candidates[i];
+                if(c.b_checked)
+                    continue;
+                wxString file = wxString::FromUTF8(c.worker_file.c_str());
+                if(c.known)
+                    PreloadFile(file);
+                else
+                    c.b_compat = CheckPluginCompatibility(file);
+            }
+        };
+
+        std::vector<std::thread> threads;
+        int nthreads = wxMin((int)std::thread::hardware_concurrency(), n) - 1;
+        for(int i = 0; i < nthreads; i++) {
+            try {
+                threads.push_back(std::thread(worker));
+            } catch(std::system_error &) {
+                break;
+            }
+        }
+        worker();
+        for(auto &t : threads)
+            t.join();
+    }
+
+    for(size_t i = 0 ; i < candidates.size() ; i++) {
+        Candidate &c = candidates[i];
+        wxString file_name = c.file_name;
+        wxString plugin_file = c.plugin_file;
+        wxDateTime plugin_modification = c.modification;
+        bool enabled = c.enabled;
+
+        const PluginManifest::Entry *known = c.known;
+        bool b_compat = known ? known->state != PluginManifest::PLUGIN_INCOMPATIBLE : c.b_compat;
+
+        //  Without the dialogs, there is nothing to learn from failing again
+        if(known && known->state == PluginManifest::PLUGIN_UNLOADABLE && !m_benable_blackdialog) {
+            wxLogMessage("Skipping unchanged candidate which failed to load before.");
+            continue;
+        }
+
         if(m_benable_blackdialog && !b_compat)
         {
             wxLogMessage(wxString::Format(_T("    %s: %s"), _T("Incompatible plugin detected"), file_name.c_str()));
@@ -852,6 +1085,19 @@ bool PlugInManager::LoadPlugInDirectory(const wxString& plugin_dir, bool load_en
         if(b_compat)
             pic = LoadPlugIn(file_name);
 
+        if(plugin_modification.IsValid() && c.size != wxInvalidSize) {
+            PluginManifest::Entry entry;
+            entry.size = c.size;
+            entry.mtime = plugin_modification.GetTicks();
+            if(!b_compat)
+                entry.state = PluginManifest::PLUGIN_INCOMPATIBLE;
+            else if(pic && pic->m_pplugin)
+                entry.state = PluginManifest::PLUGIN_LOADABLE;
+            else
+                entry.state = PluginManifest::PLUGIN_UNLOADABLE;
+            m_manifest->Set(file_name, entry);
+        }
+
         if(pic)
         {
             if(pic->m_pplugin)
@@ -967,6 +1213,7 @@ bool PlugInManager::CallLateInit(void)
             case 115:
             case 116:
             case 117:
+            case 118:
                 ProcessLateInit(pic);
                 break;
         }
@@ -1009,6 +1256,7 @@ void PlugInManager::SendVectorChartObjectInfo(const wxString &chart, const wxStr
                 case 115:
                 case 116:
                 case 117:
+                case 118:
                 {
                     opencpn_plugin_112 *ppi = dynamic_cast<opencpn_plugin_112 *>(pic->m_pplugin);
                     if(ppi)
@@ -1678,7 +1926,9 @@ bool PlugInManager::CheckPluginCompatibility(wxString plugin_file)
     return true;
 #endif
     
-    FILE *f = fopen(plugin_file, "r");
+    MappedFile f;
+    if(!f.Open(plugin_file))
+        return false;
     char strver[26]; //Enough space even for very big integers...
 
     sprintf( strver,
@@ -1692,19 +1942,8 @@ bool PlugInManager::CheckPluginCompatibility(wxString plugin_file)
              #error undefined plugin platform
 #endif    
              , wxMAJOR_VERSION, wxMINOR_VERSION );
-    b_compat = false;
-    
-    int pos = 0, len = strlen(strver), c;
-    while((c = fgetc(f)) != EOF) {
-        if(c == strver[pos]) {
-            if(++pos == len) {
-                b_compat = true;
-                break;
-            }
-        } else
-            pos = 0;
-    }
-    fclose(f);
+    const unsigned char *end = f.GetData() + f.GetSize();
+    b_compat = std::search(f.GetData(), end, strver, strver + strlen(strver)) != end;
 #endif
 #endif // __WXGTK__
     wxLogMessage("PLugin is compatible: %s", b_compat ? "true" : "false");
@@ -1926,6 +2165,7 @@ PlugInContainer *PlugInManager::LoadPlugIn(wxString plugin_file)
         
     case 116:
     case 117:
+    case 118:
         pic->m_pplugin = dynamic_cast<opencpn_plugin_116*>(plug_in);
         break;
         
@@ -2002,6 +2242,7 @@ bool PlugInManager::RenderAllCanvasOverlayPlugIns( ocpnDC &dc, const ViewPort &v
                         }
                         case 116:
                         case 117:
+                        case 118:
                         {
                             opencpn_plugin_18 *ppi = dynamic_cast<opencpn_plugin_18 *>(pic->m_pplugin);
                             if (ppi) {
@@ -2067,6 +2308,7 @@ bool PlugInManager::RenderAllCanvasOverlayPlugIns( ocpnDC &dc, const ViewPort &v
                         }
                         case 116:
                         case 117:
+                        case 118:
                         {
                             opencpn_plugin_18 *ppi = dynamic_cast<opencpn_plugin_18 *>(pic->m_pplugin);
                             if (ppi) {
@@ -2142,6 +2384,7 @@ bool PlugInManager::RenderAllGLCanvasOverlayPlugIns( wxGLContext *pcontext, cons
                     }
                     case 116:
                     case 117:
+                    case 118:
                     {
                         opencpn_plugin_18 *ppi = dynamic_cast<opencpn_plugin_18 *>(pic->m_pplugin);
                         if (ppi) {
@@ -2181,6 +2424,7 @@ bool PlugInManager::SendMouseEventToPlugins( wxMouseEvent &event)
                     case 115:
                     case 116:
                     case 117:
+                    case 118:
                     {
                         opencpn_plugin_112 *ppi = dynamic_cast<opencpn_plugin_112*>(pic->m_pplugin);
                         if(ppi)
@@ -2215,6 +2459,7 @@ bool PlugInManager::SendKeyEventToPlugins( wxKeyEvent &event)
                         case 115:
                         case 116: 
                         case 117:
+                        case 118:
                         {
                             opencpn_plugin_113 *ppi = dynamic_cast<opencpn_plugin_113*>(pic->m_pplugin);
                             if(ppi && ppi->KeyboardEventHook( event ))
@@ -2279,6 +2524,7 @@ void NotifySetupOptionsPlugin( PlugInContainer *pic )
             case 115:
             case 116:    
             case 117:
+            case 118:
             {
                 opencpn_plugin_19 *ppi = dynamic_cast<opencpn_plugin_19 *>(pic->m_pplugin);
                 if(ppi) {
@@ -2465,6 +2711,7 @@ void PlugInManager::SendMessageToAllPlugins(const wxString &message_id, const wx
                 case 115:
                 case 116:
                 case 117:
+                case 118:
                 {
                     opencpn_plugin_18 *ppi = dynamic_cast<opencpn_plugin_18 *>(pic->m_pplugin);
                     if(ppi)
@@ -2528,6 +2775,8 @@ void PlugInManager::SendPositionFixToAllPlugIns(GenericPosDatEx *ppos)
     pfix_ex.Hdt = ppos->kHdt;
     pfix_ex.Hdm = ppos->kHdm;
 
+    PluginSnapshot::Get().SetPositionFix(pfix_ex, bGPSValid);
+
     for(unsigned int i = 0 ; i < plugin_array.GetCount() ; i++)
     {
         PlugInContainer *pic = plugin_array[i];
@@ -2547,6 +2796,7 @@ void PlugInManager::SendPositionFixToAllPlugIns(GenericPosDatEx *ppos)
                 case 115:
                 case 116:
                 case 117:
+                case 118:
                 {
                     opencpn_plugin_18 *ppi = dynamic_cast<opencpn_plugin_18 *>(pic->m_pplugin);
                     if(ppi)
@@ -2589,6 +2839,7 @@ void PlugInManager::SendActiveLegInfoToAllPlugIns(ActiveLegDat *leg_info)
         case 116:
           break;
         case 117:
+        case 118:
         {
           opencpn_plugin_117 *ppi = dynamic_cast<opencpn_plugin_117 *>(pic->m_pplugin);
           if (ppi)
@@ -2638,6 +2889,7 @@ void PlugInManager::PrepareAllPluginContextMenus()
                 {
                     case 116:
                     case 117:
+                    case 118:
                     {
                         opencpn_plugin_116 *ppi = dynamic_cast<opencpn_plugin_116 *>(pic->m_pplugin);
                         if(ppi)
@@ -4615,6 +4867,11 @@ const char* opencpn_plugin_117::GetPlugInVersionBuild() { return ""; };
 void opencpn_plugin_117::SetActiveLegInfo(Plugin_Active_Leg_Info &leg_info)
 {}
 
+//    Opencpn_Plugin_118 Implementation
+opencpn_plugin_118::opencpn_plugin_118(void *pmgr)
+    :opencpn_plugin_117(pmgr)
+{}
+
 
 //          Helper and interface classes
 
@@ -4625,7 +4882,12 @@ void opencpn_plugin_117::SetActiveLegInfo(Plugin_Active_Leg_Info &leg_info)
 PlugIn_AIS_Target *Create_PI_AIS_Target(AIS_Target_Data *ptarget)
 {
     PlugIn_AIS_Target *pret = new PlugIn_AIS_Target;
+    Fill_PI_AIS_Target(pret, ptarget);
+    return pret;
+}
 
+void Fill_PI_AIS_Target(PlugIn_AIS_Target *pret, AIS_Target_Data *ptarget)
+{
     pret->MMSI =            ptarget->MMSI;
     pret->Class =           ptarget->Class;
     pret->NavStatus =       ptarget->NavStatus;
@@ -4650,8 +4912,6 @@ PlugIn_AIS_Target *Create_PI_AIS_Target(AIS_Target_Data *ptarget)
 
     memcpy(pret->CallSign, ptarget->CallSign, CALL_SIGN_LEN);
     memcpy(pret->ShipName, ptarget->ShipName, SHIP_NAME_LEN);
-
-    return pret;
 }
 
 //-------------------------------------------------------------------------------
@@ -8278,3 +8538,18 @@ void ZeroXTE() {
     g_pRouteMan->ZeroCurrentXTEToActivePoint();
   }
 }
+
+bool GetPositionFixSnapshot(PlugIn_Position_Fix_Ex *pfix, unsigned int *pgeneration)
+{
+    return PluginSnapshot::Get().GetPositionFix(pfix, pgeneration);
+}
+
+unsigned int GetAISTargetSnapshotGeneration(void)
+{
+    return PluginSnapshot::Get().GetAISGeneration();
+}
+
+int GetAISTargetSnapshot(PlugIn_AIS_Target *ptargets, int max_targets, unsigned int *pgeneration)
+{
+    return PluginSnapshot::Get().GetAISTargets(ptargets, max_targets, pgeneration);
+}
@@ -413,6 +413,7 @@ s52plib::s52plib( const wxString& PLib, bool b_forceLegacy )
     
     //        Set up some default flags
     m_bDeClutterText = false;
+    m_bDraftMode = false;
     m_bShowAtonText = true;
     m_bShowNationalTexts = false;
 
@@ -2621,7 +2622,8 @@ int s52plib::RenderT_All( ObjRazRules *rzRules, Rules *rules, ViewPort *vp, bool
         GetPointPixSingle( rzRules, rzRules->obj->y, rzRules->obj->x, &r, vp );
 
         wxRect rect;
-        bool bwas_drawn = RenderText( m_pdc, text, r.x, r.y, &rect, rzRules->obj, m_bDeClutterText, vp );
+        bool bdeclutter = m_bDeClutterText && !m_bDraftMode;
+        bool bwas_drawn = RenderText( m_pdc, text, r.x, r.y, &rect, rzRules->obj, bdeclutter, vp );
 
         //  If this is an un-cached text render, it probably means that a single object has two or more
         //  text renders in its rule set.  RDOCAL is one example.  There are others
@@ -2649,7 +2651,7 @@ int s52plib::RenderT_All( ObjRazRules *rzRules, Rules *rules, ViewPort *vp, bool
         
         
         //      If this text was actually drawn, add a pointer to its rect to the de-clutter list if it doesn't already exist
-        if( m_bDeClutterText ) {
+        if( bdeclutter ) {
             if( bwas_drawn ) {
                 bool b_found = false;
                 for( TextObjList::Node *node = m_textObjList.GetFirst(); node; node =  node->GetNext() ) {
@@ -3615,7 +3617,7 @@ int s52plib::RenderGLLS( ObjRazRules *rzRules, Rules *rules, ViewPort *vp )
     
 #else    
     glLineWidth(lineWidth);
-    if(lineWidth > 4.0 && m_GLLineSmoothing){
+    if(lineWidth > 4.0 && m_GLLineSmoothing && !m_bDraftMode){
         glEnable( GL_LINE_SMOOTH );
         glEnable( GL_BLEND );
     }
@@ -3943,7 +3945,7 @@ int s52plib::RenderLS( ObjRazRules *rzRules, Rules *rules, ViewPort *vp )
 #endif
 
 #ifndef __OCPN__ANDROID__
-            if(w >= 2 && m_GLLineSmoothing){    
+            if(w >= 2 && m_GLLineSmoothing && !m_bDraftMode){    
                 glEnable( GL_LINE_SMOOTH );
                 glEnable( GL_BLEND );
             }
@@ -4158,7 +4160,7 @@ int s52plib::RenderLSLegacy( ObjRazRules *rzRules, Rules *rules, ViewPort *vp )
 #endif
 
 #ifndef __OCPN__ANDROID__
-        if(w >= 2 && m_GLLineSmoothing){
+        if(w >= 2 && m_GLLineSmoothing && !m_bDraftMode){
             glEnable( GL_LINE_SMOOTH );
             glEnable( GL_BLEND );
         }
@@ -5570,7 +5572,7 @@ next_seg_dc:
                     glBlendFunc (GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
                     glEnable (GL_BLEND);
                     
-                    if( m_GLLineSmoothing )
+                    if( m_GLLineSmoothing && !m_bDraftMode )
                     {
                         glEnable (GL_LINE_SMOOTH);
                         glHint (GL_LINE_SMOOTH_HINT, GL_NICEST);
@@ -5642,7 +5644,7 @@ next_seg_dc:
                     glBlendFunc (GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
                     glEnable (GL_BLEND);
 
-                    if( m_GLLineSmoothing ) {
+                    if( m_GLLineSmoothing && !m_bDraftMode ) {
                         glEnable (GL_LINE_SMOOTH);
                         glHint (GL_LINE_SMOOTH_HINT, GL_NICEST);
                     }
@@ -6478,7 +6480,7 @@ int s52plib::RenderCARC_VBO( ObjRazRules *rzRules, Rules *rules, ViewPort *vp )
 
 #ifndef __OCPN__ANDROID__
         glEnable( GL_BLEND );
-        if( m_GLLineSmoothing )
+        if( m_GLLineSmoothing && !m_bDraftMode )
             glEnable( GL_LINE_SMOOTH );
 #endif        
         glEnableClientState(GL_VERTEX_ARRAY);             // activate vertex coords array
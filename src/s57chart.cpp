@@ -81,6 +81,7 @@
 #include <map>
 
 #include "ssl/sha1.h"
+#include "PerfTrace.h"
 
 #ifdef __MSVC__
 #define strncasecmp(x,y,z) _strnicmp(x,y,z)
@@ -3962,7 +3963,8 @@ bool s57chart::GetBaseFileAttr( const wxString& file000 )
 
 int s57chart::BuildSENCFile( const wxString& FullPath000, const wxString& SENCFileName, bool b_progress )
 {
-    
+    PERF_ZONE("s57chart::BuildSENCFile");
+
     //  LOD calculation
     double display_pix_per_meter  = g_Platform->GetDisplayDPmm() * 1000;
     double meters_per_pixel_max_scale = GetNormalScaleMin(0,g_b_overzoom_x)/display_pix_per_meter;
@@ -4016,6 +4018,8 @@ int s57chart::BuildSENCFile( const wxString& FullPath000, const wxString& SENCFi
 
 int s57chart::BuildRAZFromSENCFile( const wxString& FullPath )
 {
+    PERF_ZONE("s57chart::BuildRAZFromSENCFile");
+
     int ret_val = 0;                    // default is OK
 
     Osenc sencfile;
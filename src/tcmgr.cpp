@@ -33,393 +33,159 @@
 #include <math.h>
 #include <time.h>
 
+#include <atomic>
+#include <thread>
+#include <system_error>
+
 #include "chart1.h"
 #include "dychart.h"
 #include "tcmgr.h"
+#include "TCExtremaCache.h"
 #include "georef.h"
+#include "bbox.h"
 
 //-----------------------------------------------------------------------------------
 //    TIDELIB
 //-----------------------------------------------------------------------------------
 
-//      Static variables for the TIDELIB
-
-time_t s_next_epoch      = TIDE_BAD_TIME; /* next years newyears */
-time_t s_this_epoch      = TIDE_BAD_TIME; /* this years newyears */
-int    s_this_year       = -1;
+//      Samples evaluated by phase recurrence before the constituent
+//      phases are re-seeded with cos()/sin(), bounding rounding drift
+#define TIDE_SERIES_RESEED  128
 
-double time2dt_tide (time_t t, int deriv, IDX_entry *pIDX);
-int yearoftimet (time_t t);
-void happy_new_year (IDX_entry *pIDX, int new_year);
-void set_epoch (IDX_entry *pIDX, int year);
+//      Step, in seconds, of the high/low water search
+#define TIDE_EVENT_STEP     60
 
-double time2tide (time_t t, IDX_entry *pIDX)
+/*  UTC calendar arithmetic, so that finding the year of a time or the
+ *  time of a new year never goes through gmtime() and its static buffer. */
+static long DaysFromCivil(long y, int m, int d)
 {
-    return time2dt_tide(t, 0, pIDX);
+    y -= m <= 2;
+    long era = (y >= 0 ? y : y - 399) / 400;
+    long yoe = y - era * 400;
+    long doy = (153 * (m > 2 ? m - 3 : m + 9) + 2) / 5 + d - 1;
+    long doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    return era * 146097 + doe - 719468;
 }
 
-
-
-/** BOGUS amplitude stuff - Added mgh
- * For knots^2 current stations, returns square root of (value * amplitude),
- * For normal stations, returns value * amplitude */
-
-double BOGUS_amplitude(double mpy, IDX_entry *pIDX)
+static time_t EpochOfYear(int year)
 {
-    Station_Data *pmsd = pIDX->pref_sta_data;
-
-    if (!pmsd->have_BOGUS)                                // || !convert_BOGUS)   // Added mgh
-        return(mpy * pIDX->max_amplitude);
-    else {
-        if (mpy >= 0.0)
-            return( sqrt( mpy * pIDX->max_amplitude));
-        else
-            return(-sqrt(-mpy * pIDX->max_amplitude));
-    }
+    return (time_t)DaysFromCivil(year, 1, 1) * 86400;
 }
 
-/* Calculate the denormalized tide. */
-double time2atide (time_t t, IDX_entry *pIDX)
+static int YearOfTime(time_t t)
 {
-    return BOGUS_amplitude(time2tide(t, pIDX), pIDX) + pIDX->pref_sta_data->DATUM;
+    long z = (long)(t / 86400);
+    if((t % 86400) < 0)
+        z--;
+    z += 719468;
+    long era = (z >= 0 ? z : z - 146096) / 146097;
+    long doe = z - era * 146097;
+    long yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+    long doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+    long mp = (5 * doy + 2) / 153;
+    long m = mp < 10 ? mp + 3 : mp - 9;
+    return (int)(yoe + era * 400 + (m <= 2));
 }
 
 
-/* Next high tide, low tide, transition of the mark level, or some
- *   combination.
- *       Bit      Meaning
- *        0       low tide
- *        1       high tide
- *        2       falling transition
- *        3       rising transition
- */
-int next_big_event (time_t *tm, IDX_entry *pIDX)
-{
-    double p, q;
-    int flags = 0, slope = 0;
-    p = time2atide (*tm, pIDX);
-    *tm += 60;
-    q = time2atide (*tm, pIDX);
-    *tm += 60;
-    if (p < q)
-        slope = 1;
-    while (1) {
-        if ((slope == 1 && q < p) || (slope == 0 && p < q)) {
-            /* Tide event */
-            flags |= (1 << slope);
-        }
-        /* Modes in which to return mark transitions: */
-        /*    -text (no -graph)   */
-        /*    -graph (no -text)   */
-        /*    -ppm                */
-        /*    -gif                */
-        /*    -ps                 */
-
-
-        //    if (mark && ((text && !graphmode) || (!text && graphmode)
-        //    || ppm || gif || ps))
-        //      int marklev = 0;
-#if (0)
-        if(0)
-            if ((p > marklev && q <= marklev) || (p < marklev && q >= marklev)) {
-                /* Transition event */
-                if (p < q)
-                    flags |= 8;
-                else
-                    flags |= 4;
-                if (!(flags & 3)) {
-                    /* If we're incredibly unlucky, we could miss a tide event if we
-                     *                       don't check for it here:
-                     *
-                     *                                       . <----   Value that would be returned
-                     *                                  -----------    Mark level
-                     *                                .           .
-                     */
-                    p = q;
-                    q = time2atide (*tm, pIDX);
-                    if ((slope == 1 && q < p) || (slope == 0 && p < q)) {
-                        /* Tide event */
-                        flags |= (1 << slope);
-                    }
-                }
-            }
-#endif
+//-----------------------------------------------------------------------------------
+//    TCPredictor Implementation
+//-----------------------------------------------------------------------------------
 
-        if (flags) {
-            *tm -= 60;
-            /* Don't back up over a transition event, but do back up to where the
-             *               tide changed if possible.  If they happen at the same time, then
-             *               we're off by a minute on the tide, but if we back it up it will
-             *               get snagged on the transition event over and over. */
-            if (flags < 4)
-                *tm -= 60;
-            return flags;
-        }
-        p = q;
-        q = time2atide (*tm, pIDX);
-        *tm += 60;
-    }
-}
+TCPredictor::TCPredictor(const IDX_entry *pIDX)
+{
+    m_pIDX = pIDX;
+    m_psd = pIDX ? pIDX->pref_sta_data : NULL;
+    m_ncst = 0;
+    m_max_amplitude = 0.0;
+    m_next_slot = 0;
+    for(int i = 0; i < 3; i++)
+        m_coefs[i].year = -1;
+
+    m_lowtime = m_hightime = 0;
+    m_lowlvl = m_highlvl = 0.0;
+
+    if(!m_psd || !pIDX->m_cst_speeds || !pIDX->m_cst_nodes || !pIDX->m_cst_epochs)
+        return;
 
+    m_ncst = pIDX->num_csts;
 
+    /* Figure out max amplitude over all the years in the node factors table. */
+    /* This function by Geoffrey T. Dairiki */
+    for(int i = 0; i < pIDX->num_nodes; i++) {
+        double year_amp = 0.0;
 
-/* Estimate the normalized mean tide level around a particular time by
- *   summing only the long-term constituents. */
-/* Does not do any blending around year's end. */
-/* This is used only by time2asecondary for finding the mean tide level */
-double time2mean (time_t t, IDX_entry *pIDX)
-{
-    double tide = 0.0;
-    int a;
-    int new_year = yearoftimet (t);
-    if (pIDX->epoch_year != new_year)
-        happy_new_year (pIDX, new_year);
-
-    for (a=0; a<pIDX->num_csts; a++) {
-        if (pIDX->m_cst_speeds[a] < 6e-6) {
-            tide += pIDX->m_work_buffer[a] *
-                    cos (pIDX->m_cst_speeds[a] * ((long)(t - pIDX->epoch) + pIDX->pref_sta_data->meridian) +
-                    pIDX->m_cst_epochs[a][pIDX->epoch_year-pIDX->first_year] - pIDX->pref_sta_data->epoch[a]);
-        }
+        for(int a = 0; a < m_ncst; a++)
+            year_amp += m_psd->amplitude[a] * pIDX->m_cst_nodes[a][i];
+        if(year_amp > m_max_amplitude)
+            m_max_amplitude = year_amp;
     }
 
-    return tide;
+    if(m_max_amplitude == 0.0)
+        m_ncst = 0;
 }
 
+void TCPredictor::LoadState(const IDX_entry *pIDX)
+{
+    m_lowtime = pIDX->sec_low_time;
+    m_hightime = pIDX->sec_high_time;
+    m_lowlvl = pIDX->sec_low_level;
+    m_highlvl = pIDX->sec_high_level;
+}
 
-
-/* If offsets are in effect, interpolate the 'corrected' denormalized
- * tide.  The normalized is derived from this, instead of the other way
- * around, because the application of height offsets requires the
- * denormalized tide. */
-double time2asecondary (time_t t, IDX_entry *pIDX) {
-
-    time_t tadj = t + pIDX->station_tz_offset;
-    
-    /* Get rid of the normals. */
-    if (!(pIDX->have_offsets))
-        return time2atide (tadj, pIDX);
-
-    {
-        /* Intervalwidth of 14 (was originally 13) failed on this input:
-         *        -location Dublon -hloff +0.0001 -gstart 1997:09:10:00:00 -raw 1997:09:15:00:00
-         */
-#define intervalwidth 15
-#define stretchfactor 3
-
-        static time_t lowtime=0, hightime=0;
-        static double lowlvl, highlvl; /* Normalized tide levels for MIN, MAX */
-        time_t T;  /* Adjusted t */
-        double S, Z, HI, HS, magicnum;
-        time_t interval = 3600 * intervalwidth;
-        long difflow, diffhigh;
-        int badlowflag=0, badhighflag=0;
-
-
-        /* Algorithm by Jean-Pierre Lapointe (scipur@collegenotre-dame.qc.ca) */
-        /* as interpreted, munged, and implemented by DWF */
-
-        /* This is the initial guess (average of time offsets) */
-        //    T = t - (httimeoff + lttimeoff) / 2;
-        T = tadj - (pIDX->IDX_ht_time_off * 60 + pIDX->IDX_lt_time_off * 60) / 2;
-        /* The usage of an estimate of mean tide level here is to correct
-         *           for seasonal changes in tide level.  Previously I had simply used
-         *           the zero of the tide function as the mean, but this gave bad
-         *           results around summer and winter for locations with large seasonal
-         *           variations. */
-//        printf("-----time2asecondary  %ld %ld %d %d\n", t, T, pIDX->IDX_ht_time_off ,pIDX->IDX_lt_time_off);
-
-        Z = time2mean(T, pIDX);
-        S = time2tide(T, pIDX) - Z;
-
-        /* Find MAX and MIN.  I use the highest high tide and the lowest
-         *           low tide over a 26 hour period, but I allow the interval to stretch
-         *           a lot if necessary to avoid creating discontinuities.  The
-         *           heuristic used is not perfect but will hopefully be good enough.
-         *
-         *           It is an assumption in the algorithm that the tide level will
-         *           be above the mean tide level for MAX and below it for MIN.  A
-         *           changeover occurs at mean tide level.  It would be nice to
-         *           always use the two tides that immediately bracket T and to put
-         *           the changeover at mid tide instead of always at mean tide
-         *           level, since this would eliminate much of the inaccuracy.
-         *           Unfortunately if you change the location of the changeover it
-         *           causes the tide function to become discontinuous.
-         *
-         *           Now that I'm using time2mean, the changeover does move, but so
-         *           slowly that it makes no difference.
-         */
-
-        if (lowtime < T)
-            difflow = T - lowtime;
-        else
-            difflow = lowtime - T;
-        if (hightime < T)
-            diffhigh = T - hightime;
-        else
-            diffhigh = hightime - T;
-
-        /* Update MIN? */
-        if (difflow > interval * stretchfactor)
-            badlowflag = 1;
-        if (badlowflag || (difflow > interval && S > 0)) {
-            time_t tt;
-            double tl;
-            tt = T - interval;
-            next_big_event (&tt, pIDX);
-            lowlvl = time2tide (tt, pIDX);
-            lowtime = tt;
-            while (tt < T + interval) {
-                next_big_event (&tt, pIDX);
-                tl = time2tide (tt, pIDX);
-                if (tl < lowlvl && tt < T + interval) {
-                    lowlvl = tl;
-                    lowtime = tt;
-                }
-            }
-        }
-        /* Update MAX? */
-        if (diffhigh > interval * stretchfactor)
-            badhighflag = 1;
-        if (badhighflag || (diffhigh > interval && S < 0)) {
-            time_t tt;
-            double tl;
-            tt = T - interval;
-            next_big_event (&tt, pIDX);
-            highlvl = time2tide (tt, pIDX);
-            hightime = tt;
-            while (tt < T + interval) {
-                next_big_event (&tt, pIDX);
-                tl = time2tide (tt, pIDX);
-                if (tl > highlvl && tt < T + interval) {
-                    highlvl = tl;
-                    hightime = tt;
-                }
-            }
-        }
-
-#if 0
-        /* UNFORTUNATELY there are times when the tide level NEVER CROSSES
-         *           THE MEAN for extended periods of time.  ARRRGH!  */
-        if (lowlvl >= 0.0)
-            lowlvl = -1.0;
-        if (highlvl <= 0.0)
-            highlvl = 1.0;
-#endif
-        /* Now that I'm using time2mean, I should be guaranteed to get
-         *           an appropriate low and high. */
-
-
-        /* Improve the initial guess. */
-        if (S > 0)
-            magicnum = 0.5 * S / fabs(highlvl - Z);
-        else
-            magicnum = 0.5 * S / fabs(lowlvl - Z);
-        //    T = T - magicnum * (httimeoff - lttimeoff);
-        T = T - (time_t)(magicnum * ((pIDX->IDX_ht_time_off * 60) - (pIDX->IDX_lt_time_off * 60)));
-        HI = time2tide(T, pIDX);
-
-        //    Correct the amplitude offsets for BOGUS knot^2 units
-        double ht_off, lt_off;
-        if (pIDX->pref_sta_data->have_BOGUS)
-        {
-            ht_off = pIDX->IDX_ht_off * pIDX->IDX_ht_off;         // Square offset in kts to adjust for kts^2
-            lt_off = pIDX->IDX_lt_off * pIDX->IDX_lt_off;
-        }
-        else
-        {
-            ht_off = pIDX->IDX_ht_off;
-            lt_off = pIDX->IDX_lt_off;
-        }
-
-
-        /* Denormalize and apply the height offsets. */
-        HI = BOGUS_amplitude(HI, pIDX) + pIDX->pref_sta_data->DATUM;
-        {
-            double RH=1.0, RL=1.0, HH=0.0, HL=0.0;
-            RH = pIDX->IDX_ht_mpy;
-            HH = ht_off;
-            RL = pIDX->IDX_lt_mpy;
-            HL = lt_off;
-
-            /* I patched the usage of RH and RL to avoid big ugly
-             *            discontinuities when they are not equal.  -- DWF */
-
-            HS =  HI * ((RH+RL)/2 + (RH-RL)*magicnum)
-                  + (HH+HL)/2 + (HH-HL)*magicnum;
-        }
-
-        return HS;
-    }
+void TCPredictor::SaveState(IDX_entry *pIDX) const
+{
+    pIDX->sec_low_time = m_lowtime;
+    pIDX->sec_high_time = m_hightime;
+    pIDX->sec_low_level = m_lowlvl;
+    pIDX->sec_high_level = m_highlvl;
 }
 
+/* Figure out normalized multipliers and phases for constituents for a
+ * particular year.  The last three years used are kept, which covers the
+ * blending around new year.  The returned reference is only good until
+ * the next call. */
+const TCPredictor::YearCoefs &TCPredictor::Coefs(int year)
+{
+    for(int i = 0; i < 3; i++) {
+        if(m_coefs[i].year == year)
+            return m_coefs[i];
+    }
 
+    YearCoefs &yc = m_coefs[m_next_slot];
+    m_next_slot = (m_next_slot + 1) % 3;
 
+    //  Outside of the node factor tables, use the nearest year available
+    int nyears = wxMin(m_pIDX->num_epochs, m_pIDX->num_nodes);
+    int iy = wxMax(0, wxMin(year - m_pIDX->first_year, nyears - 1));
 
+    yc.year = year;
+    yc.epoch = EpochOfYear(year);
+    yc.mpy.resize(m_ncst);
+    yc.phase.resize(m_ncst);
+    for(int a = 0; a < m_ncst; a++) {
+        yc.mpy[a] = m_psd->amplitude[a] * m_pIDX->m_cst_nodes[a][iy] / m_max_amplitude;
+        yc.phase[a] = m_pIDX->m_cst_epochs[a][iy] - m_psd->epoch[a];
+    }
 
+    return yc;
+}
 
 /*
- * We will need a function for tidal height as a function of time
- * which is continuous (and has continuous first and second derivatives)
- * for all times.
- *
- * Since the epochs & multipliers for the tidal constituents change
- * with the year, the regular time2tide(t) function has small
- * discontinuities at new years.  These discontinuities really
- * fry the fast root-finders.
- *
- * We will eliminate the new-years discontinuities by smoothly
- * interpolating (or "blending") between the tides calculated with one
- * year's coefficients, and the tides calculated with the next year's
- * coefficients.
- *
- * i.e. for times near a new years, we will "blend" a tide
- * as follows:
- *
- * tide(t) = tide(year-1, t)
- *                  + w((t - t0) / Tblend) * (tide(year,t) - tide(year-1,t))
- *
- * Here:  t0 is the time of the nearest new-year.
- *        tide(year-1, t) is the tide calculated using the coefficients
- *           for the year just preceding t0.
- *        tide(year, t) is the tide calculated using the coefficients
- *           for the year which starts at t0.
- *        Tblend is the "blending" time scale.  This is set by
- *           the macro TIDE_BLEND_TIME, currently one hour.
- *        w(x) is the "blending function", whice varies smoothly
- *           from 0, for x < -1 to 1 for x > 1.
- *
- * Derivatives of the blended tide can be evaluated in terms of derivatives
- * of w(x), tide(year-1, t), and tide(year, t).  The blended tide is
- * guaranteed to have as many continuous derivatives as w(x).  */
-
-/* time2dt_tide(time_t t, int n)
- *
- *   Calculate nth time derivative the normalized tide.
- *
- * Notes: This function does not check for changes in year.
- *  This is important to our algorithm, since for times near
- *  new years, we interpolate between the tides calculated
- *  using one years coefficients, and the next years coefficients.
- *
- *  Except for this detail, time2dt_tide(t,0) should return a value
- *  identical to time2tide(t).
+ * Calculate nth time derivative the normalized tide, using the
+ * coefficients of one year only.  See Tide() for the blending.
  */
-double _time2dt_tide (time_t t, int deriv, IDX_entry *pIDX)
+double TCPredictor::EvalTide(const YearCoefs &yc, time_t t, int deriv) const
 {
+    const double *speeds = m_pIDX->m_cst_speeds;
     double dt_tide = 0.0;
-    int a, b;
-    double term, tempd;
+    double tempd = M_PI / 2.0 * deriv;
+    long off = (long)(t - yc.epoch) + m_psd->meridian;
 
-    tempd = M_PI / 2.0 * deriv;
-    for (a=0; a<pIDX->num_csts; a++)
-    {
-        term = pIDX->m_work_buffer[a] *
-               cos(tempd +
-                   pIDX->m_cst_speeds[a] * ((long)(t - pIDX->epoch) + pIDX->pref_sta_data->meridian) +
-                   pIDX->m_cst_epochs[a][pIDX->epoch_year-pIDX->first_year] - pIDX->pref_sta_data->epoch[a]);
-        for (b = deriv; b > 0; b--)
-            term *= pIDX->m_cst_speeds[a];
+    for(int a = 0; a < m_ncst; a++) {
+        double term = yc.mpy[a] * cos(tempd + speeds[a] * off + yc.phase[a]);
+        for(int b = deriv; b > 0; b--)
+            term *= speeds[a];
         dt_tide += term;
     }
     return dt_tide;
@@ -465,245 +231,449 @@ blend_weight (double x, int deriv)
  * This function does the actual "blending" of the tide
  * and its derivatives.
  */
-double blend_tide (time_t t, unsigned int deriv, int first_year, double blend, IDX_entry *pIDX)
+double TCPredictor::BlendTide(time_t t, int deriv, int first_year, double blend)
 {
-    double        fl[TIDE_MAX_DERIV + 1];
-    double        fr[TIDE_MAX_DERIV + 1];
-    double *      fp      = fl;
-    double        w[TIDE_MAX_DERIV + 1];
-    double        fact = 1.0;
-    double        f;
-    unsigned int  n;
-
+    double fl[TIDE_MAX_DERIV + 1];
+    double fr[TIDE_MAX_DERIV + 1];
+    double w[TIDE_MAX_DERIV + 1];
+    double fact = 1.0;
+    double f;
+    int n;
 
-    /*
-     * If we are already happy_new_year()ed into one of the two years
-     * of interest, compute that years tide values first.
-     */
-    int year = yearoftimet(t);
-    if (year == first_year + 1)
-        fp = fr;
-    else if (year != first_year)
-        happy_new_year(pIDX, first_year);
     for (n = 0; n <= deriv; n++)
-        fp[n] = _time2dt_tide(t, n, pIDX);
+        fl[n] = EvalTide(Coefs(first_year), t, n);
 
-    /*
-     * Compute tide values for the other year of interest,
-     *  and the needed values of w(x) and its derivatives.
-     */
-    if (fp == fl)
-    {
-        happy_new_year(pIDX, first_year + 1);
-        fp = fr;
-    }
-    else
-    {
-        happy_new_year(pIDX, first_year);
-        fp = fl;
-    }
-    for (n = 0; n <= deriv; n++)
-    {
-        fp[n] = _time2dt_tide(t, n, pIDX);
+    for (n = 0; n <= deriv; n++) {
+        fr[n] = EvalTide(Coefs(first_year + 1), t, n);
         w[n] = blend_weight(blend, n);
     }
 
-    /*
-     * Do the blending.
-     */
-    
-    
     f = fl[deriv];
-    for (n = 0; n <= deriv; n++)
-    {
+    for (n = 0; n <= deriv; n++) {
         f += fact * w[n] * (fr[deriv-n] - fl[deriv-n]);
         fact *= (double)(deriv - n)/(n+1) * (1.0/TIDE_BLEND_TIME);
     }
-    printf(" %ld  %g     %g %g %g\n", (long)t, blend, fr[0], fl[0], f);
     return f;
 }
 
-double  time2dt_tide (time_t t, int deriv, IDX_entry *pIDX)
+/*
+ * We will need a function for tidal height as a function of time
+ * which is continuous (and has continuous first and second derivatives)
+ * for all times.
+ *
+ * Since the epochs & multipliers for the tidal constituents change
+ * with the year, the regular time2tide(t) function has small
+ * discontinuities at new years.  These discontinuities really
+ * fry the fast root-finders.
+ *
+ * We will eliminate the new-years discontinuities by smoothly
+ * interpolating (or "blending") between the tides calculated with one
+ * year's coefficients, and the tides calculated with the next year's
+ * coefficients.
+ *
+ * i.e. for times near a new years, we will "blend" a tide
+ * as follows:
+ *
+ * tide(t) = tide(year-1, t)
+ *                  + w((t - t0) / Tblend) * (tide(year,t) - tide(year-1,t))
+ *
+ * Here:  t0 is the time of the nearest new-year.
+ *        tide(year-1, t) is the tide calculated using the coefficients
+ *           for the year just preceding t0.
+ *        tide(year, t) is the tide calculated using the coefficients
+ *           for the year which starts at t0.
+ *        Tblend is the "blending" time scale.  This is set by
+ *           the macro TIDE_BLEND_TIME, currently one hour.
+ *        w(x) is the "blending function", whice varies smoothly
+ *           from 0, for x < -1 to 1 for x > 1.
+ *
+ * Derivatives of the blended tide can be evaluated in terms of derivatives
+ * of w(x), tide(year-1, t), and tide(year, t).  The blended tide is
+ * guaranteed to have as many continuous derivatives as w(x).  */
+double TCPredictor::Tide(time_t t, int deriv)
 {
-    int           new_year;
-    int yott = yearoftimet( t );
-    new_year = yott;
-
-    /* Make sure our values of next_epoch and epoch are up to date. */
-    if (new_year != s_this_year)
-    {
-        if (new_year + 1 < pIDX->first_year + pIDX->num_epochs)
-        {
-            set_epoch(pIDX, new_year + 1);
-            s_next_epoch = pIDX->epoch;
-        }
-        else
-            s_next_epoch = TIDE_BAD_TIME;
-
-        happy_new_year(pIDX, s_this_year = new_year);
-        s_this_epoch = pIDX->epoch;
-    }
-
+    int year = YearOfTime(t);
+    int last_year = m_pIDX->first_year + m_pIDX->num_epochs - 1;
+    time_t this_epoch = EpochOfYear(year);
 
     /*
      * If we're close to either the previous or the next
      * new years we must blend the two years tides.
      */
-    if (t - s_this_epoch <= TIDE_BLEND_TIME && s_this_year > pIDX->first_year)
-        return blend_tide(t, deriv,
-                          s_this_year - 1,
-                          (double)(t - s_this_epoch)/TIDE_BLEND_TIME,
-                          pIDX );
-    else if (s_next_epoch - t <= TIDE_BLEND_TIME
-             && s_this_year + 1 < pIDX->first_year + pIDX->num_epochs)
-        return blend_tide(t, deriv,
-                          s_this_year,
-                          -(double)(s_next_epoch - t)/TIDE_BLEND_TIME,
-                          pIDX );
+    if (t - this_epoch <= TIDE_BLEND_TIME && year > m_pIDX->first_year)
+        return BlendTide(t, deriv, year - 1,
+                         (double)(t - this_epoch)/TIDE_BLEND_TIME);
+
+    if (year < last_year) {
+        time_t next_epoch = EpochOfYear(year + 1);
+        if (next_epoch - t <= TIDE_BLEND_TIME)
+            return BlendTide(t, deriv, year,
+                             -(double)(next_epoch - t)/TIDE_BLEND_TIME);
+    }
 
     /*
      * Else, we're far enough from newyears to ignore the blending.
      */
-    if (pIDX->epoch_year != new_year)
-        happy_new_year(pIDX, new_year);
-
-    return _time2dt_tide(t, deriv, pIDX);
+    return EvalTide(Coefs(year), t, deriv);
 }
 
+/*
+ * Normalized tide at t0, t0+step, ...
+ *
+ * Away from new year each constituent is a pure rotation between
+ * samples, so the phases are advanced by complex multiplication rather
+ * than a cos() per constituent per sample.
+ */
+void TCPredictor::TideSeries(time_t t0, int step, int count, double *out)
+{
+    if(step <= 0) {
+        for(int i = 0; i < count; i++)
+            out[i] = Tide(t0 + (time_t)i * step);
+        return;
+    }
 
+    const double *speeds = m_pIDX->m_cst_speeds;
+    int last_year = m_pIDX->first_year + m_pIDX->num_epochs - 1;
 
-/* Figure out max amplitude over all the years in the node factors table. */
-/* This function by Geoffrey T. Dairiki */
-void figure_max_amplitude (IDX_entry *pIDX)
-{
-    int       i, a;
+    m_cos.resize(m_ncst);
+    m_sin.resize(m_ncst);
+    m_cosd.resize(m_ncst);
+    m_sind.resize(m_ncst);
+    for(int a = 0; a < m_ncst; a++) {
+        m_cosd[a] = cos(speeds[a] * step);
+        m_sind[a] = sin(speeds[a] * step);
+    }
+
+    int i = 0;
+    while(i < count) {
+        time_t t = t0 + (time_t)i * step;
+        int year = YearOfTime(t);
+        time_t this_epoch = EpochOfYear(year);
+        time_t next_epoch = EpochOfYear(year + 1);
+        time_t t_end = next_epoch;
+
+        bool bblend = (t - this_epoch <= TIDE_BLEND_TIME && year > m_pIDX->first_year);
+        if(year < last_year) {
+            t_end = next_epoch - TIDE_BLEND_TIME;
+            if(t >= t_end)
+                bblend = true;
+        }
 
-    if (pIDX->max_amplitude == 0.0) {
-        for (i = 0; i < pIDX->num_nodes; i++) {
-            double year_amp = 0.0;
+        if(bblend) {
+            out[i++] = Tide(t);
+            continue;
+        }
+
+        //  Run of samples which all use this year's coefficients
+        long nrun = (long)((t_end - t + step - 1) / step);
+        int n = (int)wxMin((long)(count - i), nrun);
+
+        const YearCoefs &yc = Coefs(year);
+        const double *mpy = &yc.mpy[0];
+        double *c = &m_cos[0], *s = &m_sin[0];
+        const double *cd = &m_cosd[0], *sd = &m_sind[0];
+
+        for(int j = 0; j < n; j++) {
+            if((j % TIDE_SERIES_RESEED) == 0) {
+                long off = (long)(t + (time_t)j * step - yc.epoch) + m_psd->meridian;
+                for(int a = 0; a < m_ncst; a++) {
+                    double ph = speeds[a] * off + yc.phase[a];
+                    c[a] = cos(ph);
+                    s[a] = sin(ph);
+                }
+            }
 
-            for (a=0; a < pIDX->num_csts; a++)
-                year_amp += pIDX->pref_sta_data->amplitude[a] * pIDX->m_cst_nodes[a][i];
-            if (year_amp > pIDX->max_amplitude)
-                pIDX->max_amplitude = year_amp;
+            double sum = 0.0;
+            for(int a = 0; a < m_ncst; a++) {
+                sum += mpy[a] * c[a];
+                double cn = c[a] * cd[a] - s[a] * sd[a];
+                s[a] = s[a] * cd[a] + c[a] * sd[a];
+                c[a] = cn;
+            }
+            out[i + j] = sum;
         }
+        i += n;
     }
 }
 
-/* Figure out normalized multipliers for constituents for a particular year. */
-void figure_multipliers (IDX_entry *pIDX, int year)
+/* Estimate the normalized mean tide level around a particular time by
+ *   summing only the long-term constituents. */
+/* Does not do any blending around year's end. */
+/* This is used only by Secondary() for finding the mean tide level */
+double TCPredictor::Mean(time_t t)
 {
-    int a;
+    const double *speeds = m_pIDX->m_cst_speeds;
+    const YearCoefs &yc = Coefs(YearOfTime(t));
+    long off = (long)(t - yc.epoch) + m_psd->meridian;
+    double tide = 0.0;
 
-    figure_max_amplitude( pIDX );
-    for (a = 0; a < pIDX->num_csts; a++) {
-        pIDX->m_work_buffer[a] = pIDX->pref_sta_data->amplitude[a] * pIDX->m_cst_nodes[a][year-pIDX->first_year] / pIDX->max_amplitude;  // BOGUS_amplitude?
+    for (int a = 0; a < m_ncst; a++) {
+        if (speeds[a] < 6e-6)
+            tide += yc.mpy[a] * cos(speeds[a] * off + yc.phase[a]);
     }
+
+    return tide;
 }
 
+/** BOGUS amplitude stuff - Added mgh
+ * For knots^2 current stations, returns square root of (value * amplitude),
+ * For normal stations, returns value * amplitude
+ * Also adds the datum, giving the denormalized tide. */
+double TCPredictor::Denormalize(double mpy) const
+{
+    double v;
+    if (!m_psd->have_BOGUS)
+        v = mpy * m_max_amplitude;
+    else if (mpy >= 0.0)
+        v = sqrt( mpy * m_max_amplitude);
+    else
+        v = -sqrt(-mpy * m_max_amplitude);
 
-/* This idiotic function is needed by the new tm2gmt. */
-#define compare_int(a,b) (((int)(a))-((int)(b)))
-int compare_tm (struct tm *a, struct tm *b) {
-    int temp;
-    /* printf ("A is %d:%d:%d:%d:%d:%d   B is %d:%d:%d:%d:%d:%d\n",
-     *      a->tm_year+1900, a->tm_mon+1, a->tm_mday, a->tm_hour,
-     *      a->tm_min, a->tm_sec,
-     *      b->tm_year+1900, b->tm_mon+1, b->tm_mday, b->tm_hour,
-     *      b->tm_min, b->tm_sec); */
-
-    temp = compare_int (a->tm_year, b->tm_year);
-    if (temp)
-        return temp;
-    temp = compare_int (a->tm_mon, b->tm_mon);
-    if (temp)
-        return temp;
-    temp = compare_int (a->tm_mday, b->tm_mday);
-    if (temp)
-        return temp;
-    temp = compare_int (a->tm_hour, b->tm_hour);
-    if (temp)
-        return temp;
-    temp = compare_int (a->tm_min, b->tm_min);
-    if (temp)
-        return temp;
-    return compare_int (a->tm_sec, b->tm_sec);
+    return v + m_psd->DATUM;
 }
 
-/* Convert a struct tm in GMT back to a time_t.  isdst is ignored, since
- *   it never should have been needed by mktime in the first place.
+/* Next high tide or low tide of the reference station.
+ *       Bit      Meaning
+ *        0       low tide
+ *        1       high tide
+ * The search steps by a minute, evaluated a block at a time.
  */
-time_t tm2gmt (struct tm *ht)
+int TCPredictor::NextBigEvent(time_t *tm)
 {
-    time_t guess, newguess, thebit;
-    int loopcounter, compare;
-    struct tm *gt;
+    const int nblock = 64;
+    double v[nblock];
+    time_t t0 = *tm;
+
+    TideSeries(t0, TIDE_EVENT_STEP, nblock, v);
+    for(int k = 0; k < nblock; k++)
+        v[k] = Denormalize(v[k]);
+
+    int slope = (v[0] < v[1]) ? 1 : 0;
+    double p = v[1];
+    long base = 0;
+    int k = 2;
+
+    while(1) {
+        if(k == nblock) {
+            base += nblock;
+            TideSeries(t0 + base * TIDE_EVENT_STEP, TIDE_EVENT_STEP, nblock, v);
+            for(int j = 0; j < nblock; j++)
+                v[j] = Denormalize(v[j]);
+            k = 0;
+        }
 
-    guess = 0;
-    loopcounter = (sizeof(time_t) * 8)-1;
-    thebit = ((time_t)1) << (loopcounter-1);
+        double q = v[k];
+        if ((slope == 1 && q < p) || (slope == 0 && p < q)) {
+            /* Tide event, return the time of the turning sample */
+            *tm = t0 + (base + k - 1) * TIDE_EVENT_STEP;
+            return 1 << slope;
+        }
+        p = q;
+        k++;
+    }
+}
+
+/* If offsets are in effect, interpolate the 'corrected' denormalized
+ * tide.  The normalized is derived from this, instead of the other way
+ * around, because the application of height offsets requires the
+ * denormalized tide. */
+double TCPredictor::Secondary(time_t t)
+{
+    const IDX_entry *pIDX = m_pIDX;
+    time_t tadj = t + pIDX->station_tz_offset;
 
-    /* For simplicity, I'm going to insist that the time_t we want is
-     *       positive.  If time_t is signed, skip the sign bit.
+    /* Get rid of the normals. */
+    if (!(pIDX->have_offsets))
+        return Denormalize(Tide(tadj));
+
+    /* Intervalwidth of 14 (was originally 13) failed on this input:
+     *        -location Dublon -hloff +0.0001 -gstart 1997:09:10:00:00 -raw 1997:09:15:00:00
      */
-    if ((signed long)thebit < (time_t)(0)) {
-        /* You can't just shift thebit right because it propagates the sign bit. */
-        loopcounter--;
-        thebit = ((time_t)1) << (loopcounter-1);
-    }
+#define intervalwidth 15
+#define stretchfactor 3
 
-    for (; loopcounter; loopcounter--) {
-        newguess = guess | thebit;
-        gt = gmtime(&newguess);
-        if(NULL != gt)
-        {
-            compare = compare_tm (gt, ht);
-            if (compare <= 0)
-                guess = newguess;
+    time_t T;  /* Adjusted t */
+    double S, Z, HI, HS, magicnum;
+    time_t interval = 3600 * intervalwidth;
+    long difflow, diffhigh;
+    int badlowflag=0, badhighflag=0;
+
+
+    /* Algorithm by Jean-Pierre Lapointe (scipur@collegenotre-dame.qc.ca) */
+    /* as interpreted, munged, and implemented by DWF */
+
+    /* This is the initial guess (average of time offsets) */
+    T = tadj - (pIDX->IDX_ht_time_off * 60 + pIDX->IDX_lt_time_off * 60) / 2;
+    /* The usage of an estimate of mean tide level here is to correct
+     *           for seasonal changes in tide level.  Previously I had simply used
+     *           the zero of the tide function as the mean, but this gave bad
+     *           results around summer and winter for locations with large seasonal
+     *           variations. */
+    Z = Mean(T);
+    S = Tide(T) - Z;
+
+    /* Find MAX and MIN.  I use the highest high tide and the lowest
+     *           low tide over a 26 hour period, but I allow the interval to stretch
+     *           a lot if necessary to avoid creating discontinuities.  The
+     *           heuristic used is not perfect but will hopefully be good enough.
+     *
+     *           It is an assumption in the algorithm that the tide level will
+     *           be above the mean tide level for MAX and below it for MIN.  A
+     *           changeover occurs at mean tide level.  It would be nice to
+     *           always use the two tides that immediately bracket T and to put
+     *           the changeover at mid tide instead of always at mean tide
+     *           level, since this would eliminate much of the inaccuracy.
+     *           Unfortunately if you change the location of the changeover it
+     *           causes the tide function to become discontinuous.
+     *
+     *           Now that I'm using time2mean, the changeover does move, but so
+     *           slowly that it makes no difference.
+     *
+     *           MIN and MAX are kept per predictor, so they are only searched
+     *           again once T has moved on by more than the interval.
+     */
+
+    if (m_lowtime < T)
+        difflow = T - m_lowtime;
+    else
+        difflow = m_lowtime - T;
+    if (m_hightime < T)
+        diffhigh = T - m_hightime;
+    else
+        diffhigh = m_hightime - T;
+
+    /* Update MIN? */
+    if (difflow > interval * stretchfactor)
+        badlowflag = 1;
+    if (badlowflag || (difflow > interval && S > 0)) {
+        time_t tt;
+        double tl;
+        tt = T - interval;
+        NextBigEvent (&tt);
+        m_lowlvl = Tide (tt);
+        m_lowtime = tt;
+        while (tt < T + interval) {
+            NextBigEvent (&tt);
+            tl = Tide (tt);
+            if (tl < m_lowlvl && tt < T + interval) {
+                m_lowlvl = tl;
+                m_lowtime = tt;
+            }
+        }
+    }
+    /* Update MAX? */
+    if (diffhigh > interval * stretchfactor)
+        badhighflag = 1;
+    if (badhighflag || (diffhigh > interval && S < 0)) {
+        time_t tt;
+        double tl;
+        tt = T - interval;
+        NextBigEvent (&tt);
+        m_highlvl = Tide (tt);
+        m_hightime = tt;
+        while (tt < T + interval) {
+            NextBigEvent (&tt);
+            tl = Tide (tt);
+            if (tl > m_highlvl && tt < T + interval) {
+                m_highlvl = tl;
+                m_hightime = tt;
+            }
         }
-        thebit >>= 1;
     }
 
-    return guess;
-}
+    /* Now that I'm using time2mean, I should be guaranteed to get
+     *           an appropriate low and high. */
 
-int yearoftimet (time_t t)
-{
-    return ((gmtime (&t))->tm_year) + 1900;
-}
 
+    /* Improve the initial guess. */
+    if (S > 0)
+        magicnum = 0.5 * S / fabs(m_highlvl - Z);
+    else
+        magicnum = 0.5 * S / fabs(m_lowlvl - Z);
+    T = T - (time_t)(magicnum * ((pIDX->IDX_ht_time_off * 60) - (pIDX->IDX_lt_time_off * 60)));
+    HI = Tide(T);
+
+    //    Correct the amplitude offsets for BOGUS knot^2 units
+    double ht_off, lt_off;
+    if (m_psd->have_BOGUS)
+    {
+        ht_off = pIDX->IDX_ht_off * pIDX->IDX_ht_off;         // Square offset in kts to adjust for kts^2
+        lt_off = pIDX->IDX_lt_off * pIDX->IDX_lt_off;
+    }
+    else
+    {
+        ht_off = pIDX->IDX_ht_off;
+        lt_off = pIDX->IDX_lt_off;
+    }
+
+
+    /* Denormalize and apply the height offsets. */
+    HI = Denormalize(HI);
+    {
+        double RH=1.0, RL=1.0, HH=0.0, HL=0.0;
+        RH = pIDX->IDX_ht_mpy;
+        HH = ht_off;
+        RL = pIDX->IDX_lt_mpy;
+        HL = lt_off;
+
+        /* I patched the usage of RH and RL to avoid big ugly
+         *            discontinuities when they are not equal.  -- DWF */
 
-/* Calculate time_t of the epoch. */
-void set_epoch (IDX_entry *pIDX, int year)
+        HS =  HI * ((RH+RL)/2 + (RH-RL)*magicnum)
+              + (HH+HL)/2 + (HH-HL)*magicnum;
+    }
+
+    return HS;
+}
+
+double TCPredictor::GetLevel(time_t t)
 {
-    struct tm ht;
+    if(!IsOk())
+        return 0.0;
 
-    ht.tm_year = year - 1900;
-    ht.tm_sec = ht.tm_min = ht.tm_hour = ht.tm_mon = 0;
-    ht.tm_mday = 1;
-    pIDX->epoch = tm2gmt (&ht);
+    return Secondary(t);
 }
 
-/* Re-initialize for a different year */
-void happy_new_year (IDX_entry *pIDX, int new_year)
+void TCPredictor::GetLevels(time_t t0, int step, int count, float *values)
 {
-    pIDX->epoch_year = new_year;
-    figure_multipliers ( pIDX, new_year );
-    set_epoch ( pIDX, new_year );
+    if(!IsOk()) {
+        for(int i = 0; i < count; i++)
+            values[i] = 0;
+        return;
+    }
+
+    //  Subordinate stations shift each sample by a level dependent time
+    //  offset, so only reference stations are evaluated as a series
+    if(!m_pIDX->have_offsets) {
+        m_series.resize(count);
+        TideSeries(t0 + m_pIDX->station_tz_offset, step, count, &m_series[0]);
+        for(int i = 0; i < count; i++)
+            values[i] = Denormalize(m_series[i]);
+    }
+    else {
+        for(int i = 0; i < count; i++)
+            values[i] = Secondary(t0 + (time_t)i * step);
+    }
 }
 
 //      TCMgr Implementation
 TCMgr::TCMgr()
 {
+    m_pExtrema = new TCExtremaCache;
 }
 
 TCMgr::~TCMgr()
 {
     PurgeData();
+    delete m_pExtrema;
 }
 
 void TCMgr::PurgeData()
 {
+    //  The cache worker may still be reading the index entries
+    m_pExtrema->Clear();
+    m_predictors.clear();
+
     //  Index entries are owned by the data sources
     //  so we need to clear them from the combined list without
     //  deleting them
@@ -711,6 +681,9 @@ void TCMgr::PurgeData()
         m_Combined_IDX_array.Detach(0);
     }
 
+    m_tide_index.Clear();
+    m_current_index.Clear();
+
     //  Delete all the data sources
     m_source_array.Clear();
 }
@@ -755,12 +728,19 @@ TC_Error_Code TCMgr::LoadDataSources(wxArrayString &sources)
         }
     }
 
+    for( unsigned int j = 1; j < m_Combined_IDX_array.GetCount(); j++ ) {
+        const IDX_entry *pIDX = &m_Combined_IDX_array[j];
+        char type = pIDX->IDX_type;
+        if( type == 't' || type == 'T' )
+            m_tide_index.Add(j, pIDX->IDX_lat, pIDX->IDX_lon);
+        else if( type == 'c' || type == 'C' )
+            m_current_index.Add(j, pIDX->IDX_lat, pIDX->IDX_lon);
+    }
+    m_tide_index.Build();
+    m_current_index.Build();
+
     bTCMReady = true;
-    
-    if (m_Combined_IDX_array.Count() <= 1)
-        OCPNMessageBox( NULL, _("It seems you have no tide/current harmonic data installed."),
-                        _("OpenCPN Info"), wxOK | wxCENTER );
-        
+
     return  TC_NO_ERROR ;
 }
 
@@ -773,40 +753,84 @@ const IDX_entry *TCMgr::GetIDX_entry(int index) const
 }
 
 
-bool TCMgr::GetTideOrCurrent(time_t t, int idx, float &tcvalue, float& dir)
+IDX_entry *TCMgr::GetPredictionEntry(int idx)
 {
-    //    Return a sensible value of 0,0 by default
-    dir = 0;
-    tcvalue = 0;
+    if((unsigned int)idx >= m_Combined_IDX_array.GetCount())
+        return NULL;
 
     //    Load up this location data
     IDX_entry *pIDX = &m_Combined_IDX_array[idx];    // point to the index entry
 
-    if( !pIDX ) {
-        dir = 0;
-        tcvalue = 0;
-        return false;
-    }
+    if( !pIDX )
+        return NULL;
 
-    if( !pIDX->IDX_Useable ) {
-        dir = 0;
-        tcvalue = 0;
-        return(false);                                        // no error, but unuseable
-    }
+    if( !pIDX->IDX_Useable )
+        return NULL;                                          // no error, but unuseable
 
     if(pIDX->pDataSource) {
         if(pIDX->pDataSource->LoadHarmonicData(pIDX) != TC_NO_ERROR)
-            return false;
+            return NULL;
     }
 
-    pIDX->max_amplitude = 0.0;                // Force multiplier re-compute
-    int yott = yearoftimet( t );
+    return pIDX;
+}
+
+//  Predictors are kept per station, so the amplitude scan and the per year
+//  multipliers are not redone on every call, e.g. for each station painted.
+//  Main thread only.
+TCPredictor *TCMgr::GetPredictor(IDX_entry *pIDX)
+{
+    std::map<const IDX_entry *, TCPredictor>::iterator it = m_predictors.find(pIDX);
+    if(it == m_predictors.end() || !it->second.IsFor(pIDX)) {
+        if(it != m_predictors.end())
+            m_predictors.erase(it);
+        else if(m_predictors.size() >= MAX_PREDICTORS)
+            m_predictors.clear();
+        it = m_predictors.insert(std::make_pair(pIDX, TCPredictor(pIDX))).first;
+    }
+
+    return it->second.IsOk() ? &it->second : NULL;
+}
+
+//  Queue a background window of levels and high/low waters around t,
+//  unless the cache already covers it
+void TCMgr::RequestExtrema(int idx, time_t t)
+{
+    if(!m_pExtrema->NeedsRequest(idx, t))
+        return;
+
+    IDX_entry *pIDX = GetPredictionEntry(idx);
+    if( !pIDX )
+        return;
+
+    TCPredictor *predictor = GetPredictor(pIDX);
+    if( !predictor )
+        return;
+
+    predictor->LoadState(pIDX);
+    m_pExtrema->Request(idx, *predictor, t);
+}
 
-    happy_new_year (pIDX, yott);              //Calculate new multipliers
+bool TCMgr::GetTideOrCurrent(time_t t, int idx, float &tcvalue, float& dir)
+{
+    //    Return a sensible value of 0,0 by default
+    dir = 0;
+    tcvalue = 0;
+
+    IDX_entry *pIDX = GetPredictionEntry(idx);
+    if( !pIDX )
+        return false;
+
+    TCPredictor *predictor = GetPredictor(pIDX);
+    if( !predictor )
+        return false;
 
     //    Finally, calculate the tide/current
 
-    double level = time2asecondary (t + (00 * 60), pIDX);  // 300. 240
+    predictor->LoadState(pIDX);
+    double level = predictor->GetLevel(t);
+    predictor->SaveState(pIDX);
+
     if(level >= 0)
         dir = pIDX->IDX_flood_dir;
     else
@@ -817,6 +841,80 @@ bool TCMgr::GetTideOrCurrent(time_t t, int idx, float &tcvalue, float& dir)
     return(true); // Got it!
 }
 
+bool TCMgr::GetTideOrCurrentSeries(time_t t0, int step, int count, int idx, float *values, float *dirs)
+{
+    for(int i = 0; i < count; i++) {
+        values[i] = 0;
+        if(dirs)
+            dirs[i] = 0;
+    }
+
+    IDX_entry *pIDX = GetPredictionEntry(idx);
+    if( !pIDX )
+        return false;
+
+    TCPredictor *predictor = GetPredictor(pIDX);
+    if( !predictor )
+        return false;
+
+    predictor->LoadState(pIDX);
+    predictor->GetLevels(t0, step, count, values);
+    predictor->SaveState(pIDX);
+
+    if(dirs) {
+        for(int i = 0; i < count; i++)
+            dirs[i] = (values[i] >= 0) ? pIDX->IDX_flood_dir : pIDX->IDX_ebb_dir;
+    }
+
+    return true;
+}
+
+void TCMgr::GetTideOrCurrentSeries(time_t t0, int step, int count, const std::vector<int> &stations,
+                                   std::vector<float> &values)
+{
+    int nsta = stations.size();
+    values.assign((size_t)nsta * count, 0.f);
+    if(!nsta || count <= 0)
+        return;
+
+    //  Harmonic data is loaded here, on the calling thread, so the
+    //  workers below only ever read the index entries
+    std::vector<TCPredictor> predictors;
+    predictors.reserve(nsta);
+    for(int k = 0; k < nsta; k++) {
+        IDX_entry *pIDX = GetPredictionEntry(stations[k]);
+        predictors.push_back(TCPredictor(pIDX));
+        if(pIDX)
+            predictors.back().LoadState(pIDX);
+    }
+
+    std::atomic<int> next(0);
+    auto worker = [&]() {
+        int k;
+        while((k = next++) < nsta)
+            predictors[k].GetLevels(t0, step, count, &values[(size_t)k * count]);
+    };
+
+    int nthreads = wxMin((int)std::thread::hardware_concurrency(), nsta) - 1;
+    std::vector<std::thread> threads;
+    for(int i = 0; i < nthreads; i++) {
+        try {
+            threads.push_back(std::thread(worker));
+        } catch(std::system_error &) {
+            break;
+        }
+    }
+    worker();
+    for(unsigned int i = 0; i < threads.size(); i++)
+        threads[i].join();
+
+    for(int k = 0; k < nsta; k++) {
+        IDX_entry *pIDX = GetPredictionEntry(stations[k]);
+        if(pIDX && predictors[k].IsOk())
+            predictors[k].SaveState(pIDX);
+    }
+}
+
 extern wxDateTime gTimeSource;
 
 bool TCMgr::GetTideOrCurrent15(time_t t_d, int idx, float &tcvalue, float& dir, bool &bnew_val)
@@ -902,28 +1000,22 @@ bool TCMgr::GetTideFlowSens(time_t t, int sch_step, int idx, float &tcvalue_now,
     w_t = false;
 
 
-    //    Load up this location data
-    IDX_entry *pIDX = &m_Combined_IDX_array[idx];             // point to the index entry
-
+    IDX_entry *pIDX = GetPredictionEntry(idx);
     if( !pIDX )
         return false;
 
-    if( !pIDX->IDX_Useable )
-        return false;                                        // no error, but unuseable
-
-    if(pIDX->pDataSource) {
-        if(pIDX->pDataSource->LoadHarmonicData(pIDX) != TC_NO_ERROR)
-            return false;
-    }
-
-    pIDX->max_amplitude = 0.0;                // Force multiplier re-compute
-    int yott = yearoftimet( t );
-    happy_new_year (pIDX, yott);              //Force new multipliers
+    //  Not from the cached samples: near slack water their interpolation
+    //  can get the sense of the flow wrong
+    TCPredictor *predictor = GetPredictor(pIDX);
+    if( !predictor )
+        return false;
 
     //    Finally, process the tide flow sens
 
-    tcvalue_now = time2asecondary (t , pIDX);
-    tcvalue_prev = time2asecondary (t + sch_step , pIDX);
+    predictor->LoadState(pIDX);
+    tcvalue_now = predictor->GetLevel(t);
+    tcvalue_prev = predictor->GetLevel(t + sch_step);
+    predictor->SaveState(pIDX);
 
     w_t = tcvalue_now > tcvalue_prev;           // w_t = true --> flood , w_t = false --> ebb
 
@@ -936,18 +1028,16 @@ void TCMgr::GetHightOrLowTide(time_t t, int sch_step_1, int sch_step_2, float ti
     tcvalue = 0;
     tctime = t;
 
-    //    Load up this location data
-    IDX_entry *pIDX = &m_Combined_IDX_array[idx];             // point to the index entry
-
+    IDX_entry *pIDX = GetPredictionEntry(idx);
     if( !pIDX )
         return;
 
-    if( !pIDX->IDX_Useable )
-        return;                                        // no error, but unuseable
-
-    if(pIDX->pDataSource) {
-        if(pIDX->pDataSource->LoadHarmonicData(pIDX) != TC_NO_ERROR)
-            return;
+    RequestExtrema(idx, t);
+    TCExtremum ext;
+    if(m_pExtrema->GetExtremum(idx, t, sch_step_1 > 0, w_t, ext)) {
+        tcvalue = ext.level;
+        tctime = ext.time;
+        return;
     }
 
     // Is the cache data reasonably fresh?
@@ -963,9 +1053,10 @@ void TCMgr::GetHightOrLowTide(time_t t, int sch_step_1, int sch_step_2, float ti
     }
 
 
-    pIDX->max_amplitude = 0.0;                // Force multiplier re-compute
-    int yott = yearoftimet( t );
-    happy_new_year (pIDX, yott);
+    TCPredictor *predictor = GetPredictor(pIDX);
+    if( !predictor )
+        return;
+    predictor->LoadState(pIDX);
 
     // Finally, calculate the Hight and low tides
     double newval = tide_val;
@@ -978,7 +1069,7 @@ void TCMgr::GetHightOrLowTide(time_t t, int sch_step_1, int sch_step_2, float ti
         j++;
         oldval = newval;
         ttt = t + ( sch_step_1 * j );
-        newval = time2asecondary (ttt, pIDX);
+        newval = predictor->GetLevel(ttt);
     }
     oldval = ( w_t ) ? newval - 1: newval + 1 ;
     while ( (newval > oldval) == w_t )                  // searching back each minute
@@ -986,11 +1077,12 @@ void TCMgr::GetHightOrLowTide(time_t t, int sch_step_1, int sch_step_2, float ti
         oldval = newval ;
         k++;
         ttt = t +  ( sch_step_1 * j ) - ( sch_step_2 * k ) ;
-        newval = time2asecondary (ttt, pIDX);
+        newval = predictor->GetLevel(ttt);
     }
     tcvalue = newval;
     tctime = ttt + sch_step_2 ;
-    
+    predictor->SaveState(pIDX);
+
     // Cache the data
     pIDX->recent_highlow_calc_time = t;
     if(w_t){
@@ -1022,83 +1114,91 @@ double  TCMgr::GetStationLon(IDX_entry *pIDX)
 
 int TCMgr::GetNextBigEvent(time_t *tm, int idx)
 {
-    float tcvalue[1];
-    float dir;
-    bool ret;
-    double p, q;
+    IDX_entry *pIDX = GetPredictionEntry(idx);
+    if( !pIDX )
+        return 0;
+
+    RequestExtrema(idx, *tm);
+    TCExtremum ext;
+    if(m_pExtrema->GetNextExtremum(idx, *tm, ext)) {
+        *tm = ext.time;
+        return ext.bhigh ? 2 : 1;
+    }
+
+    TCPredictor *predictor = GetPredictor(pIDX);
+    if( !predictor )
+        return 0;
+
+    //    Step by a minute, evaluating the levels a block at a time
+    const int nblock = 64;
+    float tcvalue[nblock];
+    time_t t0 = *tm;
+    long base = 0;
     int flags = 0, slope = 0;
-    ret = GetTideOrCurrent(*tm, idx, tcvalue[0],  dir);
-    p = tcvalue[0];
-    *tm += 60;
-    ret = GetTideOrCurrent(*tm, idx, tcvalue[0],  dir);
-    q = tcvalue[0];
-    *tm += 60;
-    if (p < q)
+
+    predictor->LoadState(pIDX);
+    predictor->GetLevels(t0, 60, nblock, tcvalue);
+    if (tcvalue[0] < tcvalue[1])
         slope = 1;
-    while (1) {
+
+    double p = tcvalue[1];
+    int k = 2;
+    while (!flags) {
+        if (k == nblock) {
+            base += nblock;
+            predictor->GetLevels(t0 + base * 60, 60, nblock, tcvalue);
+            k = 0;
+        }
+        double q = tcvalue[k];
         if ((slope == 1 && q < p) || (slope == 0 && p < q)) {
             /* Tide event */
             flags |= (1 << slope);
-        }
-        if (flags) {
-            *tm -= 60;
-            if (flags < 4)
-                *tm -= 60;
-            return flags;
+            *tm = t0 + (base + k - 1) * 60;
         }
         p = q;
-        ret = GetTideOrCurrent(*tm, idx, tcvalue[0],  dir);
-        q = tcvalue[0];
-        *tm += 60;
+        k++;
     }
-    return 0;
+    predictor->SaveState(pIDX);
+
+    return flags;
 }
 
-std::map<double, const IDX_entry*> TCMgr::GetStationsForLL(double xlat, double xlon) const
+void TCMgr::GetStationsInBBox(const LLBBox &box, double marge, bool bcurrents, std::vector<int> &stations) const
+{
+    if(bcurrents)
+        m_current_index.GetInBBox(box, marge, stations);
+    else
+        m_tide_index.GetInBBox(box, marge, stations);
+}
+
+std::map<double, const IDX_entry*> TCMgr::GetStationsForLL(double xlat, double xlon, int max_stations) const
 {
     std::map<double, const IDX_entry*> x;
-    const IDX_entry *lpIDX;
-    
-    for ( int j=1 ; j<Get_max_IDX() +1 ; j++ ) {
-        lpIDX = GetIDX_entry ( j );
-        char type = lpIDX->IDX_type;
-        wxString locnx ( lpIDX->IDX_station_name, wxConvUTF8 );
-        
-        if ( type == 't' || type == 'T' ) {
-            double brg, dist;
-            DistanceBearingMercator(xlat, xlon, lpIDX->IDX_lat, lpIDX->IDX_lon, &brg, &dist);
-            x.emplace(std::make_pair(dist, lpIDX));
-        }
-    }
-    
+
+    std::vector<std::pair<double, int> > nearest;
+    m_tide_index.GetNearest(xlat, xlon, max_stations, nearest);
+
+    for(unsigned int i = 0; i < nearest.size(); i++)
+        x.emplace(std::make_pair(nearest[i].first, GetIDX_entry(nearest[i].second)));
+
     return x;
 }
 
 int TCMgr::GetStationIDXbyName(const wxString & prefix, double xlat, double xlon) const
 {
-    const IDX_entry *lpIDX;
     int jx = 0;
-    wxString locn;
     double distx = 100000.;
 
-    int jmax = Get_max_IDX();
-
-    for ( int j=1 ; j<Get_max_IDX() +1 ; j++ ) {
-        lpIDX = GetIDX_entry ( j );
-        char type = lpIDX->IDX_type;             // Entry "TCtcIUu" identifier
-        wxString locnx ( lpIDX->IDX_station_name, wxConvUTF8 );
+    //  Only Tides are in the index, search outwards for the first name match
+    std::vector<std::pair<double, int> > nearest;
+    m_tide_index.GetNearest(xlat, xlon, 1, nearest,
+                            [&](int j) {
+                                wxString locnx ( GetIDX_entry ( j )->IDX_station_name, wxConvUTF8 );
+                                return locnx.StartsWith(prefix);
+                            });
 
-        if ( (( type == 't' ) ||  ( type == 'T' ) )   // only Tides
-                && (locnx.StartsWith(prefix))) {
-            double brg, dist;
-            DistanceBearingMercator(xlat, xlon, lpIDX->IDX_lat, lpIDX->IDX_lon, &brg, &dist);
-            if (dist < distx) {
-                distx = dist;
-                jx = j;
-            }
-        }
-    } // end for loop
-    //} // end if @~~ found in WP
+    if( nearest.size() && nearest[0].first < distx )
+        jx = nearest[0].second;
     return(jx);
 }
 
@@ -1107,19 +1207,33 @@ int TCMgr::GetStationIDXbyNameType(const wxString & prefix, double xlat, double
 {
     const IDX_entry *lpIDX;
     int jx = 0;
-    wxString locn;
     double distx = 100000.;
 
-    // if (prp->m_MarkName.Find(_T("@~~")) != wxNOT_FOUND) {
-    //tide_form = prp->m_MarkName.Mid(prp->m_MarkName.Find(_T("@~~"))+3);
-    int jmax = Get_max_IDX();
+    auto accept = [&](int j) {
+        char typep = GetIDX_entry ( j )->IDX_type;             // Entry "TCtcIUu" identifier
+        wxString locnx ( GetIDX_entry ( j )->IDX_station_name, wxConvUTF8 );
+        return ( type == typep ) && (locnx.StartsWith(prefix));
+    };
+
+    //  Tides and currents are indexed, search outwards for the first match
+    const TCStationIndex *index = NULL;
+    if( type == 't' || type == 'T' )
+        index = &m_tide_index;
+    else if( type == 'c' || type == 'C' )
+        index = &m_current_index;
+
+    if( index ) {
+        std::vector<std::pair<double, int> > nearest;
+        index->GetNearest(xlat, xlon, 1, nearest, accept);
+        if( nearest.size() && nearest[0].first < distx )
+            jx = nearest[0].second;
+        return(jx);
+    }
 
     for ( int j=1 ; j<Get_max_IDX() +1 ; j++ ) {
         lpIDX = GetIDX_entry ( j );
-        char typep = lpIDX->IDX_type;             // Entry "TCtcIUu" identifier
-        wxString locnx ( lpIDX->IDX_station_name, wxConvUTF8 );
 
-        if ( ( type == typep ) && (locnx.StartsWith(prefix))) {
+        if ( accept(j) ) {
             double brg, dist;
             DistanceBearingMercator(xlat, xlon, lpIDX->IDX_lat, lpIDX->IDX_lon, &brg, &dist);
             if (dist < distx) {
@@ -1131,7 +1245,6 @@ int TCMgr::GetStationIDXbyNameType(const wxString & prefix, double xlat, double
     return(jx);
 }
 
-
 /* $Id: tide_db_default.h 1092 2006-11-16 03:02:42Z flaterco $ */
 
 //#include "tcd.h"